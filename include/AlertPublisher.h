@@ -0,0 +1,202 @@
+/**
+ * @file AlertPublisher.h
+ * @brief Queued, batched alert delivery that never blocks the detector
+ *
+ * @details Alarm transitions and sensor faults are turned into Alerts and
+ * handed to publish(), which only appends to a fixed ring: no I/O, no
+ * allocation, O(1). Delivery happens in poll(), through an AlertTransport
+ * whose start()/poll() must not block either (a non-blocking HTTP client on
+ * the host, a whole Serial line once the UART buffer has room on the board):
+ *
+ * - Batching: up to batchMax queued alerts go out as one JSON request,
+ *   `{"alerts":[{"id":..,"type":..,"t_ms":..,"cm":..,"faults":..,"count":..}]}`
+ * - Backoff: after a failed request the next try waits backoffMinMs,
+ *   doubling per consecutive failure up to backoffMaxMs, with 50-100%
+ *   random jitter so devices do not retry in lockstep
+ * - Deduplication: every alert has an increasing id that survives reboots,
+ *   so a receiver drops repeats of a batch whose answer was lost; and an
+ *   alert repeating one still waiting in the queue (same type and fault
+ *   bits, first seen less than dedupWindowMs ago) replaces it at the tail
+ *   with its count bumped, so a flapping sensor holds two entries, not a
+ *   full queue, and the newest entry is still the newest state
+ * - Bounded queue: ALERT_QUEUE_SIZE alerts; when full the oldest is dropped
+ *   and counted
+ * - Persistence: with a ConfigBackend the queue is saved by the first
+ *   poll() after a new alert is queued or a batch is delivered, never on a
+ *   timer, so a quiet system does not write flash at all; restore()
+ *   reloads it after a reboot (CRC-checked, as the config record). Merged
+ *   repeats only bump a count and ride along with the next save, so a
+ *   flapping sensor does not wear the flash. Ids are reserved
+ *   ALERT_ID_BLOCK at a time in the record, so a reboot does not reuse an
+ *   id that was delivered but not yet saved
+ */
+
+#ifndef ALERT_PUBLISHER_H
+#define ALERT_PUBLISHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ConfigStore.h"
+
+/** @brief Alerts kept until delivered */
+#define ALERT_QUEUE_SIZE 32
+
+/** @brief Most alerts per request */
+#define ALERT_BATCH_MAX 8
+
+/** @brief Request body buffer; holds ALERT_BATCH_MAX alerts */
+#define ALERT_BODY_MAX 1024
+
+/**
+ * @brief Ids reserved in the record; restore() continues after them
+ * @details Renewed by the next poll() once half are used, so ids are only
+ * reused if more than ALERT_ID_BLOCK / 2 are taken between two polls.
+ */
+#define ALERT_ID_BLOCK 1024
+
+/** @brief Serial line carrying one batch on the board: `@A {"alerts":[...]}` */
+#define ALERT_LINE_PREFIX "@A "
+
+/** @brief Persisted queue format version */
+#define ALERT_RECORD_VERSION 1
+
+/** @brief Bytes of a persisted queue holding count alerts */
+#define ALERT_RECORD_BYTES(count) ((size_t)16 + 16 * (size_t)(count))
+
+enum class AlertType : uint8_t {
+  Intruder,     ///< Alarm raised
+  Clear,        ///< Alarm cleared
+  SensorFault,  ///< Sensor fault bits changed to non-zero
+  SensorOk      ///< Sensor recovered
+};
+
+/** @brief Lowercase name used in the JSON body ("intruder", "clear", ...) */
+const char* alertTypeName(AlertType type);
+
+struct Alert {
+  uint32_t id;       ///< Increasing, never reused; receivers drop repeats
+  uint32_t timeMs;   ///< millis() of the first occurrence
+  AlertType type;
+  uint8_t faults;    ///< SENSOR_FAULT_* bits (faults only)
+  uint16_t count;    ///< Occurrences merged into this alert
+  float distanceCm;  ///< Reading that caused it (alarms only)
+};
+
+struct AlertConfig {
+  uint8_t batchMax = ALERT_BATCH_MAX;  ///< Alerts per request (1..ALERT_BATCH_MAX)
+  uint32_t backoffMinMs = 1000;        ///< Wait after the first failure
+  uint32_t backoffMaxMs = 60000;       ///< Longest wait between tries
+  uint32_t dedupWindowMs = 10000;      ///< Repeats this close merge; 0 = off
+};
+
+/** @brief State of the request in flight */
+enum class DeliveryStatus : uint8_t {
+  Pending,    ///< Still sending or waiting for the answer
+  Delivered,  ///< Receiver accepted the batch
+  Failed      ///< Refused, timed out or not reachable
+};
+
+/**
+ * @brief Carries one request body to the receiver
+ * @details Neither call may block. The body stays valid until poll() has
+ * returned Delivered or Failed.
+ */
+class AlertTransport {
+ public:
+  virtual ~AlertTransport() {}
+
+  /** @return false if the request could not even be started (a failure) */
+  virtual bool start(const char* body, size_t length) = 0;
+
+  virtual DeliveryStatus poll() = 0;
+};
+
+/**
+ * @brief Formats alerts as the JSON request body
+ * @return Characters written (NUL terminated), 0 if capacity is too small
+ */
+size_t formatAlertBatch(const Alert* alerts, size_t count, char* out, size_t capacity);
+
+class AlertPublisher {
+ public:
+  /**
+   * @param store Where the queue is persisted; nullptr keeps it in RAM only
+   */
+  AlertPublisher(AlertTransport& transport, ConfigBackend* store = nullptr,
+                 const AlertConfig& config = AlertConfig());
+
+  /**
+   * @brief Loads the queue and the next id saved by a previous run
+   * @details Call before the first poll(), which may save over the record.
+   * Alerts published before it are renumbered after the restored ids and
+   * stay behind the restored alerts, so no id is reused and the queue stays
+   * in id order.
+   * @return Alerts restored (0 if nothing valid was stored)
+   */
+  size_t restore();
+
+  /** @brief Queues one alert; never blocks (drops the oldest when full) */
+  void publish(AlertType type, uint32_t timeMs, float distanceCm = 0, uint8_t faults = 0);
+
+  /** @brief Advances delivery and saves the queue if it gained or lost alerts */
+  void poll(uint32_t nowMs);
+
+  /** @brief Saves the queue now if it changed since the last save */
+  void flush();
+
+  size_t queued() const { return count_; }
+  bool inFlight() const { return inFlight_; }
+  const AlertConfig& config() const { return config_; }
+
+  /** @name Counters since construction */
+  ///@{
+  uint32_t delivered() const { return delivered_; }  ///< Alerts in accepted batches
+  uint32_t dropped() const { return dropped_; }      ///< Pushed out of a full queue
+  uint32_t merged() const { return merged_; }        ///< Folded into a queued repeat
+  uint32_t requests() const { return requests_; }    ///< Batches started
+  uint32_t failures() const { return failures_; }    ///< Batches refused or lost
+  uint32_t saves() const { return saves_; }
+  ///@}
+
+  /** @brief Current wait before the next try after failures, 0 if none */
+  uint32_t backoffMs() const { return backoffMs_; }
+
+  /** @brief One-line summary of the queue and the counters */
+  size_t format(char* out, size_t capacity) const;
+
+ private:
+  Alert& at(size_t i) { return queue_[(head_ + i) % ALERT_QUEUE_SIZE]; }
+  const Alert& at(size_t i) const { return queue_[(head_ + i) % ALERT_QUEUE_SIZE]; }
+  void startBatch(uint32_t nowMs);
+  void finishBatch(bool delivered, uint32_t nowMs);
+  void remove(size_t i);
+  uint32_t nextRandom();
+
+  AlertTransport& transport_;
+  ConfigBackend* store_;
+  AlertConfig config_;
+  Alert queue_[ALERT_QUEUE_SIZE];
+  size_t head_;
+  size_t count_;
+  uint32_t nextId_;
+  uint32_t idLimit_;  ///< Ids below this may have been used (as saved)
+  bool inFlight_;
+  uint32_t batchLastId_;  ///< Highest id in the batch in flight
+  size_t batchSize_;
+  uint32_t retryAtMs_;
+  uint32_t backoffMs_;
+  uint32_t consecutiveFailures_;
+  bool dirty_;     ///< Queue differs from the saved record
+  bool saveDue_;   ///< An alert was queued or delivered since the last save
+  uint32_t random_;
+  char body_[ALERT_BODY_MAX];
+  uint32_t delivered_;
+  uint32_t dropped_;
+  uint32_t merged_;
+  uint32_t requests_;
+  uint32_t failures_;
+  uint32_t saves_;
+};
+
+#endif  // ALERT_PUBLISHER_H
@@ -0,0 +1,205 @@
+/**
+ * @file ArduinoHal.h
+ * @brief Hal, console I/O and configuration storage implementations that
+ * forward to the Arduino core on the ESP32
+ */
+
+#ifndef ARDUINO_HAL_H
+#define ARDUINO_HAL_H
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+
+#include "AlertPublisher.h"
+#include "CommandConsole.h"
+#include "ConfigStore.h"
+#include "Hal.h"
+
+class ArduinoHal : public Hal {
+ public:
+  ArduinoHal()
+      : pulsePin_(0xff),
+        pulseLevel_(HIGH),
+        pulseTimeoutUs_(0),
+        startUs_(0),
+        riseUs_(0),
+        fallUs_(0) {}
+
+  void pinMode(uint8_t pin, uint8_t mode) override { ::pinMode(pin, mode); }
+  void digitalWrite(uint8_t pin, uint8_t level) override { ::digitalWrite(pin, level); }
+  unsigned long pulseIn(uint8_t pin, uint8_t level, unsigned long timeoutUs) override {
+    return ::pulseIn(pin, level, timeoutUs);
+  }
+  void delayMicroseconds(uint32_t us) override { ::delayMicroseconds(us); }
+  void delay(uint32_t ms) override { ::delay(ms); }
+  void lightSleep(uint32_t us) override {
+    // The UART clock stops in light sleep; send what is queued first.
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup(us);
+    esp_light_sleep_start();
+  }
+  unsigned long millis() override { return ::millis(); }
+  unsigned long micros() override { return ::micros(); }
+  uint64_t micros64() override { return (uint64_t)esp_timer_get_time(); }
+  uint32_t cpuFrequencyMhz() override { return ::getCpuFrequencyMhz(); }
+  bool setCpuFrequencyMhz(uint32_t mhz) override { return ::setCpuFrequencyMhz(mhz); }
+
+  /**
+   * @details Both edges are timestamped by a pin interrupt (esp_timer, so
+   * the width does not depend on the CPU clock); the timeout covers the
+   * wait for the pulse and the pulse itself, as with pulseIn().
+   */
+  void startPulse(uint8_t pin, uint8_t level, unsigned long timeoutUs) override {
+    if (pulsePin_ != 0xff) detachInterrupt(pulsePin_);
+    pulsePin_ = pin;
+    pulseLevel_ = level;
+    pulseTimeoutUs_ = timeoutUs;
+    riseUs_ = 0;
+    fallUs_ = 0;
+    startUs_ = (uint64_t)esp_timer_get_time();
+    attachInterruptArg(pin, onPulseEdge, this, CHANGE);
+  }
+
+  bool pulseDone(unsigned long& widthUs) override {
+    if (pulsePin_ == 0xff) {
+      widthUs = 0;
+      return true;
+    }
+    uint64_t fallUs = fallUs_;
+    bool timedOut = (uint64_t)esp_timer_get_time() - startUs_ > pulseTimeoutUs_;
+    if (fallUs == 0 && !timedOut) return false;
+    detachInterrupt(pulsePin_);
+    pulsePin_ = 0xff;
+    bool inTime = fallUs != 0 && fallUs - startUs_ <= pulseTimeoutUs_;
+    widthUs = inTime ? (unsigned long)(fallUs - riseUs_) : 0;
+    return true;
+  }
+
+ private:
+  static void IRAM_ATTR onPulseEdge(void* arg) {
+    ArduinoHal* hal = (ArduinoHal*)arg;
+    uint64_t nowUs = (uint64_t)esp_timer_get_time();
+    if (::digitalRead(hal->pulsePin_) == hal->pulseLevel_) {
+      if (hal->riseUs_ == 0) hal->riseUs_ = nowUs;
+    } else if (hal->riseUs_ != 0 && hal->fallUs_ == 0) {
+      hal->fallUs_ = nowUs;
+    }
+  }
+
+  uint8_t pulsePin_;  ///< Pin being timed, 0xff if none
+  uint8_t pulseLevel_;
+  unsigned long pulseTimeoutUs_;
+  uint64_t startUs_;
+  volatile uint64_t riseUs_;  ///< Set by the edge interrupt, 0 until then
+  volatile uint64_t fallUs_;
+};
+
+/**
+ * @brief Console on the Serial port; read() never waits for input
+ */
+class SerialConsoleIo : public ConsoleIo {
+ public:
+  int read() override { return Serial.available() > 0 ? Serial.read() : -1; }
+  void write(const char* text, size_t length) override {
+    Serial.write((const uint8_t*)text, length);
+  }
+  size_t writeSpace() override { return (size_t)Serial.availableForWrite(); }
+};
+
+/**
+ * @brief Configuration record as one NVS blob
+ * @details A single getBytes() on a read-only handle: one lookup at boot
+ * however many parameters the record holds. Other records (the alert queue)
+ * use their own key in the same namespace.
+ */
+class NvsConfigBackend : public ConfigBackend {
+ public:
+  explicit NvsConfigBackend(const char* key = "config") : key_(key) {}
+
+  int read(uint8_t* out, size_t capacity) override {
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, true)) return -1;  // never written
+    size_t n = prefs.isKey(key_) ? prefs.getBytes(key_, out, capacity) : 0;
+    prefs.end();
+    return n > 0 ? (int)n : -1;
+  }
+  bool write(const uint8_t* data, size_t length) override {
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, false)) return false;
+    bool ok = prefs.putBytes(key_, data, length) == length;
+    prefs.end();
+    return ok;
+  }
+  bool erase() override {
+    Preferences prefs;
+    if (!prefs.begin(NAMESPACE, false)) return false;
+    bool ok = !prefs.isKey(key_) || prefs.remove(key_);
+    prefs.end();
+    return ok;
+  }
+
+ private:
+  static constexpr const char* NAMESPACE = "detector";
+  const char* key_;
+};
+
+/**
+ * @brief Alert batches as `@A <json>` lines on Serial
+ * @details There is no network stack in this firmware: a host bridge that
+ * reads the serial port forwards each line to the webhook and answers with
+ * the console command `alerts ok` or `alerts fail`. poll() writes the whole
+ * line in one go once the UART buffer has room for all of it, so it never
+ * waits on the port and no other output can land inside the line; with no
+ * answer within timeoutMs the batch counts as failed.
+ */
+class SerialAlertTransport : public AlertTransport {
+ public:
+  explicit SerialAlertTransport(uint32_t timeoutMs = 5000)
+      : body_(nullptr), length_(0), written_(false), startMs_(0), timeoutMs_(timeoutMs),
+        result_(DeliveryStatus::Failed) {}
+
+  bool start(const char* body, size_t length) override {
+    body_ = body;
+    length_ = length;
+    written_ = false;
+    startMs_ = millis();
+    result_ = DeliveryStatus::Pending;
+    return true;
+  }
+
+  DeliveryStatus poll() override {
+    if (result_ != DeliveryStatus::Pending) return result_;
+    // Prefix, body and newline; sizeof() counts the prefix's NUL for the newline.
+    if (!written_ && (size_t)Serial.availableForWrite() >= sizeof(ALERT_LINE_PREFIX) + length_) {
+      Serial.write((const uint8_t*)ALERT_LINE_PREFIX, sizeof(ALERT_LINE_PREFIX) - 1);
+      Serial.write((const uint8_t*)body_, length_);
+      Serial.write('\n');
+      written_ = true;
+    }
+    if (millis() - startMs_ >= timeoutMs_) result_ = DeliveryStatus::Failed;
+    return result_;
+  }
+
+  /** @brief The bridge's answer to the line sent; ignored if none is awaited */
+  void answer(bool delivered) {
+    if (result_ == DeliveryStatus::Pending && written_) {
+      result_ = delivered ? DeliveryStatus::Delivered : DeliveryStatus::Failed;
+    }
+  }
+
+ private:
+  const char* body_;
+  size_t length_;
+  bool written_;
+  uint32_t startMs_;
+  uint32_t timeoutMs_;
+  DeliveryStatus result_;
+};
+
+#endif  // ARDUINO
+
+#endif  // ARDUINO_HAL_H
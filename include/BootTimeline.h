@@ -0,0 +1,60 @@
+/**
+ * @file BootTimeline.h
+ * @brief Named timestamps of the boot sequence
+ *
+ * @details The firmware marks each boot step (configuration loaded, pins
+ * set, first ping, armed, console up) with the time since reset, so the
+ * time until the area is guarded again after a power cut can be read off
+ * the `boot` command. Marks are kept in a fixed table; only the first mark
+ * of each name counts.
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Most marks one timeline holds */
+#define BOOT_MAX_MARKS 12
+
+class BootTimeline {
+ public:
+  BootTimeline() : count_(0) {}
+
+  /**
+   * @param name Step name; must outlive the timeline
+   * @param timeUs Time since reset
+   * @return false if the name was already marked or the table is full
+   */
+  bool mark(const char* name, uint64_t timeUs);
+
+  /** @return true and the time of the mark, or false if it is missing */
+  bool find(const char* name, uint64_t& timeUs) const;
+
+  bool has(const char* name) const {
+    uint64_t timeUs;
+    return find(name, timeUs);
+  }
+
+  size_t size() const { return count_; }
+  const char* name(size_t i) const { return marks_[i].name; }
+  uint64_t timeUs(size_t i) const { return marks_[i].timeUs; }
+
+  /**
+   * @brief Formats the marks as `name=ms ...` in the order they were made
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t format(char* out, size_t capacity) const;
+
+ private:
+  struct Mark {
+    const char* name;
+    uint64_t timeUs;
+  };
+
+  Mark marks_[BOOT_MAX_MARKS];
+  size_t count_;
+};
+
+#endif  // BOOT_TIMELINE_H
@@ -0,0 +1,164 @@
+/**
+ * @file CommandConsole.h
+ * @brief Non-blocking, zero-allocation line console for live tuning
+ *
+ * @details Bytes are pulled from a ConsoleIo one at a time into a fixed
+ * line buffer; poll() reads at most a handful of them and runs at most one
+ * complete line, so a burst of input never holds up a measurement cycle
+ * (the rest waits in the UART's RX buffer for the next poll()).
+ *
+ * A line is `<command> [args]`. The first word selects a registered
+ * command; the rest of the line, with surrounding spaces removed, is passed
+ * to its handler. Three commands are built in:
+ * - `help`: lists the commands and parameters
+ * - `get [name]`: prints one parameter, or all of them
+ * - `set <name> <value>`: changes a parameter after parsing and range
+ *   checking it, then calls the parameter listener, which can reject the
+ *   new value (the old one is put back)
+ *
+ * Commands and parameters are kept in fixed tables that point to the
+ * caller's names and variables, so nothing is copied or allocated. Output
+ * goes through print()/printf() into the same ConsoleIo.
+ */
+
+#ifndef COMMAND_CONSOLE_H
+#define COMMAND_CONSOLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Longest accepted line (longer lines are dropped with an error) */
+#define CONSOLE_LINE_MAX 64
+
+/** @brief Most commands one console can hold (built-ins excluded) */
+#define CONSOLE_MAX_COMMANDS 24
+
+/** @brief Most parameters one console can hold */
+#define CONSOLE_MAX_PARAMETERS 24
+
+/** @brief Bytes read per poll() */
+#define CONSOLE_POLL_BYTES 32
+
+/** @brief Longest printf() output */
+#define CONSOLE_OUTPUT_MAX 160
+
+/**
+ * @brief Byte source and text sink of a console
+ */
+class ConsoleIo {
+ public:
+  virtual ~ConsoleIo() {}
+
+  /** @return The next received byte, or -1 if none is waiting */
+  virtual int read() = 0;
+
+  virtual void write(const char* text, size_t length) = 0;
+
+  /** @return Bytes write() takes without waiting; the default never waits */
+  virtual size_t writeSpace() { return SIZE_MAX; }
+};
+
+class CommandConsole;
+
+/**
+ * @brief Runs one command
+ * @param args Rest of the line after the command word ("" if none)
+ */
+typedef void (*CommandHandler)(CommandConsole& console, const char* args, void* context);
+
+/**
+ * @brief Called after `set` changed a parameter
+ * @return false to reject the change (the previous value is restored)
+ */
+typedef bool (*ParameterListener)(const char* name, void* context);
+
+class CommandConsole {
+ public:
+  explicit CommandConsole(ConsoleIo& io);
+
+  /**
+   * @param name First word of the command line; must outlive the console
+   * @param help One-line usage for `help`; must outlive the console
+   * @return false if the table is full
+   */
+  bool addCommand(const char* name, const char* help, CommandHandler handler,
+                  void* context = nullptr);
+
+  /**
+   * @name Parameters for get/set
+   * Names and variables must outlive the console. Values outside [min, max]
+   * are rejected.
+   * @{
+   */
+  bool addFloat(const char* name, float* value, float min, float max);
+  bool addUint32(const char* name, uint32_t* value, uint32_t min, uint32_t max);
+  bool addUint8(const char* name, uint8_t* value, uint8_t min, uint8_t max);
+  bool addBool(const char* name, bool* value);
+  /** @param choices Names of the values 0..count-1 */
+  bool addChoice(const char* name, uint8_t* value, const char* const* choices, uint8_t count);
+  /** @} */
+
+  void setParameterListener(ParameterListener listener, void* context) {
+    listener_ = listener;
+    listenerContext_ = context;
+  }
+
+  /**
+   * @brief Reads up to CONSOLE_POLL_BYTES and runs a line if one completed
+   * @return true if a line was run
+   */
+  bool poll();
+
+  /** @brief Runs one line as if it had been received (modified in place) */
+  void execute(char* line);
+
+  void print(const char* text);
+  void println(const char* text);
+  void printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+  /** @brief Lines dropped for exceeding CONSOLE_LINE_MAX */
+  uint32_t overlongLines() const { return overlongLines_; }
+
+ private:
+  enum class ParamType : uint8_t { Float, Uint32, Uint8, Bool, Choice };
+
+  struct Command {
+    const char* name;
+    const char* help;
+    CommandHandler handler;
+    void* context;
+  };
+
+  struct Parameter {
+    const char* name;
+    ParamType type;
+    void* value;
+    float min;
+    float max;
+    const char* const* choices;  ///< Choice only
+  };
+
+  bool addParameter(const char* name, ParamType type, void* value, float min, float max,
+                    const char* const* choices);
+  const Parameter* findParameter(const char* name) const;
+  void printParameter(const Parameter& parameter);
+  bool setParameter(const Parameter& parameter, const char* text);
+  static size_t valueSize(ParamType type);
+  void help();
+  void get(const char* args);
+  void set(char* args);
+
+  ConsoleIo& io_;
+  Command commands_[CONSOLE_MAX_COMMANDS];
+  size_t commandCount_;
+  Parameter parameters_[CONSOLE_MAX_PARAMETERS];
+  size_t parameterCount_;
+  ParameterListener listener_;
+  void* listenerContext_;
+  char line_[CONSOLE_LINE_MAX + 1];
+  size_t length_;
+  bool overlong_;  ///< Current line exceeded the buffer; drop it at the end
+  uint32_t overlongLines_;
+};
+
+#endif  // COMMAND_CONSOLE_H
@@ -0,0 +1,99 @@
+/**
+ * @file ConfigStore.h
+ * @brief Versioned, CRC-checked detector configuration record
+ *
+ * @details The tunable DetectorConfig fields (the ones `set` can change) are
+ * packed into one little-endian record, so a boot reads a single blob
+ * instead of a key per parameter:
+ *
+ *   u32 magic 'IDCF' (0x46434449), u16 version, u16 payload length,
+ *   u32 CRC-32 of the payload, then the payload:
+ *   f32 trip, clear, trip margin, clear margin, track gate,
+ *   u8 samples, u32 ping spacing, jitter, echo timeout, cycle period,
+ *   u8 trip dwell, clear dwell, filter, light sleep,
+ *   u32 idle period, idle CPU MHz
+ *
+ * Pins, calibration length and noise settings are never stored: they come
+ * from the build. A missing, damaged or older record leaves the compiled
+ * defaults in place. Where the record lives is up to a ConfigBackend (NVS on
+ * the ESP32, a file on the host).
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "IntruderDetector.h"
+
+/** @brief Record format version; records of another version are ignored */
+#define CONFIG_RECORD_VERSION 1
+
+/** @brief Size of a complete record */
+#define CONFIG_RECORD_BYTES 61
+
+/**
+ * @brief Storage for one configuration record
+ */
+class ConfigBackend {
+ public:
+  virtual ~ConfigBackend() {}
+
+  /**
+   * @brief Reads the stored record
+   * @return Bytes read, or -1 if there is none
+   */
+  virtual int read(uint8_t* out, size_t capacity) = 0;
+
+  /** @brief Replaces the stored record */
+  virtual bool write(const uint8_t* data, size_t length) = 0;
+
+  /** @brief Deletes the stored record (true if none is left) */
+  virtual bool erase() = 0;
+};
+
+/** @brief Outcome of ConfigStore::load() */
+enum class ConfigLoad : uint8_t {
+  Loaded,    ///< Stored values applied
+  Missing,   ///< Nothing stored
+  Corrupt,   ///< Bad magic, length, CRC or value
+  Outdated   ///< Written by another record version
+};
+
+/** @brief Lowercase name of a load result ("loaded", "missing", ...) */
+const char* configLoadName(ConfigLoad result);
+
+/** @brief CRC-32 (IEEE 802.3, reflected, as used by zlib) */
+uint32_t crc32(const uint8_t* data, size_t length);
+
+/**
+ * @brief Packs the tunable fields of config into a record
+ * @return CONFIG_RECORD_BYTES, or 0 if capacity is too small
+ */
+size_t encodeConfigRecord(const DetectorConfig& config, uint8_t* out, size_t capacity);
+
+/**
+ * @brief Checks a record and applies its fields to config
+ * @details config is only written if the whole record is valid, values
+ * included: they must pass validDetectorTuning(), or the result is Corrupt.
+ */
+ConfigLoad decodeConfigRecord(const uint8_t* data, size_t length, DetectorConfig& config);
+
+class ConfigStore {
+ public:
+  explicit ConfigStore(ConfigBackend& backend) : backend_(backend) {}
+
+  /** @brief Applies the stored record to config (left untouched on failure) */
+  ConfigLoad load(DetectorConfig& config);
+
+  bool save(const DetectorConfig& config);
+
+  /** @brief Forgets the stored record; the next boot uses the defaults */
+  bool erase() { return backend_.erase(); }
+
+ private:
+  ConfigBackend& backend_;
+};
+
+#endif  // CONFIG_STORE_H
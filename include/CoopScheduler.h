@@ -0,0 +1,165 @@
+/**
+ * @file CoopScheduler.h
+ * @brief Stackless cooperative tasks (protothreads) and their scheduler
+ *
+ * @details A CoopTask is written as straight-line code in step() between
+ * COOP_BEGIN() and COOP_END(); every wait is an await macro that saves the
+ * position (the source line) and returns to the scheduler, and the next
+ * step() jumps back to it with a switch. Tasks need no stack of their own
+ * and nothing is allocated, but local variables do not survive an await:
+ * keep state in members. Only one await per source line.
+ *
+ * The awaits:
+ * - COOP_SLEEP_FOR(us): resume once us have passed
+ * - COOP_AWAIT_ECHO(pin, level, timeoutUs, widthUs): time one pulse with
+ *   Hal::startPulse() and resume once it ended or timed out
+ * - COOP_AWAIT_UART_SPACE(io, bytes): resume once the ConsoleIo can take
+ *   bytes without blocking
+ * - COOP_WAIT_UNTIL(condition), COOP_YIELD()
+ *
+ * Condition waits are re-checked every pollUs (COOP_POLL_US by default).
+ * CoopScheduler::run() steps every task that is due and returns the
+ * earliest wake time, so the caller can sleep or do other work until then.
+ * Everything runs on one thread; a task that blocks holds up the others.
+ */
+
+#ifndef COOP_SCHEDULER_H
+#define COOP_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Hal.h"
+
+/** @brief Most tasks one scheduler can hold */
+#define COOP_MAX_TASKS 8
+
+/** @brief Default interval at which a condition wait is re-checked */
+#define COOP_POLL_US 200
+
+class CoopScheduler;
+
+class CoopTask {
+ public:
+  explicit CoopTask(uint32_t pollUs = COOP_POLL_US)
+      : hal_(nullptr), line_(0), wakeUs_(0), pollUs_(pollUs), steps_(0), finished_(false) {}
+  virtual ~CoopTask() {}
+
+  /** @brief Runs from the last await to the next one */
+  virtual void step() = 0;
+
+  /** @brief When the task wants to run next (Hal::micros64()) */
+  uint64_t wakeUs() const { return wakeUs_; }
+
+  /** @brief True after COOP_END() was reached; the task is not run again */
+  bool finished() const { return finished_; }
+
+  /** @brief step() calls so far */
+  uint32_t steps() const { return steps_; }
+
+ protected:
+  /** @brief Clock and pins; set when the task is added to a scheduler */
+  Hal& hal() { return *hal_; }
+
+  /** @brief Marks the task finished (COOP_END()) */
+  void finishTask() { finished_ = true; }
+
+  /** @name State used by the COOP_ macros */
+  ///@{
+  Hal* hal_;
+  uint16_t line_;  ///< Source line of the pending await, 0 = start
+  uint64_t wakeUs_;
+  uint32_t pollUs_;
+  ///@}
+
+ private:
+  friend class CoopScheduler;
+  uint32_t steps_;
+  bool finished_;
+};
+
+// ============================================================================
+// AWAITS
+// ============================================================================
+
+#define COOP_BEGIN() \
+  switch (line_) {   \
+    case 0:
+
+#define COOP_END() \
+  }                \
+  line_ = 0;       \
+  finishTask();    \
+  return
+
+/** @brief Lets the other due tasks run, then continues */
+#define COOP_YIELD()            \
+  do {                          \
+    wakeUs_ = hal_->micros64(); \
+    line_ = __LINE__;           \
+    return;                     \
+    case __LINE__:;             \
+  } while (0)
+
+#define COOP_SLEEP_FOR(us)             \
+  do {                                 \
+    wakeUs_ = hal_->micros64() + (us); \
+    line_ = __LINE__;                  \
+    return;                            \
+    case __LINE__:;                    \
+  } while (0)
+
+#define COOP_WAIT_UNTIL(condition)            \
+  do {                                        \
+    line_ = __LINE__;                         \
+    [[fallthrough]];                          \
+    case __LINE__:                            \
+      if (!(condition)) {                     \
+        wakeUs_ = hal_->micros64() + pollUs_; \
+        return;                               \
+      }                                       \
+  } while (0)
+
+#define COOP_AWAIT_ECHO(pin, level, timeoutUs, widthUs) \
+  do {                                                  \
+    hal_->startPulse((pin), (level), (timeoutUs));      \
+    COOP_WAIT_UNTIL(hal_->pulseDone(widthUs));          \
+  } while (0)
+
+#define COOP_AWAIT_UART_SPACE(io, bytes) COOP_WAIT_UNTIL((io).writeSpace() >= (size_t)(bytes))
+
+// ============================================================================
+// SCHEDULER
+// ============================================================================
+
+class CoopScheduler {
+ public:
+  explicit CoopScheduler(Hal& hal);
+
+  /**
+   * @brief Adds a task; it first runs at the next run()
+   * @return false if the table is full
+   */
+  bool add(CoopTask& task);
+
+  /**
+   * @brief Steps every task whose wake time has come, once each
+   * @return Earliest wake time of the unfinished tasks (UINT64_MAX if none)
+   */
+  uint64_t run();
+
+  size_t tasks() const { return taskCount_; }
+
+  /** @brief run() calls, and task steps over all of them */
+  uint32_t runs() const { return runs_; }
+  uint32_t steps() const { return steps_; }
+
+ private:
+  Hal& hal_;
+  CoopTask* tasks_[COOP_MAX_TASKS];
+  size_t taskCount_;
+  uint32_t runs_;
+  uint32_t steps_;
+};
+
+#endif  // COOP_SCHEDULER_H
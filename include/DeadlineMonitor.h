@@ -0,0 +1,81 @@
+/**
+ * @file DeadlineMonitor.h
+ * @brief Cycle period, jitter and deadline-miss tracking for loop()
+ *
+ * @details cycleStart() is called once at the top of every measurement
+ * cycle. The time since the previous call is the cycle's period; it goes into
+ * a LogHistogram and is compared with the budget (the longest a cycle may
+ * take, e.g. IntruderDetector::cycleBudgetUs() plus a margin for output).
+ * A period over budget is a deadline miss.
+ *
+ * Jitter is the cycle-to-cycle change of the period, smoothed like RFC 3550
+ * interarrival jitter (J += (|D| - J) / 16), plus its maximum.
+ *
+ * healthy() turns false after escalateAfter consecutive misses. The firmware
+ * only feeds the task watchdog while healthy() is true, so a cycle that
+ * hangs (no cycleStart() at all) or keeps overrunning ends in a watchdog
+ * reset instead of a silently disarmed detector.
+ */
+
+#ifndef DEADLINE_MONITOR_H
+#define DEADLINE_MONITOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LogHistogram.h"
+
+struct DeadlineConfig {
+  uint32_t budgetUs = 1000000;   ///< Longest acceptable cycle period
+  uint16_t escalateAfter = 10;   ///< Consecutive misses before healthy() fails; 0 = never
+};
+
+class DeadlineMonitor {
+ public:
+  explicit DeadlineMonitor(const DeadlineConfig& config = DeadlineConfig());
+
+  /** @brief Marks the start of a cycle */
+  void cycleStart(uint64_t nowUs);
+
+  /** @brief False once escalateAfter consecutive cycles missed their deadline */
+  bool healthy() const {
+    return config_.escalateAfter == 0 || consecutiveMisses_ < config_.escalateAfter;
+  }
+
+  /** @brief Clears the statistics (the next cycleStart() starts a new period) */
+  void reset();
+
+  const DeadlineConfig& config() const { return config_; }
+  void setConfig(const DeadlineConfig& config) { config_ = config; }
+
+  uint32_t cycles() const { return periods_.count(); }
+  uint32_t misses() const { return misses_; }
+  uint32_t consecutiveMisses() const { return consecutiveMisses_; }
+  uint32_t maxConsecutiveMisses() const { return maxConsecutiveMisses_; }
+  uint32_t lastPeriodUs() const { return lastPeriodUs_; }
+  uint32_t jitterUs() const { return jitterUs_ >> 4; }
+  uint32_t maxJitterUs() const { return maxJitterUs_; }
+
+  /** @brief Cycle periods in µs */
+  const LogHistogram& periods() const { return periods_; }
+
+  /**
+   * @brief Formats the counters on one line
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t formatCounters(char* out, size_t capacity) const;
+
+ private:
+  DeadlineConfig config_;
+  LogHistogram periods_;
+  uint64_t lastStartUs_;
+  bool started_;
+  uint32_t lastPeriodUs_;
+  uint32_t jitterUs_;      ///< Smoothed jitter, scaled by 16
+  uint32_t maxJitterUs_;
+  uint32_t misses_;
+  uint32_t consecutiveMisses_;
+  uint32_t maxConsecutiveMisses_;
+};
+
+#endif  // DEADLINE_MONITOR_H
@@ -0,0 +1,82 @@
+/**
+ * @file DetectionScorer.h
+ * @brief Scores detector alarms against labelled ground truth
+ *
+ * @details For each `intruder` label the scorer finds the first alarm active
+ * during [start, end + grace]:
+ * - none: the event is missed
+ * - raised later than lateUs after the label start: detected but late
+ * - otherwise: detected on time
+ * The latency is alarm raise time - label start (0 if the alarm was already
+ * on when the intruder arrived).
+ *
+ * An alarm raised outside every intruder window and every `ignore` span is
+ * a false alarm. Host only.
+ */
+
+#ifndef DETECTION_SCORER_H
+#define DETECTION_SCORER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+#include "GroundTruth.h"
+#include "ReplayHal.h"
+
+struct ScoreOptions {
+  uint64_t graceUs = 2000000;   ///< Alarms up to this long after a label ends still count
+  uint64_t lateUs = 1000000;    ///< Detections slower than this are "late"
+};
+
+/** @brief Outcome for one intruder label */
+struct EventScore {
+  uint64_t startUs;
+  uint64_t endUs;
+  bool detected;
+  bool late;
+  uint64_t latencyUs;           ///< Valid when detected
+};
+
+/** @brief Score of one trace, or several traces merged */
+struct TraceScore {
+  std::vector<EventScore> events;
+  std::vector<uint64_t> falseAlarmTimes;
+  double hours = 0;             ///< Scored capture time
+
+  size_t missed() const;
+  size_t late() const;
+  size_t detected() const { return events.size() - missed(); }
+  double falseAlarmsPerHour() const;
+  double missedRate() const;
+  double meanLatencyMs() const;   ///< Over detected events; -1 if none
+
+  /**
+   * @brief Latency percentile over detected events
+   * @param p Percentile in [0, 100]
+   * @return Milliseconds, -1 if no event was detected
+   */
+  double latencyPercentileMs(double p) const;
+
+  /** @brief Appends another score (e.g. to build a corpus total) */
+  void merge(const TraceScore& other);
+
+  /**
+   * @brief Writes the score as a JSON object
+   * @param withEvents Include the per-event and false alarm lists
+   */
+  void writeJson(FILE* out, bool withEvents) const;
+};
+
+/**
+ * @brief Scores alarm intervals against labels
+ * @param alarms Alarm intervals in time order (see replayAlarms())
+ * @param labels Labels sorted by start time (see loadLabels())
+ * @param hours Length of the scored capture
+ */
+TraceScore scoreDetections(const std::vector<AlarmInterval>& alarms,
+                           const std::vector<LabelInterval>& labels, double hours,
+                           const ScoreOptions& options = ScoreOptions());
+
+#endif  // DETECTION_SCORER_H
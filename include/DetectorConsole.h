@@ -0,0 +1,63 @@
+/**
+ * @file DetectorConsole.h
+ * @brief Detector parameters for the command console
+ *
+ * @details Registers the tunable fields of a DetectorConfig with a
+ * CommandConsole under short names, so the firmware and the host console
+ * simulator offer the same `get`/`set` vocabulary. The console writes into
+ * the given config; the caller's parameter listener checks it with
+ * validDetectorTuning() and hands it to IntruderDetector::tune().
+ */
+
+#ifndef DETECTOR_CONSOLE_H
+#define DETECTOR_CONSOLE_H
+
+#include "CommandConsole.h"
+#include "IntruderDetector.h"
+
+/**
+ * @brief Longest worst-case cycle (detectorCycleBudgetUs()) a tuning may have
+ * @details The firmware feeds its 5 s task watchdog once per cycle; this
+ * leaves room for Serial output and the deadline margin on top.
+ */
+#define DETECTOR_MAX_CYCLE_US 3000000
+
+/**
+ * @name Parameter ranges
+ * @brief What `set` and validDetectorTuning() accept, shared with the host
+ * tools' command-line options
+ * @{
+ */
+#define DETECTOR_MAX_DISTANCE_CM 500  ///< trip, clear, margins and gate
+#define DETECTOR_MAX_SPACING_MS 200
+#define DETECTOR_MAX_JITTER_MS 200
+#define DETECTOR_MIN_TIMEOUT_US 1000
+#define DETECTOR_MAX_TIMEOUT_US 40000
+#define DETECTOR_MAX_PERIOD_MS 2500   ///< Cycle and idle period
+#define DETECTOR_MAX_IDLE_MHZ 240
+/** @} */
+
+/**
+ * @brief Registers trip, clear, margins, timing, filter and power fields
+ * @param config Written by `set`; must outlive the console
+ * @return false if the console ran out of parameter slots
+ */
+bool addDetectorParameters(CommandConsole& console, DetectorConfig& config);
+
+/**
+ * @brief Checks a whole tuning before it is applied
+ * @details Every field must lie in the range `set` accepts for it (NaN
+ * never does), the clear distance beyond the trip distance for the fixed
+ * thresholds and the scene margins alike, and the worst-case cycle within
+ * DETECTOR_MAX_CYCLE_US.
+ */
+bool validDetectorTuning(const DetectorConfig& config);
+
+/**
+ * @brief Whether the quiet-scene CPU clock is 0 (off), 80, 160 or 240 MHz
+ * @details Other clocks break the UART or are not ones setCpuFrequencyMhz()
+ * accepts; see PowerScheduler.h.
+ */
+bool validIdleCpuMhz(uint32_t mhz);
+
+#endif  // DETECTOR_CONSOLE_H
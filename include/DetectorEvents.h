@@ -0,0 +1,51 @@
+/**
+ * @file DetectorEvents.h
+ * @brief Publishes detector and sensor health output on an EventBus
+ *
+ * @details The single listener the detector and SensorHealth need: each
+ * callback becomes one event, stamped with Hal::micros64(), and everything
+ * else (buzzer latency, printing, metrics, logging) subscribes to the bus.
+ */
+
+#ifndef DETECTOR_EVENTS_H
+#define DETECTOR_EVENTS_H
+
+#include "EventBus.h"
+#include "Hal.h"
+#include "IntruderDetector.h"
+#include "SensorHealth.h"
+
+class DetectorEventSource : public DetectorListener, public SensorHealthListener {
+ public:
+  DetectorEventSource(EventBus& bus, Hal& hal) : bus_(bus), hal_(hal) {}
+
+  void onPing(uint32_t timeUs, uint32_t echoUs) override {
+    bus_.publishSample(hal_.micros64(), timeUs, echoUs);
+  }
+
+  void onReading(float distanceCm) override {
+    bus_.publishReading(EventType::ReadingReady, hal_.micros64(), distanceCm);
+  }
+
+  void onIntruder(float distanceCm) override {
+    bus_.publishReading(EventType::AlarmRaised, hal_.micros64(), distanceCm);
+  }
+
+  void onClear(float distanceCm) override {
+    bus_.publishReading(EventType::AlarmCleared, hal_.micros64(), distanceCm);
+  }
+
+  void onCalibrated(const SceneModel& scene) override {
+    bus_.publishCalibrated(hal_.micros64(), scene);
+  }
+
+  void onHealthChange(uint8_t faults, uint8_t previous) override {
+    bus_.publishFault(hal_.micros64(), faults, previous);
+  }
+
+ private:
+  EventBus& bus_;
+  Hal& hal_;
+};
+
+#endif  // DETECTOR_EVENTS_H
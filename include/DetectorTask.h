@@ -0,0 +1,42 @@
+/**
+ * @file DetectorTask.h
+ * @brief The detector's measurement cycle as a cooperative task
+ *
+ * @details Does what IntruderDetector::loop() does, written the same
+ * straight-line way, but every wait is an await: the echo of each ping
+ * (Hal::startPulse()), the spacing after it and the cycle wait. Other tasks
+ * (console, telemetry output) run in those gaps instead of after the whole
+ * cycle. Readings, alarms and the listener calls are the same as loop()'s.
+ *
+ * The cycle wait is left to the scheduler's caller, so the power
+ * scheduler's light sleep is not used; setQuiet() still picks the CPU
+ * clock.
+ */
+
+#ifndef DETECTOR_TASK_H
+#define DETECTOR_TASK_H
+
+#include <stdint.h>
+
+#include "CoopScheduler.h"
+#include "IntruderDetector.h"
+
+class DetectorTask : public CoopTask {
+ public:
+  explicit DetectorTask(IntruderDetector& detector, uint32_t pollUs = COOP_POLL_US);
+
+  void step() override;
+
+  /** @brief Readings completed so far */
+  uint32_t readings() const { return readings_; }
+
+ private:
+  IntruderDetector& detector_;
+  unsigned long echoes_[DETECTOR_MAX_SAMPLES];
+  uint8_t samples_;
+  uint8_t ping_;
+  uint32_t pingTime_;
+  uint32_t readings_;
+};
+
+#endif  // DETECTOR_TASK_H
@@ -0,0 +1,63 @@
+/**
+ * @file EnergyModel.h
+ * @brief Battery drain estimate from where a simulated run spent its time
+ *
+ * @details A run is reduced to an EnergyUsage (total time, time in light
+ * sleep, sleeps entered, CPU clock while awake, sensor ranging time,
+ * buzzer-on time, all taken from SimHal and the alarm intervals) and an
+ * EnergyConfig of supply currents:
+ *
+ *   charge = awake * cpuActiveMa - (awake * 240 - awakeMhzUs) * cpuMaPerMhz
+ *          + slept * lightSleepMa
+ *          + sleeps * wakeUs * (cpuActiveMa - lightSleepMa)
+ *          + total * (sensorIdleMa + boardMa)
+ *          + echoWait * (sensorRangingMa - sensorIdleMa)
+ *          + buzzer * buzzerMa
+ *
+ * The defaults are datasheet figures for a bare ESP32 module with the radio
+ * off (40 mA at 240 MHz, about 24 mA at 80 MHz) and an HC-SR04; set boardMa
+ * for the regulator and USB-serial bridge of a development board. Host only.
+ */
+
+#ifndef ENERGY_MODEL_H
+#define ENERGY_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct EnergyConfig {
+  float cpuActiveMa = 40;       ///< CPU awake at 240 MHz: measuring or in delay()
+  float cpuMaPerMhz = 0.1f;     ///< Saved per MHz below 240 while awake
+  float lightSleepMa = 0.8f;    ///< Light sleep with the timer wakeup armed
+  float sensorIdleMa = 2;       ///< HC-SR04 quiescent
+  float sensorRangingMa = 15;   ///< HC-SR04 while an echo is awaited
+  float buzzerMa = 30;          ///< Buzzer/vibration motor on
+  float boardMa = 0;            ///< Regulator, USB-serial bridge, LEDs
+  uint32_t wakeUs = 500;        ///< Extra awake time per sleep (entry and wake-up)
+};
+
+/** @brief Where a run spent its time */
+struct EnergyUsage {
+  uint64_t totalUs = 0;
+  uint64_t sleptUs = 0;         ///< In light sleep
+  uint32_t sleeps = 0;          ///< Light sleeps entered
+  uint64_t awakeMhzUs = 0;      ///< CPU MHz x µs while awake; 0 = always 240 MHz
+  uint64_t echoWaitUs = 0;      ///< Sensor ranging
+  uint64_t buzzerUs = 0;        ///< Alarm on
+};
+
+/** @brief Mean supply current over the run, in mA */
+double averageCurrentMa(const EnergyConfig& config, const EnergyUsage& usage);
+
+/** @brief Charge drawn per day at the run's mean current, in mAh */
+inline double milliampHoursPerDay(const EnergyConfig& config, const EnergyUsage& usage) {
+  return averageCurrentMa(config, usage) * 24;
+}
+
+/**
+ * @brief Formats the model's currents on one line
+ * @return Characters written (output is always NUL terminated)
+ */
+size_t formatEnergyConfig(const EnergyConfig& config, char* out, size_t capacity);
+
+#endif  // ENERGY_MODEL_H
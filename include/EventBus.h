@@ -0,0 +1,158 @@
+/**
+ * @file EventBus.h
+ * @brief Statically allocated publish/subscribe between detector modules
+ *
+ * @details Modules that react to the detector (buzzer latency probe, serial
+ * output, metrics, summaries, telemetry, future flash logging or network
+ * alerts) subscribe to the event types they need instead of being called
+ * one by one from a hard-wired listener. Adding a sink is one subscribe()
+ * call; the measurement code only ever publishes.
+ *
+ * Events live in a small ring of pooled slots. A publisher fills a slot in
+ * place (acquire(), then publish()), and every subscriber whose mask
+ * contains the type gets a const reference to that slot, in subscription
+ * order: nothing is copied and nothing is allocated. Dispatch is
+ * synchronous, so the slot is only valid until the handler returns.
+ *
+ * A handler may publish too (e.g. a SampleReady subscriber that raises a
+ * SensorFault). The new event is queued behind the current one and
+ * dispatched once every subscriber has seen the current one, so handlers
+ * never nest and each subscriber sees events in publication order. If the
+ * pool is full the event is dropped and counted.
+ *
+ * The bus is meant for one task (the Arduino loop task); ISRs keep using
+ * their own lock-free queues (see LatencyProbe).
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class SceneModel;
+
+/** @brief Event slots: the event being dispatched plus those it raised */
+#define EVENT_POOL_SIZE 8
+
+/** @brief Most subscribers one bus can hold */
+#define EVENT_MAX_SUBSCRIBERS 16
+
+// ============================================================================
+// EVENTS
+// ============================================================================
+
+enum class EventType : uint8_t {
+  SampleReady,   ///< One raw ping (sample)
+  ReadingReady,  ///< One filtered reading (reading)
+  AlarmRaised,   ///< Buzzer on (reading: the distance that tripped it)
+  AlarmCleared,  ///< Buzzer off (reading)
+  SensorFault,   ///< Sensor fault bits changed, 0 = recovered (fault)
+  Calibrated,    ///< Startup calibration finished (calibrated)
+  Count
+};
+
+/** @brief Lowercase name of an event type ("sample", "alarm_raised", ...) */
+const char* eventTypeName(EventType type);
+
+/** @brief Subscription mask bit of one event type */
+inline uint32_t eventBit(EventType type) { return 1u << (uint8_t)type; }
+
+/** @brief Subscription mask of every event type */
+#define EVENT_MASK_ALL ((1u << (uint8_t)EventType::Count) - 1)
+
+struct Event {
+  EventType type;
+  uint64_t timeUs;  ///< When it was published (Hal::micros64())
+
+  /** @brief Payload; the member named in the EventType comment is set */
+  union {
+    struct {
+      uint32_t pingUs;  ///< Ping time as passed to DetectorListener::onPing()
+      uint32_t echoUs;  ///< Echo width, 0 on timeout
+    } sample;
+    struct {
+      float distanceCm;
+    } reading;
+    struct {
+      uint8_t faults;    ///< SENSOR_FAULT_* bits now
+      uint8_t previous;  ///< SENSOR_FAULT_* bits before
+    } fault;
+    struct {
+      const SceneModel* scene;  ///< Check scene->ready()
+    } calibrated;
+  };
+};
+
+/**
+ * @brief Receives one event
+ * @param event Pooled slot; valid until the handler returns
+ */
+typedef void (*EventHandler)(const Event& event, void* context);
+
+// ============================================================================
+// BUS
+// ============================================================================
+
+class EventBus {
+ public:
+  EventBus();
+
+  /**
+   * @param mask eventBit() of each type to receive, or EVENT_MASK_ALL
+   * @return false if the table is full
+   */
+  bool subscribe(uint32_t mask, EventHandler handler, void* context = nullptr);
+
+  /**
+   * @brief Reserves the next pool slot for an event of the given type
+   * @details Fill in the payload, then call publish(). Acquiring again
+   * before publishing reuses the same slot.
+   * @return The slot, or nullptr if the pool is full (the event is dropped)
+   */
+  Event* acquire(EventType type, uint64_t timeUs);
+
+  /**
+   * @brief Queues the acquired event and dispatches unless already dispatching
+   */
+  void publish();
+
+  /** @name Typed shorthands for acquire() + publish() */
+  ///@{
+  void publishSample(uint64_t timeUs, uint32_t pingUs, uint32_t echoUs);
+  void publishReading(EventType type, uint64_t timeUs, float distanceCm);
+  void publishFault(uint64_t timeUs, uint8_t faults, uint8_t previous);
+  void publishCalibrated(uint64_t timeUs, const SceneModel& scene);
+  ///@}
+
+  size_t subscribers() const { return subscriberCount_; }
+
+  /** @brief Events dispatched, and dropped for want of a pool slot */
+  uint32_t published() const { return published_; }
+  uint32_t dropped() const { return dropped_; }
+
+  /** @brief Most slots ever in use at once */
+  uint8_t maxDepth() const { return maxDepth_; }
+
+ private:
+  struct Subscriber {
+    uint32_t mask;
+    EventHandler handler;
+    void* context;
+  };
+
+  void dispatch();
+
+  Subscriber subscribers_[EVENT_MAX_SUBSCRIBERS];
+  size_t subscriberCount_;
+  Event pool_[EVENT_POOL_SIZE];
+  uint8_t head_;   ///< Oldest queued slot (being dispatched)
+  uint8_t count_;  ///< Queued slots, not counting an acquired one
+  bool acquired_;
+  bool dispatching_;
+  uint8_t maxDepth_;
+  uint32_t published_;
+  uint32_t dropped_;
+};
+
+#endif  // EVENT_BUS_H
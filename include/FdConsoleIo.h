@@ -0,0 +1,39 @@
+/**
+ * @file FdConsoleIo.h
+ * @brief ConsoleIo over POSIX file descriptors (pipes, terminals)
+ *
+ * @details The input descriptor is switched to non-blocking mode, so read()
+ * behaves like Serial.available()/Serial.read(): -1 when nothing is
+ * waiting. Input is fetched in small chunks to keep the system calls down.
+ * Host only.
+ */
+
+#ifndef FD_CONSOLE_IO_H
+#define FD_CONSOLE_IO_H
+
+#include "CommandConsole.h"
+
+class FdConsoleIo : public ConsoleIo {
+ public:
+  FdConsoleIo(int inFd, int outFd);
+
+  /** @brief Restores the input descriptor's blocking mode */
+  ~FdConsoleIo() override;
+
+  int read() override;
+  void write(const char* text, size_t length) override;
+
+  /** @brief True once the input end was closed and everything was read */
+  bool eof() const { return eof_; }
+
+ private:
+  int inFd_;
+  int outFd_;
+  int savedFlags_;
+  unsigned char buffer_[64];
+  size_t length_;
+  size_t position_;
+  bool eof_;
+};
+
+#endif  // FD_CONSOLE_IO_H
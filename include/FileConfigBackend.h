@@ -0,0 +1,29 @@
+/**
+ * @file FileConfigBackend.h
+ * @brief ConfigBackend in a host file, standing in for NVS
+ *
+ * @details The record is written to `<path>.tmp` and renamed over the file,
+ * so an interrupted save leaves the previous record intact, as an NVS
+ * commit does. Host only.
+ */
+
+#ifndef FILE_CONFIG_BACKEND_H
+#define FILE_CONFIG_BACKEND_H
+
+#include <string>
+
+#include "ConfigStore.h"
+
+class FileConfigBackend : public ConfigBackend {
+ public:
+  explicit FileConfigBackend(const std::string& path) : path_(path) {}
+
+  int read(uint8_t* out, size_t capacity) override;
+  bool write(const uint8_t* data, size_t length) override;
+  bool erase() override;
+
+ private:
+  std::string path_;
+};
+
+#endif  // FILE_CONFIG_BACKEND_H
@@ -0,0 +1,52 @@
+/**
+ * @file GroundTruth.h
+ * @brief Labelled ground truth for a recorded trace
+ *
+ * @details Labels live in a sidecar text file next to the trace
+ * (`session.trace` -> `session.labels`). The format is documented in
+ * docs/label_format.md; in short, one interval per line:
+ *
+ *   <startUs> <endUs> [intruder|ignore]
+ *
+ * `intruder` (the default) marks a real intrusion the detector must report.
+ * `ignore` marks a span (maintenance, someone testing the sensor) where
+ * alarms are neither required nor counted as false. Times are on the
+ * trace's timeline. Host only.
+ */
+
+#ifndef GROUND_TRUTH_H
+#define GROUND_TRUTH_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/** @brief First line written by saveLabels() */
+#define LABEL_FORMAT_HEADER "#! ids-labels 1"
+
+enum class LabelKind : uint8_t {
+  Intruder,  ///< An intruder was really present
+  Ignore     ///< Do not score alarms in this span
+};
+
+/** @brief One labelled interval */
+struct LabelInterval {
+  uint64_t startUs;
+  uint64_t endUs;
+  LabelKind kind = LabelKind::Intruder;
+};
+
+/** @brief Sidecar path for a trace ("x.trace" -> "x.labels") */
+std::string labelPathFor(const std::string& tracePath);
+
+/**
+ * @brief Loads labels, sorted by start time
+ * @return false if the file cannot be read or a line is malformed
+ */
+bool loadLabels(const std::string& path, std::vector<LabelInterval>& labels);
+
+/** @brief Writes labels in sidecar format */
+bool saveLabels(const std::string& path, const std::vector<LabelInterval>& labels);
+
+#endif  // GROUND_TRUTH_H
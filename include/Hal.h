@@ -0,0 +1,114 @@
+/**
+ * @file Hal.h
+ * @brief Hardware abstraction layer used by the detection logic
+ *
+ * @details The detector never calls Arduino functions directly; it goes
+ * through a Hal so the exact same getDistanceCm()/loop() code can run on the
+ * ESP32 (ArduinoHal), against a recorded trace (ReplayHal) or against the
+ * sensor simulator on the PC. Method names mirror the Arduino API they wrap.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Arduino.h provides these on target; define them for the native build.
+#ifndef HIGH
+#define HIGH 0x1
+#endif
+#ifndef LOW
+#define LOW 0x0
+#endif
+#ifndef INPUT
+#define INPUT 0x01
+#endif
+#ifndef OUTPUT
+#define OUTPUT 0x03
+#endif
+
+class Hal {
+ public:
+  virtual ~Hal() {}
+
+  virtual void pinMode(uint8_t pin, uint8_t mode) = 0;
+  virtual void digitalWrite(uint8_t pin, uint8_t level) = 0;
+
+  /**
+   * @brief Width of the next pulse at the given level, as pulseIn()
+   * @return Pulse width in µs, 0 on timeout
+   */
+  virtual unsigned long pulseIn(uint8_t pin, uint8_t level, unsigned long timeoutUs) = 0;
+
+  /**
+   * @brief Starts timing the next pulse at the given level without waiting
+   * @details Poll pulseDone() for the result; one pulse at a time. The
+   * default runs pulseIn() right here, so it still blocks and pulseDone() is
+   * true at once. ArduinoHal and SimHal return immediately and time the
+   * pulse in the background, which lets a cooperative task yield meanwhile.
+   */
+  virtual void startPulse(uint8_t pin, uint8_t level, unsigned long timeoutUs) {
+    pulseUs_ = pulseIn(pin, level, timeoutUs);
+  }
+
+  /**
+   * @brief Result of the last startPulse()
+   * @param widthUs Set to the pulse width in µs (0 on timeout) once done
+   * @return false while the pulse is still being timed
+   */
+  virtual bool pulseDone(unsigned long& widthUs) {
+    widthUs = pulseUs_;
+    return true;
+  }
+
+  virtual void delayMicroseconds(uint32_t us) = 0;
+  virtual void delay(uint32_t ms) = 0;
+
+  /**
+   * @brief Sleeps for about us with the CPU stopped, as ESP32 light sleep
+   * @details Outputs keep their level. Wake-up may come a little late; the
+   * default just delays.
+   */
+  virtual void lightSleep(uint32_t us) {
+    delay(us / 1000);
+    delayMicroseconds(us % 1000);
+  }
+
+  /**
+   * @name Timestamps
+   * All three run at the same rate whatever the CPU clock (esp_timer on the
+   * ESP32), so they stay valid across setCpuFrequencyMhz().
+   * @{
+   */
+
+  /** @brief Wrapping 32-bit millisecond clock, as millis() */
+  virtual unsigned long millis() = 0;
+
+  /** @brief Wrapping 32-bit microsecond clock, as micros() */
+  virtual unsigned long micros() = 0;
+
+  /** @brief Monotonic microseconds since boot that never wrap */
+  virtual uint64_t micros64() = 0;
+
+  /** @} */
+
+  /** @brief Current CPU clock in MHz, as getCpuFrequencyMhz() */
+  virtual uint32_t cpuFrequencyMhz() { return 240; }
+
+  /**
+   * @brief Changes the CPU clock, as setCpuFrequencyMhz()
+   * @details Never call it while a pulse is measured: pulseIn() counts CPU
+   * cycles and converts them with the clock at the end.
+   * @return false if the frequency is not supported (the default supports none)
+   */
+  virtual bool setCpuFrequencyMhz(uint32_t /*mhz*/) { return false; }
+
+ protected:
+  unsigned long pulseUs_ = 0;  ///< Result of the default startPulse()
+};
+
+#endif  // HAL_H
@@ -0,0 +1,54 @@
+/**
+ * @file HttpAlertTransport.h
+ * @brief AlertTransport that POSTs each batch to an HTTP endpoint
+ *
+ * @details Stands in for a webhook or a Firebase REST write. Every batch
+ * opens a non-blocking TCP connection to host:port (IPv4 address, no DNS),
+ * sends `POST <path>` with the JSON body and `Connection: close`, and reads
+ * the status line; poll() advances whichever of these steps is ready and
+ * never waits. A 2xx status is Delivered; anything else, a closed or
+ * refused connection, or no answer within the timeout is Failed.
+ * Host only.
+ */
+
+#ifndef HTTP_ALERT_TRANSPORT_H
+#define HTTP_ALERT_TRANSPORT_H
+
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+
+#include "AlertPublisher.h"
+
+class HttpAlertTransport : public AlertTransport {
+ public:
+  HttpAlertTransport(const std::string& host, uint16_t port, const std::string& path,
+                     uint32_t timeoutMs = 2000);
+  ~HttpAlertTransport() override;
+
+  bool start(const char* body, size_t length) override;
+  DeliveryStatus poll() override;
+
+  /** @brief HTTP status of the last answered request, 0 if none */
+  int lastStatus() const { return lastStatus_; }
+
+ private:
+  enum class Step : uint8_t { Idle, Connecting, Sending, Receiving };
+
+  DeliveryStatus finish(DeliveryStatus status);
+
+  std::string host_;
+  uint16_t port_;
+  std::string path_;
+  uint32_t timeoutMs_;
+  int fd_;
+  Step step_;
+  std::string request_;
+  size_t sent_;
+  std::string response_;
+  std::chrono::steady_clock::time_point deadline_;
+  int lastStatus_;
+};
+
+#endif  // HTTP_ALERT_TRANSPORT_H
@@ -0,0 +1,337 @@
+/**
+ * @file IntruderDetector.h
+ * @brief Hardware-independent intruder detection logic
+ *
+ * @details Holds the measurement routine (getDistanceCm()) and the
+ * hysteresis state machine (loop()) that used to live directly in the
+ * sketch. All hardware access goes through a Hal, and everything the sketch
+ * wants to report (readings, alarms, raw pings) is delivered to a
+ * DetectorListener, so the same code runs on the ESP32, in the replay engine
+ * and in the simulators.
+ */
+
+#ifndef INTRUDER_DETECTOR_H
+#define INTRUDER_DETECTOR_H
+
+#include <stdint.h>
+
+#include "Hal.h"
+#include "NoiseEstimator.h"
+#include "PowerScheduler.h"
+#include "SceneModel.h"
+
+class LoopProfiler;
+
+// ============================================================================
+// CONSTANTS
+// ============================================================================
+
+/**
+ * @brief Speed of sound in air at room temperature
+ * @details Value in centimeters per microsecond (cm/µs)
+ */
+#define SOUND_SPEED 0.034
+
+/** @brief Most pings a single reading can average */
+#define DETECTOR_MAX_SAMPLES 16
+
+/**
+ * @brief Converts an echo width to a distance
+ * @details The pulse covers the way to the object and back, hence the / 2.
+ * @param echoUs Echo width in µs
+ * @return Distance in centimeters
+ */
+inline float echoToDistanceCm(unsigned long echoUs) {
+  return (echoUs * SOUND_SPEED) / 2;
+}
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+/**
+ * @brief How the pings of one reading are combined
+ */
+enum class FilterType : uint8_t {
+  Mean,       ///< Sum of valid echoes / all pings (original behaviour)
+  ValidMean,  ///< Mean of the pings that returned an echo
+  Median      ///< Median of the pings that returned an echo
+};
+
+/** @brief Number of FilterType values */
+#define FILTER_TYPE_COUNT 3
+
+/**
+ * @brief Detector parameters; defaults reproduce the original sketch
+ */
+struct DetectorConfig {
+  uint8_t trigPin = 5;              ///< Sensor trigger pin
+  uint8_t echoPin = 18;             ///< Sensor echo pin
+  uint8_t buzzerPin = 17;           ///< Buzzer/vibration motor pin
+  uint8_t samplesPerReading = 5;    ///< Pings averaged per reading
+  uint32_t pingSpacingMs = 10;      ///< Delay after each ping
+  uint32_t pingJitterMs = 0;        ///< Spacing varies by up to ± this (same mean); 0 = fixed
+  uint32_t echoTimeoutUs = 30000;   ///< pulseIn() timeout (~5 m range)
+  uint32_t cyclePeriodMs = 500;     ///< Wait after each reading
+  float tripCm = 6;                 ///< Alarm when closer than this
+  float clearCm = 8;                ///< Clear when farther than this
+  FilterType filter = FilterType::Mean;  ///< Ping combination
+  uint8_t tripDwell = 1;            ///< Consecutive readings needed to alarm
+  uint8_t clearDwell = 1;           ///< Consecutive readings needed to clear
+  float trackGateCm = 0;            ///< Drop pings this far off the last reading; 0 = off
+  SceneConfig scene;                ///< Baseline-relative thresholds (off by default)
+  NoiseConfig noise;                ///< Noise-sized hysteresis gap (off by default)
+  PowerConfig power;                ///< Light sleep in the cycle wait (off by default)
+};
+
+/** @brief Lowercase name of a filter type ("mean", "validmean", "median") */
+const char* filterTypeName(FilterType filter);
+
+/**
+ * @brief Parses a filter type name as returned by filterTypeName()
+ * @return false if the name is unknown
+ */
+bool parseFilterType(const char* name, FilterType& filter);
+
+/**
+ * @brief Longest a loop() cycle with this configuration takes
+ * @details Every ping timing out after the longest spacing, then the
+ * longest cycle wait (calibration, idle or normal period); listener output
+ * (Serial printing) comes on top.
+ */
+uint32_t detectorCycleBudgetUs(const DetectorConfig& config);
+
+// ============================================================================
+// LISTENER
+// ============================================================================
+
+/**
+ * @brief Receives detector output; every method defaults to doing nothing
+ */
+class DetectorListener {
+ public:
+  virtual ~DetectorListener() {}
+
+  /** @brief One raw ping; echoUs is 0 on timeout */
+  virtual void onPing(uint32_t /*timeUs*/, uint32_t /*echoUs*/) {}
+
+  /** @brief One averaged reading, before the state machine runs */
+  virtual void onReading(float /*distanceCm*/) {}
+
+  /** @brief The alarm was raised (buzzer on) */
+  virtual void onIntruder(float /*distanceCm*/) {}
+
+  /** @brief The alarm was cleared (buzzer off) */
+  virtual void onClear(float /*distanceCm*/) {}
+
+  /** @brief The startup calibration finished (check scene.ready()) */
+  virtual void onCalibrated(const SceneModel& /*scene*/) {}
+};
+
+// ============================================================================
+// DETECTOR
+// ============================================================================
+
+class IntruderDetector {
+ public:
+  explicit IntruderDetector(Hal& hal, const DetectorConfig& config = DetectorConfig());
+
+  /** @brief Configures the pins and turns the buzzer off */
+  void begin();
+
+  /**
+   * @brief Measures distance using the ultrasonic sensor with noise reduction
+   * @details With pingJitterMs the spacing after each ping is drawn
+   * uniformly from spacing ± jitter, so late echoes of the previous ping
+   * (multipath, other sensors) land at a different distance every time
+   * instead of forming a consistent ghost. trackGateCm then drops those
+   * scattered pings (see gateEchoes()).
+   * @return Average distance in centimeters (0 if no valid readings)
+   */
+  float getDistanceCm();
+
+  /**
+   * @brief Runs one measurement cycle: measure, update alarm state, wait
+   * @details While the scene model calibrates, readings only go to the model
+   * and the alarm state is left alone. The wait goes through the power
+   * scheduler: cyclePeriodMs, or power.idlePeriodMs while nothing is
+   * happening (see cycleWaitMs()). Just before it the CPU clock is set for
+   * the wait and the next reading (see PowerScheduler::setQuiet()).
+   */
+  void loop();
+
+  /**
+   * @name Cycle steps
+   * loop() is getDistanceCm(), processReading() and the cycle wait; a
+   * caller that does the waiting itself (DetectorTask) uses these instead:
+   * per ping trigger(), the echo, recordPing() and nextPingSpacingUs(); then
+   * combinePings() and processReading(); then cycleWaitMs().
+   * @{
+   */
+
+  /** @brief Pings per reading, limited to DETECTOR_MAX_SAMPLES */
+  uint8_t samplesPerReading() const {
+    return config_.samplesPerReading < DETECTOR_MAX_SAMPLES ? config_.samplesPerReading
+                                                            : DETECTOR_MAX_SAMPLES;
+  }
+
+  /**
+   * @brief Sends one 10 µs trigger pulse
+   * @return Ping time (Hal::micros()) for recordPing()
+   */
+  uint32_t trigger();
+
+  /** @brief Reports one ping's echo (0 on timeout) to the listener */
+  void recordPing(uint32_t pingTime, unsigned long echoUs) {
+    listener_->onPing(pingTime, (uint32_t)echoUs);
+  }
+
+  /** @brief Wait after a ping: pingSpacingMs, jittered if configured */
+  uint32_t nextPingSpacingUs();
+
+  /**
+   * @brief Gates and filters the pings of one reading (see gateEchoes())
+   * @return Distance in centimeters (0 if no valid readings)
+   */
+  float combinePings(unsigned long* echoUs, uint8_t count);
+
+  /**
+   * @brief Reports a reading and runs the calibration or alarm state machine
+   * @details Everything loop() does after measuring, except the wait; the
+   * CPU clock is set for the wait.
+   */
+  void processReading(float distanceCm);
+
+  /** @} */
+
+  /**
+   * @brief Combines the pings of one reading according to config().filter
+   * @param echoUs Echo widths in µs, 0 for timed-out pings
+   * @param count Number of pings
+   * @return Distance in centimeters (0 if no valid readings)
+   */
+  float filterReading(const unsigned long* echoUs, uint8_t count) const;
+
+  /**
+   * @brief Drops pings that the rest of the reading does not back up
+   * @details Each valid ping gets one vote from every valid ping within
+   * trackGateCm of it (itself included); timed-out pings vote against. Pings
+   * without a strict majority are set to 0 (no echo); a tie is kept only if
+   * the track (the previous reading) is within the gate too. A real object,
+   * new or not, shows up in most pings and keeps them; scattered ghost
+   * echoes are dropped. Does nothing with the gate off.
+   * @return Number of pings dropped
+   */
+  uint8_t gateEchoes(unsigned long* echoUs, uint8_t count, float trackCm) const;
+
+  /**
+   * @brief Applies one reading to the hysteresis state machine
+   * @details Uses the thresholds from thresholds().
+   * @return true if the alarm state changed
+   */
+  bool update(float distanceCm);
+
+  /**
+   * @brief Current trip and clear distances
+   * @details The scene model's once it is ready, the fixed tripCm/clearCm
+   * otherwise; with config().noise.adaptive, clear is then moved to trip
+   * plus the noise-sized gap.
+   */
+  void thresholds(float& tripCm, float& clearCm) const;
+
+  /**
+   * @brief True while nothing is going on
+   * @details Calibrated, no alarm, no trip pending and the last reading not
+   * within power.approachMarginCm of the trip distance. Selects the idle
+   * cycle wait and the idle CPU clock.
+   */
+  bool quiet() const;
+
+  /**
+   * @brief Wait at the end of the current cycle
+   * @details scene.calibrationPeriodMs (if set) while calibrating;
+   * power.idlePeriodMs (if set) while quiet(); cyclePeriodMs otherwise, so
+   * an approaching intruder is sampled at the full rate.
+   */
+  uint32_t cycleWaitMs() const;
+
+  /** @brief detectorCycleBudgetUs() of the current configuration */
+  uint32_t cycleBudgetUs() const { return detectorCycleBudgetUs(config_); }
+
+  bool intruder() const { return intruder_; }
+  float distanceCm() const { return distanceCm_; }
+
+  const DetectorConfig& config() const { return config_; }
+
+  /** @brief Replaces the configuration (restarts the scene calibration) */
+  void setConfig(const DetectorConfig& config);
+
+  /**
+   * @brief Replaces the configuration while running
+   * @details Unlike setConfig() the learned scene and the noise estimate are
+   * kept; changed margins apply from the next reading. The pins, the
+   * calibration length and the noise settings stay as they are.
+   */
+  void tune(const DetectorConfig& config);
+
+  /**
+   * @brief Arms or disarms the alarm
+   * @details Disarmed, readings are still taken and reported but never raise
+   * the alarm and the scene does not adapt. Disarming clears an active alarm
+   * (onClear() is called).
+   */
+  void setArmed(bool armed);
+  bool armed() const { return armed_; }
+
+  /** @brief True once readings can raise the alarm: armed and calibrated */
+  bool protecting() const { return armed_ && !scene_.calibrating(); }
+
+  /** @brief Baseline model; restart calibration with scene().start() */
+  SceneModel& scene() { return scene_; }
+  const SceneModel& scene() const { return scene_; }
+
+  /** @brief Pings dropped by the track gate since begin() */
+  uint32_t gatedPings() const { return gatedPings_; }
+
+  /** @brief Cycle-wait scheduler and its sleep counters */
+  const PowerScheduler& power() const { return power_; }
+
+  /** @brief Reading-noise estimate (fed even when not adaptive) */
+  const NoiseEstimator& noise() const { return noise_; }
+
+  /** @brief Sets the output listener; nullptr restores the silent default */
+  void setListener(DetectorListener* listener);
+
+  /**
+   * @brief Times the phases of getDistanceCm()/loop() into a profiler
+   * @param profiler Profiler to record into; nullptr (default) disables timing
+   */
+  void setProfiler(LoopProfiler* profiler) { profiler_ = profiler; }
+
+ private:
+  /** @brief Ping jitter, limited to the spacing so it never goes negative */
+  uint32_t jitterMs() const {
+    return config_.pingJitterMs < config_.pingSpacingMs ? config_.pingJitterMs
+                                                        : config_.pingSpacingMs;
+  }
+
+  /** @brief Next spacing drawn from pingSpacingMs ± jitterMs(), in µs */
+  uint32_t jitteredSpacingUs();
+
+  Hal& hal_;
+  DetectorConfig config_;
+  DetectorListener* listener_;
+  LoopProfiler* profiler_;
+  SceneModel scene_;
+  NoiseEstimator noise_;
+  PowerScheduler power_;
+  float distanceCm_;
+  bool intruder_;
+  bool armed_;
+  uint8_t tripCount_;
+  uint8_t clearCount_;
+  uint32_t random_;     ///< xorshift32 state for the ping jitter
+  uint32_t gatedPings_;
+};
+
+#endif  // INTRUDER_DETECTOR_H
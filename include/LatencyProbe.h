@@ -0,0 +1,92 @@
+/**
+ * @file LatencyProbe.h
+ * @brief End-to-end detection latency: ground-truth event to buzzer on
+ *
+ * @details The probe pairs two kinds of timestamps (µs, one monotonic clock):
+ * - events: the moment an object really entered the zone. On the device they
+ *   come from an external trigger input (light barrier, push button) via an
+ *   interrupt; on the host from the simulator's known intrusion times.
+ * - alarms: the moment the buzzer pin went HIGH.
+ *
+ * The first event after the previous alarm is matched with the next alarm,
+ * and the difference goes into a LogHistogram in µs. Further events before
+ * that alarm (a bouncing trigger, the same intruder again) and events while
+ * the alarm is already on are ignored. An event still unmatched after the
+ * miss timeout counts as missed; an alarm with no event waiting counts as a
+ * false alarm.
+ *
+ * markEvent() only pushes into a lock-free ring buffer, so it may be called
+ * from an ISR while the loop calls everything else.
+ */
+
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LogHistogram.h"
+#include "RingBuffer.h"
+
+/** @brief Events that can wait between two polls */
+#define LATENCY_EVENT_QUEUE 16
+
+/** @brief Default time after which an unmatched event counts as missed */
+#define LATENCY_MISS_TIMEOUT_US 10000000ull
+
+class LatencyProbe {
+ public:
+  explicit LatencyProbe(uint64_t missTimeoutUs = LATENCY_MISS_TIMEOUT_US);
+
+  /**
+   * @brief Records a ground-truth event (ISR safe, single producer)
+   * @return false if the queue was full and the event was dropped
+   */
+  bool markEvent(uint64_t timeUs) {
+    if (events_.push(timeUs)) return true;
+    dropped_++;
+    return false;
+  }
+
+  /** @brief The alarm was raised at timeUs */
+  void markAlarm(uint64_t timeUs);
+
+  /** @brief The alarm was cleared at timeUs */
+  void markClear(uint64_t timeUs);
+
+  /** @brief Consumes queued events up to nowUs and expires missed ones */
+  void poll(uint64_t nowUs);
+
+  /** @brief Clears results (queued events are kept) */
+  void reset();
+
+  /** @brief Event-to-alarm latency in µs of every detected event */
+  const LogHistogram& histogram() const { return latency_; }
+
+  uint32_t detected() const { return latency_.count(); }
+  uint32_t missed() const { return missed_; }
+  uint32_t falseAlarms() const { return falseAlarms_; }
+  uint32_t dropped() const { return dropped_; }
+
+  /**
+   * @brief Formats detected/missed/false alarm counts
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t formatCounts(char* out, size_t capacity) const;
+
+ private:
+  void drain(uint64_t uptoUs);
+  void expire(uint64_t nowUs);
+
+  RingBuffer<uint64_t, LATENCY_EVENT_QUEUE> events_;
+  LogHistogram latency_;
+  uint64_t missTimeoutUs_;
+  uint64_t pendingUs_;
+  bool pending_;
+  bool alarmActive_;
+  uint32_t missed_;
+  uint32_t falseAlarms_;
+  volatile uint32_t dropped_;  ///< Written by the event producer only
+};
+
+#endif  // LATENCY_PROBE_H
@@ -0,0 +1,113 @@
+/**
+ * @file LogHistogram.h
+ * @brief Fixed-memory latency histogram with logarithmic buckets
+ *
+ * @details Values are unsigned 32-bit durations in any unit (cycles, ns,
+ * µs). Each power of two is split into LOG_HISTOGRAM_SUB_BUCKETS linear
+ * buckets, so every bucket is at most 25% wide relative to its value while
+ * the whole 32-bit range fits in LOG_HISTOGRAM_BUCKETS counters (~500 bytes).
+ * Values below LOG_HISTOGRAM_SUB_BUCKETS get exact buckets.
+ *
+ * record() is a handful of instructions and never allocates, so it can run
+ * in the detection loop on the ESP32.
+ */
+
+#ifndef LOG_HISTOGRAM_H
+#define LOG_HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Prefix of histogram export lines (see formatHistogramLine()) */
+#define HISTOGRAM_LINE_PREFIX "@H "
+
+/** @brief log2 of the number of linear buckets per power of two */
+#define LOG_HISTOGRAM_SUB_BITS 2
+
+/** @brief Linear buckets per power of two */
+#define LOG_HISTOGRAM_SUB_BUCKETS (1 << LOG_HISTOGRAM_SUB_BITS)
+
+/** @brief Total number of buckets covering 0 .. UINT32_MAX */
+#define LOG_HISTOGRAM_BUCKETS ((32 - LOG_HISTOGRAM_SUB_BITS + 1) << LOG_HISTOGRAM_SUB_BITS)
+
+class LogHistogram {
+ public:
+  LogHistogram() { reset(); }
+
+  /** @brief Adds one value */
+  void record(uint32_t value) {
+    counts_[bucketOf(value)]++;
+    count_++;
+    sum_ += value;
+    if (value < min_) min_ = value;
+    if (value > max_) max_ = value;
+  }
+
+  /** @brief Forgets every value */
+  void reset();
+
+  uint32_t count() const { return count_; }
+  uint32_t min() const { return count_ ? min_ : 0; }
+  uint32_t max() const { return max_; }
+  uint64_t sum() const { return sum_; }
+  double mean() const { return count_ ? (double)sum_ / count_ : 0; }
+
+  /**
+   * @brief Approximate percentile
+   * @param p Percentile in [0, 100]
+   * @return Upper bound of the bucket holding the p-th value (never above
+   *         max()), 0 if empty
+   */
+  uint32_t percentile(double p) const;
+
+  /** @brief Adds every value of another histogram */
+  void merge(const LogHistogram& other);
+
+  /** @brief Number of values in bucket i */
+  uint32_t bucketCount(size_t i) const { return counts_[i]; }
+
+  /** @brief Smallest value that lands in bucket i */
+  static uint32_t bucketLow(size_t i);
+
+  /** @brief Largest value that lands in bucket i */
+  static uint32_t bucketHigh(size_t i);
+
+  /** @brief Bucket a value lands in */
+  static size_t bucketOf(uint32_t value) {
+    if (value < LOG_HISTOGRAM_SUB_BUCKETS) return value;
+    unsigned msb = 31 - __builtin_clz(value);
+    unsigned shift = msb - LOG_HISTOGRAM_SUB_BITS;
+    return ((size_t)(shift + 1) << LOG_HISTOGRAM_SUB_BITS) +
+           ((value >> shift) & (LOG_HISTOGRAM_SUB_BUCKETS - 1));
+  }
+
+ private:
+  uint32_t counts_[LOG_HISTOGRAM_BUCKETS];
+  uint32_t count_;
+  uint32_t min_;
+  uint32_t max_;
+  uint64_t sum_;
+};
+
+/** @brief Column titles matching formatHistogramSummary() */
+const char* histogramSummaryHeader();
+
+/**
+ * @brief Formats count, min, mean, p50/p90/p99 and max in µs
+ * @param ticksPerUs Histogram units per microsecond
+ * @return Characters written (output is always NUL terminated)
+ */
+size_t formatHistogramSummary(const char* name, uint32_t ticksPerUs, const LogHistogram& h,
+                              char* out, size_t capacity);
+
+/**
+ * @brief Formats a histogram as one export line
+ * @details `@H <name> <ticksPerUs> <low>:<count> ...` with one pair per
+ * non-empty bucket; low is the bucket's smallest value in histogram units.
+ * Output that does not fit is cut at a pair boundary.
+ * @return Characters written (output is always NUL terminated)
+ */
+size_t formatHistogramLine(const char* name, uint32_t ticksPerUs, const LogHistogram& h,
+                           char* out, size_t capacity);
+
+#endif  // LOG_HISTOGRAM_H
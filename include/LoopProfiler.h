@@ -0,0 +1,153 @@
+/**
+ * @file LoopProfiler.h
+ * @brief Per-phase timing of the detection loop
+ *
+ * @details The detector and the sketch wrap each phase of a cycle in a
+ * ProfileScope. The scope reads a free-running tick counter on entry and exit
+ * and records the difference in the phase's LogHistogram:
+ * - on the ESP32 the CPU cycle counter (one tick per CPU clock)
+ * - on the PC std::chrono::steady_clock (one tick per nanosecond)
+ *
+ * All memory is fixed (one histogram per phase) and a scope with a null
+ * profiler does nothing, so profiling can be left compiled in. Phases may
+ * nest; the Loop phase covers a whole cycle including the others.
+ *
+ * The tick counter is 32 bits wide and wraps (every ~18 s at 240 MHz), which
+ * is fine for phases well under that. The ESP32's cycle counter runs at the
+ * CPU clock, which the power scheduler may change between cycles, so each
+ * scope is converted to fixed-rate ticks (ticksPerUs(), 240 per µs on the
+ * ESP32) with the clock it ran at. A scope that spans a clock change is not
+ * recorded; the detector switches just before the cycle wait, so that only
+ * drops the Loop sample of a cycle that switches.
+ */
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "LogHistogram.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief Phases of one detection cycle
+ */
+enum class LoopPhase : uint8_t {
+  Trigger,     ///< Trigger pulse (digitalWrite + delayMicroseconds)
+  EchoWait,    ///< pulseIn() waiting for the echo
+  PingDelay,   ///< delay() between pings
+  Filter,      ///< filterReading() float math
+  Update,      ///< Hysteresis state machine and buzzer write
+  Report,      ///< Listener output (Serial printing on the device)
+  Telemetry,   ///< Telemetry block output
+  CycleDelay,  ///< delay() at the end of the cycle
+  Loop,        ///< A whole cycle
+  Count
+};
+
+/** @brief Lowercase name of a phase ("echo_wait", ...) */
+const char* loopPhaseName(LoopPhase phase);
+
+class LoopProfiler {
+ public:
+  /** @brief Current tick count (wraps) */
+  static uint32_t now() {
+#ifdef ARDUINO
+    return ESP.getCycleCount();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  /** @brief Ticks per microsecond of now() at the current CPU clock */
+  static uint32_t clockTicksPerUs() {
+#ifdef ARDUINO
+    return getCpuFrequencyMhz();
+#else
+    return 1000;
+#endif
+  }
+
+  /** @brief Ticks per microsecond of the recorded histograms */
+  static uint32_t ticksPerUs() {
+#ifdef ARDUINO
+    return 240;
+#else
+    return 1000;
+#endif
+  }
+
+  /**
+   * @brief Records one phase duration
+   * @param ticks Duration in now() ticks
+   * @param clockTicksPerUs clockTicksPerUs() while the phase ran
+   */
+  void record(LoopPhase phase, uint32_t ticks, uint32_t clockTicksPerUs) {
+    if (clockTicksPerUs != ticksPerUs()) {
+      ticks = (uint32_t)((uint64_t)ticks * ticksPerUs() / clockTicksPerUs);
+    }
+    histograms_[(size_t)phase].record(ticks);
+  }
+
+  const LogHistogram& histogram(LoopPhase phase) const {
+    return histograms_[(size_t)phase];
+  }
+
+  /** @brief Clears every phase */
+  void reset();
+
+  /**
+   * @brief Formats a phase's summary in µs (see formatHistogramSummary())
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t formatPhase(LoopPhase phase, char* out, size_t capacity) const;
+
+  /**
+   * @brief Formats a phase's `@H` export line (see formatHistogramLine())
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t formatHistogram(LoopPhase phase, char* out, size_t capacity) const;
+
+ private:
+  LogHistogram histograms_[(size_t)LoopPhase::Count];
+};
+
+/**
+ * @brief Times the enclosing block as one phase
+ */
+class ProfileScope {
+ public:
+  ProfileScope(LoopProfiler* profiler, LoopPhase phase)
+      : profiler_(profiler), phase_(phase), start_(0), clock_(0) {
+    if (__builtin_expect(profiler != nullptr, 0)) {
+      clock_ = LoopProfiler::clockTicksPerUs();
+      start_ = LoopProfiler::now();
+    }
+  }
+
+  ~ProfileScope() {
+    if (__builtin_expect(profiler_ != nullptr, 0)) {
+      uint32_t ticks = LoopProfiler::now() - start_;
+      if (LoopProfiler::clockTicksPerUs() == clock_) profiler_->record(phase_, ticks, clock_);
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  LoopProfiler* profiler_;
+  LoopPhase phase_;
+  uint32_t start_;
+  uint32_t clock_;  ///< clockTicksPerUs() at the start
+};
+
+#endif  // LOOP_PROFILER_H
@@ -0,0 +1,144 @@
+/**
+ * @file Metrics.h
+ * @brief Fixed-memory runtime metrics: counters, gauges, histograms, probes
+ *
+ * @details Metric objects are plain globals owned by whoever updates them; a
+ * MetricsRegistry only holds up to METRICS_MAX named pointers to them, so
+ * nothing is allocated and an update never touches the registry:
+ * - Counter: monotonically increasing uint32_t, relaxed atomic add
+ * - Gauge: last value of a float, relaxed atomic store
+ * - Histogram: a LogHistogram; not atomic, so it must be updated and read
+ *   from the same task (the loop task on the device)
+ * - Probe: a function read only when a snapshot is taken, for counts that
+ *   already live elsewhere (e.g. TelemetryStream::overflows())
+ *
+ * A snapshot is either text (one `name kind value` line per metric) or a
+ * compact little-endian binary record, printed by the firmware as an `@M`
+ * hex line:
+ *
+ *   u16 magic 'IM' (0x4D49), u8 version (1), u8 metric count, u32 uptime ms,
+ *   then per metric: u8 kind, u8 name length, name bytes, value
+ *   - counter/probe: u32
+ *   - gauge: float32
+ *   - histogram: u32 count, min, max, p50, p90, p99, u64 sum
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "LogHistogram.h"
+
+/** @brief Most metrics one registry can hold */
+#define METRICS_MAX 24
+
+/** @brief Longest metric name kept in a binary snapshot */
+#define METRICS_NAME_MAX 31
+
+/** @brief Largest possible binary snapshot */
+#define METRICS_SNAPSHOT_MAX_BYTES (8 + METRICS_MAX * (2 + METRICS_NAME_MAX + 32))
+
+/** @brief Prefix of binary snapshot lines */
+#define METRICS_SNAPSHOT_PREFIX "@M "
+
+/** @brief First two bytes of a binary snapshot */
+#define METRICS_SNAPSHOT_MAGIC 0x4D49
+
+/** @brief Binary snapshot layout version */
+#define METRICS_SNAPSHOT_VERSION 1
+
+enum class MetricKind : uint8_t { Counter, Gauge, Histogram, Probe };
+
+/** @brief Lowercase name of a metric kind */
+const char* metricKindName(MetricKind kind);
+
+class Counter {
+ public:
+  Counter() : value_(0) {}
+  void add(uint32_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  uint32_t value() const { return value_.load(std::memory_order_relaxed); }
+  void reset() { value_.store(0, std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint32_t> value_;
+};
+
+class Gauge {
+ public:
+  Gauge() : value_(0) {}
+  void set(float value) { value_.store(value, std::memory_order_relaxed); }
+  float value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<float> value_;
+};
+
+/** @brief Reads a value kept elsewhere; called only for snapshots */
+typedef uint32_t (*MetricProbe)(const void* context);
+
+class MetricsRegistry {
+ public:
+  MetricsRegistry() : count_(0) {}
+
+  /** @return false if the registry is full */
+  bool addCounter(const char* name, Counter* counter);
+  bool addGauge(const char* name, Gauge* gauge);
+  bool addHistogram(const char* name, LogHistogram* histogram);
+  bool addProbe(const char* name, MetricProbe probe, const void* context);
+
+  size_t size() const { return count_; }
+
+  /** @brief Zeroes every counter and histogram (gauges and probes are kept) */
+  void reset();
+
+  /**
+   * @brief Formats metric i as one text line (`name kind value...`)
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t formatEntry(size_t i, char* out, size_t capacity) const;
+
+  /**
+   * @brief Writes a binary snapshot (layout in the file comment)
+   * @param uptimeMs Stored in the header
+   * @return Bytes written, 0 if capacity is too small
+   */
+  size_t encodeSnapshot(uint32_t uptimeMs, uint8_t* out, size_t capacity) const;
+
+ private:
+  struct Entry {
+    const char* name;
+    MetricKind kind;
+    void* target;
+    const void* context;  ///< Probes only
+  };
+
+  bool add(const char* name, MetricKind kind, void* target, const void* context);
+
+  Entry entries_[METRICS_MAX];
+  size_t count_;
+};
+
+/**
+ * @brief Receives the metrics of a decoded binary snapshot
+ */
+class MetricsSnapshotVisitor {
+ public:
+  virtual ~MetricsSnapshotVisitor() {}
+  virtual void onValue(const char* name, MetricKind kind, double value) = 0;
+  virtual void onHistogram(const char* name, uint32_t count, uint32_t min, uint32_t max,
+                           uint32_t p50, uint32_t p90, uint32_t p99, uint64_t sum) = 0;
+};
+
+/**
+ * @brief Decodes a binary snapshot
+ * @param uptimeMs Receives the header's uptime
+ * @return false if the data is truncated or not a version 1 snapshot
+ */
+bool decodeMetricsSnapshot(const uint8_t* data, size_t length, uint32_t& uptimeMs,
+                           MetricsSnapshotVisitor& visitor);
+
+#endif  // METRICS_H
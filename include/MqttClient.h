@@ -0,0 +1,207 @@
+/**
+ * @file MqttClient.h
+ * @brief Minimal non-blocking MQTT 3.1.1 publisher with per-topic QoS
+ *
+ * @details Only what the detector needs: CONNECT (clean session), PUBLISH
+ * at QoS 0 or 1, one SUBSCRIBE (for dashboards and the host tools),
+ * PINGREQ keep-alive. Nothing is allocated and no call waits on the
+ * network:
+ *
+ * - publish() encodes the packet into one of MQTT_QUEUE_SLOTS fixed slots
+ *   and returns; QoS comes from the topic (addTopic())
+ * - poll() advances the connection, writes as many queued bytes as the
+ *   MqttLink takes, reads acknowledgements and pings, and reconnects after
+ *   reconnectMs when the link breaks
+ * - QoS 1 slots are kept until PUBACK and sent again (DUP) after
+ *   ackTimeoutMs or a reconnect; when every slot is taken a QoS 1 message
+ *   pushes out the oldest unsent QoS 0 one, otherwise the new message is
+ *   dropped and counted
+ *
+ * Queued QoS 1 packets go out before QoS 0 ones, so an alarm does not wait
+ * behind sample blocks; within a QoS level packets go out in publish()
+ * order, resent ones by their first publish.
+ */
+
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Messages queued or waiting for PUBACK */
+#define MQTT_QUEUE_SLOTS 8
+
+/** @brief Largest encoded packet; holds a 256-byte sample block and its topic */
+#define MQTT_PACKET_MAX 320
+
+/** @brief Topics one client can publish to */
+#define MQTT_MAX_TOPICS 4
+
+/** @brief Longest topic name or subscription filter */
+#define MQTT_TOPIC_MAX 48
+
+/**
+ * @brief Non-blocking byte stream to the broker (TCP socket, WiFiClient...)
+ */
+class MqttLink {
+ public:
+  virtual ~MqttLink() {}
+
+  /** @brief Starts connecting; false if that failed at once */
+  virtual bool open() = 0;
+
+  /** @return 1 connected, 0 still connecting, -1 failed or closed */
+  virtual int status() = 0;
+
+  /** @return Bytes taken (0 if it would block), -1 if the link broke */
+  virtual int write(const uint8_t* data, size_t length) = 0;
+
+  /** @return Bytes read (0 if none are waiting), -1 if the link broke */
+  virtual int read(uint8_t* out, size_t capacity) = 0;
+
+  virtual void close() = 0;
+};
+
+struct MqttOptions {
+  const char* clientId = "intruder-detector";
+  uint16_t keepAliveS = 30;      ///< PINGREQ after half of this without traffic
+  uint32_t reconnectMs = 2000;   ///< Wait before reconnecting a broken link
+  uint32_t ackTimeoutMs = 5000;  ///< Resend a QoS 1 message without PUBACK
+};
+
+/** @brief Called from poll() for every message on the subscription */
+typedef void (*MqttMessageHandler)(const char* topic, const uint8_t* payload, size_t length,
+                                   void* context);
+
+/**
+ * @brief Writes the MQTT variable-length "remaining length" field
+ * @return Bytes written (1-4)
+ */
+size_t mqttPutLength(uint8_t* out, size_t length);
+
+/**
+ * @brief Reads a remaining length field
+ * @return Bytes it took, 0 if more input is needed, -1 if malformed
+ */
+int mqttGetLength(const uint8_t* in, size_t available, size_t& length);
+
+/**
+ * @brief Encodes a PUBLISH packet
+ * @return Packet size, 0 if it does not fit in capacity
+ */
+size_t mqttEncodePublish(uint8_t* out, size_t capacity, const char* topic,
+                         const uint8_t* payload, size_t length, uint8_t qos, uint16_t packetId);
+
+class MqttClient {
+ public:
+  explicit MqttClient(MqttLink& link, const MqttOptions& options = MqttOptions());
+
+  /**
+   * @brief Registers a topic to publish to
+   * @param qos 0 (at most once) or 1 (at least once)
+   * @return Topic handle for publish(), -1 if the table is full or the name too long
+   */
+  int addTopic(const char* name, uint8_t qos);
+
+  /**
+   * @brief Subscribes to filter on every (re)connect; one subscription per client
+   * @return false if the filter is too long
+   */
+  bool subscribe(const char* filter, MqttMessageHandler handler, void* context = nullptr);
+
+  /**
+   * @brief Queues one message; works while disconnected
+   * @return false if it was dropped (no free slot, too big, unknown topic)
+   */
+  bool publish(int topic, const uint8_t* payload, size_t length);
+
+  /** @brief Advances connecting, sending and receiving; never blocks */
+  void poll(uint32_t nowMs);
+
+  /** @brief CONNACK received on the current link */
+  bool connected() const { return state_ == State::Connected; }
+
+  /** @brief Slots in use (queued or waiting for PUBACK) */
+  size_t queued() const;
+
+  /** @name Counters since construction */
+  ///@{
+  uint32_t published() const { return published_; }  ///< Accepted by publish()
+  uint32_t sent() const { return sent_; }            ///< PUBLISH packets written out
+  uint32_t acked() const { return acked_; }          ///< PUBACKs for our QoS 1 messages
+  uint32_t resent() const { return resent_; }        ///< QoS 1 packets sent again
+  uint32_t dropped() const { return dropped_; }      ///< Refused or pushed out
+  uint32_t received() const { return received_; }    ///< Messages on the subscription
+  uint32_t connects() const { return connects_; }    ///< CONNACKs accepted
+  uint32_t attempts() const { return attempts_; }    ///< Connections started
+  ///@}
+
+  /** @brief One-line summary of the state and counters */
+  size_t format(char* out, size_t capacity) const;
+
+ private:
+  enum class State : uint8_t { Idle, Connecting, Handshake, Connected };
+  enum class SlotState : uint8_t { Free, Queued, AwaitingAck };
+
+  struct Topic {
+    char name[MQTT_TOPIC_MAX + 1];
+    uint8_t qos;
+  };
+
+  struct Slot {
+    uint8_t packet[MQTT_PACKET_MAX];
+    uint16_t length;
+    uint16_t packetId;
+    uint32_t order;   ///< publish() order; lowest queued goes first
+    uint32_t sentMs;  ///< When the last copy was written (QoS 1)
+    SlotState state;
+    uint8_t qos;
+  };
+
+  void disconnect(uint32_t nowMs);
+  void onConnected(uint32_t nowMs);
+  void send(uint32_t nowMs);
+  void receive(uint32_t nowMs);
+  void handlePacket(uint8_t header, const uint8_t* body, size_t length, uint32_t nowMs);
+  int nextSlot() const;
+  uint16_t nextPacketId();
+  bool queueControl(const uint8_t* packet, size_t length);
+
+  MqttLink& link_;
+  MqttOptions options_;
+  State state_;
+  uint32_t stateMs_;
+  uint32_t lastWriteMs_;
+  uint32_t lastReadMs_;
+  bool pingPending_;
+
+  Topic topics_[MQTT_MAX_TOPICS];
+  size_t topicCount_;
+  char filter_[MQTT_TOPIC_MAX + 1];
+  MqttMessageHandler handler_;
+  void* handlerContext_;
+
+  Slot slots_[MQTT_QUEUE_SLOTS];
+  uint32_t nextOrder_;
+  uint16_t nextPacketId_;
+
+  /** @brief Packet being written: a slot, or control packets when current_ < 0 */
+  int current_;
+  size_t offset_;
+  uint8_t control_[MQTT_TOPIC_MAX + 64];
+  size_t controlLength_;
+
+  uint8_t rx_[MQTT_PACKET_MAX];
+  size_t rxLength_;
+
+  uint32_t published_;
+  uint32_t sent_;
+  uint32_t acked_;
+  uint32_t resent_;
+  uint32_t dropped_;
+  uint32_t received_;
+  uint32_t connects_;
+  uint32_t attempts_;
+};
+
+#endif  // MQTT_CLIENT_H
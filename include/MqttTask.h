@@ -0,0 +1,54 @@
+/**
+ * @file MqttTask.h
+ * @brief MQTT send pipeline, run beside the measurement
+ *
+ * @details Each pass hands a finished sample block (if any) to the
+ * MqttClient and polls the client, which writes what the socket takes
+ * without waiting. Under a CoopScheduler it runs every periodUs in the
+ * gaps of DetectorTask; the sequential loop() calls pump() after each
+ * cycle instead. Sample blocks are published as a 4-byte little-endian
+ * sequence number followed by the SampleCodec block (the `@B` line's
+ * content in binary), so a subscriber can tell where blocks were lost.
+ */
+
+#ifndef MQTT_TASK_H
+#define MQTT_TASK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CoopScheduler.h"
+#include "MqttClient.h"
+#include "Telemetry.h"
+
+/** @brief Default interval between passes */
+#define MQTT_TASK_PERIOD_US 5000
+
+/** @brief Bytes in front of each sample block (sequence number) */
+#define MQTT_SAMPLES_HEADER 4
+
+class MqttTask : public CoopTask {
+ public:
+  /** @param samples Stream whose finished blocks are published */
+  MqttTask(MqttClient& client, TelemetryStream& samples, uint32_t periodUs = MQTT_TASK_PERIOD_US);
+
+  /** @brief Topic handle (MqttClient::addTopic()) for the blocks; -1 holds them */
+  void setSamplesTopic(int topic) { samplesTopic_ = topic; }
+
+  void step() override;
+
+  /** @brief One pass: queue a finished block if a slot is free, then poll */
+  void pump(uint32_t nowMs);
+
+  /** @brief Sample blocks handed to the client */
+  uint32_t blocks() const { return blocks_; }
+
+ private:
+  MqttClient& client_;
+  TelemetryStream& samples_;
+  int samplesTopic_;
+  uint32_t periodUs_;
+  uint32_t blocks_;
+};
+
+#endif  // MQTT_TASK_H
@@ -0,0 +1,73 @@
+/**
+ * @file NoiseEstimator.h
+ * @brief Streaming estimate of reading noise for adaptive hysteresis
+ *
+ * @details The fixed 6/8 cm band is too wide for a quiet installation
+ * (the alarm lingers after the intruder left) and too narrow for a noisy one
+ * (readings straddle the band and the buzzer chatters). NoiseEstimator
+ * tracks the noise of successive readings and the detector sizes the gap
+ * between trip and clear from it:
+ *
+ *   clearCm = tripCm + clamp(gapSigmas * sigma, minGapCm, maxGapCm)
+ *
+ * The trip distance itself is never moved, so adaptation cannot cost a
+ * detection; only how readily the alarm clears changes.
+ *
+ * sigma comes from an EWMA of |reading - previous reading|, a streaming
+ * mean-absolute-difference: for Gaussian noise E|d| = 2 sigma / sqrt(pi).
+ * Each difference is clipped to clipFactor times the current estimate
+ * before it is averaged in, so an intruder stepping in (a 30 cm jump) does
+ * not count as noise. Readings without an echo (0) are skipped.
+ *
+ * Until warmupReadings differences have been seen, ready() is false and the
+ * configured clearCm applies.
+ */
+
+#ifndef NOISE_ESTIMATOR_H
+#define NOISE_ESTIMATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct NoiseConfig {
+  bool adaptive = false;       ///< Size the trip/clear gap from the measured noise
+  float alpha = 0.05f;         ///< EWMA weight of each new difference
+  float gapSigmas = 4;         ///< Gap in noise standard deviations
+  float minGapCm = 0.5f;       ///< Narrowest gap
+  float maxGapCm = 10;         ///< Widest gap
+  float clipFactor = 4;        ///< Differences beyond this many estimates are clipped
+  uint16_t warmupReadings = 20;  ///< Differences needed before the estimate is used
+};
+
+class NoiseEstimator {
+ public:
+  explicit NoiseEstimator(const NoiseConfig& config = NoiseConfig());
+
+  const NoiseConfig& config() const { return config_; }
+
+  /** @brief Replaces the configuration and restarts the estimate */
+  void setConfig(const NoiseConfig& config);
+
+  /** @brief Forgets the estimate */
+  void reset();
+
+  /** @brief Adds one reading (0 = no echo, skipped) */
+  void addReading(float distanceCm);
+
+  /** @brief True once warmupReadings differences have been averaged */
+  bool ready() const { return differences_ >= config_.warmupReadings; }
+
+  /** @brief Estimated standard deviation of a reading */
+  float sigmaCm() const;
+
+  /** @brief Hysteresis gap for the current estimate */
+  float gapCm() const;
+
+ private:
+  NoiseConfig config_;
+  float previousCm_;
+  float meanAbsDiffCm_;
+  uint32_t differences_;
+};
+
+#endif  // NOISE_ESTIMATOR_H
@@ -0,0 +1,106 @@
+/**
+ * @file PowerScheduler.h
+ * @brief Light-sleep duty cycling between measurement cycles
+ *
+ * @details The wait at the end of every cycle used to be a plain delay(),
+ * during which the ESP32 keeps its CPU clocked at full speed doing nothing.
+ * With PowerConfig::lightSleep the scheduler spends that time in light sleep
+ * instead (Hal::lightSleep(), a timer wakeup on the ESP32) and draws well
+ * under 1 mA rather than tens of mA.
+ *
+ * Sampling cadence is kept: the scheduler computes the wake-up deadline
+ * first, sleeps until wakeMarginUs before it (waking from light sleep takes
+ * a little time and the timer is not exact) and then delays the rest against
+ * micros64(), so a cycle ends at the same moment whether it slept or not.
+ * Waits shorter than minSleepUs are plain delays; entering and leaving sleep
+ * would cost more than it saves.
+ *
+ * Alarm response is kept too: GPIO outputs hold their level in light sleep,
+ * so the buzzer stays on through the wait, and the next measurement happens
+ * on time. idlePeriodMs optionally stretches the wait while the scene is
+ * quiet (see below; the detector switches back to cyclePeriodMs as soon as
+ * it is not), trading first-detection latency for battery.
+ *
+ * Clock scaling: with idleCpuMhz set, setQuiet() drops the CPU clock to it
+ * while the detector reports a quiet scene (calibrated, clear, no trip
+ * pending and the last reading not within approachMarginCm of the trip
+ * distance) and restores fullCpuMhz as soon as it is not. The detector calls
+ * it between readings, never during one, because pulseIn() counts CPU
+ * cycles; everything else is timed with the clock-independent Hal
+ * timestamps. Keep idleCpuMhz at 80, 160 or 240: below 80 the ESP32's APB
+ * clock drops too and the UART baud rate with it, and other values are not
+ * clocks setCpuFrequencyMhz() accepts (validDetectorTuning() rejects them).
+ *
+ * While asleep the CPU cycle counter stops and the UART does not receive, so
+ * the CycleDelay profile phase shrinks to the awake part of the wait and
+ * serial commands typed during a sleep are lost.
+ */
+
+#ifndef POWER_SCHEDULER_H
+#define POWER_SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Hal.h"
+
+struct PowerConfig {
+  bool lightSleep = false;       ///< Light sleep between cycles instead of delay()
+  uint32_t idlePeriodMs = 0;     ///< Cycle wait while quiet; 0 = the normal cycle period
+  uint32_t minSleepUs = 5000;    ///< Shorter waits are plain delays
+  uint32_t wakeMarginUs = 2000;  ///< Wake this early, then delay to the exact time
+  uint32_t idleCpuMhz = 0;       ///< CPU clock while quiet; 0 = never change the clock
+  uint32_t fullCpuMhz = 240;     ///< CPU clock otherwise
+  float approachMarginCm = 10;   ///< Readings this close to the trip distance end quiet
+};
+
+class PowerScheduler {
+ public:
+  PowerScheduler(Hal& hal, const PowerConfig& config = PowerConfig());
+
+  const PowerConfig& config() const { return config_; }
+  void setConfig(const PowerConfig& config) { config_ = config; }
+
+  /** @brief Returns waitUs after the call, asleep for as much of it as allowed */
+  void wait(uint32_t waitUs);
+
+  /**
+   * @brief Sets the CPU clock for a quiet or an active scene
+   * @details Does nothing unless idleCpuMhz is set. Call between readings.
+   */
+  void setQuiet(bool quiet);
+
+  /** @brief Clears the counters */
+  void reset();
+
+  /** @brief Light sleeps entered */
+  uint32_t sleeps() const { return sleeps_; }
+
+  /** @brief Time handed to Hal::lightSleep() */
+  uint64_t sleptUs() const { return sleptUs_; }
+
+  /** @brief Time spent waiting awake (short waits, margins, sleep off) */
+  uint64_t awakeWaitUs() const { return awakeWaitUs_; }
+
+  /** @brief CPU clock changes made by setQuiet() */
+  uint32_t clockChanges() const { return clockChanges_; }
+
+  /**
+   * @brief Formats the counters on one line
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t formatCounters(char* out, size_t capacity) const;
+
+ private:
+  /** @brief Delays until deadlineUs on the micros64() clock */
+  void delayUntil(uint64_t deadlineUs);
+
+  Hal& hal_;
+  PowerConfig config_;
+  uint32_t sleeps_;
+  uint64_t sleptUs_;
+  uint64_t awakeWaitUs_;
+  uint32_t clockChanges_;
+};
+
+#endif  // POWER_SCHEDULER_H
@@ -0,0 +1,110 @@
+/**
+ * @file ReplayHal.h
+ * @brief Hal that replays a recorded trace against a virtual clock
+ *
+ * @details Each pulseIn() on the echo pin returns the next recorded echo
+ * width. Time only exists as a virtual clock:
+ * - delay()/delayMicroseconds() advance it by the requested amount
+ * - pulseIn() first jumps it forward to the recorded ping time (the trace
+ *   is the ground truth for when pings happened), then adds the echo width
+ *   or the timeout
+ *
+ * The clock never runs backwards, so it only follows the trace while the
+ * detector pings in the same pattern as the recorded one: with a different
+ * number of pings per reading it drifts from trace time and alarm times are
+ * wrong (see replayMatchesTrace()).
+ *
+ * Nothing ever sleeps, so replay runs as fast as the detector code allows.
+ * Writes to the buzzer pin are reported as timestamped edges. Host only.
+ */
+
+#ifndef REPLAY_HAL_H
+#define REPLAY_HAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "Hal.h"
+#include "IntruderDetector.h"
+#include "TraceFile.h"
+
+/**
+ * @brief Receives buzzer pin edges during replay
+ */
+class BuzzerEdgeListener {
+ public:
+  virtual ~BuzzerEdgeListener() {}
+  virtual void onBuzzerEdge(uint64_t timeUs, uint8_t level) = 0;
+};
+
+class ReplayHal : public Hal {
+ public:
+  /**
+   * @param records First record to replay
+   * @param count Number of records to replay
+   * @param echoPin Pin whose pulseIn() calls consume records
+   * @param buzzerPin Pin whose writes are reported as edges
+   */
+  ReplayHal(const TraceRecord* records, size_t count, uint8_t echoPin,
+            uint8_t buzzerPin);
+
+  void setEdgeListener(BuzzerEdgeListener* listener) { edgeListener_ = listener; }
+
+  /** @brief True once every record has been consumed */
+  bool finished() const { return cursor_ >= count_; }
+
+  /** @brief Records consumed so far */
+  size_t consumed() const { return cursor_; }
+
+  /** @brief Current virtual time in µs */
+  uint64_t now() const { return nowUs_; }
+
+  void pinMode(uint8_t, uint8_t) override {}
+  void digitalWrite(uint8_t pin, uint8_t level) override;
+  unsigned long pulseIn(uint8_t pin, uint8_t level, unsigned long timeoutUs) override;
+  void delayMicroseconds(uint32_t us) override { nowUs_ += us; }
+  void delay(uint32_t ms) override { nowUs_ += (uint64_t)ms * 1000; }
+  unsigned long millis() override { return (unsigned long)(nowUs_ / 1000); }
+  unsigned long micros() override { return (unsigned long)nowUs_; }
+  uint64_t micros64() override { return nowUs_; }
+
+ private:
+  const TraceRecord* records_;
+  size_t count_;
+  size_t cursor_;
+  uint64_t nowUs_;
+  uint8_t echoPin_;
+  uint8_t buzzerPin_;
+  uint8_t buzzerLevel_;
+  BuzzerEdgeListener* edgeListener_;
+};
+
+// ============================================================================
+// REPLAY HELPERS
+// ============================================================================
+
+/** @brief One raised alarm; clearedUs is UINT64_MAX if it never cleared */
+struct AlarmInterval {
+  uint64_t raisedUs;
+  uint64_t clearedUs;
+};
+
+/**
+ * @brief True if config pings in the pattern the trace was recorded with
+ *
+ * @details Replay keeps the recorded ping times, so the number of pings per
+ * reading cannot be changed. Shorter waits than recorded are harmless (the
+ * clock jumps to the next recorded ping); longer ones also push it ahead.
+ */
+bool replayMatchesTrace(const TraceSensorConfig& sensor, const DetectorConfig& config);
+
+/**
+ * @brief Replays records through a fresh detector and collects its alarms
+ * @param alarms Emptied, then filled with the alarm intervals in time order
+ */
+void replayAlarms(const TraceRecord* records, size_t count, const DetectorConfig& config,
+                  std::vector<AlarmInterval>& alarms);
+
+#endif  // REPLAY_HAL_H
@@ -0,0 +1,77 @@
+/**
+ * @file RingBuffer.h
+ * @brief Fixed-size single-producer/single-consumer ring buffer
+ *
+ * @details Storage is a plain array inside the object, so there is no heap
+ * allocation and the buffer can be a global. One context may push() and one
+ * other context may pop() at the same time without a lock (for example an
+ * ISR producing and loop() consuming). Indices run freely and are masked, so
+ * all N slots are usable; N must be a power of two.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+template <typename T, size_t N>
+class RingBuffer {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+
+ public:
+  RingBuffer() : head_(0), tail_(0) {}
+
+  /**
+   * @brief Appends an item (producer side)
+   * @return false if the buffer is full; the item is dropped
+   */
+  bool push(const T& item) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= N) return false;
+    items_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Removes the oldest item (consumer side)
+   * @return false if the buffer is empty
+   */
+  bool pop(T& item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return false;
+    item = items_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Copies the oldest item without removing it (consumer side)
+   * @return false if the buffer is empty
+   */
+  bool peek(T& item) const {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) return false;
+    item = items_[tail & (N - 1)];
+    return true;
+  }
+
+  /** @brief Items currently stored (a snapshot when used concurrently) */
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+  bool full() const { return size() >= N; }
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  T items_[N];
+  std::atomic<uint32_t> head_;  ///< Next slot to write; only the producer stores
+  std::atomic<uint32_t> tail_;  ///< Next slot to read; only the consumer stores
+};
+
+#endif  // RING_BUFFER_H
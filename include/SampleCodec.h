@@ -0,0 +1,214 @@
+/**
+ * @file SampleCodec.h
+ * @brief Streaming Gorilla-style compression for sensor sample history
+ *
+ * @details Samples are (timestamp, value) pairs where the timestamp is a
+ * wrapping 32-bit counter (millis() or micros()) and the value is a signed
+ * fixed-point integer (e.g. distance in 1/100 cm or an echo duration in µs).
+ *
+ * Each block is self-contained and starts with a 16 byte header followed by a
+ * MSB-first bit stream:
+ *
+ * | Offset | Size | Field                                     |
+ * |--------|------|-------------------------------------------|
+ * | 0      | 2    | Magic 0x4853 ("SH"), little endian        |
+ * | 2      | 1    | Format version (1)                        |
+ * | 3      | 1    | Reserved (0)                              |
+ * | 4      | 2    | Sample count                              |
+ * | 6      | 2    | Payload length in bits                    |
+ * | 8      | 4    | First timestamp                           |
+ * | 12     | 4    | First value                               |
+ *
+ * Every following sample is encoded as:
+ * - Timestamp: zig-zag delta-of-delta
+ *   - `0`            delta unchanged
+ *   - `10`   + 7 bits
+ *   - `110`  + 12 bits
+ *   - `1110` + 20 bits
+ *   - `1111` + 32 bits
+ * - Value: zig-zag delta from the previous value
+ *   - `0`            value unchanged
+ *   - `10`   + 7 bits
+ *   - `110`  + 12 bits
+ *   - `1110` + 18 bits
+ *   - `1111` + 32 bits
+ *
+ * All arithmetic is modulo 2^32, so timestamp wrap-around and arbitrary value
+ * jumps round-trip exactly. The encoder never allocates: it writes into a
+ * caller supplied buffer and refuses a sample once the block is full, at
+ * which point the caller seals the block and starts a new one.
+ */
+
+#ifndef SAMPLE_CODEC_H
+#define SAMPLE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// BLOCK FORMAT CONSTANTS
+// ============================================================================
+
+/** @brief Magic number at the start of every block ("SH", little endian) */
+#define SAMPLE_BLOCK_MAGIC 0x4853
+
+/** @brief Current block format version */
+#define SAMPLE_BLOCK_VERSION 1
+
+/** @brief Size of the fixed block header in bytes */
+#define SAMPLE_BLOCK_HEADER_BYTES 16
+
+/** @brief Worst-case encoded size of one sample after the first, in bits */
+#define SAMPLE_MAX_BITS_PER_SAMPLE 72
+
+/**
+ * @brief Scale used to store distances as fixed-point integers
+ * @details 100 stores centimetres with two decimal places (1/100 cm).
+ */
+#define DISTANCE_FIXED_SCALE 100
+
+// ============================================================================
+// ENCODER
+// ============================================================================
+
+/**
+ * @brief Incrementally encodes samples into a single bit-packed block
+ *
+ * @details The header is rewritten on every append so a partially filled
+ * block is always decodable, which lets the device flush it at any moment.
+ */
+class SampleBlockEncoder {
+ public:
+  SampleBlockEncoder();
+
+  /**
+   * @brief Starts a new, empty block in the given buffer
+   * @param buffer Destination storage, must outlive the encoder's use of it
+   * @param capacity Size of buffer in bytes (at least SAMPLE_BLOCK_HEADER_BYTES)
+   */
+  void begin(uint8_t* buffer, size_t capacity);
+
+  /**
+   * @brief Appends one sample to the block
+   * @return false if the sample does not fit; the block is left unchanged
+   */
+  bool append(uint32_t timestamp, int32_t value);
+
+  /** @brief Number of samples in the block */
+  uint16_t count() const { return count_; }
+
+  /** @brief Encoded size of the block in bytes, header included */
+  size_t sizeBytes() const;
+
+  /** @brief True once no further sample is guaranteed to fit */
+  bool full() const;
+
+  /** @brief Start of the encoded block */
+  const uint8_t* data() const { return buffer_; }
+
+ private:
+  void writeBits(uint32_t bits, uint8_t width);
+  void writeHeader();
+
+  uint8_t* buffer_;
+  size_t capacityBits_;
+  size_t bitPos_;
+  uint16_t count_;
+  uint32_t firstTimestamp_;
+  int32_t firstValue_;
+  uint32_t prevTimestamp_;
+  uint32_t prevDelta_;
+  uint32_t prevValue_;
+};
+
+// ============================================================================
+// DECODER
+// ============================================================================
+
+/**
+ * @brief Sequentially decodes a block produced by SampleBlockEncoder
+ */
+class SampleBlockDecoder {
+ public:
+  SampleBlockDecoder();
+
+  /**
+   * @brief Validates the block header and prepares for decoding
+   * @return false if the buffer is too short or the header is invalid
+   */
+  bool begin(const uint8_t* data, size_t length);
+
+  /**
+   * @brief Decodes the next sample
+   * @return false when every sample of the block has been returned
+   */
+  bool next(uint32_t& timestamp, int32_t& value);
+
+  /** @brief Total number of samples declared by the block header */
+  uint16_t count() const { return count_; }
+
+  /** @brief Encoded size of the block in bytes, header included */
+  size_t sizeBytes() const;
+
+ private:
+  uint32_t readBits(uint8_t width);
+
+  const uint8_t* payload_;
+  size_t payloadBits_;
+  size_t bitPos_;
+  uint16_t count_;
+  uint16_t index_;
+  uint32_t firstTimestamp_;
+  int32_t firstValue_;
+  uint32_t prevTimestamp_;
+  uint32_t prevDelta_;
+  uint32_t prevValue_;
+};
+
+// ============================================================================
+// ON-DEVICE HISTORY
+// ============================================================================
+
+/**
+ * @brief Fixed-size ring of compressed sample blocks
+ *
+ * @details Keeps the most recent SAMPLE_HISTORY_BLOCKS blocks of history in
+ * RAM. When the active block fills up it is sealed and the oldest block is
+ * recycled, so memory use never grows.
+ */
+#define SAMPLE_HISTORY_BLOCKS 8
+#define SAMPLE_HISTORY_BLOCK_BYTES 256
+
+class SampleHistory {
+ public:
+  SampleHistory();
+
+  /**
+   * @brief Records one sample, rolling over to a new block when needed
+   * @return true if appending the sample sealed the previous block
+   */
+  bool append(uint32_t timestamp, int32_t value);
+
+  /** @brief Number of blocks currently holding data (sealed + active) */
+  size_t blockCount() const { return used_; }
+
+  /**
+   * @brief Returns a block, oldest first
+   * @param index 0 is the oldest block, blockCount() - 1 the active one
+   * @param length Receives the encoded size in bytes
+   */
+  const uint8_t* block(size_t index, size_t& length) const;
+
+  /** @brief Total samples recorded since start-up (including recycled ones) */
+  uint32_t totalSamples() const { return total_; }
+
+ private:
+  uint8_t blocks_[SAMPLE_HISTORY_BLOCKS][SAMPLE_HISTORY_BLOCK_BYTES];
+  size_t sizes_[SAMPLE_HISTORY_BLOCKS];
+  size_t active_;
+  size_t used_;
+  uint32_t total_;
+  SampleBlockEncoder encoder_;
+};
+
+#endif  // SAMPLE_CODEC_H
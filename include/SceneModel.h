@@ -0,0 +1,105 @@
+/**
+ * @file SceneModel.h
+ * @brief Empty-scene baseline learned at startup, slowly adapted afterwards
+ *
+ * @details With a fixed trip distance the detector only works when nothing
+ * else is in range. SceneModel instead learns what the sensor normally sees
+ * (e.g. a wall at 40 cm) and places the thresholds relative to it:
+ *
+ *   tripCm  = baseline - tripMarginCm  - sigmas * sigma
+ *   clearCm = baseline - clearMarginCm - sigmas * sigma
+ *
+ * i.e. an alarm is an object at least tripMarginCm (plus the noise
+ * allowance) in front of the background.
+ *
+ * - Calibration: the first calibrationReadings readings are folded into a
+ *   Welford mean/variance. Readings without an echo (0) count towards the
+ *   window but not into the statistics. If fewer than half of them had an
+ *   echo, or the baseline is too close to fit the margins, the model stays
+ *   unavailable and the fixed DetectorConfig thresholds apply. Nothing is
+ *   detected until it ends, so calibrationPeriodMs can take the readings
+ *   faster than the normal cycle and shorten the unprotected time at boot.
+ * - Adaptation: every later reading moves the mean and variance by
+ *   adaptRate (exponentially weighted Welford update), so slow changes such
+ *   as temperature drift are followed. It is frozen while an alarm is
+ *   active, so an intruder standing still never becomes background.
+ *
+ * Pair it with FilterType::Median (or ValidMean): FilterType::Mean counts a
+ * timed-out ping as 0 cm, which pulls a wall at 40 cm to ~24 cm and, with
+ * baseline-relative thresholds, reads as an intrusion.
+ *
+ * The model is a handful of floats: no samples are stored.
+ */
+
+#ifndef SCENE_MODEL_H
+#define SCENE_MODEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct SceneConfig {
+  uint16_t calibrationReadings = 0;  ///< Readings learned at begin(); 0 = fixed thresholds
+  uint32_t calibrationPeriodMs = 0;  ///< Cycle wait while calibrating; 0 = the normal period
+  float tripMarginCm = 10;           ///< Alarm this much in front of the baseline
+  float clearMarginCm = 6;           ///< Clear once back within this margin
+  float sigmas = 3;                  ///< Noise allowance in baseline standard deviations
+  float adaptRate = 0.01f;           ///< Weight of each reading after calibration; 0 = frozen
+};
+
+class SceneModel {
+ public:
+  explicit SceneModel(const SceneConfig& config = SceneConfig());
+
+  const SceneConfig& config() const { return config_; }
+
+  /** @brief Replaces the configuration and restarts calibration */
+  void setConfig(const SceneConfig& config);
+
+  /**
+   * @brief Replaces the margins, sigmas and adaptation rate, keeping the baseline
+   * @details calibrationReadings is left as it is.
+   */
+  void tune(const SceneConfig& config);
+
+  /** @brief Forgets the baseline and starts calibrating again */
+  void start();
+
+  /** @brief True while the calibration window is being collected */
+  bool calibrating() const { return calibrated_ < config_.calibrationReadings; }
+
+  /** @brief True once a usable baseline exists (tripCm()/clearCm() apply) */
+  bool ready() const { return ready_; }
+
+  /**
+   * @brief Adds one reading
+   * @param distanceCm Reading, 0 if it had no echo
+   * @param frozen True while an alarm is active (no adaptation)
+   * @return true if this reading completed the calibration
+   */
+  bool addReading(float distanceCm, bool frozen);
+
+  float baselineCm() const { return mean_; }
+  float sigmaCm() const;
+  float tripCm() const { return mean_ - config_.tripMarginCm - config_.sigmas * sigmaCm(); }
+  float clearCm() const { return mean_ - config_.clearMarginCm - config_.sigmas * sigmaCm(); }
+
+  /** @brief Readings folded in since start() (calibration and adaptation) */
+  uint32_t samples() const { return samples_; }
+
+  /**
+   * @brief Formats the state, baseline and derived thresholds
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t format(char* out, size_t capacity) const;
+
+ private:
+  SceneConfig config_;
+  uint16_t calibrated_;  ///< Readings seen in the calibration window
+  bool ready_;
+  uint32_t samples_;
+  float mean_;
+  float m2_;        ///< Sum of squared deviations (during calibration)
+  float variance_;  ///< After calibration
+};
+
+#endif  // SCENE_MODEL_H
@@ -0,0 +1,126 @@
+/**
+ * @file SensorHealth.h
+ * @brief Fault detection over the raw ping stream
+ *
+ * @details The detector cannot tell a broken sensor from an empty room: a
+ * disconnected echo wire makes every pulseIn() time out, the reading becomes
+ * 0 and update() treats that as "no intruder", so the system is silently
+ * disarmed. SensorHealth watches every raw echo width (the same values as
+ * DetectorListener::onPing()) and raises faults on its own listener:
+ * - SENSOR_FAULT_TIMEOUTS: too many timed-out pings in the window
+ * - SENSOR_FAULT_OUT_OF_RANGE: too many echoes outside the sensor's range
+ * - SENSOR_FAULT_NOISY: standard deviation of the echoes implausibly high
+ * - SENSOR_FAULT_STUCK: the exact same echo width many times in a row
+ *
+ * Rates and variance cover the last SENSOR_HEALTH_WINDOW pings and are only
+ * judged once the window is full. A rate or deviation fault clears when the
+ * value falls to half its limit, a stuck fault on the first different echo.
+ *
+ * addSample() is O(1): the window is a ring whose running sums are updated
+ * with the entering and leaving ping, no loops, no allocation.
+ */
+
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Pings covered by the rate and variance checks (power of two) */
+#define SENSOR_HEALTH_WINDOW 32
+
+/** @name Fault bits */
+///@{
+#define SENSOR_FAULT_TIMEOUTS 0x01
+#define SENSOR_FAULT_OUT_OF_RANGE 0x02
+#define SENSOR_FAULT_NOISY 0x04
+#define SENSOR_FAULT_STUCK 0x08
+///@}
+
+struct SensorHealthConfig {
+  float minCm = 2;                  ///< Closest distance the sensor can measure
+  float maxCm = 400;                ///< Farthest distance the sensor can measure
+  float maxTimeoutRate = 0.5f;      ///< Fraction of timed-out pings that raises a fault
+  float maxOutOfRangeRate = 0.25f;  ///< Fraction of out-of-range echoes that raises a fault
+  float maxStdDevCm = 40;           ///< Deviation of valid echoes that raises a fault
+  uint16_t stuckSamples = 32;       ///< Identical echoes in a row that raise a fault; 0 = off
+};
+
+/**
+ * @brief Receives fault changes (separate from the intruder alarm)
+ */
+class SensorHealthListener {
+ public:
+  virtual ~SensorHealthListener() {}
+
+  /** @brief The fault bits changed from previous to faults */
+  virtual void onHealthChange(uint8_t faults, uint8_t previous) = 0;
+};
+
+class SensorHealth {
+ public:
+  explicit SensorHealth(const SensorHealthConfig& config = SensorHealthConfig());
+
+  void setListener(SensorHealthListener* listener) { listener_ = listener; }
+
+  const SensorHealthConfig& config() const { return config_; }
+  void setConfig(const SensorHealthConfig& config);
+
+  /**
+   * @brief Adds one raw ping
+   * @param echoUs Echo width, 0 on timeout
+   * @return The fault bits after this ping
+   */
+  uint8_t addSample(uint32_t echoUs);
+
+  /** @brief Empties the window and clears faults and counts (without notifying) */
+  void reset();
+
+  uint8_t faults() const { return faults_; }
+  bool healthy() const { return faults_ == 0; }
+
+  /** @brief Number of times the sensor went from healthy to faulty */
+  uint32_t faultEvents() const { return faultEvents_; }
+
+  float timeoutRate() const;
+  float outOfRangeRate() const;
+  float stdDevCm() const;
+  uint32_t repeatCount() const { return repeats_; }
+
+  /**
+   * @brief Formats the faults and the values they are judged on
+   * @return Characters written (output is always NUL terminated)
+   */
+  size_t format(char* out, size_t capacity) const;
+
+ private:
+  uint32_t filled() const { return count_ < SENSOR_HEALTH_WINDOW ? count_ : SENSOR_HEALTH_WINDOW; }
+  uint8_t evaluate() const;
+
+  SensorHealthConfig config_;
+  SensorHealthListener* listener_;
+  uint32_t minEchoUs_;
+  uint32_t maxEchoUs_;
+
+  uint16_t echoes_[SENSOR_HEALTH_WINDOW];  ///< 0 = timeout
+  uint8_t flags_[SENSOR_HEALTH_WINDOW];
+  uint32_t count_;
+  uint32_t timeouts_;
+  uint32_t outOfRange_;
+  uint32_t valid_;
+  uint64_t sum_;     ///< Of valid echoes in the window
+  uint64_t sumSq_;
+
+  uint32_t lastEchoUs_;
+  uint32_t repeats_;
+  uint8_t faults_;
+  uint32_t faultEvents_;
+};
+
+/**
+ * @brief Writes the names of the set fault bits, comma separated ("ok" if none)
+ * @return Characters written (output is always NUL terminated)
+ */
+size_t formatSensorFaults(uint8_t faults, char* out, size_t capacity);
+
+#endif  // SENSOR_HEALTH_H
@@ -0,0 +1,89 @@
+/**
+ * @file SensorSimulator.h
+ * @brief Host-side model of an HC-SR04 looking at a scene
+ *
+ * @details Produces the echo pulse width (in µs) that pulseIn() would return
+ * for a ping fired at a given time. The scene is a static background (e.g. a
+ * wall) plus any number of intrusion intervals during which an object sits
+ * closer to the sensor. Gaussian measurement noise and random echo timeouts
+ * are layered on top. A seeded xorshift generator keeps runs reproducible.
+ *
+ * Multipath: with ghostCm set, each ping also bounces off a far reflector
+ * and that echo arrives distanceToEchoUs(ghostCm) after the ping. If the
+ * next ping is fired before then, the late echo lands in its listening
+ * window and ends the pulse early: pulseIn() reports the time left until
+ * the late echo instead of the real distance. With a fixed ping spacing the
+ * ghost distance is the same every time.
+ *
+ * Only built for the native environments; the firmware never links it.
+ */
+
+#ifndef SENSOR_SIMULATOR_H
+#define SENSOR_SIMULATOR_H
+
+#include <stdint.h>
+
+#include <vector>
+
+/**
+ * @brief An object present in front of the sensor for a time window
+ */
+struct SimIntrusion {
+  uint64_t startUs;   ///< Time the object enters the detection zone
+  uint64_t endUs;     ///< Time the object leaves
+  float distanceCm;   ///< Distance of the object from the sensor
+};
+
+/**
+ * @brief Static description of the simulated scene and sensor
+ */
+struct SimScene {
+  float backgroundCm = 0;          ///< Background distance, 0 = nothing in range
+  float noiseCm = 0.3f;            ///< Standard deviation of range noise
+  float timeoutProbability = 0;    ///< Chance that a ping gets no echo at all
+  float glitchProbability = 0;     ///< Chance of a spurious short echo (2-6 cm)
+  float ghostCm = 0;               ///< Far reflector whose echo arrives late, 0 = none
+  float ghostProbability = 1;      ///< Chance that the late echo is strong enough to register
+  unsigned long echoTimeoutUs = 30000;  ///< pulseIn() timeout used by the firmware
+  std::vector<SimIntrusion> intrusions;
+};
+
+class SensorSimulator {
+ public:
+  explicit SensorSimulator(const SimScene& scene, uint64_t seed = 1);
+
+  /**
+   * @brief Echo pulse width for a ping fired at timeUs
+   * @return Pulse width in µs, or 0 when the ping times out
+   */
+  unsigned long echoAt(uint64_t timeUs);
+
+  /** @brief Distance the scene presents at timeUs, before noise (0 = none) */
+  float trueDistanceAt(uint64_t timeUs) const;
+
+  /** @brief Converts a distance to the round-trip echo width in µs */
+  static unsigned long distanceToEchoUs(float distanceCm);
+
+  const SimScene& scene() const { return scene_; }
+
+ private:
+  double uniform();
+  double gaussian();
+  unsigned long directEcho(uint64_t timeUs);
+
+  SimScene scene_;
+  uint64_t lastPingUs_;
+  bool havePing_;
+  std::vector<uint64_t> latestEnd_;  ///< Running max of endUs, by start time
+  uint64_t state_;
+};
+
+/**
+ * @brief Builds a scene with randomly placed intrusions over a time span
+ * @param durationUs Length of the simulated session
+ * @param intrusionCount Number of intrusions to scatter over the session
+ * @param seed Random seed
+ */
+SimScene makeRandomScene(uint64_t durationUs, int intrusionCount, uint64_t seed);
+
+#endif  // SENSOR_SIMULATOR_H
@@ -0,0 +1,66 @@
+/**
+ * @file SerialTasks.h
+ * @brief Cooperative tasks for the Serial console and the `@B` telemetry
+ *
+ * @details Run next to DetectorTask on a CoopScheduler:
+ * - ConsoleTask polls the command console every few ms, so a command is
+ *   answered within that period instead of after the measurement cycle
+ * - TelemetryTask writes each telemetry block as one `@B` line once the
+ *   UART buffer can take all of it (COOP_AWAIT_UART_SPACE), so a 500-byte
+ *   line never blocks the other tasks in Serial.write(), and no other
+ *   output (console replies, summaries) can land inside it
+ */
+
+#ifndef SERIAL_TASKS_H
+#define SERIAL_TASKS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CommandConsole.h"
+#include "CoopScheduler.h"
+#include "Telemetry.h"
+
+/** @brief Default console poll period */
+#define CONSOLE_TASK_PERIOD_US 5000
+
+/** @brief Default check period for a finished block and for UART room */
+#define TELEMETRY_TASK_POLL_US 5000
+
+/** @brief UART transmit buffer the firmware sets up; holds a whole `@B` or `@A` line */
+#define SERIAL_TX_BUFFER_BYTES 2048
+
+static_assert(TELEMETRY_LINE_MAX < SERIAL_TX_BUFFER_BYTES, "`@B` line must fit the TX buffer");
+
+/**
+ * @brief Polls the console; again right away after a command ran
+ */
+class ConsoleTask : public CoopTask {
+ public:
+  explicit ConsoleTask(CommandConsole& console, uint32_t periodUs = CONSOLE_TASK_PERIOD_US)
+      : console_(console), periodUs_(periodUs) {}
+
+  void step() override;
+
+ private:
+  CommandConsole& console_;
+  uint32_t periodUs_;
+};
+
+/**
+ * @brief Prints each finished telemetry block as one `@B` line, written whole
+ */
+class TelemetryTask : public CoopTask {
+ public:
+  TelemetryTask(TelemetryStream& stream, ConsoleIo& io, uint32_t pollUs = TELEMETRY_TASK_POLL_US);
+
+  void step() override;
+
+ private:
+  TelemetryStream& stream_;
+  ConsoleIo& io_;
+  char text_[TELEMETRY_LINE_MAX + 1];
+  size_t textLength_;
+};
+
+#endif  // SERIAL_TASKS_H
@@ -0,0 +1,88 @@
+/**
+ * @file SimHal.h
+ * @brief Hal that drives the detector from the sensor simulator
+ *
+ * @details Like ReplayHal, time is a virtual clock advanced by delays and
+ * echo waits, but every pulseIn() on the echo pin asks a SensorSimulator for
+ * the echo at the current virtual time instead of reading a recording. The
+ * detector's own timing therefore decides when the scene is sampled, and the
+ * scene's intrusion times are exact ground truth. Writes to the buzzer pin
+ * are reported as timestamped edges. Host only.
+ */
+
+#ifndef SIM_HAL_H
+#define SIM_HAL_H
+
+#include <stdint.h>
+
+#include "Hal.h"
+#include "ReplayHal.h"
+#include "SensorSimulator.h"
+
+class SimHal : public Hal {
+ public:
+  /**
+   * @param sensor Simulator to sample; must outlive the Hal
+   * @param echoPin Pin whose pulseIn() calls sample the simulator
+   * @param buzzerPin Pin whose writes are reported as edges
+   * @param startUs Initial virtual time
+   */
+  SimHal(SensorSimulator& sensor, uint8_t echoPin, uint8_t buzzerPin, uint64_t startUs = 0);
+
+  void setEdgeListener(BuzzerEdgeListener* listener) { edgeListener_ = listener; }
+
+  /** @brief Current virtual time in µs */
+  uint64_t now() const { return nowUs_; }
+
+  /** @brief Virtual time spent in lightSleep() */
+  uint64_t sleptUs() const { return sleptUs_; }
+
+  /** @brief Virtual time spent in pulseIn() on the echo pin (sensor ranging) */
+  uint64_t echoWaitUs() const { return echoWaitUs_; }
+
+  /** @brief Sum of CPU MHz x µs over the time awake (mean clock = this / awake time) */
+  uint64_t awakeMhzUs() const { return awakeMhzUs_; }
+
+  /** @brief CPU clock changes made through setCpuFrequencyMhz() */
+  uint32_t clockChanges() const { return clockChanges_; }
+
+  void pinMode(uint8_t, uint8_t) override {}
+  void digitalWrite(uint8_t pin, uint8_t level) override;
+  unsigned long pulseIn(uint8_t pin, uint8_t level, unsigned long timeoutUs) override;
+  /** @brief Samples the echo now; pulseDone() once the clock reached its end */
+  void startPulse(uint8_t pin, uint8_t level, unsigned long timeoutUs) override;
+  bool pulseDone(unsigned long& widthUs) override;
+  void delayMicroseconds(uint32_t us) override { advance(us); }
+  void delay(uint32_t ms) override { advance((uint64_t)ms * 1000); }
+  void lightSleep(uint32_t us) override {
+    nowUs_ += us;
+    sleptUs_ += us;
+  }
+  unsigned long millis() override { return (unsigned long)(nowUs_ / 1000); }
+  unsigned long micros() override { return (unsigned long)nowUs_; }
+  uint64_t micros64() override { return nowUs_; }
+  uint32_t cpuFrequencyMhz() override { return cpuMhz_; }
+  bool setCpuFrequencyMhz(uint32_t mhz) override;
+
+ private:
+  /** @brief Advances the clock with the CPU awake */
+  void advance(uint64_t us) {
+    nowUs_ += us;
+    awakeMhzUs_ += us * cpuMhz_;
+  }
+
+  SensorSimulator& sensor_;
+  uint64_t nowUs_;
+  uint64_t sleptUs_;
+  uint64_t echoWaitUs_;
+  uint64_t awakeMhzUs_;
+  uint32_t cpuMhz_;
+  uint32_t clockChanges_;
+  uint64_t pulseEndUs_;  ///< When the pulse started by startPulse() is over
+  uint8_t echoPin_;
+  uint8_t buzzerPin_;
+  uint8_t buzzerLevel_;
+  BuzzerEdgeListener* edgeListener_;
+};
+
+#endif  // SIM_HAL_H
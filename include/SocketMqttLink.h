@@ -0,0 +1,34 @@
+/**
+ * @file SocketMqttLink.h
+ * @brief MqttLink over a non-blocking BSD TCP socket
+ *
+ * @details Plain socket calls, so the same code runs on the host and on the
+ * ESP32 (lwIP sockets, once WiFi is up). The broker is an IPv4 address;
+ * there is no DNS lookup, which could block.
+ */
+
+#ifndef SOCKET_MQTT_LINK_H
+#define SOCKET_MQTT_LINK_H
+
+#include <stdint.h>
+
+#include "MqttClient.h"
+
+class SocketMqttLink : public MqttLink {
+ public:
+  SocketMqttLink(const char* address, uint16_t port) : address_(address), port_(port), fd_(-1) {}
+  ~SocketMqttLink() override { close(); }
+
+  bool open() override;
+  int status() override;
+  int write(const uint8_t* data, size_t length) override;
+  int read(uint8_t* out, size_t capacity) override;
+  void close() override;
+
+ private:
+  const char* address_;
+  uint16_t port_;
+  int fd_;
+};
+
+#endif  // SOCKET_MQTT_LINK_H
@@ -0,0 +1,112 @@
+/**
+ * @file SummaryAggregator.h
+ * @brief Per-interval reading summaries in place of a line per reading
+ *
+ * @details Printing every reading costs ~50 bytes of Serial output per
+ * cycle, which grows with the sampling rate. SummaryAggregator folds the
+ * readings, pings and alarm state of each interval (a second, a minute)
+ * into one IntervalSummary:
+ * - reading count and min/max/mean distance of the readings with an echo
+ * - readings without any echo, pings and ping timeouts
+ * - a fixed-bin distance histogram (edges in SUMMARY_BIN_EDGES_CM)
+ * - alarms raised and time spent in alarm
+ *
+ * The firmware prints each one as an `@S` hex line with this little-endian
+ * layout (46 bytes), decoded by the telemetry decoder:
+ *
+ *   u16 magic 'IS' (0x5349), u8 version (1), u8 bin count,
+ *   u32 start ms, u32 duration ms, u16 readings, no-echo readings, pings,
+ *   timeouts, u16 min, max, mean in 1/100 cm, u32 alarm ms, u8 alarms
+ *   raised, u8 flags (bit 0: alarm active at the end), u16 bins[]
+ *
+ * Fixed memory, no allocation; all times are millis().
+ */
+
+#ifndef SUMMARY_AGGREGATOR_H
+#define SUMMARY_AGGREGATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Prefix of a Serial line carrying an encoded summary */
+#define SUMMARY_PREFIX "@S "
+
+/** @brief Histogram bins: below the first edge, between edges, above the last */
+#define SUMMARY_BINS 7
+
+/** @brief Size of an encoded summary */
+#define SUMMARY_BYTES 46
+
+/** @brief Upper bin edges in cm (readings without echo are not binned) */
+extern const float SUMMARY_BIN_EDGES_CM[SUMMARY_BINS - 1];
+
+struct IntervalSummary {
+  uint32_t startMs = 0;
+  uint32_t durationMs = 0;
+  uint16_t readings = 0;
+  uint16_t noEcho = 0;          ///< Readings of 0 (no ping echoed)
+  uint16_t pings = 0;
+  uint16_t timeouts = 0;        ///< Pings without echo
+  float minCm = 0;              ///< Over readings with an echo; 0 if none
+  float maxCm = 0;
+  float meanCm = 0;
+  uint32_t alarmMs = 0;         ///< Time the alarm was on during the interval
+  uint8_t alarms = 0;           ///< Alarms raised during the interval
+  bool alarmActive = false;     ///< Alarm on at the end of the interval
+  uint16_t bins[SUMMARY_BINS] = {};
+};
+
+class SummaryAggregator {
+ public:
+  explicit SummaryAggregator(uint32_t intervalMs = 1000);
+
+  uint32_t intervalMs() const { return intervalMs_; }
+
+  /** @brief Takes effect when the current interval closes */
+  void setIntervalMs(uint32_t intervalMs) { intervalMs_ = intervalMs > 0 ? intervalMs : 1; }
+
+  /** @brief Starts the first interval (drops anything collected) */
+  void start(uint32_t nowMs);
+
+  void addPing(uint32_t echoUs);
+  void addReading(float distanceCm);
+
+  /** @brief Alarm raised (true) or cleared (false) at nowMs */
+  void setAlarm(bool active, uint32_t nowMs);
+
+  /**
+   * @brief Closes the current interval once it has lasted intervalMs()
+   * @return true if summary() now holds a newly closed interval
+   */
+  bool poll(uint32_t nowMs);
+
+  /** @brief Last closed interval */
+  const IntervalSummary& summary() const { return last_; }
+
+ private:
+  void close(uint32_t nowMs);
+
+  uint32_t intervalMs_;
+  IntervalSummary current_;
+  IntervalSummary last_;
+  float sumCm_;
+  uint16_t echoed_;           ///< Readings with an echo, for the mean
+  uint32_t alarmSinceMs_;     ///< Start of the running alarm (or interval), if active
+};
+
+/**
+ * @brief Formats a summary on one line for people
+ * @return Characters written (output is always NUL terminated)
+ */
+size_t formatSummary(const IntervalSummary& summary, char* out, size_t capacity);
+
+/**
+ * @brief Encodes a summary in the binary layout above
+ * @return SUMMARY_BYTES, or 0 if capacity is too small
+ */
+size_t encodeSummary(const IntervalSummary& summary, uint8_t* out, size_t capacity);
+
+/** @brief Decodes a binary summary; false if it is malformed */
+bool decodeSummary(const uint8_t* data, size_t length, IntervalSummary& summary);
+
+#endif  // SUMMARY_AGGREGATOR_H
@@ -0,0 +1,115 @@
+/**
+ * @file Telemetry.h
+ * @brief Per-ping telemetry stream emitted by the firmware over Serial
+ *
+ * @details Every ping (timestamp from micros(), echo width from pulseIn()) is
+ * compressed with SampleCodec into blocks. Finished blocks are printed as
+ * text lines that coexist with the human readable log:
+ *
+ * - `@C key=value ...`   sensor and detector configuration, printed once at boot
+ * - `@B <seq> <hex>`     one encoded SampleCodec block; seq increments per block
+ *
+ * The host decoder (native_telemetry_decoder) turns a captured serial log
+ * into a trace file (see TraceFile.h and docs/trace_format.md). Missing
+ * sequence numbers tell it where blocks were lost.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SampleCodec.h"
+
+/** @brief Size of one telemetry block in bytes */
+#define TELEMETRY_BLOCK_BYTES 256
+
+/** @brief Prefix of configuration lines */
+#define TELEMETRY_CONFIG_PREFIX "@C "
+
+/** @brief Prefix of block lines */
+#define TELEMETRY_BLOCK_PREFIX "@B "
+
+/** @brief Longest `@B` line: prefix, 10-digit sequence, space, hex, newline */
+#define TELEMETRY_LINE_MAX (sizeof(TELEMETRY_BLOCK_PREFIX) - 1 + 11 + 2 * TELEMETRY_BLOCK_BYTES + 1)
+
+/**
+ * @brief Double-buffered telemetry block producer
+ *
+ * @details record() is cheap and never blocks: it fills the active block and,
+ * when full, hands it over as the pending block. The main loop prints the
+ * pending block when it has time. If a second block fills before the first
+ * was printed, the new block is dropped and counted in overflows().
+ */
+class TelemetryStream {
+ public:
+  TelemetryStream();
+
+  /** @brief Records one ping */
+  void record(uint32_t timeUs, uint32_t echoUs);
+
+  /** @brief Moves a partially filled active block to pending (e.g. on demand) */
+  void flush();
+
+  /**
+   * @brief Returns the block waiting to be sent, if any
+   * @param length Receives the block size in bytes
+   * @param sequence Receives the block sequence number
+   * @return nullptr when nothing is pending
+   */
+  const uint8_t* pending(size_t& length, uint32_t& sequence) const;
+
+  /** @brief Marks the pending block as sent */
+  void releasePending();
+
+  /** @brief Blocks dropped because the previous one was still pending */
+  uint32_t overflows() const { return overflows_; }
+
+ private:
+  void seal();
+
+  uint8_t buffers_[2][TELEMETRY_BLOCK_BYTES];
+  size_t pendingLength_;
+  uint8_t active_;
+  bool hasPending_;
+  uint32_t pendingSequence_;
+  uint32_t nextSequence_;
+  uint32_t overflows_;
+  SampleBlockEncoder encoder_;
+};
+
+/**
+ * @brief Writes data as lowercase hex into out (2 * length characters, no NUL)
+ */
+void telemetryToHex(const uint8_t* data, size_t length, char* out);
+
+/**
+ * @brief Formats a block as one `@B` line, newline included
+ * @param out At least TELEMETRY_LINE_MAX + 1 bytes; NUL-terminated
+ * @return Length of the line, to be written in one go so that no other
+ *   output can land inside it
+ */
+size_t telemetryFormatBlockLine(const uint8_t* block, size_t length, uint32_t sequence,
+                                char* out);
+
+/**
+ * @brief Decodes hex text (either case) up to the end of the string or line
+ * @param length Receives the number of bytes decoded
+ * @return false on a non-hex character, an odd digit count or overflow
+ */
+bool telemetryFromHex(const char* hex, uint8_t* out, size_t capacity, size_t& length);
+
+/**
+ * @brief Parses a `@B` line
+ * @param line Text of the line (trailing CR/LF allowed)
+ * @param block Receives the decoded block bytes
+ * @param capacity Size of block
+ * @param length Receives the number of bytes decoded
+ * @param sequence Receives the block sequence number
+ * @return false if the line is not a well-formed block line
+ */
+bool telemetryParseBlockLine(const char* line, uint8_t* block, size_t capacity,
+                             size_t& length, uint32_t& sequence);
+
+#endif  // TELEMETRY_H
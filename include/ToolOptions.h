@@ -0,0 +1,40 @@
+/**
+ * @file ToolOptions.h
+ * @brief Command-line handling shared by the host tools
+ *
+ * @details Lets every tool accept the same detector overrides
+ * (`--trip 5 --filter median ...`) on top of the configuration a trace was
+ * recorded with. Host only.
+ */
+
+#ifndef TOOL_OPTIONS_H
+#define TOOL_OPTIONS_H
+
+#include "IntruderDetector.h"
+#include "TraceFile.h"
+
+/** @brief Usage text for the options handled by parseDetectorOption() */
+#define DETECTOR_OPTIONS_USAGE                                                  \
+  "  --trip cm  --clear cm  --samples n  --spacing ms  --period ms\n"          \
+  "  --timeout us  --filter mean|validmean|median  --dwell n  --clear-dwell n\n" \
+  "  --calibrate readings  --trip-margin cm  --clear-margin cm  --adapt rate\n"   \
+  "  --adaptive-gap sigmas (0 = fixed gap)  --jitter ms  --gate cm\n"            \
+  "  --sleep 0|1  --idle-period ms  --idle-mhz mhz (0 = fixed clock)\n"          \
+  "  --calib-period ms (0 = cycle period)\n"
+
+/**
+ * @brief Copies the pins, timing, filter and scene calibration a trace was
+ * recorded with
+ */
+void applyTraceConfig(const TraceHeader& header, DetectorConfig& config);
+
+/**
+ * @brief Applies one `--name value` detector override
+ * @details Values outside the range the console's `set` accepts (see
+ * DetectorConsole.h) are invalid and leave the config unchanged. Limits
+ * between fields, such as clear beyond trip, are not checked here.
+ * @return 1 if handled, 0 if arg is not a detector option, -1 if value is invalid
+ */
+int parseDetectorOption(const char* arg, const char* value, DetectorConfig& config);
+
+#endif  // TOOL_OPTIONS_H
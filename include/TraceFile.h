@@ -0,0 +1,197 @@
+/**
+ * @file TraceFile.h
+ * @brief Indexed, memory-mappable file format for recorded sensor sessions
+ *
+ * @details A trace file is laid out as:
+ *
+ *   [TraceHeader 88 B][TraceRecord 16 B x recordCount][TraceIndexEntry 16 B x indexCount]
+ *
+ * Records are sorted by time and fixed-size, so record i lives at
+ * headerBytes + i * sizeof(TraceRecord). Every indexStride-th record
+ * also gets an entry in the sparse index at the end of the file, which lets
+ * a reader find any timestamp with a binary search over a few kilobytes of
+ * index followed by a binary search inside one stride, touching only a
+ * handful of pages of a multi-gigabyte mapping.
+ *
+ * All integers are little endian. The full specification lives in
+ * docs/trace_format.md. Readers also accept version 1 files, whose 64-byte
+ * header ends before the detector settings. Host only.
+ */
+
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <vector>
+
+// ============================================================================
+// ON-DISK STRUCTURES
+// ============================================================================
+
+#define TRACE_MAGIC "IDSTRACE"
+#define TRACE_VERSION 2
+/** @brief headerBytes of a version 1 file: everything before TraceHeader::detector */
+#define TRACE_V1_HEADER_BYTES 64
+#define TRACE_DEFAULT_INDEX_STRIDE 4096
+
+/** @brief Record flag: the ping timed out (echoUs is 0) */
+#define TRACE_FLAG_TIMEOUT 0x0001
+/** @brief Record flag: samples were lost immediately before this record */
+#define TRACE_FLAG_GAP 0x0002
+
+/**
+ * @brief Sensor configuration the session was captured with
+ */
+struct TraceSensorConfig {
+  uint8_t trigPin;
+  uint8_t echoPin;
+  uint8_t buzzerPin;
+  uint8_t samplesPerReading;  ///< Pings averaged per distance reading
+  uint32_t echoTimeoutUs;     ///< pulseIn() timeout
+  uint32_t pingSpacingMs;     ///< Delay between pings of one reading
+  uint32_t cyclePeriodMs;     ///< Delay between readings
+  float soundSpeedCmPerUs;    ///< SOUND_SPEED used by the firmware
+};
+
+/**
+ * @brief Detector settings the session was captured with
+ * @details How the firmware turned the pings into readings and alarms, so a
+ * replay starts from the same filter and scene calibration. Version 1 files
+ * do not have them; readers fill in traceDefaultDetectorConfig().
+ */
+struct TraceDetectorConfig {
+  uint8_t filter;                ///< FilterType of the ping combination
+  uint8_t reserved0;
+  uint16_t calibrationReadings;  ///< Scene calibration length; 0 = fixed thresholds
+  uint32_t calibrationPeriodMs;  ///< Cycle wait while calibrating; 0 = the normal period
+  float tripMarginCm;            ///< Alarm this much in front of the baseline
+  float clearMarginCm;           ///< Clear once back within this margin
+  float adaptRate;               ///< Baseline adaptation after calibration
+  uint32_t reserved1;
+};
+
+struct TraceHeader {
+  char magic[8];              ///< "IDSTRACE"
+  uint16_t version;           ///< TRACE_VERSION
+  uint16_t headerBytes;       ///< sizeof(TraceHeader)
+  uint16_t recordBytes;       ///< sizeof(TraceRecord)
+  uint16_t reserved0;
+  uint32_t indexStride;       ///< Records between index entries
+  TraceSensorConfig sensor;
+  uint64_t recordCount;       ///< 0 in an unfinished file, see docs
+  uint64_t indexOffset;       ///< Byte offset of the index, 0 if absent
+  uint64_t indexCount;
+  TraceDetectorConfig detector;  ///< Version 2 and later
+};
+
+struct TraceRecord {
+  uint64_t timeUs;            ///< Ping time, µs since start of capture clock
+  uint32_t echoUs;            ///< Echo pulse width, 0 on timeout
+  uint16_t flags;             ///< TRACE_FLAG_*
+  uint16_t reserved;
+};
+
+struct TraceIndexEntry {
+  uint64_t timeUs;            ///< Time of record recordIndex
+  uint64_t recordIndex;
+};
+
+static_assert(sizeof(TraceHeader) == 88, "TraceHeader must stay 88 bytes");
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord must stay 16 bytes");
+static_assert(sizeof(TraceIndexEntry) == 16, "TraceIndexEntry must stay 16 bytes");
+
+/** @brief Sensor configuration matching the stock firmware constants */
+TraceSensorConfig traceDefaultSensorConfig();
+
+/**
+ * @brief Detector settings of a trace that does not record them
+ * @details The host tools' own defaults (mean filter, fixed thresholds), so
+ * version 1 traces replay as they always did.
+ */
+TraceDetectorConfig traceDefaultDetectorConfig();
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+/**
+ * @brief Streams records to a new trace file and appends the index on close
+ */
+class TraceWriter {
+ public:
+  TraceWriter();
+  ~TraceWriter();
+
+  bool open(const char* path, const TraceSensorConfig& sensor,
+            const TraceDetectorConfig& detector = traceDefaultDetectorConfig(),
+            uint32_t indexStride = TRACE_DEFAULT_INDEX_STRIDE);
+
+  /**
+   * @brief Appends a record
+   * @return false on I/O error or if time goes backwards
+   */
+  bool append(uint64_t timeUs, uint32_t echoUs, uint16_t flags = 0);
+
+  /** @brief Writes the index, finalises the header and closes the file */
+  bool close();
+
+  uint64_t recordCount() const { return count_; }
+
+ private:
+  FILE* file_;
+  TraceHeader header_;
+  uint64_t count_;
+  uint64_t lastTimeUs_;
+  std::vector<TraceIndexEntry> index_;
+};
+
+// ============================================================================
+// READER
+// ============================================================================
+
+/**
+ * @brief Read-only memory mapping of a trace file
+ *
+ * @details Files whose writer never reached close() have recordCount 0 in
+ * the header; the reader then derives the count from the file size and
+ * falls back to searching the records directly. header() is a copy; for a
+ * version 1 file its detector settings are traceDefaultDetectorConfig().
+ */
+class TraceReader {
+ public:
+  TraceReader();
+  ~TraceReader();
+
+  TraceReader(const TraceReader&) = delete;
+  TraceReader& operator=(const TraceReader&) = delete;
+
+  bool open(const char* path);
+  void close();
+
+  const TraceHeader& header() const { return header_; }
+  const TraceSensorConfig& sensor() const { return header_.sensor; }
+  const TraceDetectorConfig& detector() const { return header_.detector; }
+  size_t size() const { return count_; }
+  const TraceRecord* records() const { return records_; }
+  const TraceRecord& operator[](size_t i) const { return records_[i]; }
+
+  /**
+   * @brief Index of the first record with timeUs >= t
+   * @return size() if every record is earlier than t
+   */
+  size_t seek(uint64_t timeUs) const;
+
+ private:
+  void* map_;
+  size_t mapLength_;
+  TraceHeader header_;
+  const TraceRecord* records_;
+  size_t count_;
+  const TraceIndexEntry* index_;
+  size_t indexCount_;
+};
+
+#endif  // TRACE_FILE_H
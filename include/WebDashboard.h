@@ -0,0 +1,171 @@
+/**
+ * @file WebDashboard.h
+ * @brief Embedded HTTP server with a live plot page and a binary WebSocket
+ *
+ * @details `GET /` serves a small page that plots distance; `GET /ws`
+ * upgrades to a WebSocket on which the server streams samples and state
+ * changes. Everything runs from poll() on non-blocking BSD sockets (lwIP
+ * on the ESP32), with fixed buffers and no allocation:
+ *
+ * - sample() and state() append 5-byte records to the open frame; it is
+ *   sealed when full, when it is flushMs old, or at once for a state
+ *   change, so one WebSocket message carries up to DASHBOARD_FRAME_RECORDS
+ *   samples
+ * - a sealed frame is encoded once, WebSocket header included, into a ring
+ *   of DASHBOARD_FRAMES; every viewer writes the same bytes from its own
+ *   cursor, so a new viewer costs socket writes but no encoding
+ * - a viewer that falls more than the ring behind skips to the oldest
+ *   frame still held (counted); one still in the middle of the frame being
+ *   reused is closed
+ *
+ * Frame payload (little endian): u32 time of the first record in ms, then
+ * records of u8 kind, u16 ms since the previous record, u16 value. Kinds:
+ * DashboardRecord; sample values are cm x 10, 0 for no echo.
+ */
+
+#ifndef WEB_DASHBOARD_H
+#define WEB_DASHBOARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "CoopScheduler.h"
+
+/** @brief Open WebSocket and HTTP connections */
+#define DASHBOARD_MAX_CLIENTS 8
+
+/** @brief Sealed frames kept for viewers that are behind */
+#define DASHBOARD_FRAMES 8
+
+/** @brief Records per WebSocket message */
+#define DASHBOARD_FRAME_RECORDS 100
+
+/** @brief Bytes of one record in a frame */
+#define DASHBOARD_RECORD_BYTES 5
+
+/** @brief Longest HTTP request head accepted */
+#define DASHBOARD_REQUEST_MAX 1024
+
+/** @brief Default age at which a partly filled frame is sent */
+#define DASHBOARD_FLUSH_MS 100
+
+/** @brief Default interval between passes when run as a task */
+#define DASHBOARD_TASK_PERIOD_US 5000
+
+/** @brief Largest frame: WebSocket header, start time and records */
+#define DASHBOARD_FRAME_BYTES (4 + 4 + DASHBOARD_FRAME_RECORDS * DASHBOARD_RECORD_BYTES)
+
+enum class DashboardRecord : uint8_t {
+  Sample = 0,    ///< One ping; value cm x 10, 0 = no echo
+  Intruder = 1,  ///< Alarm raised; value cm x 10
+  Clear = 2,     ///< Alarm cleared; value cm x 10
+  Fault = 3,     ///< Sensor fault state changed; value = fault bits (0 = ok)
+};
+
+/**
+ * @brief Sec-WebSocket-Accept for a client key (SHA-1 and base64, RFC 6455)
+ * @param out At least 29 bytes; NUL-terminated
+ */
+void webSocketAccept(const char* key, char* out);
+
+class WebDashboard : public CoopTask {
+ public:
+  /** @param port TCP port; 0 picks a free one (see port()) */
+  explicit WebDashboard(uint16_t port = 80, uint32_t flushMs = DASHBOARD_FLUSH_MS,
+                        uint32_t periodUs = DASHBOARD_TASK_PERIOD_US);
+  ~WebDashboard() override;
+
+  /** @brief Starts listening on all interfaces; false if that failed */
+  bool begin();
+
+  /** @brief Port listened on (after begin()) */
+  uint16_t port() const { return port_; }
+
+  /** @brief Adds one ping to the open frame */
+  void sample(uint32_t timeMs, float distanceCm);
+
+  /** @brief Adds a state change and sends the frame at the next poll() */
+  void state(DashboardRecord kind, uint32_t timeMs, uint16_t value);
+
+  /** @brief Accepts viewers, seals an old frame, reads requests and writes */
+  void poll(uint32_t nowMs);
+
+  void step() override;
+
+  /** @brief Open WebSocket connections */
+  size_t viewers() const;
+
+  /** @brief Frames the furthest-behind viewer still has to send */
+  uint32_t lag() const;
+
+  /** @name Counters since construction */
+  ///@{
+  uint32_t records() const { return records_; }          ///< sample() and state() calls
+  uint32_t frames() const { return nextSequence_; }      ///< Frames encoded (once each)
+  uint32_t frameSends() const { return frameSends_; }    ///< Frames written to a viewer
+  uint64_t bytesSent() const { return bytesSent_; }      ///< All bytes written
+  uint32_t skipped() const { return skipped_; }          ///< Frames viewers missed
+  uint32_t pages() const { return pages_; }              ///< Pages served
+  uint32_t upgrades() const { return upgrades_; }        ///< WebSocket handshakes
+  uint32_t dropped() const { return dropped_; }          ///< Connections closed by us
+  ///@}
+
+  /** @brief One-line summary of viewers and counters */
+  size_t format(char* out, size_t capacity) const;
+
+ private:
+  enum class ClientState : uint8_t { Free, Request, Response, Streaming };
+
+  struct Frame {
+    uint8_t bytes[DASHBOARD_FRAME_BYTES];
+    uint16_t start;   ///< Offset of the WebSocket header
+    uint16_t length;  ///< Bytes from start
+  };
+
+  struct Client {
+    int fd;
+    ClientState state;
+    bool upgrade;         ///< Response is the 101; stream frames after it
+    char request[DASHBOARD_REQUEST_MAX];
+    size_t requestLength;
+    char head[192];       ///< Response status line and headers
+    size_t headLength;
+    const char* body;     ///< Static page, or nullptr
+    size_t bodyLength;
+    size_t offset;        ///< Bytes of head + body, or of the frame, written
+    uint32_t sequence;    ///< Next frame to send (Streaming)
+  };
+
+  void accept();
+  void readRequest(Client& client);
+  void readFrames(Client& client);
+  void respond(Client& client);
+  void write(Client& client);
+  void closeClient(Client& client);
+  void append(DashboardRecord kind, uint32_t timeMs, uint16_t value);
+  void seal();
+  void reuseOldest();
+
+  uint16_t port_;
+  uint32_t flushMs_;
+  uint32_t periodUs_;
+  int listenFd_;
+  Client clients_[DASHBOARD_MAX_CLIENTS];
+
+  Frame frames_[DASHBOARD_FRAMES];
+  uint32_t nextSequence_;  ///< Sequence of the open frame; frames below it are sealed
+  size_t openLength_;      ///< Bytes in the open frame, from its payload start
+  uint32_t openMs_;        ///< Time of its first record
+  uint32_t lastMs_;        ///< Time of its last record
+  bool flushNow_;
+
+  uint32_t records_;
+  uint32_t frameSends_;
+  uint64_t bytesSent_;
+  uint32_t skipped_;
+  uint32_t pages_;
+  uint32_t upgrades_;
+  uint32_t dropped_;
+};
+
+#endif  // WEB_DASHBOARD_H
@@ -0,0 +1,67 @@
+/**
+ * @file WorkStealingPool.h
+ * @brief Fixed-size thread pool with per-worker deques and work stealing
+ *
+ * @details Each worker owns a deque. Submitted jobs are spread round-robin
+ * over the deques; a worker pops from the back of its own deque (newest
+ * first, cache friendly) and, when that is empty, steals from the front of
+ * the others' (oldest first). Jobs of very uneven cost — e.g. replaying a
+ * short and a long trace — therefore still keep every core busy. Host only.
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+ public:
+  /** @param threads Worker count; 0 uses every hardware thread */
+  explicit WorkStealingPool(size_t threads = 0);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /** @brief Queues a job; may be called from inside a job */
+  void submit(std::function<void()> job);
+
+  /** @brief Blocks until every submitted job has finished */
+  void wait();
+
+  size_t threadCount() const { return workers_.size(); }
+
+  /** @brief Jobs taken from another worker's deque so far */
+  size_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  void run(size_t self);
+  bool takeJob(size_t self, std::function<void()>& job);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> nextQueue_;
+  std::atomic<size_t> pending_;   ///< Submitted but not yet finished
+  std::atomic<size_t> queued_;    ///< Submitted but not yet taken
+  std::atomic<size_t> steals_;
+  std::atomic<bool> stopping_;
+  std::mutex idleMutex_;
+  std::condition_variable workAvailable_;
+  std::condition_variable allDone_;
+};
+
+#endif  // WORK_STEALING_POOL_H
@@ -0,0 +1,290 @@
+/**
+ * @file AlertPublisher.cpp
+ * @brief Alert queue, batching, backoff and persistence
+ */
+
+#include "AlertPublisher.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+const uint32_t ALERT_MAGIC = 0x51414449;  // "IDAQ"
+const size_t HEADER_BYTES = 12;           // magic, version, count, CRC
+
+void putU16(uint8_t* out, uint16_t v) {
+  out[0] = (uint8_t)v;
+  out[1] = (uint8_t)(v >> 8);
+}
+
+void putU32(uint8_t* out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out[i] = (uint8_t)(v >> (8 * i));
+}
+
+uint16_t getU16(const uint8_t* in) { return (uint16_t)(in[0] | (in[1] << 8)); }
+
+uint32_t getU32(const uint8_t* in) {
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++) v |= (uint32_t)in[i] << (8 * i);
+  return v;
+}
+
+/** @brief Serialized Alert: id, time, type, faults, count, distance */
+void putAlert(uint8_t* out, const Alert& alert) {
+  putU32(out, alert.id);
+  putU32(out + 4, alert.timeMs);
+  out[8] = (uint8_t)alert.type;
+  out[9] = alert.faults;
+  putU16(out + 10, alert.count);
+  uint32_t bits;
+  memcpy(&bits, &alert.distanceCm, sizeof(bits));
+  putU32(out + 12, bits);
+}
+
+bool getAlert(const uint8_t* in, Alert& alert) {
+  if (in[8] > (uint8_t)AlertType::SensorOk) return false;
+  alert.id = getU32(in);
+  alert.timeMs = getU32(in + 4);
+  alert.type = (AlertType)in[8];
+  alert.faults = in[9];
+  alert.count = getU16(in + 10);
+  uint32_t bits = getU32(in + 12);
+  memcpy(&alert.distanceCm, &bits, sizeof(bits));
+  return true;
+}
+
+}  // namespace
+
+const char* alertTypeName(AlertType type) {
+  switch (type) {
+    case AlertType::Intruder:
+      return "intruder";
+    case AlertType::Clear:
+      return "clear";
+    case AlertType::SensorFault:
+      return "sensor_fault";
+    case AlertType::SensorOk:
+      return "sensor_ok";
+  }
+  return "unknown";
+}
+
+size_t formatAlertBatch(const Alert* alerts, size_t count, char* out, size_t capacity) {
+  size_t n = 0;
+  int w = snprintf(out, capacity, "{\"alerts\":[");
+  if (w < 0 || (size_t)w >= capacity) return 0;
+  n = (size_t)w;
+  for (size_t i = 0; i < count; i++) {
+    const Alert& a = alerts[i];
+    w = snprintf(out + n, capacity - n,
+                 "%s{\"id\":%lu,\"type\":\"%s\",\"t_ms\":%lu,\"cm\":%.2f,\"faults\":%u,"
+                 "\"count\":%u}",
+                 i > 0 ? "," : "", (unsigned long)a.id, alertTypeName(a.type),
+                 (unsigned long)a.timeMs, (double)a.distanceCm, (unsigned)a.faults,
+                 (unsigned)a.count);
+    if (w < 0 || (size_t)w >= capacity - n) return 0;
+    n += (size_t)w;
+  }
+  w = snprintf(out + n, capacity - n, "]}");
+  if (w < 0 || (size_t)w >= capacity - n) return 0;
+  return n + (size_t)w;
+}
+
+AlertPublisher::AlertPublisher(AlertTransport& transport, ConfigBackend* store,
+                               const AlertConfig& config)
+    : transport_(transport),
+      store_(store),
+      config_(config),
+      head_(0),
+      count_(0),
+      nextId_(1),
+      idLimit_(1),
+      inFlight_(false),
+      batchLastId_(0),
+      batchSize_(0),
+      retryAtMs_(0),
+      backoffMs_(0),
+      consecutiveFailures_(0),
+      dirty_(false),
+      saveDue_(false),
+      random_(0x2545F491),
+      delivered_(0),
+      dropped_(0),
+      merged_(0),
+      requests_(0),
+      failures_(0),
+      saves_(0) {
+  if (config_.batchMax < 1) config_.batchMax = 1;
+  if (config_.batchMax > ALERT_BATCH_MAX) config_.batchMax = ALERT_BATCH_MAX;
+}
+
+size_t AlertPublisher::restore() {
+  if (store_ == nullptr) return 0;
+  uint8_t record[ALERT_RECORD_BYTES(ALERT_QUEUE_SIZE)];
+  int n = store_->read(record, sizeof(record));
+  if (n < (int)ALERT_RECORD_BYTES(0)) return 0;
+  uint16_t count = getU16(record + 6);
+  if (getU32(record) != ALERT_MAGIC || getU16(record + 4) != ALERT_RECORD_VERSION ||
+      count > ALERT_QUEUE_SIZE || (size_t)n != ALERT_RECORD_BYTES(count)) {
+    return 0;
+  }
+  const uint8_t* payload = record + HEADER_BYTES;
+  if (crc32(payload, (size_t)n - HEADER_BYTES) != getU32(record + 8)) return 0;
+  Alert restored[ALERT_QUEUE_SIZE];
+  for (size_t i = 0; i < count; i++) {
+    if (!getAlert(payload + 4 + 16 * i, restored[i])) return 0;
+  }
+  // Past every id the previous run may have used; the next poll() reserves more.
+  uint32_t limit = getU32(payload);
+  if ((int32_t)(limit - nextId_) > 0) nextId_ = limit;
+  idLimit_ = nextId_;
+  // Alerts published before this call were numbered from 1, like the
+  // previous run's: move them past its ids.
+  for (size_t i = 0; i < count_; i++) at(i).id = nextId_++;
+  for (size_t i = 0; i < count; i++) {
+    if (count_ == ALERT_QUEUE_SIZE) break;
+    // Before anything published since boot, in their original order.
+    head_ = (head_ + ALERT_QUEUE_SIZE - 1) % ALERT_QUEUE_SIZE;
+    queue_[head_] = restored[count - 1 - i];
+    count_++;
+  }
+  return count;
+}
+
+void AlertPublisher::publish(AlertType type, uint32_t timeMs, float distanceCm, uint8_t faults) {
+  for (size_t i = count_; config_.dedupWindowMs > 0 && i-- > 0;) {
+    Alert& queued = at(i);
+    if (inFlight_ && queued.id <= batchLastId_) break;  // this one and older are being sent
+    if (queued.type != type || queued.faults != faults ||
+        timeMs - queued.timeMs >= config_.dedupWindowMs) {
+      continue;
+    }
+    Alert repeat = queued;
+    remove(i);
+    repeat.id = nextId_++;
+    if (repeat.count < UINT16_MAX) repeat.count++;
+    repeat.distanceCm = distanceCm;
+    at(count_) = repeat;
+    count_++;
+    merged_++;
+    dirty_ = true;
+    return;
+  }
+  if (count_ == ALERT_QUEUE_SIZE) {
+    // Oldest first: it may already be in the batch in flight, which is fine.
+    head_ = (head_ + 1) % ALERT_QUEUE_SIZE;
+    count_--;
+    dropped_++;
+  }
+  Alert& alert = at(count_);
+  alert.id = nextId_++;
+  alert.timeMs = timeMs;
+  alert.type = type;
+  alert.faults = faults;
+  alert.count = 1;
+  alert.distanceCm = distanceCm;
+  count_++;
+  dirty_ = true;
+  saveDue_ = true;
+}
+
+void AlertPublisher::poll(uint32_t nowMs) {
+  if (inFlight_) {
+    DeliveryStatus status = transport_.poll();
+    if (status != DeliveryStatus::Pending) {
+      finishBatch(status == DeliveryStatus::Delivered, nowMs);
+    }
+  }
+  if (!inFlight_ && count_ > 0 && (int32_t)(nowMs - retryAtMs_) >= 0) startBatch(nowMs);
+  bool idsLow = (int32_t)(idLimit_ - nextId_) < ALERT_ID_BLOCK / 2;
+  if (saveDue_ || idsLow) flush();
+}
+
+void AlertPublisher::remove(size_t i) {
+  for (; i + 1 < count_; i++) at(i) = at(i + 1);
+  count_--;
+}
+
+void AlertPublisher::startBatch(uint32_t nowMs) {
+  Alert batch[ALERT_BATCH_MAX];
+  batchSize_ = count_ < config_.batchMax ? count_ : config_.batchMax;
+  for (size_t i = 0; i < batchSize_; i++) batch[i] = at(i);
+  batchLastId_ = batch[batchSize_ - 1].id;
+  size_t length = formatAlertBatch(batch, batchSize_, body_, sizeof(body_));
+  requests_++;
+  inFlight_ = true;
+  if (length == 0 || !transport_.start(body_, length)) finishBatch(false, nowMs);
+}
+
+/**
+ * @details Alerts are removed by id, so one pushed out of a full queue
+ * while its batch was in flight is not counted twice.
+ */
+void AlertPublisher::finishBatch(bool delivered, uint32_t nowMs) {
+  inFlight_ = false;
+  if (delivered) {
+    while (count_ > 0 && at(0).id <= batchLastId_) {
+      head_ = (head_ + 1) % ALERT_QUEUE_SIZE;
+      count_--;
+      delivered_++;
+    }
+    consecutiveFailures_ = 0;
+    backoffMs_ = 0;
+    retryAtMs_ = nowMs;
+    dirty_ = true;
+    saveDue_ = true;
+    return;
+  }
+  failures_++;
+  consecutiveFailures_++;
+  uint32_t backoff = config_.backoffMinMs;
+  for (uint32_t i = 1; i < consecutiveFailures_ && backoff < config_.backoffMaxMs; i++) {
+    backoff *= 2;
+  }
+  if (backoff > config_.backoffMaxMs) backoff = config_.backoffMaxMs;
+  // 50-100% of the step, so many devices do not retry in lockstep.
+  backoffMs_ = backoff / 2 + nextRandom() % (backoff / 2 + 1);
+  retryAtMs_ = nowMs + backoffMs_;
+}
+
+void AlertPublisher::flush() {
+  bool idsLow = (int32_t)(idLimit_ - nextId_) < ALERT_ID_BLOCK / 2;
+  if (store_ == nullptr || (!dirty_ && !idsLow)) return;
+  uint32_t idLimit = idsLow ? nextId_ + ALERT_ID_BLOCK : idLimit_;
+  uint8_t record[ALERT_RECORD_BYTES(ALERT_QUEUE_SIZE)];
+  putU32(record, ALERT_MAGIC);
+  putU16(record + 4, ALERT_RECORD_VERSION);
+  putU16(record + 6, (uint16_t)count_);
+  uint8_t* payload = record + HEADER_BYTES;
+  putU32(payload, idLimit);
+  for (size_t i = 0; i < count_; i++) putAlert(payload + 4 + 16 * i, at(i));
+  size_t length = ALERT_RECORD_BYTES(count_);
+  putU32(record + 8, crc32(payload, length - HEADER_BYTES));
+  if (store_->write(record, length)) {
+    idLimit_ = idLimit;
+    dirty_ = false;
+    saveDue_ = false;
+    saves_++;
+  }
+}
+
+uint32_t AlertPublisher::nextRandom() {
+  // xorshift32
+  random_ ^= random_ << 13;
+  random_ ^= random_ >> 17;
+  random_ ^= random_ << 5;
+  return random_;
+}
+
+size_t AlertPublisher::format(char* out, size_t capacity) const {
+  int n = snprintf(out, capacity,
+                   "queued=%u/%u in_flight=%s delivered=%lu dropped=%lu merged=%lu "
+                   "requests=%lu failures=%lu backoff_ms=%lu saves=%lu next_id=%lu",
+                   (unsigned)count_, (unsigned)ALERT_QUEUE_SIZE, inFlight_ ? "yes" : "no",
+                   (unsigned long)delivered_, (unsigned long)dropped_, (unsigned long)merged_,
+                   (unsigned long)requests_, (unsigned long)failures_, (unsigned long)backoffMs_,
+                   (unsigned long)saves_, (unsigned long)nextId_);
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file BootTimeline.cpp
+ * @brief Boot timestamp implementation
+ */
+
+#include "BootTimeline.h"
+
+#include <stdio.h>
+#include <string.h>
+
+bool BootTimeline::mark(const char* name, uint64_t timeUs) {
+  if (count_ >= BOOT_MAX_MARKS || has(name)) return false;
+  marks_[count_].name = name;
+  marks_[count_].timeUs = timeUs;
+  count_++;
+  return true;
+}
+
+bool BootTimeline::find(const char* name, uint64_t& timeUs) const {
+  for (size_t i = 0; i < count_; i++) {
+    if (strcmp(marks_[i].name, name) == 0) {
+      timeUs = marks_[i].timeUs;
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t BootTimeline::format(char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  size_t pos = 0;
+  out[0] = '\0';
+  for (size_t i = 0; i < count_ && pos + 1 < capacity; i++) {
+    int n = snprintf(out + pos, capacity - pos, "%s%s=%.1f", i > 0 ? " " : "", marks_[i].name,
+                     marks_[i].timeUs / 1000.0);
+    if (n < 0) break;
+    pos += (size_t)n < capacity - pos ? (size_t)n : capacity - pos - 1;
+  }
+  return pos;
+}
@@ -0,0 +1,297 @@
+/**
+ * @file CommandConsole.cpp
+ * @brief Non-blocking line console implementation
+ */
+
+#include "CommandConsole.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+/** @brief Skips leading spaces and cuts trailing ones */
+char* trim(char* text) {
+  while (isSpace(*text)) text++;
+  size_t n = strlen(text);
+  while (n > 0 && isSpace(text[n - 1])) text[--n] = '\0';
+  return text;
+}
+
+/** @brief Cuts the first word off text; returns the rest, trimmed */
+char* splitWord(char* text) {
+  char* rest = text;
+  while (*rest != '\0' && !isSpace(*rest)) rest++;
+  if (*rest != '\0') *rest++ = '\0';
+  return trim(rest);
+}
+
+}  // namespace
+
+CommandConsole::CommandConsole(ConsoleIo& io)
+    : io_(io),
+      commandCount_(0),
+      parameterCount_(0),
+      listener_(nullptr),
+      listenerContext_(nullptr),
+      length_(0),
+      overlong_(false),
+      overlongLines_(0) {}
+
+bool CommandConsole::addCommand(const char* name, const char* help, CommandHandler handler,
+                                void* context) {
+  if (commandCount_ >= CONSOLE_MAX_COMMANDS) return false;
+  Command& command = commands_[commandCount_++];
+  command.name = name;
+  command.help = help;
+  command.handler = handler;
+  command.context = context;
+  return true;
+}
+
+bool CommandConsole::addParameter(const char* name, ParamType type, void* value, float min,
+                                  float max, const char* const* choices) {
+  if (parameterCount_ >= CONSOLE_MAX_PARAMETERS) return false;
+  Parameter& parameter = parameters_[parameterCount_++];
+  parameter.name = name;
+  parameter.type = type;
+  parameter.value = value;
+  parameter.min = min;
+  parameter.max = max;
+  parameter.choices = choices;
+  return true;
+}
+
+bool CommandConsole::addFloat(const char* name, float* value, float min, float max) {
+  return addParameter(name, ParamType::Float, value, min, max, nullptr);
+}
+
+bool CommandConsole::addUint32(const char* name, uint32_t* value, uint32_t min, uint32_t max) {
+  return addParameter(name, ParamType::Uint32, value, (float)min, (float)max, nullptr);
+}
+
+bool CommandConsole::addUint8(const char* name, uint8_t* value, uint8_t min, uint8_t max) {
+  return addParameter(name, ParamType::Uint8, value, min, max, nullptr);
+}
+
+bool CommandConsole::addBool(const char* name, bool* value) {
+  return addParameter(name, ParamType::Bool, value, 0, 1, nullptr);
+}
+
+bool CommandConsole::addChoice(const char* name, uint8_t* value, const char* const* choices,
+                               uint8_t count) {
+  return addParameter(name, ParamType::Choice, value, 0, (float)(count - 1), choices);
+}
+
+/**
+ * @details Stops at the end of a line so that each poll() runs at most one
+ * command; whatever follows stays in the driver's buffer. An overlong line
+ * is consumed to its end and then reported once.
+ */
+bool CommandConsole::poll() {
+  for (size_t i = 0; i < CONSOLE_POLL_BYTES; i++) {
+    int c = io_.read();
+    if (c < 0) return false;
+    if (c == '\r' || c == '\n') {
+      if (overlong_) {
+        overlong_ = false;
+        length_ = 0;
+        overlongLines_++;
+        println("Line too long");
+        return false;
+      }
+      if (length_ == 0) continue;  // \r\n, blank lines
+      line_[length_] = '\0';
+      length_ = 0;
+      execute(line_);
+      return true;
+    }
+    if (length_ < CONSOLE_LINE_MAX) {
+      line_[length_++] = (char)c;
+    } else {
+      overlong_ = true;
+    }
+  }
+  return false;
+}
+
+void CommandConsole::execute(char* line) {
+  char* name = trim(line);
+  if (*name == '\0') return;
+  char* args = splitWord(name);
+  if (strcmp(name, "help") == 0) {
+    help();
+    return;
+  }
+  if (strcmp(name, "get") == 0) {
+    get(args);
+    return;
+  }
+  if (strcmp(name, "set") == 0) {
+    set(args);
+    return;
+  }
+  for (size_t i = 0; i < commandCount_; i++) {
+    if (strcmp(name, commands_[i].name) == 0) {
+      commands_[i].handler(*this, args, commands_[i].context);
+      return;
+    }
+  }
+  printf("Unknown command: %s (try help)\n", name);
+}
+
+void CommandConsole::help() {
+  println("help | get [name] | set <name> <value>");
+  for (size_t i = 0; i < commandCount_; i++) println(commands_[i].help);
+  print("Parameters:");
+  for (size_t i = 0; i < parameterCount_; i++) {
+    print(" ");
+    print(parameters_[i].name);
+  }
+  println("");
+}
+
+const CommandConsole::Parameter* CommandConsole::findParameter(const char* name) const {
+  for (size_t i = 0; i < parameterCount_; i++) {
+    if (strcmp(name, parameters_[i].name) == 0) return &parameters_[i];
+  }
+  return nullptr;
+}
+
+void CommandConsole::printParameter(const Parameter& parameter) {
+  switch (parameter.type) {
+    case ParamType::Float:
+      printf("%s=%.2f\n", parameter.name, (double)*(float*)parameter.value);
+      break;
+    case ParamType::Uint32:
+      printf("%s=%lu\n", parameter.name, (unsigned long)*(uint32_t*)parameter.value);
+      break;
+    case ParamType::Uint8:
+      printf("%s=%u\n", parameter.name, (unsigned)*(uint8_t*)parameter.value);
+      break;
+    case ParamType::Bool:
+      printf("%s=%s\n", parameter.name, *(bool*)parameter.value ? "on" : "off");
+      break;
+    case ParamType::Choice:
+      printf("%s=%s\n", parameter.name, parameter.choices[*(uint8_t*)parameter.value]);
+      break;
+  }
+}
+
+void CommandConsole::get(const char* args) {
+  if (*args == '\0') {
+    for (size_t i = 0; i < parameterCount_; i++) printParameter(parameters_[i]);
+    return;
+  }
+  const Parameter* parameter = findParameter(args);
+  if (parameter == nullptr) {
+    printf("Unknown parameter: %s\n", args);
+    return;
+  }
+  printParameter(*parameter);
+}
+
+bool CommandConsole::setParameter(const Parameter& parameter, const char* text) {
+  char* end = nullptr;
+  switch (parameter.type) {
+    case ParamType::Float: {
+      float value = strtof(text, &end);
+      if (*end != '\0' || !(value >= parameter.min && value <= parameter.max)) return false;
+      *(float*)parameter.value = value;
+      return true;
+    }
+    case ParamType::Uint32:
+    case ParamType::Uint8: {
+      if (*text == '-') return false;
+      unsigned long value = strtoul(text, &end, 10);
+      if (*end != '\0' || value < parameter.min || value > parameter.max) return false;
+      if (parameter.type == ParamType::Uint32) {
+        *(uint32_t*)parameter.value = (uint32_t)value;
+      } else {
+        *(uint8_t*)parameter.value = (uint8_t)value;
+      }
+      return true;
+    }
+    case ParamType::Bool:
+      if (strcmp(text, "on") == 0 || strcmp(text, "1") == 0) {
+        *(bool*)parameter.value = true;
+      } else if (strcmp(text, "off") == 0 || strcmp(text, "0") == 0) {
+        *(bool*)parameter.value = false;
+      } else {
+        return false;
+      }
+      return true;
+    case ParamType::Choice:
+      for (uint8_t i = 0; i <= (uint8_t)parameter.max; i++) {
+        if (strcmp(text, parameter.choices[i]) == 0) {
+          *(uint8_t*)parameter.value = i;
+          return true;
+        }
+      }
+      return false;
+  }
+  return false;
+}
+
+size_t CommandConsole::valueSize(ParamType type) {
+  switch (type) {
+    case ParamType::Float:
+      return sizeof(float);
+    case ParamType::Uint32:
+      return sizeof(uint32_t);
+    case ParamType::Bool:
+      return sizeof(bool);
+    case ParamType::Uint8:
+    case ParamType::Choice:
+      break;
+  }
+  return sizeof(uint8_t);
+}
+
+void CommandConsole::set(char* args) {
+  char* value = splitWord(args);
+  const Parameter* parameter = findParameter(args);
+  if (parameter == nullptr) {
+    printf("Unknown parameter: %s\n", args);
+    return;
+  }
+  uint8_t previous[sizeof(uint32_t)];
+  memcpy(previous, parameter->value, valueSize(parameter->type));
+  if (*value == '\0' || !setParameter(*parameter, value)) {
+    if (parameter->type == ParamType::Float || parameter->type == ParamType::Uint32 ||
+        parameter->type == ParamType::Uint8) {
+      printf("Invalid value for %s (%g..%g)\n", parameter->name, (double)parameter->min,
+             (double)parameter->max);
+    } else {
+      printf("Invalid value for %s\n", parameter->name);
+    }
+    return;
+  }
+  if (listener_ != nullptr && !listener_(parameter->name, listenerContext_)) {
+    memcpy(parameter->value, previous, valueSize(parameter->type));
+    printf("Rejected %s=%s\n", parameter->name, value);
+    return;
+  }
+  printParameter(*parameter);
+}
+
+void CommandConsole::print(const char* text) { io_.write(text, strlen(text)); }
+
+void CommandConsole::println(const char* text) {
+  print(text);
+  io_.write("\n", 1);
+}
+
+void CommandConsole::printf(const char* format, ...) {
+  char out[CONSOLE_OUTPUT_MAX];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(out, sizeof(out), format, args);
+  va_end(args);
+  if (n < 0) return;
+  io_.write(out, (size_t)n < sizeof(out) ? (size_t)n : sizeof(out) - 1);
+}
@@ -0,0 +1,184 @@
+/**
+ * @file ConfigStore.cpp
+ * @brief Configuration record implementation
+ */
+
+#include "ConfigStore.h"
+
+#include <string.h>
+
+#include "DetectorConsole.h"
+
+namespace {
+
+const uint32_t CONFIG_MAGIC = 0x46434449;  // "IDCF"
+const size_t HEADER_BYTES = 12;
+const size_t PAYLOAD_BYTES = CONFIG_RECORD_BYTES - HEADER_BYTES;
+
+// ============================================================================
+// Little-endian helpers
+// ============================================================================
+
+/**
+ * @brief Appends fields to a buffer the caller sized for them
+ */
+class Writer {
+ public:
+  explicit Writer(uint8_t* out) : out_(out), pos_(0) {}
+
+  void u8(uint8_t v) { out_[pos_++] = v; }
+  void u16(uint16_t v) {
+    u8((uint8_t)v);
+    u8((uint8_t)(v >> 8));
+  }
+  void u32(uint32_t v) {
+    for (int i = 0; i < 4; i++) u8((uint8_t)(v >> (8 * i)));
+  }
+  void f32(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    u32(bits);
+  }
+  size_t size() const { return pos_; }
+
+ private:
+  uint8_t* out_;
+  size_t pos_;
+};
+
+class Reader {
+ public:
+  explicit Reader(const uint8_t* in) : in_(in), pos_(0) {}
+
+  uint8_t u8() { return in_[pos_++]; }
+  uint16_t u16() {
+    uint16_t v = u8();
+    return (uint16_t)(v | (u8() << 8));
+  }
+  uint32_t u32() {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)u8() << (8 * i);
+    return v;
+  }
+  float f32() {
+    uint32_t bits = u32();
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+ private:
+  const uint8_t* in_;
+  size_t pos_;
+};
+
+}  // namespace
+
+const char* configLoadName(ConfigLoad result) {
+  switch (result) {
+    case ConfigLoad::Loaded:
+      return "loaded";
+    case ConfigLoad::Missing:
+      return "missing";
+    case ConfigLoad::Corrupt:
+      return "corrupt";
+    case ConfigLoad::Outdated:
+      return "outdated";
+  }
+  return "?";
+}
+
+/**
+ * @details Bitwise: it covers only the 49-byte payload (the record is 61
+ * bytes with its 12-byte header) and runs at boot and on save, so a 1 KB table
+ * would cost more flash than the loop saves.
+ */
+uint32_t crc32(const uint8_t* data, size_t length) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+  }
+  return ~crc;
+}
+
+size_t encodeConfigRecord(const DetectorConfig& config, uint8_t* out, size_t capacity) {
+  if (capacity < CONFIG_RECORD_BYTES) return 0;
+  Writer payload(out + HEADER_BYTES);
+  payload.f32(config.tripCm);
+  payload.f32(config.clearCm);
+  payload.f32(config.scene.tripMarginCm);
+  payload.f32(config.scene.clearMarginCm);
+  payload.f32(config.trackGateCm);
+  payload.u8(config.samplesPerReading);
+  payload.u32(config.pingSpacingMs);
+  payload.u32(config.pingJitterMs);
+  payload.u32(config.echoTimeoutUs);
+  payload.u32(config.cyclePeriodMs);
+  payload.u8(config.tripDwell);
+  payload.u8(config.clearDwell);
+  payload.u8((uint8_t)config.filter);
+  payload.u8(config.power.lightSleep ? 1 : 0);
+  payload.u32(config.power.idlePeriodMs);
+  payload.u32(config.power.idleCpuMhz);
+
+  Writer header(out);
+  header.u32(CONFIG_MAGIC);
+  header.u16(CONFIG_RECORD_VERSION);
+  header.u16((uint16_t)payload.size());
+  header.u32(crc32(out + HEADER_BYTES, payload.size()));
+  return HEADER_BYTES + payload.size();
+}
+
+ConfigLoad decodeConfigRecord(const uint8_t* data, size_t length, DetectorConfig& config) {
+  if (length < HEADER_BYTES) return ConfigLoad::Corrupt;
+  Reader header(data);
+  if (header.u32() != CONFIG_MAGIC) return ConfigLoad::Corrupt;
+  if (header.u16() != CONFIG_RECORD_VERSION) return ConfigLoad::Outdated;
+  uint16_t payloadBytes = header.u16();
+  uint32_t crc = header.u32();
+  if (payloadBytes != PAYLOAD_BYTES || length < HEADER_BYTES + payloadBytes ||
+      crc32(data + HEADER_BYTES, payloadBytes) != crc) {
+    return ConfigLoad::Corrupt;
+  }
+
+  DetectorConfig loaded = config;
+  Reader payload(data + HEADER_BYTES);
+  loaded.tripCm = payload.f32();
+  loaded.clearCm = payload.f32();
+  loaded.scene.tripMarginCm = payload.f32();
+  loaded.scene.clearMarginCm = payload.f32();
+  loaded.trackGateCm = payload.f32();
+  loaded.samplesPerReading = payload.u8();
+  loaded.pingSpacingMs = payload.u32();
+  loaded.pingJitterMs = payload.u32();
+  loaded.echoTimeoutUs = payload.u32();
+  loaded.cyclePeriodMs = payload.u32();
+  loaded.tripDwell = payload.u8();
+  loaded.clearDwell = payload.u8();
+  uint8_t filter = payload.u8();
+  loaded.power.lightSleep = payload.u8() != 0;
+  loaded.power.idlePeriodMs = payload.u32();
+  loaded.power.idleCpuMhz = payload.u32();
+
+  loaded.filter = (FilterType)filter;
+
+  // A valid CRC does not make a record from a buggy or older build safe to
+  // run: it has to pass the same checks as a `set`.
+  if (!validDetectorTuning(loaded)) return ConfigLoad::Corrupt;
+  config = loaded;
+  return ConfigLoad::Loaded;
+}
+
+ConfigLoad ConfigStore::load(DetectorConfig& config) {
+  uint8_t record[CONFIG_RECORD_BYTES];
+  int length = backend_.read(record, sizeof(record));
+  if (length < 0) return ConfigLoad::Missing;
+  return decodeConfigRecord(record, (size_t)length, config);
+}
+
+bool ConfigStore::save(const DetectorConfig& config) {
+  uint8_t record[CONFIG_RECORD_BYTES];
+  size_t length = encodeConfigRecord(config, record, sizeof(record));
+  return length > 0 && backend_.write(record, length);
+}
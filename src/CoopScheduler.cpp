@@ -0,0 +1,37 @@
+/**
+ * @file CoopScheduler.cpp
+ * @brief Cooperative task scheduler
+ */
+
+#include "CoopScheduler.h"
+
+CoopScheduler::CoopScheduler(Hal& hal) : hal_(hal), taskCount_(0), runs_(0), steps_(0) {}
+
+bool CoopScheduler::add(CoopTask& task) {
+  if (taskCount_ >= COOP_MAX_TASKS) return false;
+  task.hal_ = &hal_;
+  task.wakeUs_ = hal_.micros64();
+  tasks_[taskCount_++] = &task;
+  return true;
+}
+
+/**
+ * @details The clock is read again before each task, so a task that took a
+ * while does not make the next one run late by a stale comparison.
+ */
+uint64_t CoopScheduler::run() {
+  runs_++;
+  uint64_t nextUs = UINT64_MAX;
+  for (size_t i = 0; i < taskCount_; i++) {
+    CoopTask& task = *tasks_[i];
+    if (task.finished_) continue;
+    if (task.wakeUs_ <= hal_.micros64()) {
+      task.steps_++;
+      steps_++;
+      task.step();
+      if (task.finished_) continue;
+    }
+    if (task.wakeUs_ < nextUs) nextUs = task.wakeUs_;
+  }
+  return nextUs;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file DeadlineMonitor.cpp
+ * @brief Cycle period, jitter and deadline-miss tracking implementation
+ */
+
+#include "DeadlineMonitor.h"
+
+#include <stdio.h>
+
+DeadlineMonitor::DeadlineMonitor(const DeadlineConfig& config) : config_(config) { reset(); }
+
+void DeadlineMonitor::reset() {
+  periods_.reset();
+  started_ = false;
+  lastStartUs_ = 0;
+  lastPeriodUs_ = 0;
+  jitterUs_ = 0;
+  maxJitterUs_ = 0;
+  misses_ = 0;
+  consecutiveMisses_ = 0;
+  maxConsecutiveMisses_ = 0;
+}
+
+void DeadlineMonitor::cycleStart(uint64_t nowUs) {
+  if (!started_) {
+    started_ = true;
+    lastStartUs_ = nowUs;
+    return;
+  }
+  uint64_t elapsed = nowUs - lastStartUs_;
+  lastStartUs_ = nowUs;
+  uint32_t period = elapsed < UINT32_MAX ? (uint32_t)elapsed : UINT32_MAX;
+
+  if (periods_.count() > 0) {
+    uint32_t delta = period > lastPeriodUs_ ? period - lastPeriodUs_ : lastPeriodUs_ - period;
+    if (delta > maxJitterUs_) maxJitterUs_ = delta;
+    // J += (|D| - J) / 16, kept scaled by 16 to stay in integers.
+    jitterUs_ += delta - ((jitterUs_ + 8) >> 4);
+  }
+  periods_.record(period);
+  lastPeriodUs_ = period;
+
+  if (period > config_.budgetUs) {
+    misses_++;
+    consecutiveMisses_++;
+    if (consecutiveMisses_ > maxConsecutiveMisses_) maxConsecutiveMisses_ = consecutiveMisses_;
+  } else {
+    consecutiveMisses_ = 0;
+  }
+}
+
+size_t DeadlineMonitor::formatCounters(char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  int n = snprintf(out, capacity,
+                   "cycles=%lu misses=%lu consecutive=%lu max_consecutive=%lu budget_us=%lu "
+                   "last_us=%lu min_us=%lu max_us=%lu jitter_us=%lu max_jitter_us=%lu %s",
+                   (unsigned long)cycles(), (unsigned long)misses_,
+                   (unsigned long)consecutiveMisses_, (unsigned long)maxConsecutiveMisses_,
+                   (unsigned long)config_.budgetUs, (unsigned long)lastPeriodUs_,
+                   (unsigned long)periods_.min(), (unsigned long)periods_.max(),
+                   (unsigned long)jitterUs(), (unsigned long)maxJitterUs_,
+                   healthy() ? "healthy" : "ESCALATED");
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file DetectorConsole.cpp
+ * @brief Detector parameter registration
+ */
+
+#include "DetectorConsole.h"
+
+namespace {
+
+// The ESP32 clocks setCpuFrequencyMhz() accepts without dropping the APB
+// clock and with it the UART baud rate (see PowerScheduler.h); 0 = off.
+const uint32_t IDLE_MHZ_CHOICES[] = {0, 80, 160, 240};
+
+/** @brief False for NaN as well */
+bool inRange(float value, float min, float max) { return value >= min && value <= max; }
+
+bool distanceInRange(float cm) { return inRange(cm, 0, DETECTOR_MAX_DISTANCE_CM); }
+
+}  // namespace
+
+bool addDetectorParameters(CommandConsole& console, DetectorConfig& config) {
+  // The console keeps the pointer, so the table has to outlive this call.
+  static const char* filterNames[FILTER_TYPE_COUNT];
+  for (uint8_t i = 0; i < FILTER_TYPE_COUNT; i++) filterNames[i] = filterTypeName((FilterType)i);
+
+  const float maxCm = DETECTOR_MAX_DISTANCE_CM;
+  bool ok = true;
+  ok &= console.addFloat("trip", &config.tripCm, 0, maxCm);
+  ok &= console.addFloat("clear", &config.clearCm, 0, maxCm);
+  ok &= console.addFloat("trip_margin", &config.scene.tripMarginCm, 0, maxCm);
+  ok &= console.addFloat("clear_margin", &config.scene.clearMarginCm, 0, maxCm);
+  ok &= console.addFloat("gate", &config.trackGateCm, 0, maxCm);
+  ok &= console.addUint8("samples", &config.samplesPerReading, 1, DETECTOR_MAX_SAMPLES);
+  ok &= console.addUint32("spacing", &config.pingSpacingMs, 0, DETECTOR_MAX_SPACING_MS);
+  ok &= console.addUint32("jitter", &config.pingJitterMs, 0, DETECTOR_MAX_JITTER_MS);
+  ok &= console.addUint32("timeout", &config.echoTimeoutUs, DETECTOR_MIN_TIMEOUT_US,
+                          DETECTOR_MAX_TIMEOUT_US);
+  ok &= console.addUint32("period", &config.cyclePeriodMs, 0, DETECTOR_MAX_PERIOD_MS);
+  ok &= console.addUint8("dwell", &config.tripDwell, 1, 255);
+  ok &= console.addUint8("clear_dwell", &config.clearDwell, 1, 255);
+  // FilterType is a uint8_t enum; the console stores its index directly.
+  ok &= console.addChoice("filter", reinterpret_cast<uint8_t*>(&config.filter), filterNames,
+                          FILTER_TYPE_COUNT);
+  ok &= console.addBool("sleep", &config.power.lightSleep);
+  ok &= console.addUint32("idle_period", &config.power.idlePeriodMs, 0, DETECTOR_MAX_PERIOD_MS);
+  // Only 0, 80, 160 or 240: the range lets the rest through to the
+  // listener, whose validDetectorTuning() rejects them.
+  ok &= console.addUint32("idle_mhz", &config.power.idleCpuMhz, 0, DETECTOR_MAX_IDLE_MHZ);
+  return ok;
+}
+
+bool validDetectorTuning(const DetectorConfig& config) {
+  bool inRanges =
+      distanceInRange(config.tripCm) && distanceInRange(config.clearCm) &&
+      distanceInRange(config.scene.tripMarginCm) &&
+      distanceInRange(config.scene.clearMarginCm) && distanceInRange(config.trackGateCm) &&
+      config.samplesPerReading >= 1 && config.samplesPerReading <= DETECTOR_MAX_SAMPLES &&
+      config.pingSpacingMs <= DETECTOR_MAX_SPACING_MS &&
+      config.pingJitterMs <= DETECTOR_MAX_JITTER_MS &&
+      config.echoTimeoutUs >= DETECTOR_MIN_TIMEOUT_US &&
+      config.echoTimeoutUs <= DETECTOR_MAX_TIMEOUT_US &&
+      config.cyclePeriodMs <= DETECTOR_MAX_PERIOD_MS && config.tripDwell >= 1 &&
+      config.clearDwell >= 1 && (uint8_t)config.filter < FILTER_TYPE_COUNT &&
+      config.power.idlePeriodMs <= DETECTOR_MAX_PERIOD_MS &&
+      validIdleCpuMhz(config.power.idleCpuMhz);
+  // Margins count inwards from the baseline, so clear sits at the smaller one.
+  return inRanges && config.clearCm > config.tripCm &&
+         config.scene.clearMarginCm < config.scene.tripMarginCm &&
+         detectorCycleBudgetUs(config) <= DETECTOR_MAX_CYCLE_US;
+}
+
+bool validIdleCpuMhz(uint32_t mhz) {
+  for (uint32_t choice : IDLE_MHZ_CHOICES) {
+    if (mhz == choice) return true;
+  }
+  return false;
+}
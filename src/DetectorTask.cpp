@@ -0,0 +1,27 @@
+/**
+ * @file DetectorTask.cpp
+ * @brief Cooperative measurement cycle
+ */
+
+#include "DetectorTask.h"
+
+DetectorTask::DetectorTask(IntruderDetector& detector, uint32_t pollUs)
+    : CoopTask(pollUs), detector_(detector), samples_(0), ping_(0), pingTime_(0), readings_(0) {}
+
+void DetectorTask::step() {
+  const DetectorConfig& config = detector_.config();
+  COOP_BEGIN();
+  for (;;) {
+    samples_ = detector_.samplesPerReading();
+    for (ping_ = 0; ping_ < samples_; ping_++) {
+      pingTime_ = detector_.trigger();
+      COOP_AWAIT_ECHO(config.echoPin, HIGH, config.echoTimeoutUs, echoes_[ping_]);
+      detector_.recordPing(pingTime_, echoes_[ping_]);
+      COOP_SLEEP_FOR(detector_.nextPingSpacingUs());
+    }
+    detector_.processReading(detector_.combinePings(echoes_, samples_));
+    readings_++;
+    COOP_SLEEP_FOR((uint64_t)detector_.cycleWaitMs() * 1000);
+  }
+  COOP_END();
+}
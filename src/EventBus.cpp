@@ -0,0 +1,115 @@
+/**
+ * @file EventBus.cpp
+ * @brief Pooled synchronous event dispatch
+ */
+
+#include "EventBus.h"
+
+const char* eventTypeName(EventType type) {
+  switch (type) {
+    case EventType::SampleReady:
+      return "sample";
+    case EventType::ReadingReady:
+      return "reading";
+    case EventType::AlarmRaised:
+      return "alarm_raised";
+    case EventType::AlarmCleared:
+      return "alarm_cleared";
+    case EventType::SensorFault:
+      return "sensor_fault";
+    case EventType::Calibrated:
+      return "calibrated";
+    case EventType::Count:
+      break;
+  }
+  return "unknown";
+}
+
+EventBus::EventBus()
+    : subscriberCount_(0),
+      head_(0),
+      count_(0),
+      acquired_(false),
+      dispatching_(false),
+      maxDepth_(0),
+      published_(0),
+      dropped_(0) {}
+
+bool EventBus::subscribe(uint32_t mask, EventHandler handler, void* context) {
+  if (subscriberCount_ >= EVENT_MAX_SUBSCRIBERS) return false;
+  Subscriber& subscriber = subscribers_[subscriberCount_++];
+  subscriber.mask = mask;
+  subscriber.handler = handler;
+  subscriber.context = context;
+  return true;
+}
+
+Event* EventBus::acquire(EventType type, uint64_t timeUs) {
+  if (count_ >= EVENT_POOL_SIZE) {
+    acquired_ = false;
+    dropped_++;
+    return nullptr;
+  }
+  Event* event = &pool_[(head_ + count_) % EVENT_POOL_SIZE];
+  event->type = type;
+  event->timeUs = timeUs;
+  acquired_ = true;
+  return event;
+}
+
+void EventBus::publish() {
+  if (!acquired_) return;
+  acquired_ = false;
+  count_++;
+  if (count_ > maxDepth_) maxDepth_ = count_;
+  if (!dispatching_) dispatch();
+}
+
+/**
+ * @details The head slot stays queued while its handlers run, so events
+ * they publish go to later slots and the reference they hold stays valid.
+ */
+void EventBus::dispatch() {
+  dispatching_ = true;
+  while (count_ > 0) {
+    const Event& event = pool_[head_];
+    uint32_t bit = eventBit(event.type);
+    for (size_t i = 0; i < subscriberCount_; i++) {
+      if (subscribers_[i].mask & bit) subscribers_[i].handler(event, subscribers_[i].context);
+    }
+    published_++;
+    head_ = (uint8_t)((head_ + 1) % EVENT_POOL_SIZE);
+    count_--;
+  }
+  dispatching_ = false;
+}
+
+void EventBus::publishSample(uint64_t timeUs, uint32_t pingUs, uint32_t echoUs) {
+  Event* event = acquire(EventType::SampleReady, timeUs);
+  if (event == nullptr) return;
+  event->sample.pingUs = pingUs;
+  event->sample.echoUs = echoUs;
+  publish();
+}
+
+void EventBus::publishReading(EventType type, uint64_t timeUs, float distanceCm) {
+  Event* event = acquire(type, timeUs);
+  if (event == nullptr) return;
+  event->reading.distanceCm = distanceCm;
+  publish();
+}
+
+void EventBus::publishFault(uint64_t timeUs, uint8_t faults, uint8_t previous) {
+  Event* event = acquire(EventType::SensorFault, timeUs);
+  if (event == nullptr) return;
+  event->fault.faults = faults;
+  event->fault.previous = previous;
+  publish();
+}
+
+void EventBus::publishCalibrated(uint64_t timeUs, const SceneModel& scene) {
+  Event* event = acquire(EventType::Calibrated, timeUs);
+  if (event == nullptr) return;
+  event->calibrated.scene = &scene;
+  publish();
+}
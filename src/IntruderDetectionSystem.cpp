@@ -1,27 +1,76 @@
 /**
  * @file main.cpp
  * @brief Ultrasonic Intruder Detection System with Haptic Feedback
- * 
+ *
  * @details This program implements an intruder detection system using an ultrasonic
  * sensor (HC-SR04 or similar) to measure distance and trigger a buzzer/vibration motor
  * when an object is detected within a specified threshold. The system employs noise
  * reduction through distance averaging and hysteresis-based detection to prevent
  * false triggering.
- * 
+ *
+ * The measurement and hysteresis logic lives in IntruderDetector, which talks
+ * to the hardware through ArduinoHal. This file wires it to the pins and to
+ * the Serial output.
+ *
  * @author [Akpan Mercy Ekerette]
  * @date September 2025
  * @version 1.0
- * 
+ *
  * @hardware
  * - ESP32/Arduino compatible microcontroller
  * - HC-SR04 Ultrasonic Distance Sensor
  * - Buzzer/Vibration Motor
- * 
+ *
  * @dependencies
  * - Arduino.h
+ * - IntruderDetector.h / ArduinoHal.h (detection logic and hardware access)
+ * - SampleCodec.h (compressed distance history)
+ * - Telemetry.h (per-ping telemetry stream)
+ * - LoopProfiler.h (per-phase loop timing, dumped with the `prof` command)
+ * - LatencyProbe.h (intrusion-to-buzzer latency, `lat` commands)
+ * - DeadlineMonitor.h + esp_task_wdt.h (cycle deadlines, task watchdog)
+ * - Metrics.h (runtime counters/gauges/histograms, `metrics` commands)
+ * - SensorHealth.h (disconnected/stuck/noisy sensor alerts, `health` command)
+ * - CommandConsole.h / DetectorConsole.h (Serial commands, `get`/`set` tuning)
+ * - ConfigStore.h (tuned parameters kept in NVS, `save`/`defaults` commands)
+ * - BootTimeline.h (boot step timestamps and boot-to-armed time, `boot` command)
+ * - SummaryAggregator.h (per-second `@S` summaries instead of a line per reading)
+ * - EventBus.h / DetectorEvents.h (detector output fanned out to the sinks)
+ * - CoopScheduler.h / DetectorTask.h / SerialTasks.h (optional cooperative loop)
+ * - AlertPublisher.h (queued `@A` alert batches for a webhook bridge, `alerts` command)
+ * - MqttClient.h / SocketMqttLink.h / MqttTask.h + WiFi.h (optional MQTT publishing)
+ * - WebDashboard.h (optional live dashboard over HTTP and WebSocket)
  */
 
 #include <Arduino.h>
+#include <esp_idf_version.h>
+#include <esp_task_wdt.h>
+#include <WiFi.h>
+
+#include "AlertPublisher.h"
+#include "ArduinoHal.h"
+#include "BootTimeline.h"
+#include "CommandConsole.h"
+#include "ConfigStore.h"
+#include "CoopScheduler.h"
+#include "DeadlineMonitor.h"
+#include "DetectorConsole.h"
+#include "DetectorEvents.h"
+#include "DetectorTask.h"
+#include "EventBus.h"
+#include "IntruderDetector.h"
+#include "LatencyProbe.h"
+#include "LoopProfiler.h"
+#include "Metrics.h"
+#include "MqttClient.h"
+#include "MqttTask.h"
+#include "SampleCodec.h"
+#include "SensorHealth.h"
+#include "SerialTasks.h"
+#include "SocketMqttLink.h"
+#include "WebDashboard.h"
+#include "SummaryAggregator.h"
+#include "Telemetry.h"
 // ============================================================================
 // PIN DEFINITIONS
 // ============================================================================
@@ -43,29 +92,167 @@ const int echoPin = 18;
  */
 const int buzzerPin = 17;
 
+/**
+ * @brief GPIO pin for the latency probe's ground-truth trigger
+ * @details Wire a light barrier or push button (active HIGH, to 3.3 V) that
+ * fires when an object enters the zone. Only read in `lat on` mode.
+ */
+const int latencyTriggerPin = 4;
+
 // ============================================================================
 // CONSTANTS
 // ============================================================================
 
 /**
- * @brief Speed of sound in air at room temperature
- * @details Value in centimeters per microsecond (cm/µs)
+ * @brief Conversion factor from centimeters to inches
  */
- #define SOUND_SPEED 0.034
+ #define CM_TO_INCH 0.393701
 
 /**
- * @brief Conversion factor from centimeters to inches
+ * @brief Task watchdog timeout for the loop task, in seconds
  */
- #define CM_TO_INCH 0.393701
+#define WATCHDOG_TIMEOUT_S 5
 
-// ============================================================================
-// GLOBAL VARIABLES
-// ============================================================================
+/**
+ * @brief Allowance for Serial output on top of the detector's cycle budget
+ */
+#define DEADLINE_MARGIN_US 200000
+
+// validDetectorTuning() caps the cycle so one feed per cycle keeps the watchdog quiet.
+#if DETECTOR_MAX_CYCLE_US + DEADLINE_MARGIN_US >= WATCHDOG_TIMEOUT_S * 1000000
+#error "WATCHDOG_TIMEOUT_S must exceed DETECTOR_MAX_CYCLE_US plus DEADLINE_MARGIN_US"
+#endif
+
+/**
+ * @brief Rated range of the HC-SR04; echoes outside it count as invalid
+ */
+#define SENSOR_MIN_CM 2
+#define SENSOR_MAX_CM 400
+
+/**
+ * @brief Readings used to learn the empty scene at startup
+ * @details Keep the area clear while "Calibrating" is shown. Set to 0 for
+ * the original fixed 6/8 cm thresholds and mean filter.
+ */
+#define CALIBRATION_READINGS 20
+
+/**
+ * @brief Wait between calibration readings, in ms (0 = the cycle period)
+ * @details Nothing is detected until calibration ends, so it runs faster than
+ * the 2 Hz cycle: about 2.7 s instead of 11 s from power-up to armed
+ * (native_boot_bench).
+ */
+#define CALIBRATION_PERIOD_MS 50
+
+/**
+ * @brief Size the trip/clear gap from the measured reading noise; 0 = off
+ * @details With e.g. 4 the gap is 4 sigma, between 0.5 and 10 cm: a quiet
+ * sensor clears soon after the intruder leaves, a noisy one does not chatter
+ * (compare with native_noise_eval). Off keeps the fixed gap.
+ */
+#define ADAPTIVE_GAP_SIGMAS 0
+
+/**
+ * @brief Randomize the spacing between pings by up to this much; 0 = off
+ * @details Late echoes from far reflectors or other sensors then land at a
+ * different distance every ping and TRACK_GATE_CM drops them. Use both
+ * together (e.g. 5 ms and 5 cm, see native_ghost_eval); jitter alone makes
+ * ghosts worse. Off keeps the fixed 10 ms spacing.
+ */
+#define PING_JITTER_MS 0
+
+/** @brief Drop pings the rest of the reading does not back up; 0 = off */
+#define TRACK_GATE_CM 0
+
+/**
+ * @brief Light sleep instead of delay() between cycles (battery installs)
+ * @details Same cadence and alarm response at a fraction of the current,
+ * but Serial input typed during a sleep is lost: send a command again if it
+ * gets no answer. 0 keeps the CPU awake.
+ */
+#define LIGHT_SLEEP 0
+
+/**
+ * @brief Cycle wait while the scene is clear; 0 = every cycle waits 500 ms
+ * @details Longer waits save more battery but delay the first detection by
+ * up to this much; see native_energy_sim for the trade-off.
+ */
+#define IDLE_PERIOD_MS 0
+
+/**
+ * @brief CPU clock while the scene is quiet; 0 keeps 240 MHz throughout
+ * @details Back to 240 MHz as soon as a reading comes within 10 cm of the
+ * trip distance or the alarm is on. Only changed between readings, so echo
+ * timing is unaffected. 80 is the lowest clock that keeps the UART baud rate.
+ */
+#define IDLE_CPU_MHZ 80
+
+/**
+ * @brief Length of one `@S` summary interval, in ms
+ * @details Each interval's readings, timeouts, distance histogram and alarm
+ * time are printed as one line; `summary <ms>` changes it at runtime.
+ */
+#define SUMMARY_INTERVAL_MS 1000
+
+/**
+ * @brief Also print every reading ("Distance (cm): ...") as the original did
+ * @details Off by default: at 2 Hz that is ~100 bytes/s against ~100 bytes
+ * per summary. `readings on` turns it back on.
+ */
+#define STREAM_READINGS 0
+
+/**
+ * @brief Run the detector, console and telemetry output as cooperative tasks
+ * @details 0 keeps the sequential loop(): measure, then print, then read
+ * one command, so a command waits for the whole cycle (~0.5 s) and a
+ * telemetry line blocks in Serial.write(). With 1 the measurement yields
+ * during every echo and wait; commands are answered within 5 ms and
+ * telemetry is written as the UART has room. Light sleep is not used in
+ * this mode, and `prof`/`deadline` only cover the sequential loop.
+ */
+#define COOPERATIVE_LOOP 0
+
+/**
+ * @brief Send alarm and fault alerts as `@A` lines for a host bridge
+ * @details Only useful with a bridge on the serial port that posts each
+ * line to the webhook and answers `alerts ok|fail`: without one every batch
+ * times out and is retried. The queue is kept in NVS across reboots.
+ */
+#define ALERTS_ENABLED 0
+
+/**
+ * @brief Publish alarms, summaries and sample blocks to an MQTT broker
+ * @details Joins WiFi after the first cycle and connects to the broker at
+ * MQTT_BROKER_IP (no DNS). Topics under MQTT_TOPIC_PREFIX, each with its
+ * QoS: `alarm` (alarm and sensor fault events as JSON), `summary` (the
+ * 46-byte `@S` record) and `samples` (telemetry blocks, binary, about 6
+ * messages a minute at the default cycle). Publishing only queues; the
+ * socket is written by MqttTask between cycles, or between pings with
+ * COOPERATIVE_LOOP. WiFi stays off unless this or DASHBOARD_ENABLED is set.
+ */
+#define MQTT_ENABLED 0
+#define WIFI_SSID ""
+#define WIFI_PASSWORD ""
+#define MQTT_BROKER_IP "192.168.1.10"
+#define MQTT_BROKER_PORT 1883
+#define MQTT_TOPIC_PREFIX "intruder/"
+#define MQTT_QOS_ALARM 1
+#define MQTT_QOS_SUMMARY 0
+#define MQTT_QOS_SAMPLES 0
 
 /**
- * @brief Duration of the echo pulse in microseconds
+ * @brief Serve a live distance plot at http://<board>:DASHBOARD_PORT/
+ * @details Joins WiFi (WIFI_SSID) after the first cycle. Every ping and
+ * alarm or fault change is streamed to the open pages over one WebSocket
+ * each, up to 100 pings per binary message, sent within 100 ms; state
+ * changes go out at once. Frames are encoded once for all viewers.
  */
-long duration;
+#define DASHBOARD_ENABLED 0
+#define DASHBOARD_PORT 80
+
+// ============================================================================
+// GLOBAL VARIABLES
+// ============================================================================
 
 /**
  * @brief Measured distance in centimeters
@@ -78,139 +265,1105 @@ float distanceCm;
 float distanceInch;
 
 /**
- * @brief Intruder detection state flag
- * @details Maintains the last known detection state to implement hysteresis
- * - true: Intruder currently detected
- * - false: No intruder detected
- */
-bool intruder = false;
-
-/**
- * @brief Measures distance using ultrasonic sensor with noise reduction
- * 
- * @details Performs multiple distance measurements and returns their average
- * to reduce sensor noise and improve accuracy. Each measurement cycle:
- * 1. Sends a 10µs trigger pulse
- * 2. Measures the echo pulse duration
- * 3. Applies a 30ms timeout (~5m max range)
- * 4. Averages 5 valid readings
- * 
- * @return float Average distance in centimeters (0 if no valid readings)
- * 
- * @note The function includes a 10ms delay between measurements to allow
- * the sensor to stabilize
- */
-
-float getDistanceCm() {
-  long sum = 0;
-  for (int i = 0; i < 5; i++) {
-    // Trigger pulse
-    // Turns off or resets the trigPin of the sensor
-    digitalWrite(trigPin, LOW);
-    // Waits for a short while
-    delayMicroseconds(2);
-    // Alerts the trigPin of sensor to send signals.
-    digitalWrite(trigPin, HIGH);
-    // Sends signals for a longer while 
-    delayMicroseconds(10);
-    // Stops sending signals.
-    digitalWrite(trigPin, LOW);
-
-    // Measure echo
-    // PulseIn sets echoPin to High( alerts it to listen to bounced off signals)
-    // It records how long the signals were listened to then turns it low
-    long d = pulseIn(echoPin, HIGH, 30000); // timeout 30ms (~5m max distance)
-    if (d > 0) {
-      // Repeat for i times in containing for loop to get an average distance.
-      sum += d;
+ * @brief Compressed history of measured distances
+ * @details Distances are stored as fixed-point 1/100 cm values with millis()
+ * timestamps, using delta-of-delta / zig-zag encoding (~12 bits per sample
+ * instead of 64 for raw records). `history dump` prints it as CSV for
+ * codec_bench.
+ */
+SampleHistory history;
+
+/**
+ * @brief Per-ping telemetry (timestamp + raw echo width)
+ * @details Printed as `@B` lines that the host telemetry decoder turns into
+ * trace files for replay. Set telemetryEnabled to false to silence it.
+ */
+TelemetryStream telemetry;
+bool telemetryEnabled = true;
+
+/**
+ * @brief Per-interval summaries, and whether readings are printed as well
+ */
+SummaryAggregator summaries(SUMMARY_INTERVAL_MS);
+bool streamReadings = STREAM_READINGS != 0;
+
+/**
+ * @brief Hardware access for the detector
+ */
+ArduinoHal hal;
+
+/**
+ * @brief Detection logic (measurement + hysteresis state machine)
+ */
+IntruderDetector detector(hal);
+
+/**
+ * @brief Trigger-to-buzzer latency measurement
+ * @details Enabled with `lat on`: a rising edge on latencyTriggerPin marks
+ * the real intrusion, the next alarm is matched to it. `lat` prints the
+ * distribution.
+ */
+LatencyProbe latencyProbe;
+bool latencyMode = false;
+
+/**
+ * @brief Ground-truth trigger ISR: timestamps the event for the probe
+ */
+void IRAM_ATTR onLatencyTrigger() {
+  latencyProbe.markEvent((uint64_t)esp_timer_get_time());
+}
+
+/**
+ * @brief Per-phase timing of loop() (cycle counter based)
+ * @details Dumped and reset over Serial with the `prof` / `prof reset`
+ * commands.
+ */
+LoopProfiler profiler;
+
+/**
+ * @brief Cycle period/jitter tracking; gates the task watchdog feed
+ */
+DeadlineMonitor deadline;
+
+/**
+ * @brief Sensor fault detection on the raw pings
+ * @details A disconnected or failing sensor reads as "no intruder", so its
+ * faults are reported on their own channel (SensorFault events).
+ */
+SensorHealth sensorHealth;
+
+/**
+ * @brief Runtime metrics, queried with the `metrics` commands
+ * @details Counters and gauges are relaxed atomics, safe to bump from any
+ * task; loopDurationUs is only touched by the loop task.
+ */
+Counter pingCount;
+Counter echoTimeouts;
+Counter invalidSamples;
+Counter alarmTransitions;
+Counter alarmTimeMs;
+Gauge alarmActive;
+Gauge sampleRateHz;
+LogHistogram loopDurationUs;
+MetricsRegistry metrics;
+
+/**
+ * @brief Start of the current alarm (millis) and of the previous reading
+ */
+uint32_t alarmStartMs = 0;
+uint32_t lastReadingMs = 0;
+
+/**
+ * @brief Serial command console
+ * @details Polled once per cycle; `set` writes into tuning, which is then
+ * applied with IntruderDetector::tune().
+ */
+SerialConsoleIo consoleIo;
+CommandConsole console(consoleIo);
+DetectorConfig tuning;
+
+/**
+ * @brief Tasks of the cooperative loop (COOPERATIVE_LOOP)
+ */
+CoopScheduler scheduler(hal);
+DetectorTask detectorTask(detector);
+ConsoleTask consoleTask(console);
+TelemetryTask telemetryTask(telemetry, consoleIo);
+
+/**
+ * @brief Tuned parameters saved with `save`, applied at the next boot
+ */
+NvsConfigBackend configBackend;
+ConfigStore configStore(configBackend);
+
+/**
+ * @brief Alarm and fault alerts for the host bridge (ALERTS_ENABLED)
+ * @details The bus only queues them; poll() in loop() sends them without
+ * waiting on the UART. The queue is kept in its own NVS key across reboots.
+ */
+static_assert(sizeof(ALERT_LINE_PREFIX) + ALERT_BODY_MAX <= SERIAL_TX_BUFFER_BYTES,
+              "`@A` line must fit the TX buffer");
+SerialAlertTransport alertTransport(10000);
+NvsConfigBackend alertBackend("alerts");
+AlertPublisher alerts(alertTransport, &alertBackend);
+
+/**
+ * @brief MQTT publishing (MQTT_ENABLED)
+ * @details Sample blocks come from their own stream, so `trace off` and the
+ * `@B` output do not affect them.
+ */
+SocketMqttLink mqttLink(MQTT_BROKER_IP, MQTT_BROKER_PORT);
+MqttClient mqtt(mqttLink);
+TelemetryStream mqttSamples;
+MqttTask mqttTask(mqtt, mqttSamples);
+int mqttAlarmTopic = -1;
+int mqttSummaryTopic = -1;
+
+/**
+ * @brief Live dashboard (DASHBOARD_ENABLED)
+ */
+WebDashboard dashboard(DASHBOARD_PORT);
+
+/**
+ * @brief Boot steps in µs since reset (esp_timer), printed by `boot`
+ * @details setup() only does what the first measurement needs; the banner,
+ * metrics and console follow after the first cycle (finishBoot()).
+ */
+BootTimeline bootTimeline;
+ConfigLoad bootConfigLoad = ConfigLoad::Missing;
+size_t bootAlertsRestored = 0;
+bool bootComplete = false;
+bool firstPingSeen = false;
+uint64_t armedUs = 0;  ///< First reading that could raise the alarm, 0 until then
+
+/**
+ * @brief Prints the pending telemetry block, if any, as one `@B` line
+ */
+void emitTelemetry() {
+  size_t length;
+  uint32_t sequence;
+  const uint8_t* block = telemetry.pending(length, sequence);
+  if (block == nullptr) return;
+
+  // Static: too big for the loop task's stack.
+  static char line[TELEMETRY_LINE_MAX + 1];
+  Serial.write((const uint8_t*)line, telemetryFormatBlockLine(block, length, sequence, line));
+  telemetry.releasePending();
+}
+
+// ============================================================================
+// EVENT SUBSCRIBERS
+// ============================================================================
+
+/**
+ * @brief Detector and sensor health output, fanned out to the sinks below
+ * @details The detector and SensorHealth only publish; each sink subscribes
+ * to the events it needs, in the order listed in subscribeSinks().
+ */
+EventBus bus;
+DetectorEventSource eventSource(bus, hal);
+
+/**
+ * @brief Matches alarms to latency trigger events
+ * @details Subscribed first: the buzzer pin went HIGH just before the event
+ * was stamped.
+ */
+void onLatencyEvent(const Event& event, void*) {
+  if (!latencyMode) return;
+  if (event.type == EventType::AlarmRaised) {
+    latencyProbe.markAlarm(event.timeUs);
+  } else {
+    latencyProbe.markClear(event.timeUs);
+  }
+}
+
+/**
+ * @brief Marks the first ping and the first reading that could alarm
+ */
+void onBootEvent(const Event& event, void*) {
+  if (event.type == EventType::SampleReady) {
+    if (!firstPingSeen) firstPingSeen = bootTimeline.mark("first_ping", event.timeUs);
+    return;
+  }
+  if (armedUs == 0 && detector.protecting()) {
+    armedUs = event.timeUs;
+    bootTimeline.mark("armed", armedUs);
+    Serial.printf("Boot: armed %.1f ms after reset\n", armedUs / 1000.0);
+  }
+}
+
+/**
+ * @brief Feeds every ping to the fault checks (faults come back as events)
+ */
+void onHealthEvent(const Event& event, void*) { sensorHealth.addSample(event.sample.echoUs); }
+
+/**
+ * @brief Ping, reading and alarm counters for the `metrics` commands
+ */
+void onMetricsEvent(const Event& event, void*) {
+  switch (event.type) {
+    case EventType::SampleReady: {
+      pingCount.add();
+      uint32_t echoUs = event.sample.echoUs;
+      if (echoUs == 0) {
+        echoTimeouts.add();
+      } else {
+        float cm = echoToDistanceCm(echoUs);
+        if (cm < SENSOR_MIN_CM || cm > SENSOR_MAX_CM) invalidSamples.add();
+      }
+      break;
+    }
+    case EventType::ReadingReady: {
+      uint32_t nowMs = millis();
+      if (lastReadingMs != 0 && nowMs != lastReadingMs) {
+        sampleRateHz.set(1000.0f / (float)(nowMs - lastReadingMs));
+      }
+      lastReadingMs = nowMs;
+      break;
+    }
+    case EventType::AlarmRaised:
+      alarmTransitions.add();
+      alarmActive.set(1);
+      alarmStartMs = millis();
+      break;
+    case EventType::AlarmCleared:
+      alarmTransitions.add();
+      alarmActive.set(0);
+      alarmTimeMs.add(millis() - alarmStartMs);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Records each ping into the `@B` telemetry stream
+ */
+void onTelemetryEvent(const Event& event, void*) {
+  if (telemetryEnabled) telemetry.record(event.sample.pingUs, event.sample.echoUs);
+}
+
+/**
+ * @brief Keeps the last distance and its compressed history
+ */
+void onHistoryEvent(const Event& event, void*) {
+  distanceCm = event.reading.distanceCm;
+  distanceInch = distanceCm * CM_TO_INCH;
+  history.append(millis(), (int32_t)(distanceCm * DISTANCE_FIXED_SCALE + 0.5f));
+}
+
+/**
+ * @brief Adds pings, readings and alarm time to the `@S` interval summary
+ */
+void onSummaryEvent(const Event& event, void*) {
+  switch (event.type) {
+    case EventType::SampleReady:
+      summaries.addPing(event.sample.echoUs);
+      break;
+    case EventType::ReadingReady:
+      summaries.addReading(event.reading.distanceCm);
+      break;
+    case EventType::AlarmRaised:
+    case EventType::AlarmCleared:
+      summaries.setAlarm(event.type == EventType::AlarmRaised, millis());
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Prints readings (if streamed), alarms, faults and calibration
+ */
+void onSerialEvent(const Event& event, void*) {
+  switch (event.type) {
+    case EventType::ReadingReady:
+      if (!streamReadings) break;
+      Serial.print("Distance (cm): ");
+      Serial.println(distanceCm);
+      Serial.print("Distance (inch): ");
+      Serial.println(distanceInch);
+      break;
+    case EventType::AlarmRaised:
+      Serial.println("⚠ Intruder detected!");
+      break;
+    case EventType::AlarmCleared:
+      Serial.println("Area clear");
+      break;
+    case EventType::SensorFault: {
+      // The detector is blind while the sensor is faulty.
+      char names[64];
+      formatSensorFaults(event.fault.faults, names, sizeof(names));
+      if (event.fault.faults != 0) {
+        Serial.print("⚠ Sensor fault: ");
+        Serial.print(names);
+        Serial.println(" (detection unreliable)");
+      } else {
+        Serial.println("Sensor OK");
+      }
+      break;
+    }
+    case EventType::Calibrated: {
+      const SceneModel& scene = *event.calibrated.scene;
+      char line[128];
+      scene.format(line, sizeof(line));
+      if (scene.ready()) {
+        Serial.print("Scene calibrated: ");
+      } else {
+        Serial.print("Scene calibration failed, using fixed thresholds: ");
+      }
+      Serial.println(line);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Queues an alert for each alarm transition and sensor fault change
+ */
+void onAlertEvent(const Event& event, void*) {
+  uint32_t nowMs = millis();
+  switch (event.type) {
+    case EventType::AlarmRaised:
+      alerts.publish(AlertType::Intruder, nowMs, event.reading.distanceCm);
+      break;
+    case EventType::AlarmCleared:
+      alerts.publish(AlertType::Clear, nowMs, event.reading.distanceCm);
+      break;
+    case EventType::SensorFault:
+      alerts.publish(event.fault.faults != 0 ? AlertType::SensorFault : AlertType::SensorOk,
+                     nowMs, 0, event.fault.faults);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Queues sample blocks and alarm/fault events for MQTT
+ */
+void onMqttEvent(const Event& event, void*) {
+  AlertType type;
+  switch (event.type) {
+    case EventType::SampleReady:
+      mqttSamples.record(event.sample.pingUs, event.sample.echoUs);
+      return;
+    case EventType::AlarmRaised:
+      type = AlertType::Intruder;
+      break;
+    case EventType::AlarmCleared:
+      type = AlertType::Clear;
+      break;
+    case EventType::SensorFault:
+      type = event.fault.faults != 0 ? AlertType::SensorFault : AlertType::SensorOk;
+      break;
+    default:
+      return;
+  }
+  bool alarm = type == AlertType::Intruder || type == AlertType::Clear;
+  char json[96];
+  int n = snprintf(json, sizeof(json), "{\"event\":\"%s\",\"t_ms\":%lu,\"cm\":%.2f,\"faults\":%u}",
+                   alertTypeName(type), (unsigned long)millis(),
+                   alarm ? (double)event.reading.distanceCm : 0.0,
+                   alarm ? 0u : (unsigned)event.fault.faults);
+  if (n > 0) mqtt.publish(mqttAlarmTopic, (const uint8_t*)json, (size_t)n);
+}
+
+/**
+ * @brief Streams pings and alarm/fault changes to the dashboard viewers
+ */
+void onDashboardEvent(const Event& event, void*) {
+  uint32_t timeMs = (uint32_t)(event.timeUs / 1000);
+  switch (event.type) {
+    case EventType::SampleReady:
+      dashboard.sample(timeMs, event.sample.echoUs ? echoToDistanceCm(event.sample.echoUs) : 0);
+      break;
+    case EventType::AlarmRaised:
+      dashboard.state(DashboardRecord::Intruder, timeMs,
+                      (uint16_t)(event.reading.distanceCm * 10 + 0.5f));
+      break;
+    case EventType::AlarmCleared:
+      dashboard.state(DashboardRecord::Clear, timeMs,
+                      (uint16_t)(event.reading.distanceCm * 10 + 0.5f));
+      break;
+    case EventType::SensorFault:
+      dashboard.state(DashboardRecord::Fault, timeMs, event.fault.faults);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * @brief Subscribes the sinks; a new one (flash log, network alert) goes here
+ */
+void subscribeSinks() {
+  const uint32_t alarms = eventBit(EventType::AlarmRaised) | eventBit(EventType::AlarmCleared);
+  const uint32_t samples = eventBit(EventType::SampleReady);
+  const uint32_t readings = eventBit(EventType::ReadingReady);
+  bus.subscribe(alarms, onLatencyEvent);
+  bus.subscribe(samples | readings, onBootEvent);
+  bus.subscribe(samples, onHealthEvent);
+  bus.subscribe(samples | readings | alarms, onMetricsEvent);
+  bus.subscribe(samples, onTelemetryEvent);
+  bus.subscribe(readings, onHistoryEvent);
+  bus.subscribe(samples | readings | alarms, onSummaryEvent);
+  bus.subscribe(readings | alarms | eventBit(EventType::SensorFault) |
+                    eventBit(EventType::Calibrated),
+                onSerialEvent);
+  if (ALERTS_ENABLED) bus.subscribe(alarms | eventBit(EventType::SensorFault), onAlertEvent);
+  if (MQTT_ENABLED) bus.subscribe(samples | alarms | eventBit(EventType::SensorFault), onMqttEvent);
+  if (DASHBOARD_ENABLED) {
+    bus.subscribe(samples | alarms | eventBit(EventType::SensorFault), onDashboardEvent);
+  }
+}
+
+/**
+ * @brief Starts joining WiFi; returns at once
+ */
+void startWifi() {
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+}
+
+/**
+ * @brief Registers the MQTT topics; the client connects once WiFi is up
+ */
+void startMqtt() {
+  mqttAlarmTopic = mqtt.addTopic(MQTT_TOPIC_PREFIX "alarm", MQTT_QOS_ALARM);
+  mqttSummaryTopic = mqtt.addTopic(MQTT_TOPIC_PREFIX "summary", MQTT_QOS_SUMMARY);
+  mqttTask.setSamplesTopic(mqtt.addTopic(MQTT_TOPIC_PREFIX "samples", MQTT_QOS_SAMPLES));
+  if (COOPERATIVE_LOOP) scheduler.add(mqttTask);
+}
+
+/**
+ * @brief Opens the dashboard's listening socket (lwIP is up after WiFi.mode())
+ */
+void startDashboard() {
+  if (!dashboard.begin()) {
+    Serial.println("Dashboard: listen failed");
+    return;
+  }
+  if (COOPERATIVE_LOOP) scheduler.add(dashboard);
+}
+
+/**
+ * @brief Prints the loop profile: a summary table and one `@H` line per phase
+ */
+void printProfile() {
+  char line[512];
+  Serial.printf("Loop profile (%lu ticks/us, CPU now %lu MHz)\n",
+                (unsigned long)LoopProfiler::ticksPerUs(), (unsigned long)hal.cpuFrequencyMhz());
+  Serial.println(histogramSummaryHeader());
+  for (size_t i = 0; i < (size_t)LoopPhase::Count; i++) {
+    profiler.formatPhase((LoopPhase)i, line, sizeof(line));
+    Serial.println(line);
+  }
+  for (size_t i = 0; i < (size_t)LoopPhase::Count; i++) {
+    profiler.formatHistogram((LoopPhase)i, line, sizeof(line));
+    Serial.println(line);
+  }
+}
+
+/**
+ * @brief Prints the latency probe counts, summary and `@H latency` line
+ */
+void printLatency() {
+  char line[512];
+  latencyProbe.formatCounts(line, sizeof(line));
+  Serial.printf("Latency probe %s: %s\n", latencyMode ? "on" : "off", line);
+  Serial.println(histogramSummaryHeader());
+  formatHistogramSummary("latency", 1, latencyProbe.histogram(), line, sizeof(line));
+  Serial.println(line);
+  formatHistogramLine("latency", 1, latencyProbe.histogram(), line, sizeof(line));
+  Serial.println(line);
+}
+
+/**
+ * @brief Starts or stops listening to the latency trigger input
+ */
+void setLatencyMode(bool enabled) {
+  if (enabled && !latencyMode) {
+    pinMode(latencyTriggerPin, INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(latencyTriggerPin), onLatencyTrigger, RISING);
+  } else if (!enabled && latencyMode) {
+    detachInterrupt(digitalPinToInterrupt(latencyTriggerPin));
+  }
+  latencyMode = enabled;
+  Serial.printf("Latency probe %s (trigger on GPIO %d)\n", enabled ? "on" : "off",
+                latencyTriggerPin);
+}
+
+/**
+ * @brief Prints the deadline counters and the cycle period distribution
+ */
+void printDeadline() {
+  char line[512];
+  deadline.formatCounters(line, sizeof(line));
+  Serial.println(line);
+  Serial.println(histogramSummaryHeader());
+  formatHistogramSummary("period", 1, deadline.periods(), line, sizeof(line));
+  Serial.println(line);
+  formatHistogramLine("period", 1, deadline.periods(), line, sizeof(line));
+  Serial.println(line);
+}
+
+uint32_t telemetryOverflows(const void*) { return telemetry.overflows(); }
+uint32_t latencyDropped(const void*) { return latencyProbe.dropped(); }
+uint32_t deadlineMisses(const void*) { return deadline.misses(); }
+uint32_t sensorFaults(const void*) { return sensorHealth.faults(); }
+uint32_t lightSleeps(const void*) { return detector.power().sleeps(); }
+uint32_t bootArmedMs(const void*) { return (uint32_t)(armedUs / 1000); }
+
+/**
+ * @brief Registers the metrics reported by the `metrics` commands
+ */
+void registerMetrics() {
+  metrics.addCounter("pings", &pingCount);
+  metrics.addCounter("echo_timeouts", &echoTimeouts);
+  metrics.addCounter("invalid_samples", &invalidSamples);
+  metrics.addCounter("alarm_transitions", &alarmTransitions);
+  metrics.addCounter("alarm_time_ms", &alarmTimeMs);
+  metrics.addGauge("alarm_active", &alarmActive);
+  metrics.addGauge("sample_rate_hz", &sampleRateHz);
+  metrics.addHistogram("loop_us", &loopDurationUs);
+  metrics.addProbe("telemetry_overflows", telemetryOverflows, nullptr);
+  metrics.addProbe("latency_queue_drops", latencyDropped, nullptr);
+  metrics.addProbe("deadline_misses", deadlineMisses, nullptr);
+  metrics.addProbe("sensor_faults", sensorFaults, nullptr);
+  metrics.addProbe("light_sleeps", lightSleeps, nullptr);
+  metrics.addProbe("boot_armed_ms", bootArmedMs, nullptr);
+}
+
+/**
+ * @brief Prints one `name kind value` line per metric
+ */
+void printMetrics() {
+  char line[160];
+  Serial.printf("Metrics at %lu ms\n", (unsigned long)millis());
+  for (size_t i = 0; i < metrics.size(); i++) {
+    metrics.formatEntry(i, line, sizeof(line));
+    Serial.println(line);
+  }
+}
+
+/**
+ * @brief Prints a binary metrics snapshot as one `@M` hex line
+ */
+void printMetricsSnapshot() {
+  static uint8_t snapshot[METRICS_SNAPSHOT_MAX_BYTES];
+  size_t length = metrics.encodeSnapshot(millis(), snapshot, sizeof(snapshot));
+  Serial.print(METRICS_SNAPSHOT_PREFIX);
+  char hex[65];
+  for (size_t i = 0; i < length; i += 32) {
+    size_t n = length - i < 32 ? length - i : 32;
+    telemetryToHex(snapshot + i, n, hex);
+    hex[2 * n] = '\0';
+    Serial.print(hex);
+  }
+  Serial.println();
+}
+
+/**
+ * @brief Prints the last closed interval as one `@S` hex line
+ */
+void printSummary() {
+  uint8_t encoded[SUMMARY_BYTES];
+  size_t length = encodeSummary(summaries.summary(), encoded, sizeof(encoded));
+  char hex[2 * SUMMARY_BYTES + 1];
+  telemetryToHex(encoded, length, hex);
+  hex[2 * length] = '\0';
+  Serial.print(SUMMARY_PREFIX);
+  Serial.println(hex);
+  if (MQTT_ENABLED) mqtt.publish(mqttSummaryTopic, encoded, length);
+}
+
+/**
+ * @brief Subscribes the loop task to the task watchdog
+ * @details The Arduino core usually has the watchdog running already for the
+ * idle tasks. Its timeout is replaced with WATCHDOG_TIMEOUT_S, which
+ * validDetectorTuning()'s cycle cap is sized against, while the idle tasks the
+ * core's sdkconfig watches stay subscribed.
+ */
+void startWatchdog() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_task_wdt_config_t wdt;
+  wdt.timeout_ms = WATCHDOG_TIMEOUT_S * 1000;
+  wdt.idle_core_mask = 0;
+#ifdef CONFIG_ESP_TASK_WDT_CHECK_IDLE_TASK_CPU0
+  wdt.idle_core_mask |= 1 << 0;
+#endif
+#ifdef CONFIG_ESP_TASK_WDT_CHECK_IDLE_TASK_CPU1
+  wdt.idle_core_mask |= 1 << 1;
+#endif
+  wdt.trigger_panic = true;
+  if (esp_task_wdt_reconfigure(&wdt) != ESP_OK) esp_task_wdt_init(&wdt);
+#else
+  // IDF 4 keeps the idle-task subscriptions when only the timeout changes.
+  esp_task_wdt_init(WATCHDOG_TIMEOUT_S, true);
+#endif
+  esp_task_wdt_add(NULL);
+}
+
+/**
+ * @brief Feeds the task watchdog from inside a long cycle
+ * @details Through the same deadline.healthy() gate as loop(), so a long
+ * command cannot keep a board alive that the deadline monitor gave up on.
+ */
+void feedWatchdog() {
+  if (deadline.healthy()) esp_task_wdt_reset();
+}
+
+// ============================================================================
+// SERIAL COMMANDS
+// ============================================================================
+
+void cmdProf(CommandConsole& out, const char* args, void*) {
+  if (args[0] == '\0') {
+    printProfile();
+  } else if (strcmp(args, "reset") == 0) {
+    profiler.reset();
+    out.println("Profile cleared");
+  } else {
+    out.println("Usage: prof [reset]");
+  }
+}
+
+void cmdDeadline(CommandConsole& out, const char* args, void*) {
+  if (args[0] == '\0') {
+    printDeadline();
+  } else if (strcmp(args, "reset") == 0) {
+    deadline.reset();
+    out.println("Deadline counters cleared");
+  } else {
+    out.println("Usage: deadline [reset]");
+  }
+}
+
+void cmdLat(CommandConsole& out, const char* args, void*) {
+  if (args[0] == '\0') {
+    printLatency();
+  } else if (strcmp(args, "on") == 0) {
+    setLatencyMode(true);
+  } else if (strcmp(args, "off") == 0) {
+    setLatencyMode(false);
+  } else if (strcmp(args, "reset") == 0) {
+    latencyProbe.reset();
+    out.println("Latency probe cleared");
+  } else {
+    out.println("Usage: lat [on|off|reset]");
+  }
+}
+
+void cmdScene(CommandConsole& out, const char*, void*) {
+  char line[128];
+  detector.scene().format(line, sizeof(line));
+  out.printf("Scene: %s\n", line);
+  float tripCm, clearCm;
+  detector.thresholds(tripCm, clearCm);
+  out.printf("In use: trip=%.2f clear=%.2f reading_noise=%.2f%s\n", tripCm, clearCm,
+             detector.noise().sigmaCm(), detector.noise().ready() ? "" : " (warming up)");
+}
+
+void cmdCalibrate(CommandConsole& out, const char*, void*) {
+  detector.scene().start();
+  out.println("Calibrating, keep the area clear...");
+}
+
+void cmdHealth(CommandConsole& out, const char*, void*) {
+  char line[160];
+  sensorHealth.format(line, sizeof(line));
+  out.printf("Sensor health: %s\n", line);
+}
+
+void cmdPower(CommandConsole& out, const char*, void*) {
+  char line[128];
+  detector.power().formatCounters(line, sizeof(line));
+  out.printf("Power: %s\n", line);
+}
+
+void cmdMetrics(CommandConsole& out, const char* args, void*) {
+  if (args[0] == '\0') {
+    printMetrics();
+  } else if (strcmp(args, "bin") == 0) {
+    printMetricsSnapshot();
+  } else if (strcmp(args, "reset") == 0) {
+    metrics.reset();
+    out.println("Metrics cleared");
+  } else {
+    out.println("Usage: metrics [bin|reset]");
+  }
+}
+
+/**
+ * @brief Parses an optional on/off argument
+ * @return false if args is neither empty, "on" nor "off"
+ */
+bool parseOnOff(const char* args, bool& value) {
+  if (args[0] == '\0') return true;
+  if (strcmp(args, "on") == 0) {
+    value = true;
+  } else if (strcmp(args, "off") == 0) {
+    value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void cmdArm(CommandConsole& out, const char* args, void*) {
+  bool armed = detector.armed();
+  if (!parseOnOff(args, armed)) {
+    out.println("Usage: arm [on|off]");
+    return;
+  }
+  if (armed != detector.armed()) detector.setArmed(armed);
+  out.printf("Alarm %s\n", detector.armed() ? "armed" : "disarmed");
+}
+
+void cmdTrace(CommandConsole& out, const char* args, void*) {
+  if (!parseOnOff(args, telemetryEnabled)) {
+    out.println("Usage: trace [on|off]");
+    return;
+  }
+  out.printf("Telemetry %s\n", telemetryEnabled ? "on" : "off");
+}
+
+/**
+ * @brief Applies a `set` to the detector
+ * @details Rejects a cycle the watchdog would not survive (see
+ * validDetectorTuning()). A longer cycle needs a larger deadline budget, or
+ * the watchdog would read the new period as overruns.
+ */
+bool onParameterSet(const char*, void*) {
+  if (!validDetectorTuning(tuning)) return false;
+  detector.tune(tuning);
+  DeadlineConfig deadlineConfig = deadline.config();
+  deadlineConfig.budgetUs = detector.cycleBudgetUs() + DEADLINE_MARGIN_US;
+  deadline.setConfig(deadlineConfig);
+  return true;
+}
+
+/**
+ * @brief Compiled configuration: the pins and the build-time defines
+ */
+DetectorConfig defaultConfig() {
+  DetectorConfig config;
+  config.trigPin = trigPin;
+  config.echoPin = echoPin;
+  config.buzzerPin = buzzerPin;
+  config.scene.calibrationReadings = CALIBRATION_READINGS;
+  config.scene.calibrationPeriodMs = CALIBRATION_PERIOD_MS;
+  // Mean counts timeouts as 0 cm, which baseline-relative thresholds would see.
+  if (CALIBRATION_READINGS > 0) config.filter = FilterType::Median;
+  config.noise.adaptive = ADAPTIVE_GAP_SIGMAS > 0;
+  config.noise.gapSigmas = ADAPTIVE_GAP_SIGMAS;
+  config.pingJitterMs = PING_JITTER_MS;
+  config.trackGateCm = TRACK_GATE_CM;
+  config.power.lightSleep = LIGHT_SLEEP != 0;
+  config.power.idlePeriodMs = IDLE_PERIOD_MS;
+  config.power.idleCpuMhz = IDLE_CPU_MHZ;
+  return config;
+}
+
+void cmdReadings(CommandConsole& out, const char* args, void*) {
+  if (!parseOnOff(args, streamReadings)) {
+    out.println("Usage: readings [on|off]");
+    return;
+  }
+  out.printf("Reading lines %s\n", streamReadings ? "on" : "off");
+}
+
+void cmdSummary(CommandConsole& out, const char* args, void*) {
+  if (args[0] == '\0') {
+    char line[192];
+    formatSummary(summaries.summary(), line, sizeof(line));
+    out.printf("Summary every %lu ms, last: %s\n", (unsigned long)summaries.intervalMs(), line);
+    return;
+  }
+  char* end = nullptr;
+  unsigned long ms = strtoul(args, &end, 10);
+  if (*end != '\0' || ms < 100 || ms > 3600000) {
+    out.println("Usage: summary [ms] (100..3600000)");
+    return;
+  }
+  summaries.setIntervalMs((uint32_t)ms);
+  out.printf("Summary every %lu ms\n", ms);
+}
+
+void cmdBoot(CommandConsole& out, const char*, void*) {
+  char line[256];
+  bootTimeline.format(line, sizeof(line));
+  out.printf("Boot (ms since reset): %s\n", line);
+  if (armedUs == 0) out.println("Not armed yet");
+}
+
+void cmdBus(CommandConsole& out, const char*, void*) {
+  out.printf("Event bus: subscribers=%u published=%lu dropped=%lu max_depth=%u/%u\n",
+             (unsigned)bus.subscribers(), (unsigned long)bus.published(),
+             (unsigned long)bus.dropped(), (unsigned)bus.maxDepth(), (unsigned)EVENT_POOL_SIZE);
+}
+
+/**
+ * @brief `alerts` prints the queue; `alerts ok|fail` is the bridge's answer
+ */
+void cmdAlerts(CommandConsole& out, const char* args, void*) {
+  if (!ALERTS_ENABLED) {
+    out.println("Alerts off (ALERTS_ENABLED 0)");
+    return;
+  }
+  if (strcmp(args, "ok") == 0 || strcmp(args, "fail") == 0) {
+    alertTransport.answer(args[0] == 'o');
+    return;
+  }
+  if (args[0] != '\0') {
+    out.println("Usage: alerts [ok|fail]");
+    return;
+  }
+  char line[192];
+  alerts.format(line, sizeof(line));
+  out.printf("Alerts: %s\n", line);
+}
+
+void cmdMqtt(CommandConsole& out, const char*, void*) {
+  if (!MQTT_ENABLED) {
+    out.println("MQTT off (MQTT_ENABLED 0)");
+    return;
+  }
+  char line[192];
+  mqtt.format(line, sizeof(line));
+  out.printf("MQTT: %s blocks=%lu block_overflows=%lu\n", line,
+             (unsigned long)mqttTask.blocks(), (unsigned long)mqttSamples.overflows());
+}
+
+void cmdDash(CommandConsole& out, const char*, void*) {
+  if (!DASHBOARD_ENABLED) {
+    out.println("Dashboard off (DASHBOARD_ENABLED 0)");
+    return;
+  }
+  char line[192];
+  dashboard.format(line, sizeof(line));
+  out.printf("Dashboard: http://%s:%u/ %s\n", WiFi.localIP().toString().c_str(),
+             (unsigned)dashboard.port(), line);
+}
+
+/**
+ * @brief `history`: size of the compressed history; `history dump`: its
+ * readings as `timestampMs,distanceCm` lines, oldest first
+ */
+void cmdHistory(CommandConsole& out, const char* args, void*) {
+  bool dump = strcmp(args, "dump") == 0;
+  if (args[0] != '\0' && !dump) {
+    out.println("Usage: history [dump]");
+    return;
+  }
+  size_t bytes = 0;
+  uint32_t kept = 0;
+  for (size_t i = 0; i < history.blockCount(); i++) {
+    size_t length;
+    const uint8_t* block = history.block(i, length);
+    SampleBlockDecoder decoder;
+    if (!decoder.begin(block, length)) continue;
+    bytes += length;
+    kept += decoder.count();
+    if (!dump) continue;
+    uint32_t timestamp;
+    int32_t value;
+    while (decoder.next(timestamp, value)) {
+      out.printf("%lu,%.2f\n", (unsigned long)timestamp, (double)value / DISTANCE_FIXED_SCALE);
     }
-    // Wait a short while for each iteration of sending waves.
-    delay(10);
+    // A full dump takes a second or two at 115200 baud.
+    feedWatchdog();
   }
-  // Takes a stable average of the i iterations.
-  long avg = sum / 5;
-  return (avg * SOUND_SPEED) / 2;
+  out.printf("History: %lu readings in %u blocks, %u bytes (%lu recorded)\n",
+             (unsigned long)kept, (unsigned)history.blockCount(), (unsigned)bytes,
+             (unsigned long)history.totalSamples());
+}
+
+void cmdSave(CommandConsole& out, const char*, void*) {
+  out.println(configStore.save(tuning) ? "Config saved" : "Config save failed");
+}
+
+void cmdDefaults(CommandConsole& out, const char*, void*) {
+  bool erased = configStore.erase();
+  tuning = defaultConfig();
+  onParameterSet(nullptr, nullptr);
+  out.println(erased ? "Compiled defaults restored" : "Defaults applied, stored config not erased");
+}
+
+/**
+ * @brief Registers the Serial commands and the tunable parameters
+ */
+void registerCommands() {
+  console.addCommand("prof", "prof [reset]", cmdProf);
+  console.addCommand("deadline", "deadline [reset]", cmdDeadline);
+  console.addCommand("lat", "lat [on|off|reset]", cmdLat);
+  console.addCommand("scene", "scene", cmdScene);
+  console.addCommand("calibrate", "calibrate", cmdCalibrate);
+  console.addCommand("health", "health", cmdHealth);
+  console.addCommand("power", "power", cmdPower);
+  console.addCommand("metrics", "metrics [bin|reset]", cmdMetrics);
+  console.addCommand("arm", "arm [on|off]", cmdArm);
+  console.addCommand("trace", "trace [on|off]", cmdTrace);
+  console.addCommand("readings", "readings [on|off]", cmdReadings);
+  console.addCommand("summary", "summary [ms]", cmdSummary);
+  console.addCommand("boot", "boot", cmdBoot);
+  console.addCommand("bus", "bus", cmdBus);
+  console.addCommand("alerts", "alerts [ok|fail]", cmdAlerts);
+  console.addCommand("mqtt", "mqtt", cmdMqtt);
+  console.addCommand("dash", "dash", cmdDash);
+  console.addCommand("history", "history [dump]", cmdHistory);
+  console.addCommand("save", "save", cmdSave);
+  console.addCommand("defaults", "defaults", cmdDefaults);
+  tuning = detector.config();
+  addDetectorParameters(console, tuning);
+  console.setParameterListener(onParameterSet, nullptr);
 }
 
 /**
  * @brief System initialization routine
- * 
+ *
  * @details Configures hardware pins, initializes serial communication,
  * and sets the system to a safe initial state. Executed once at startup.
- * 
+ *
  * Serial Configuration:
  * - Baud rate: 115200
- * 
+ *
  * Pin Configuration:
  * - trigPin: OUTPUT (sensor trigger)
  * - echoPin: INPUT (sensor echo)
  * - buzzerPin: OUTPUT (haptic feedback, initially LOW)
- * 
+ *
  * @return void
  */
 void setup() {
+  bootTimeline.mark("setup", hal.micros64());
+  // Critical path first: the area is unguarded until the detector runs.
+  // One NVS read, compiled defaults on failure.
+  DetectorConfig config = defaultConfig();
+  bootConfigLoad = configStore.load(config);
+  bootTimeline.mark("config", hal.micros64());
+  // Before the bus delivers the first alarm, so new alerts get ids past the
+  // ones the previous run used.
+  if (ALERTS_ENABLED) bootAlertsRestored = alerts.restore();
+  detector.setConfig(config);
+  subscribeSinks();
+  detector.setListener(&eventSource);
+  detector.setProfiler(&profiler);
+  detector.begin();
+  bootTimeline.mark("pins", hal.micros64());
+  sensorHealth.setListener(&eventSource);
+  summaries.start(millis());
+  // Readings are printed from the first cycle on. The TX buffer holds a
+  // whole `@B` line, so TelemetryTask can write it in one go.
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER_BYTES);
   Serial.begin(115200);
-  //OUTPUT here denotes OUTPUT from the micro-controller
-  //INPUT here denotes INPUT from the micro-controller
-  pinMode(trigPin, OUTPUT);
-  pinMode(echoPin, INPUT);
-  pinMode(buzzerPin, OUTPUT);
-  // System starts with the vibrating motor off
-  digitalWrite(buzzerPin, LOW);
+
+  DeadlineConfig deadlineConfig;
+  deadlineConfig.budgetUs = detector.cycleBudgetUs() + DEADLINE_MARGIN_US;
+  deadline.setConfig(deadlineConfig);
+  startWatchdog();
+  if (COOPERATIVE_LOOP) {
+    scheduler.add(detectorTask);
+    scheduler.add(consoleTask);
+    scheduler.add(telemetryTask);
+  }
+}
+
+/**
+ * @brief Start-up work the detector does not need, run after the first cycle
+ */
+void finishBoot() {
+  registerMetrics();
+  registerCommands();
+
+  // Sensor and detector configuration for the telemetry decoder's trace
+  // header, so a replay starts from the same filter and scene calibration
+  const DetectorConfig& config = detector.config();
+  Serial.print(TELEMETRY_CONFIG_PREFIX);
+  Serial.printf("trig=%d echo=%d buzzer=%d samples=%u timeout=%lu spacing=%lu period=%lu sound=%.3f"
+                " filter=%s calib=%u calib_period=%lu trip_margin=%.2f clear_margin=%.2f"
+                " adapt=%.4f\n",
+                trigPin, echoPin, buzzerPin, (unsigned)config.samplesPerReading,
+                (unsigned long)config.echoTimeoutUs, (unsigned long)config.pingSpacingMs,
+                (unsigned long)config.cyclePeriodMs, SOUND_SPEED, filterTypeName(config.filter),
+                (unsigned)config.scene.calibrationReadings,
+                (unsigned long)config.scene.calibrationPeriodMs,
+                (double)config.scene.tripMarginCm, (double)config.scene.clearMarginCm,
+                (double)config.scene.adaptRate);
+  Serial.printf("Config: %s (%s)\n",
+                bootConfigLoad == ConfigLoad::Loaded ? "stored" : "compiled defaults",
+                configLoadName(bootConfigLoad));
+  if (ALERTS_ENABLED) Serial.printf("Alerts: %u restored\n", (unsigned)bootAlertsRestored);
+  if (MQTT_ENABLED || DASHBOARD_ENABLED) startWifi();
+  if (MQTT_ENABLED) startMqtt();
+  if (DASHBOARD_ENABLED) startDashboard();
   Serial.println("System Ready...");
+  if (detector.scene().calibrating()) Serial.println("Calibrating, keep the area clear...");
+  bootTimeline.mark("console", hal.micros64());
+  bootComplete = true;
+}
+
+/**
+ * @brief loop() with COOPERATIVE_LOOP: runs the due tasks, then waits
+ * @details A task that hangs never returns here, so the watchdog is still
+ * fed on every pass.
+ */
+void loopCooperative() {
+  esp_task_wdt_reset();
+  uint64_t nextUs = scheduler.run();
+  // After the first reading, as in the sequential loop.
+  if (!bootComplete && detectorTask.readings() > 0) finishBoot();
+  if (latencyMode) latencyProbe.poll(hal.micros64());
+  if (summaries.poll(millis())) printSummary();
+  if (ALERTS_ENABLED) alerts.poll(millis());
+  uint64_t nowUs = hal.micros64();
+  if (nextUs <= nowUs) return;
+  // delay() lets FreeRTOS run other tasks; gaps under 1 ms are spun.
+  uint64_t waitUs = nextUs - nowUs;
+  if (waitUs >= 1000) {
+    delay((uint32_t)(waitUs / 1000));
+  } else {
+    delayMicroseconds((uint32_t)waitUs);
+  }
 }
 
 /**
  * @brief Main program execution loop
- * 
+ *
  * @details Continuously monitors distance and manages intruder detection with
  * hysteresis to prevent oscillation. The system operates as follows:
- * 
+ *
  * Detection Logic:
  * - Triggers alert when distance < 6cm (intruder detected)
  * - Clears alert when distance > 8cm (area clear)
  * - 2cm hysteresis gap prevents rapid state changes
- * 
+ *
  * Haptic Feedback:
  * - Buzzer/motor activates on detection
  * - Deactivates when intruder leaves detection zone
- * 
+ *
  * Update Rate: 2Hz (500ms delay between measurements)
- * 
+ *
  * @return void
- * 
+ *
  * @note The hysteresis implementation prevents false triggers caused by
  * objects near the detection boundary
  */
 void loop() {
-  // Get stable distance
-  distanceCm = getDistanceCm();
-  distanceInch = distanceCm * CM_TO_INCH;
-
-  // Print results
-  Serial.print("Distance (cm): ");
-  Serial.println(distanceCm);
-  Serial.print("Distance (inch): ");
-  Serial.println(distanceInch);
-
-  // Intruder detection with hysteresis
-  // If intruder was not present, 
-  // and distance is now less than distance limit (6)
-  // Intruder is now present and motor vibrates.
-  if (!intruder && distanceCm > 0 && distanceCm < 6) {
-    intruder = true;
-    Serial.println("⚠ Intruder detected!");
-    digitalWrite(buzzerPin, HIGH);
-  }
-  // If intruder remains at distance < 6cm
-  // The condition wont check and vibrating pin keeps vibrating.
-  // If intruder walks away (> 8cm).
-  // Vibrator stops vibrating.
-  else if (intruder && distanceCm > 8) {  
-    intruder = false;
-    Serial.println("Area clear");
-    digitalWrite(buzzerPin, LOW);
-  }
-  // Only runs this loop twice per second to reduce sensor checks.
-  delay(500); // half a second between checks
-}
\ No newline at end of file
+  if (COOPERATIVE_LOOP) {
+    loopCooperative();
+    return;
+  }
+  // A hung cycle never gets here, and after too many overruns the feed stops:
+  // either way the task watchdog resets the board.
+  deadline.cycleStart(hal.micros64());
+  if (deadline.healthy()) {
+    esp_task_wdt_reset();
+  } else if (deadline.consecutiveMisses() == deadline.config().escalateAfter) {
+    Serial.println("Deadline missed repeatedly, waiting for watchdog reset");
+  }
+  uint64_t loopStartUs = hal.micros64();
+  {
+    ProfileScope cycle(&profiler, LoopPhase::Loop);
+    detector.loop();
+    // Before the first telemetry block, which the `@C` line must precede.
+    if (!bootComplete) finishBoot();
+    if (telemetryEnabled) {
+      ProfileScope scope(&profiler, LoopPhase::Telemetry);
+      emitTelemetry();
+    }
+  }
+  loopDurationUs.record((uint32_t)(hal.micros64() - loopStartUs));
+  if (latencyMode) {
+    latencyProbe.poll(hal.micros64());
+  }
+  if (summaries.poll(millis())) printSummary();
+  if (ALERTS_ENABLED) alerts.poll(millis());
+  if (MQTT_ENABLED) mqttTask.pump(millis());
+  if (DASHBOARD_ENABLED) dashboard.poll(millis());
+  // At most one command per cycle; the rest waits in the UART buffer.
+  console.poll();
+}
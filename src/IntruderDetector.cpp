@@ -0,0 +1,342 @@
+/**
+ * @file IntruderDetector.cpp
+ * @brief Hardware-independent intruder detection logic
+ */
+
+#include "IntruderDetector.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "LoopProfiler.h"
+
+namespace {
+
+/** @brief Listener used when none is set, so callers never check for null */
+DetectorListener silentListener;
+
+const char* const filterNames[FILTER_TYPE_COUNT] = {"mean", "validmean", "median"};
+
+}  // namespace
+
+const char* filterTypeName(FilterType filter) {
+  return filterNames[(uint8_t)filter];
+}
+
+bool parseFilterType(const char* name, FilterType& filter) {
+  for (uint8_t i = 0; i < FILTER_TYPE_COUNT; i++) {
+    if (strcmp(name, filterNames[i]) == 0) {
+      filter = (FilterType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t detectorCycleBudgetUs(const DetectorConfig& config) {
+  uint32_t samples = config.samplesPerReading < DETECTOR_MAX_SAMPLES ? config.samplesPerReading
+                                                                     : DETECTOR_MAX_SAMPLES;
+  uint32_t jitterMs = config.pingJitterMs < config.pingSpacingMs ? config.pingJitterMs
+                                                                 : config.pingSpacingMs;
+  // 12 µs of trigger pulse per ping.
+  uint32_t pingUs = 12 + config.echoTimeoutUs + (config.pingSpacingMs + jitterMs) * 1000;
+  uint32_t waitMs = config.cyclePeriodMs;
+  if (config.power.idlePeriodMs > waitMs) waitMs = config.power.idlePeriodMs;
+  if (config.scene.calibrationPeriodMs > waitMs) waitMs = config.scene.calibrationPeriodMs;
+  return samples * pingUs + waitMs * 1000;
+}
+
+IntruderDetector::IntruderDetector(Hal& hal, const DetectorConfig& config)
+    : hal_(hal),
+      config_(config),
+      listener_(&silentListener),
+      profiler_(nullptr),
+      scene_(config.scene),
+      noise_(config.noise),
+      power_(hal, config.power),
+      distanceCm_(0),
+      intruder_(false),
+      armed_(true),
+      tripCount_(0),
+      clearCount_(0),
+      random_(0x9E3779B9u),
+      gatedPings_(0) {}
+
+void IntruderDetector::begin() {
+  //OUTPUT here denotes OUTPUT from the micro-controller
+  //INPUT here denotes INPUT from the micro-controller
+  hal_.pinMode(config_.trigPin, OUTPUT);
+  hal_.pinMode(config_.echoPin, INPUT);
+  hal_.pinMode(config_.buzzerPin, OUTPUT);
+  // System starts with the vibrating motor off
+  hal_.digitalWrite(config_.buzzerPin, LOW);
+  intruder_ = false;
+  tripCount_ = 0;
+  clearCount_ = 0;
+  scene_.start();
+  noise_.reset();
+  gatedPings_ = 0;
+  // Only needs to differ between pings, not be unpredictable.
+  random_ ^= (uint32_t)hal_.micros();
+  if (random_ == 0) random_ = 0x9E3779B9u;
+}
+
+void IntruderDetector::setConfig(const DetectorConfig& config) {
+  config_ = config;
+  scene_.setConfig(config.scene);
+  noise_.setConfig(config.noise);
+  power_.setConfig(config.power);
+}
+
+void IntruderDetector::tune(const DetectorConfig& config) {
+  DetectorConfig tuned = config;
+  tuned.trigPin = config_.trigPin;
+  tuned.echoPin = config_.echoPin;
+  tuned.buzzerPin = config_.buzzerPin;
+  tuned.scene.calibrationReadings = config_.scene.calibrationReadings;
+  tuned.noise = config_.noise;
+  config_ = tuned;
+  scene_.tune(tuned.scene);
+  power_.setConfig(tuned.power);
+}
+
+void IntruderDetector::setArmed(bool armed) {
+  armed_ = armed;
+  tripCount_ = 0;
+  clearCount_ = 0;
+  if (!armed && intruder_) {
+    intruder_ = false;
+    hal_.digitalWrite(config_.buzzerPin, LOW);
+    listener_->onClear(distanceCm_);
+  }
+}
+
+/**
+ * @details Performs multiple distance measurements and returns their average
+ * to reduce sensor noise and improve accuracy. Each measurement cycle:
+ * 1. Sends a 10µs trigger pulse
+ * 2. Measures the echo pulse duration
+ * 3. Applies the echo timeout (30ms, ~5m max range, by default)
+ * 4. Combines samplesPerReading readings with filterReading()
+ */
+float IntruderDetector::getDistanceCm() {
+  unsigned long echoes[DETECTOR_MAX_SAMPLES];
+  uint8_t samples = samplesPerReading();
+  for (uint8_t i = 0; i < samples; i++) {
+    uint32_t pingTime = trigger();
+    {
+      ProfileScope scope(profiler_, LoopPhase::EchoWait);
+      // Measure echo
+      // PulseIn sets echoPin to High( alerts it to listen to bounced off signals)
+      // It records how long the signals were listened to then turns it low
+      echoes[i] = hal_.pulseIn(config_.echoPin, HIGH, config_.echoTimeoutUs);
+    }
+    recordPing(pingTime, echoes[i]);
+    // Wait a short while for each iteration of sending waves; the same steps
+    // as DetectorTask, so both paths ping with the same spacing.
+    ProfileScope scope(profiler_, LoopPhase::PingDelay);
+    uint32_t spacingUs = nextPingSpacingUs();
+    hal_.delay(spacingUs / 1000);
+    if (spacingUs % 1000 != 0) hal_.delayMicroseconds(spacingUs % 1000);
+  }
+  return combinePings(echoes, samples);
+}
+
+uint32_t IntruderDetector::trigger() {
+  uint32_t pingTime = (uint32_t)hal_.micros();
+  ProfileScope scope(profiler_, LoopPhase::Trigger);
+  // Trigger pulse
+  // Turns off or resets the trigPin of the sensor
+  hal_.digitalWrite(config_.trigPin, LOW);
+  // Waits for a short while
+  hal_.delayMicroseconds(2);
+  // Alerts the trigPin of sensor to send signals.
+  hal_.digitalWrite(config_.trigPin, HIGH);
+  // Sends signals for a longer while
+  hal_.delayMicroseconds(10);
+  // Stops sending signals.
+  hal_.digitalWrite(config_.trigPin, LOW);
+  return pingTime;
+}
+
+uint32_t IntruderDetector::nextPingSpacingUs() {
+  return config_.pingJitterMs == 0 ? config_.pingSpacingMs * 1000 : jitteredSpacingUs();
+}
+
+float IntruderDetector::combinePings(unsigned long* echoUs, uint8_t count) {
+  ProfileScope scope(profiler_, LoopPhase::Filter);
+  gatedPings_ += gateEchoes(echoUs, count, distanceCm_);
+  return filterReading(echoUs, count);
+}
+
+uint32_t IntruderDetector::jitteredSpacingUs() {
+  uint32_t jitterUs = jitterMs() * 1000;
+  // xorshift32
+  random_ ^= random_ << 13;
+  random_ ^= random_ >> 17;
+  random_ ^= random_ << 5;
+  return config_.pingSpacingMs * 1000 - jitterUs + random_ % (2 * jitterUs + 1);
+}
+
+uint8_t IntruderDetector::gateEchoes(unsigned long* echoUs, uint8_t count, float trackCm) const {
+  if (config_.trackGateCm <= 0) return 0;
+  float distances[DETECTOR_MAX_SAMPLES];
+  for (uint8_t i = 0; i < count; i++) {
+    distances[i] = echoUs[i] != 0 ? echoToDistanceCm(echoUs[i]) : 0;
+  }
+  uint8_t dropped = 0;
+  bool keep[DETECTOR_MAX_SAMPLES];
+  for (uint8_t i = 0; i < count; i++) {
+    if (echoUs[i] == 0) continue;
+    uint8_t votes = 0;
+    for (uint8_t j = 0; j < count; j++) {
+      if (echoUs[j] != 0 && fabsf(distances[j] - distances[i]) < config_.trackGateCm) votes++;
+    }
+    bool tracked = trackCm > 0 && fabsf(trackCm - distances[i]) < config_.trackGateCm;
+    keep[i] = votes * 2 > count || (votes * 2 == count && tracked);
+  }
+  // Drop only after voting, so a dropped ping still counted for the others.
+  for (uint8_t i = 0; i < count; i++) {
+    if (echoUs[i] != 0 && !keep[i]) {
+      echoUs[i] = 0;
+      dropped++;
+    }
+  }
+  return dropped;
+}
+
+/**
+ * @note With FilterType::Mean, timed-out pings add nothing to the sum but
+ * still count in the divisor, exactly as in the original sketch.
+ */
+float IntruderDetector::filterReading(const unsigned long* echoUs, uint8_t count) const {
+  if (count == 0) return 0;
+
+  long sum = 0;
+  uint8_t valid = 0;
+  unsigned long sorted[DETECTOR_MAX_SAMPLES];
+  for (uint8_t i = 0; i < count; i++) {
+    if (echoUs[i] == 0) continue;
+    sum += (long)echoUs[i];
+    if (config_.filter == FilterType::Median) {
+      // Insertion sort: at most DETECTOR_MAX_SAMPLES elements.
+      uint8_t j = valid;
+      while (j > 0 && sorted[j - 1] > echoUs[i]) {
+        sorted[j] = sorted[j - 1];
+        j--;
+      }
+      sorted[j] = echoUs[i];
+    }
+    valid++;
+  }
+
+  long avg;
+  switch (config_.filter) {
+    case FilterType::ValidMean:
+      avg = valid > 0 ? sum / valid : 0;
+      break;
+    case FilterType::Median:
+      if (valid == 0) return 0;
+      if (valid & 1) return echoToDistanceCm(sorted[valid / 2]);
+      return ((sorted[valid / 2 - 1] + sorted[valid / 2]) * SOUND_SPEED) / 4;
+    case FilterType::Mean:
+    default:
+      // Takes a stable average of the i iterations.
+      avg = sum / count;
+      break;
+  }
+  return echoToDistanceCm((unsigned long)avg);
+}
+
+/**
+ * @details A reading only changes the state once it has held for
+ * tripDwell/clearDwell consecutive cycles (1 by default, i.e. immediately).
+ */
+void IntruderDetector::thresholds(float& tripCm, float& clearCm) const {
+  tripCm = scene_.ready() ? scene_.tripCm() : config_.tripCm;
+  clearCm = scene_.ready() ? scene_.clearCm() : config_.clearCm;
+  if (config_.noise.adaptive && noise_.ready()) clearCm = tripCm + noise_.gapCm();
+}
+
+bool IntruderDetector::update(float distanceCm) {
+  float tripCm, clearCm;
+  thresholds(tripCm, clearCm);
+  // Intruder detection with hysteresis
+  // If intruder was not present,
+  // and distance is now less than distance limit (tripCm)
+  // Intruder is now present and motor vibrates.
+  if (!intruder_ && distanceCm > 0 && distanceCm < tripCm) {
+    if (++tripCount_ < config_.tripDwell) return false;
+    tripCount_ = 0;
+    intruder_ = true;
+    hal_.digitalWrite(config_.buzzerPin, HIGH);
+    listener_->onIntruder(distanceCm);
+    return true;
+  }
+  // If intruder remains at distance < tripCm
+  // The condition wont check and vibrating pin keeps vibrating.
+  // If intruder walks away (> clearCm).
+  // Vibrator stops vibrating.
+  if (intruder_ && distanceCm > clearCm) {
+    if (++clearCount_ < config_.clearDwell) return false;
+    clearCount_ = 0;
+    intruder_ = false;
+    hal_.digitalWrite(config_.buzzerPin, LOW);
+    listener_->onClear(distanceCm);
+    return true;
+  }
+  tripCount_ = 0;
+  clearCount_ = 0;
+  return false;
+}
+
+void IntruderDetector::loop() {
+  // Get stable distance
+  processReading(getDistanceCm());
+  // Only runs this loop twice per second (by default) to reduce sensor checks.
+  ProfileScope scope(profiler_, LoopPhase::CycleDelay);
+  power_.wait(cycleWaitMs() * 1000);
+}
+
+void IntruderDetector::processReading(float distanceCm) {
+  distanceCm_ = distanceCm;
+  {
+    ProfileScope scope(profiler_, LoopPhase::Report);
+    listener_->onReading(distanceCm_);
+  }
+  {
+    ProfileScope scope(profiler_, LoopPhase::Update);
+    noise_.addReading(distanceCm_);
+    if (scene_.calibrating()) {
+      if (scene_.addReading(distanceCm_, false)) listener_->onCalibrated(scene_);
+    } else if (armed_) {
+      update(distanceCm_);
+      // Frozen while alarmed or about to be, so an intruder never becomes background.
+      scene_.addReading(distanceCm_, intruder_ || tripCount_ > 0);
+    } else {
+      // Disarmed while people are around: do not learn them either.
+      scene_.addReading(distanceCm_, true);
+    }
+  }
+  // Between readings, so no pulse is being timed while the clock changes.
+  power_.setQuiet(quiet());
+}
+
+bool IntruderDetector::quiet() const {
+  if (intruder_ || tripCount_ > 0 || scene_.calibrating()) return false;
+  float tripCm, clearCm;
+  thresholds(tripCm, clearCm);
+  return distanceCm_ <= 0 || distanceCm_ >= tripCm + config_.power.approachMarginCm;
+}
+
+uint32_t IntruderDetector::cycleWaitMs() const {
+  if (scene_.calibrating() && config_.scene.calibrationPeriodMs > 0) {
+    return config_.scene.calibrationPeriodMs;
+  }
+  return config_.power.idlePeriodMs > 0 && quiet() ? config_.power.idlePeriodMs
+                                                   : config_.cyclePeriodMs;
+}
+
+void IntruderDetector::setListener(DetectorListener* listener) {
+  listener_ = listener != nullptr ? listener : &silentListener;
+}
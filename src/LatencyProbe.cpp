@@ -0,0 +1,80 @@
+/**
+ * @file LatencyProbe.cpp
+ * @brief End-to-end detection latency probe implementation
+ */
+
+#include "LatencyProbe.h"
+
+#include <stdio.h>
+
+LatencyProbe::LatencyProbe(uint64_t missTimeoutUs)
+    : missTimeoutUs_(missTimeoutUs),
+      pendingUs_(0),
+      pending_(false),
+      alarmActive_(false),
+      missed_(0),
+      falseAlarms_(0),
+      dropped_(0) {}
+
+void LatencyProbe::markAlarm(uint64_t timeUs) {
+  drain(timeUs);
+  expire(timeUs);
+  alarmActive_ = true;
+  if (!pending_) {
+    falseAlarms_++;
+    return;
+  }
+  uint64_t latency = timeUs - pendingUs_;
+  latency_.record(latency < UINT32_MAX ? (uint32_t)latency : UINT32_MAX);
+  pending_ = false;
+}
+
+void LatencyProbe::markClear(uint64_t timeUs) {
+  drain(timeUs);
+  alarmActive_ = false;
+}
+
+void LatencyProbe::poll(uint64_t nowUs) {
+  drain(nowUs);
+  expire(nowUs);
+}
+
+void LatencyProbe::reset() {
+  latency_.reset();
+  pending_ = false;
+  missed_ = 0;
+  falseAlarms_ = 0;
+  dropped_ = 0;
+}
+
+size_t LatencyProbe::formatCounts(char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  int n = snprintf(out, capacity, "detected=%lu missed=%lu false_alarms=%lu dropped=%lu",
+                   (unsigned long)detected(), (unsigned long)missed_,
+                   (unsigned long)falseAlarms_, (unsigned long)dropped_);
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
+
+/**
+ * @details Events are queued in time order, so they can be consumed up to a
+ * timestamp. Events stamped after uptoUs (an interrupt that fired after the
+ * caller read the clock) stay queued for the next call.
+ */
+void LatencyProbe::drain(uint64_t uptoUs) {
+  uint64_t timeUs;
+  while (events_.peek(timeUs) && timeUs <= uptoUs) {
+    events_.pop(timeUs);
+    expire(timeUs);
+    if (alarmActive_ || pending_) continue;
+    pending_ = true;
+    pendingUs_ = timeUs;
+  }
+}
+
+void LatencyProbe::expire(uint64_t nowUs) {
+  if (pending_ && nowUs - pendingUs_ > missTimeoutUs_) {
+    missed_++;
+    pending_ = false;
+  }
+}
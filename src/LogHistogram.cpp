@@ -0,0 +1,98 @@
+/**
+ * @file LogHistogram.cpp
+ * @brief Fixed-memory logarithmic histogram implementation
+ */
+
+#include "LogHistogram.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+/** @brief Characters snprintf() really wrote into a buffer of this capacity */
+size_t clampWritten(int n, size_t capacity) {
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
+
+}  // namespace
+
+void LogHistogram::reset() {
+  memset(counts_, 0, sizeof(counts_));
+  count_ = 0;
+  min_ = UINT32_MAX;
+  max_ = 0;
+  sum_ = 0;
+}
+
+uint32_t LogHistogram::bucketLow(size_t i) {
+  if (i < LOG_HISTOGRAM_SUB_BUCKETS) return (uint32_t)i;
+  unsigned shift = (unsigned)(i >> LOG_HISTOGRAM_SUB_BITS) - 1;
+  uint32_t sub = (uint32_t)(i & (LOG_HISTOGRAM_SUB_BUCKETS - 1));
+  return (uint32_t)(LOG_HISTOGRAM_SUB_BUCKETS + sub) << shift;
+}
+
+uint32_t LogHistogram::bucketHigh(size_t i) {
+  if (i + 1 >= LOG_HISTOGRAM_BUCKETS) return UINT32_MAX;
+  return bucketLow(i + 1) - 1;
+}
+
+uint32_t LogHistogram::percentile(double p) const {
+  if (count_ == 0) return 0;
+  // Nearest rank, as in DetectionScorer.
+  uint32_t rank = (uint32_t)(p / 100.0 * count_ + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > count_) rank = count_;
+  uint32_t seen = 0;
+  for (size_t i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      uint32_t high = bucketHigh(i);
+      return high < max_ ? high : max_;
+    }
+  }
+  return max_;
+}
+
+void LogHistogram::merge(const LogHistogram& other) {
+  for (size_t i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) counts_[i] += other.counts_[i];
+  count_ += other.count_;
+  sum_ += other.sum_;
+  if (other.count_ && other.min_ < min_) min_ = other.min_;
+  if (other.max_ > max_) max_ = other.max_;
+}
+
+const char* histogramSummaryHeader() {
+  return "name            count     min_us    mean_us     p50_us     p90_us     p99_us"
+         "     max_us";
+}
+
+size_t formatHistogramSummary(const char* name, uint32_t ticksPerUs, const LogHistogram& h,
+                              char* out, size_t capacity) {
+  if (capacity == 0) return 0;
+  double scale = 1.0 / ticksPerUs;
+  int n = snprintf(out, capacity, "%-12s %8lu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f", name,
+                   (unsigned long)h.count(), h.min() * scale, h.mean() * scale,
+                   h.percentile(50) * scale, h.percentile(90) * scale,
+                   h.percentile(99) * scale, h.max() * scale);
+  return clampWritten(n, capacity);
+}
+
+size_t formatHistogramLine(const char* name, uint32_t ticksPerUs, const LogHistogram& h,
+                           char* out, size_t capacity) {
+  if (capacity == 0) return 0;
+  size_t used = clampWritten(snprintf(out, capacity, "%s%s %lu", HISTOGRAM_LINE_PREFIX, name,
+                                      (unsigned long)ticksPerUs),
+                             capacity);
+  for (size_t i = 0; i < LOG_HISTOGRAM_BUCKETS; i++) {
+    if (h.bucketCount(i) == 0) continue;
+    char pair[24];
+    int n = snprintf(pair, sizeof(pair), " %lu:%lu", (unsigned long)LogHistogram::bucketLow(i),
+                     (unsigned long)h.bucketCount(i));
+    if (n < 0 || used + (size_t)n >= capacity) break;
+    memcpy(out + used, pair, (size_t)n + 1);
+    used += (size_t)n;
+  }
+  return used;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file LoopProfiler.cpp
+ * @brief Per-phase loop timing implementation
+ */
+
+#include "LoopProfiler.h"
+
+namespace {
+
+const char* const phaseNames[] = {"trigger", "echo_wait", "ping_delay",  "filter", "update",
+                                  "report",  "telemetry", "cycle_delay", "loop"};
+
+static_assert(sizeof(phaseNames) / sizeof(phaseNames[0]) == (size_t)LoopPhase::Count,
+              "one name per phase");
+
+}  // namespace
+
+const char* loopPhaseName(LoopPhase phase) {
+  return (size_t)phase < (size_t)LoopPhase::Count ? phaseNames[(size_t)phase] : "?";
+}
+
+void LoopProfiler::reset() {
+  for (LogHistogram& h : histograms_) h.reset();
+}
+
+size_t LoopProfiler::formatPhase(LoopPhase phase, char* out, size_t capacity) const {
+  return formatHistogramSummary(loopPhaseName(phase), ticksPerUs(), histogram(phase), out,
+                                capacity);
+}
+
+size_t LoopProfiler::formatHistogram(LoopPhase phase, char* out, size_t capacity) const {
+  return formatHistogramLine(loopPhaseName(phase), ticksPerUs(), histogram(phase), out,
+                             capacity);
+}
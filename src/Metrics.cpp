@@ -0,0 +1,232 @@
+/**
+ * @file Metrics.cpp
+ * @brief Fixed-memory runtime metrics implementation
+ */
+
+#include "Metrics.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ============================================================================
+// Little-endian helpers
+// ============================================================================
+
+namespace {
+
+void putU16(uint8_t* out, uint16_t v) {
+  out[0] = (uint8_t)v;
+  out[1] = (uint8_t)(v >> 8);
+}
+
+void putU32(uint8_t* out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out[i] = (uint8_t)(v >> (8 * i));
+}
+
+void putU64(uint8_t* out, uint64_t v) {
+  for (int i = 0; i < 8; i++) out[i] = (uint8_t)(v >> (8 * i));
+}
+
+uint32_t getU32(const uint8_t* in) {
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+         ((uint32_t)in[3] << 24);
+}
+
+uint64_t getU64(const uint8_t* in) {
+  return (uint64_t)getU32(in) | ((uint64_t)getU32(in + 4) << 32);
+}
+
+/** @brief Encoded size of one value of the given kind */
+size_t valueSize(MetricKind kind) {
+  return kind == MetricKind::Histogram ? 6 * 4 + 8 : 4;
+}
+
+size_t nameLength(const char* name) {
+  size_t n = strlen(name);
+  return n > METRICS_NAME_MAX ? METRICS_NAME_MAX : n;
+}
+
+}  // namespace
+
+const char* metricKindName(MetricKind kind) {
+  switch (kind) {
+    case MetricKind::Counter:
+      return "counter";
+    case MetricKind::Gauge:
+      return "gauge";
+    case MetricKind::Histogram:
+      return "histogram";
+    case MetricKind::Probe:
+      return "probe";
+  }
+  return "?";
+}
+
+// ============================================================================
+// MetricsRegistry
+// ============================================================================
+
+bool MetricsRegistry::add(const char* name, MetricKind kind, void* target,
+                          const void* context) {
+  if (count_ >= METRICS_MAX) return false;
+  Entry& e = entries_[count_++];
+  e.name = name;
+  e.kind = kind;
+  e.target = target;
+  e.context = context;
+  return true;
+}
+
+bool MetricsRegistry::addCounter(const char* name, Counter* counter) {
+  return add(name, MetricKind::Counter, counter, nullptr);
+}
+
+bool MetricsRegistry::addGauge(const char* name, Gauge* gauge) {
+  return add(name, MetricKind::Gauge, gauge, nullptr);
+}
+
+bool MetricsRegistry::addHistogram(const char* name, LogHistogram* histogram) {
+  return add(name, MetricKind::Histogram, histogram, nullptr);
+}
+
+bool MetricsRegistry::addProbe(const char* name, MetricProbe probe, const void* context) {
+  return add(name, MetricKind::Probe, (void*)probe, context);
+}
+
+void MetricsRegistry::reset() {
+  for (size_t i = 0; i < count_; i++) {
+    const Entry& e = entries_[i];
+    if (e.kind == MetricKind::Counter) {
+      static_cast<Counter*>(e.target)->reset();
+    } else if (e.kind == MetricKind::Histogram) {
+      static_cast<LogHistogram*>(e.target)->reset();
+    }
+  }
+}
+
+size_t MetricsRegistry::formatEntry(size_t i, char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  if (i >= count_) {
+    out[0] = '\0';
+    return 0;
+  }
+  const Entry& e = entries_[i];
+  const char* kind = metricKindName(e.kind);
+  int n = 0;
+  switch (e.kind) {
+    case MetricKind::Counter:
+      n = snprintf(out, capacity, "%s %s %lu", e.name, kind,
+                   (unsigned long)static_cast<const Counter*>(e.target)->value());
+      break;
+    case MetricKind::Gauge:
+      n = snprintf(out, capacity, "%s %s %.3f", e.name, kind,
+                   (double)static_cast<const Gauge*>(e.target)->value());
+      break;
+    case MetricKind::Probe:
+      n = snprintf(out, capacity, "%s %s %lu", e.name, kind,
+                   (unsigned long)((MetricProbe)e.target)(e.context));
+      break;
+    case MetricKind::Histogram: {
+      const LogHistogram& h = *static_cast<const LogHistogram*>(e.target);
+      n = snprintf(out, capacity,
+                   "%s %s count=%lu min=%lu mean=%.1f p50=%lu p90=%lu p99=%lu max=%lu",
+                   e.name, kind, (unsigned long)h.count(), (unsigned long)h.min(), h.mean(),
+                   (unsigned long)h.percentile(50), (unsigned long)h.percentile(90),
+                   (unsigned long)h.percentile(99), (unsigned long)h.max());
+      break;
+    }
+  }
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
+
+size_t MetricsRegistry::encodeSnapshot(uint32_t uptimeMs, uint8_t* out, size_t capacity) const {
+  size_t needed = 8;
+  for (size_t i = 0; i < count_; i++) {
+    needed += 2 + nameLength(entries_[i].name) + valueSize(entries_[i].kind);
+  }
+  if (needed > capacity) return 0;
+
+  putU16(out, METRICS_SNAPSHOT_MAGIC);
+  out[2] = METRICS_SNAPSHOT_VERSION;
+  out[3] = (uint8_t)count_;
+  putU32(out + 4, uptimeMs);
+  size_t pos = 8;
+  for (size_t i = 0; i < count_; i++) {
+    const Entry& e = entries_[i];
+    size_t len = nameLength(e.name);
+    out[pos++] = (uint8_t)e.kind;
+    out[pos++] = (uint8_t)len;
+    memcpy(out + pos, e.name, len);
+    pos += len;
+    switch (e.kind) {
+      case MetricKind::Counter:
+        putU32(out + pos, static_cast<const Counter*>(e.target)->value());
+        break;
+      case MetricKind::Gauge: {
+        float value = static_cast<const Gauge*>(e.target)->value();
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        putU32(out + pos, bits);
+        break;
+      }
+      case MetricKind::Probe:
+        putU32(out + pos, ((MetricProbe)e.target)(e.context));
+        break;
+      case MetricKind::Histogram: {
+        const LogHistogram& h = *static_cast<const LogHistogram*>(e.target);
+        putU32(out + pos, h.count());
+        putU32(out + pos + 4, h.min());
+        putU32(out + pos + 8, h.max());
+        putU32(out + pos + 12, h.percentile(50));
+        putU32(out + pos + 16, h.percentile(90));
+        putU32(out + pos + 20, h.percentile(99));
+        putU64(out + pos + 24, h.sum());
+        break;
+      }
+    }
+    pos += valueSize(e.kind);
+  }
+  return pos;
+}
+
+// ============================================================================
+// Decoding
+// ============================================================================
+
+bool decodeMetricsSnapshot(const uint8_t* data, size_t length, uint32_t& uptimeMs,
+                           MetricsSnapshotVisitor& visitor) {
+  if (length < 8) return false;
+  if ((uint16_t)(data[0] | (data[1] << 8)) != METRICS_SNAPSHOT_MAGIC) return false;
+  if (data[2] != METRICS_SNAPSHOT_VERSION) return false;
+  size_t count = data[3];
+  uptimeMs = getU32(data + 4);
+
+  size_t pos = 8;
+  char name[METRICS_NAME_MAX + 1];
+  for (size_t i = 0; i < count; i++) {
+    if (pos + 2 > length) return false;
+    uint8_t kindByte = data[pos++];
+    size_t len = data[pos++];
+    if (kindByte > (uint8_t)MetricKind::Probe || len > METRICS_NAME_MAX) return false;
+    MetricKind kind = (MetricKind)kindByte;
+    if (pos + len + valueSize(kind) > length) return false;
+    memcpy(name, data + pos, len);
+    name[len] = '\0';
+    pos += len;
+    const uint8_t* v = data + pos;
+    if (kind == MetricKind::Histogram) {
+      visitor.onHistogram(name, getU32(v), getU32(v + 4), getU32(v + 8), getU32(v + 12),
+                          getU32(v + 16), getU32(v + 20), getU64(v + 24));
+    } else if (kind == MetricKind::Gauge) {
+      uint32_t bits = getU32(v);
+      float value;
+      memcpy(&value, &bits, sizeof(value));
+      visitor.onValue(name, kind, value);
+    } else {
+      visitor.onValue(name, kind, getU32(v));
+    }
+    pos += valueSize(kind);
+  }
+  return true;
+}
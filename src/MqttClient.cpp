@@ -0,0 +1,432 @@
+/**
+ * @file MqttClient.cpp
+ * @brief MQTT 3.1.1 packet encoding and the non-blocking client
+ */
+
+#include "MqttClient.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Fixed-header packet types (upper nibble)
+const uint8_t CONNECT = 0x10;
+const uint8_t CONNACK = 0x20;
+const uint8_t PUBLISH = 0x30;
+const uint8_t PUBACK = 0x40;
+const uint8_t SUBSCRIBE = 0x82;  // with the reserved flags 0b0010
+const uint8_t PINGREQ = 0xC0;
+const uint8_t PINGRESP = 0xD0;
+
+const uint8_t PUBLISH_DUP = 0x08;
+
+size_t putString(uint8_t* out, const char* text, size_t length) {
+  out[0] = (uint8_t)(length >> 8);
+  out[1] = (uint8_t)length;
+  memcpy(out + 2, text, length);
+  return 2 + length;
+}
+
+}  // namespace
+
+size_t mqttPutLength(uint8_t* out, size_t length) {
+  size_t n = 0;
+  do {
+    uint8_t digit = length % 128;
+    length /= 128;
+    out[n++] = length > 0 ? (uint8_t)(digit | 0x80) : digit;
+  } while (length > 0 && n < 4);
+  return n;
+}
+
+int mqttGetLength(const uint8_t* in, size_t available, size_t& length) {
+  length = 0;
+  for (size_t i = 0; i < 4; i++) {
+    if (i == available) return 0;
+    length |= (size_t)(in[i] & 0x7f) << (7 * i);
+    if ((in[i] & 0x80) == 0) return (int)i + 1;
+  }
+  return -1;
+}
+
+size_t mqttEncodePublish(uint8_t* out, size_t capacity, const char* topic,
+                         const uint8_t* payload, size_t length, uint8_t qos, uint16_t packetId) {
+  size_t topicLength = strlen(topic);
+  size_t remaining = 2 + topicLength + (qos > 0 ? 2 : 0) + length;
+  uint8_t field[4];
+  size_t fieldBytes = mqttPutLength(field, remaining);
+  if (1 + fieldBytes + remaining > capacity) return 0;
+  size_t n = 0;
+  out[n++] = (uint8_t)(PUBLISH | (qos << 1));
+  memcpy(out + n, field, fieldBytes);
+  n += fieldBytes;
+  n += putString(out + n, topic, topicLength);
+  if (qos > 0) {
+    out[n++] = (uint8_t)(packetId >> 8);
+    out[n++] = (uint8_t)packetId;
+  }
+  memcpy(out + n, payload, length);
+  return n + length;
+}
+
+MqttClient::MqttClient(MqttLink& link, const MqttOptions& options)
+    : link_(link),
+      options_(options),
+      state_(State::Idle),
+      stateMs_(0),
+      lastWriteMs_(0),
+      lastReadMs_(0),
+      pingPending_(false),
+      topicCount_(0),
+      handler_(nullptr),
+      handlerContext_(nullptr),
+      nextOrder_(0),
+      nextPacketId_(0),
+      current_(-1),
+      offset_(0),
+      controlLength_(0),
+      rxLength_(0),
+      published_(0),
+      sent_(0),
+      acked_(0),
+      resent_(0),
+      dropped_(0),
+      received_(0),
+      connects_(0),
+      attempts_(0) {
+  filter_[0] = '\0';
+  for (Slot& slot : slots_) slot.state = SlotState::Free;
+}
+
+int MqttClient::addTopic(const char* name, uint8_t qos) {
+  if (topicCount_ == MQTT_MAX_TOPICS || strlen(name) > MQTT_TOPIC_MAX || qos > 1) return -1;
+  strcpy(topics_[topicCount_].name, name);
+  topics_[topicCount_].qos = qos;
+  return (int)topicCount_++;
+}
+
+bool MqttClient::subscribe(const char* filter, MqttMessageHandler handler, void* context) {
+  if (strlen(filter) > MQTT_TOPIC_MAX) return false;
+  strcpy(filter_, filter);
+  handler_ = handler;
+  handlerContext_ = context;
+  return true;
+}
+
+bool MqttClient::publish(int topic, const uint8_t* payload, size_t length) {
+  if (topic < 0 || (size_t)topic >= topicCount_) {
+    dropped_++;
+    return false;
+  }
+  uint8_t qos = topics_[topic].qos;
+  int free = -1;
+  for (int i = 0; i < MQTT_QUEUE_SLOTS && free < 0; i++) {
+    if (slots_[i].state == SlotState::Free) free = i;
+  }
+  if (free < 0 && qos > 0) {
+    // An alarm matters more than a sample block: take the oldest unsent QoS 0 slot.
+    for (int i = 0; i < MQTT_QUEUE_SLOTS; i++) {
+      const Slot& slot = slots_[i];
+      if (slot.state != SlotState::Queued || slot.qos > 0 || i == current_) continue;
+      if (free < 0 || slot.order < slots_[free].order) free = i;
+    }
+    if (free >= 0) dropped_++;
+  }
+  if (free < 0) {
+    dropped_++;
+    return false;
+  }
+  Slot& slot = slots_[free];
+  uint16_t packetId = qos > 0 ? nextPacketId() : 0;
+  size_t n = mqttEncodePublish(slot.packet, sizeof(slot.packet), topics_[topic].name, payload,
+                               length, qos, packetId);
+  if (n == 0) {
+    slot.state = SlotState::Free;
+    dropped_++;
+    return false;
+  }
+  slot.length = (uint16_t)n;
+  slot.packetId = packetId;
+  slot.order = nextOrder_++;
+  slot.qos = qos;
+  slot.state = SlotState::Queued;
+  published_++;
+  return true;
+}
+
+uint16_t MqttClient::nextPacketId() {
+  if (++nextPacketId_ == 0) nextPacketId_ = 1;  // 0 is not a valid packet id
+  return nextPacketId_;
+}
+
+size_t MqttClient::queued() const {
+  size_t n = 0;
+  for (const Slot& slot : slots_) n += slot.state != SlotState::Free;
+  return n;
+}
+
+void MqttClient::poll(uint32_t nowMs) {
+  switch (state_) {
+    case State::Idle:
+      if (attempts_ > 0 && nowMs - stateMs_ < options_.reconnectMs) return;
+      attempts_++;
+      stateMs_ = nowMs;
+      if (!link_.open()) return;
+      state_ = State::Connecting;
+      return;
+    case State::Connecting: {
+      int status = link_.status();
+      if (status < 0 || (status == 0 && nowMs - stateMs_ >= options_.ackTimeoutMs)) {
+        disconnect(nowMs);
+        return;
+      }
+      if (status == 0) return;
+      uint8_t packet[MQTT_TOPIC_MAX + 32];
+      size_t idLength = strlen(options_.clientId);
+      if (idLength > MQTT_TOPIC_MAX) idLength = MQTT_TOPIC_MAX;
+      size_t n = 0;
+      packet[n++] = CONNECT;
+      n += mqttPutLength(packet + n, 10 + 2 + idLength);
+      n += putString(packet + n, "MQTT", 4);
+      packet[n++] = 4;     // protocol level 3.1.1
+      packet[n++] = 0x02;  // clean session
+      packet[n++] = (uint8_t)(options_.keepAliveS >> 8);
+      packet[n++] = (uint8_t)options_.keepAliveS;
+      n += putString(packet + n, options_.clientId, idLength);
+      queueControl(packet, n);
+      state_ = State::Handshake;
+      stateMs_ = nowMs;
+      lastReadMs_ = nowMs;
+      break;
+    }
+    case State::Handshake:
+      if (nowMs - stateMs_ >= options_.ackTimeoutMs) {
+        disconnect(nowMs);
+        return;
+      }
+      break;
+    case State::Connected: {
+      uint32_t keepAliveMs = (uint32_t)options_.keepAliveS * 1000;
+      if (keepAliveMs > 0) {
+        if (nowMs - lastReadMs_ >= keepAliveMs * 3 / 2) {
+          disconnect(nowMs);  // the broker went quiet: the link is dead
+          return;
+        }
+        // Also while publishing: only the PINGRESP shows the broker is still there.
+        if (!pingPending_ &&
+            (nowMs - lastWriteMs_ >= keepAliveMs / 2 || nowMs - lastReadMs_ >= keepAliveMs / 2)) {
+          const uint8_t ping[] = {PINGREQ, 0};
+          pingPending_ = queueControl(ping, sizeof(ping));
+        }
+      }
+      for (int i = 0; i < MQTT_QUEUE_SLOTS; i++) {
+        Slot& slot = slots_[i];
+        if (slot.state != SlotState::AwaitingAck || nowMs - slot.sentMs < options_.ackTimeoutMs) {
+          continue;
+        }
+        slot.packet[0] |= PUBLISH_DUP;
+        slot.state = SlotState::Queued;
+        resent_++;
+      }
+      break;
+    }
+  }
+  send(nowMs);
+  if (state_ != State::Idle) receive(nowMs);
+}
+
+bool MqttClient::queueControl(const uint8_t* packet, size_t length) {
+  if (controlLength_ + length > sizeof(control_)) return false;
+  memcpy(control_ + controlLength_, packet, length);
+  controlLength_ += length;
+  return true;
+}
+
+int MqttClient::nextSlot() const {
+  int next = -1;
+  for (int i = 0; i < MQTT_QUEUE_SLOTS; i++) {
+    const Slot& slot = slots_[i];
+    if (slot.state != SlotState::Queued) continue;
+    if (next < 0 || slot.qos > slots_[next].qos ||
+        (slot.qos == slots_[next].qos && slot.order < slots_[next].order)) {
+      next = i;
+    }
+  }
+  return next;
+}
+
+/**
+ * @details A packet is always finished before the next one starts; pending
+ * control packets (CONNECT, SUBSCRIBE, PINGREQ) go before the next PUBLISH.
+ */
+void MqttClient::send(uint32_t nowMs) {
+  for (;;) {
+    const uint8_t* data;
+    size_t length;
+    if (current_ >= 0) {
+      data = slots_[current_].packet;
+      length = slots_[current_].length;
+    } else if (controlLength_ > 0) {
+      data = control_;
+      length = controlLength_;
+    } else if (state_ == State::Connected && (current_ = nextSlot()) >= 0) {
+      offset_ = 0;
+      continue;
+    } else {
+      return;
+    }
+    int n = link_.write(data + offset_, length - offset_);
+    if (n < 0) {
+      disconnect(nowMs);
+      return;
+    }
+    if (n == 0) return;
+    offset_ += (size_t)n;
+    lastWriteMs_ = nowMs;
+    if (offset_ < length) return;
+    offset_ = 0;
+    if (current_ < 0) {
+      controlLength_ = 0;
+      continue;
+    }
+    Slot& slot = slots_[current_];
+    current_ = -1;
+    sent_++;
+    if (slot.qos == 0) {
+      slot.state = SlotState::Free;
+    } else {
+      slot.state = SlotState::AwaitingAck;
+      slot.sentMs = nowMs;
+    }
+  }
+}
+
+void MqttClient::receive(uint32_t nowMs) {
+  for (;;) {
+    if (rxLength_ == sizeof(rx_)) {
+      disconnect(nowMs);  // an incoming packet larger than MQTT_PACKET_MAX
+      return;
+    }
+    int n = link_.read(rx_ + rxLength_, sizeof(rx_) - rxLength_);
+    if (n < 0) {
+      disconnect(nowMs);
+      return;
+    }
+    if (n == 0) return;
+    rxLength_ += (size_t)n;
+    lastReadMs_ = nowMs;
+
+    size_t used = 0;
+    while (rxLength_ - used >= 2) {
+      size_t length;
+      int fieldBytes = mqttGetLength(rx_ + used + 1, rxLength_ - used - 1, length);
+      if (fieldBytes < 0) {
+        disconnect(nowMs);
+        return;
+      }
+      if (fieldBytes == 0 || rxLength_ - used < 1 + (size_t)fieldBytes + length) break;
+      handlePacket(rx_[used], rx_ + used + 1 + fieldBytes, length, nowMs);
+      if (state_ == State::Idle) return;
+      used += 1 + (size_t)fieldBytes + length;
+    }
+    memmove(rx_, rx_ + used, rxLength_ - used);
+    rxLength_ -= used;
+  }
+}
+
+void MqttClient::handlePacket(uint8_t header, const uint8_t* body, size_t length,
+                              uint32_t nowMs) {
+  switch (header & 0xf0) {
+    case CONNACK:
+      if (state_ != State::Handshake || length < 2 || body[1] != 0) {
+        disconnect(nowMs);  // refused (bad client id, not authorized...)
+        return;
+      }
+      onConnected(nowMs);
+      break;
+    case PUBACK: {
+      if (length < 2) return;
+      uint16_t packetId = (uint16_t)(body[0] << 8 | body[1]);
+      for (int i = 0; i < MQTT_QUEUE_SLOTS; i++) {
+        Slot& slot = slots_[i];
+        if (slot.state == SlotState::Free || slot.qos == 0 || slot.packetId != packetId) continue;
+        // A resend being written is finished anyway; the broker acks it again.
+        if (i == current_) continue;
+        slot.state = SlotState::Free;
+        acked_++;
+      }
+      break;
+    }
+    case PUBLISH & 0xf0: {
+      if (length < 2) return;
+      size_t topicLength = (size_t)(body[0] << 8 | body[1]);
+      size_t skip = 2 + topicLength + ((header >> 1) & 3 ? 2 : 0);
+      if (skip > length || topicLength > MQTT_TOPIC_MAX) return;
+      // Subscribed at QoS 0, so the broker never asks for a PUBACK.
+      char topic[MQTT_TOPIC_MAX + 1];
+      memcpy(topic, body + 2, topicLength);
+      topic[topicLength] = '\0';
+      received_++;
+      if (handler_ != nullptr) handler_(topic, body + skip, length - skip, handlerContext_);
+      break;
+    }
+    case PINGRESP:
+      pingPending_ = false;
+      break;
+    default:  // SUBACK: nothing to do
+      break;
+  }
+}
+
+void MqttClient::onConnected(uint32_t nowMs) {
+  state_ = State::Connected;
+  stateMs_ = nowMs;
+  connects_++;
+  if (filter_[0] == '\0') return;
+  uint8_t packet[MQTT_TOPIC_MAX + 16];
+  size_t filterLength = strlen(filter_);
+  size_t n = 0;
+  packet[n++] = SUBSCRIBE;
+  n += mqttPutLength(packet + n, 2 + 2 + filterLength + 1);
+  uint16_t packetId = nextPacketId();
+  packet[n++] = (uint8_t)(packetId >> 8);
+  packet[n++] = (uint8_t)packetId;
+  n += putString(packet + n, filter_, filterLength);
+  packet[n++] = 0;  // QoS 0
+  queueControl(packet, n);
+}
+
+/**
+ * @details Unacknowledged QoS 1 messages are queued again with DUP set; a
+ * half-written packet starts over on the next link.
+ */
+void MqttClient::disconnect(uint32_t nowMs) {
+  link_.close();
+  state_ = State::Idle;
+  stateMs_ = nowMs;
+  current_ = -1;
+  offset_ = 0;
+  controlLength_ = 0;
+  rxLength_ = 0;
+  pingPending_ = false;
+  for (Slot& slot : slots_) {
+    if (slot.state != SlotState::AwaitingAck) continue;
+    slot.packet[0] |= PUBLISH_DUP;
+    slot.state = SlotState::Queued;
+    resent_++;
+  }
+}
+
+size_t MqttClient::format(char* out, size_t capacity) const {
+  static const char* const STATES[] = {"idle", "connecting", "handshake", "connected"};
+  int n = snprintf(out, capacity,
+                   "state=%s queued=%u/%u published=%lu sent=%lu acked=%lu resent=%lu "
+                   "dropped=%lu received=%lu connects=%lu/%lu",
+                   STATES[(int)state_], (unsigned)queued(), (unsigned)MQTT_QUEUE_SLOTS,
+                   (unsigned long)published_, (unsigned long)sent_, (unsigned long)acked_,
+                   (unsigned long)resent_, (unsigned long)dropped_, (unsigned long)received_,
+                   (unsigned long)connects_, (unsigned long)attempts_);
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file MqttTask.cpp
+ * @brief MQTT send pipeline task
+ */
+
+#include "MqttTask.h"
+
+#include <string.h>
+
+MqttTask::MqttTask(MqttClient& client, TelemetryStream& samples, uint32_t periodUs)
+    : client_(client),
+      samples_(samples),
+      samplesTopic_(-1),
+      periodUs_(periodUs),
+      blocks_(0) {}
+
+void MqttTask::step() {
+  COOP_BEGIN();
+  for (;;) {
+    pump((uint32_t)hal().millis());
+    COOP_SLEEP_FOR(periodUs_);
+  }
+  COOP_END();
+}
+
+void MqttTask::pump(uint32_t nowMs) {
+  size_t length;
+  uint32_t sequence;
+  const uint8_t* block = samples_.pending(length, sequence);
+  // A full queue keeps the block pending; the stream counts what it then drops.
+  if (block != nullptr && samplesTopic_ >= 0 && client_.queued() < MQTT_QUEUE_SLOTS) {
+    uint8_t payload[MQTT_SAMPLES_HEADER + TELEMETRY_BLOCK_BYTES];
+    for (int i = 0; i < MQTT_SAMPLES_HEADER; i++) payload[i] = (uint8_t)(sequence >> (8 * i));
+    memcpy(payload + MQTT_SAMPLES_HEADER, block, length);
+    client_.publish(samplesTopic_, payload, MQTT_SAMPLES_HEADER + length);
+    samples_.releasePending();
+    blocks_++;
+  }
+  client_.poll(nowMs);
+}
@@ -0,0 +1,61 @@
+/**
+ * @file NoiseEstimator.cpp
+ * @brief Streaming reading-noise estimate implementation
+ */
+
+#include "NoiseEstimator.h"
+
+namespace {
+
+/** @brief sqrt(pi) / 2: sigma of Gaussian noise from its mean absolute difference */
+const float MEAN_ABS_DIFF_TO_SIGMA = 0.8862269f;
+
+}  // namespace
+
+NoiseEstimator::NoiseEstimator(const NoiseConfig& config) { setConfig(config); }
+
+void NoiseEstimator::setConfig(const NoiseConfig& config) {
+  config_ = config;
+  reset();
+}
+
+void NoiseEstimator::reset() {
+  previousCm_ = 0;
+  meanAbsDiffCm_ = 0;
+  differences_ = 0;
+}
+
+void NoiseEstimator::addReading(float distanceCm) {
+  if (distanceCm <= 0) return;
+  if (previousCm_ <= 0) {
+    previousCm_ = distanceCm;
+    return;
+  }
+  float diff = distanceCm - previousCm_;
+  if (diff < 0) diff = -diff;
+  previousCm_ = distanceCm;
+
+  // Clip steps (objects arriving/leaving); during warm-up the estimate is
+  // still unreliable, so clip at the widest gap instead. The floor keeps a
+  // near-zero estimate able to grow again.
+  float limit = ready() ? config_.clipFactor * meanAbsDiffCm_ : config_.maxGapCm;
+  if (limit < config_.minGapCm) limit = config_.minGapCm;
+  if (diff > limit) diff = limit;
+
+  differences_++;
+  if (ready()) {
+    meanAbsDiffCm_ += config_.alpha * (diff - meanAbsDiffCm_);
+  } else {
+    // Plain running mean while warming up, so the first values count fully.
+    meanAbsDiffCm_ += (diff - meanAbsDiffCm_) / differences_;
+  }
+}
+
+float NoiseEstimator::sigmaCm() const { return meanAbsDiffCm_ * MEAN_ABS_DIFF_TO_SIGMA; }
+
+float NoiseEstimator::gapCm() const {
+  float gap = config_.gapSigmas * sigmaCm();
+  if (gap < config_.minGapCm) gap = config_.minGapCm;
+  if (gap > config_.maxGapCm) gap = config_.maxGapCm;
+  return gap;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file PowerScheduler.cpp
+ * @brief Light-sleep duty cycling implementation
+ */
+
+#include "PowerScheduler.h"
+
+#include <stdio.h>
+
+PowerScheduler::PowerScheduler(Hal& hal, const PowerConfig& config)
+    : hal_(hal), config_(config) {
+  reset();
+}
+
+void PowerScheduler::reset() {
+  sleeps_ = 0;
+  sleptUs_ = 0;
+  awakeWaitUs_ = 0;
+  clockChanges_ = 0;
+}
+
+void PowerScheduler::wait(uint32_t waitUs) {
+  uint64_t deadlineUs = hal_.micros64() + waitUs;
+  if (config_.lightSleep && waitUs >= config_.minSleepUs &&
+      waitUs > config_.wakeMarginUs) {
+    uint32_t sleepUs = waitUs - config_.wakeMarginUs;
+    hal_.lightSleep(sleepUs);
+    sleeps_++;
+    sleptUs_ += sleepUs;
+  }
+  delayUntil(deadlineUs);
+}
+
+void PowerScheduler::setQuiet(bool quiet) {
+  if (config_.idleCpuMhz == 0) return;
+  uint32_t mhz = quiet ? config_.idleCpuMhz : config_.fullCpuMhz;
+  if (hal_.cpuFrequencyMhz() != mhz && hal_.setCpuFrequencyMhz(mhz)) clockChanges_++;
+}
+
+void PowerScheduler::delayUntil(uint64_t deadlineUs) {
+  uint64_t nowUs = hal_.micros64();
+  if (nowUs >= deadlineUs) return;
+  uint64_t remainingUs = deadlineUs - nowUs;
+  awakeWaitUs_ += remainingUs;
+  // delay() yields to other tasks; only the sub-millisecond rest spins.
+  hal_.delay((uint32_t)(remainingUs / 1000));
+  hal_.delayMicroseconds((uint32_t)(remainingUs % 1000));
+}
+
+size_t PowerScheduler::formatCounters(char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  int n = snprintf(out, capacity,
+                   "light_sleep=%s sleeps=%lu slept_ms=%lu awake_wait_ms=%lu idle_period_ms=%lu "
+                   "cpu_mhz=%lu idle_cpu_mhz=%lu clock_changes=%lu",
+                   config_.lightSleep ? "on" : "off", (unsigned long)sleeps_,
+                   (unsigned long)(sleptUs_ / 1000), (unsigned long)(awakeWaitUs_ / 1000),
+                   (unsigned long)config_.idlePeriodMs, (unsigned long)hal_.cpuFrequencyMhz(),
+                   (unsigned long)config_.idleCpuMhz, (unsigned long)clockChanges_);
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
@@ -0,0 +1,346 @@
+/**
+ * @file SampleCodec.cpp
+ * @brief Gorilla-style sample block encoder/decoder implementation
+ *
+ * @details See SampleCodec.h for the block layout and bit encoding.
+ */
+
+#include "SampleCodec.h"
+
+#include <string.h>
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+namespace {
+
+/** @brief Largest payload expressible in the 16-bit header field */
+const size_t maxPayloadBits = 0xFFFF;
+
+/** @brief Maps signed deltas onto small unsigned numbers (0,-1,1,-2 -> 0,1,2,3) */
+inline uint32_t zigZagEncode(uint32_t delta) {
+  int32_t s = (int32_t)delta;
+  return ((uint32_t)s << 1) ^ (uint32_t)(s >> 31);
+}
+
+inline uint32_t zigZagDecode(uint32_t z) {
+  return (z >> 1) ^ (uint32_t)(-(int32_t)(z & 1));
+}
+
+/** @brief Bits needed for a zig-zag timestamp delta-of-delta, prefix included */
+inline uint8_t timestampBits(uint32_t z) {
+  if (z == 0) return 1;
+  if (z < (1u << 7)) return 2 + 7;
+  if (z < (1u << 12)) return 3 + 12;
+  if (z < (1u << 20)) return 4 + 20;
+  return 4 + 32;
+}
+
+/** @brief Bits needed for a zig-zag value delta, prefix included */
+inline uint8_t valueBits(uint32_t z) {
+  if (z == 0) return 1;
+  if (z < (1u << 7)) return 2 + 7;
+  if (z < (1u << 12)) return 3 + 12;
+  if (z < (1u << 18)) return 4 + 18;
+  return 4 + 32;
+}
+
+inline void putLe16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline void putLe32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint16_t getLe16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t getLe32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+}  // namespace
+
+// ============================================================================
+// ENCODER
+// ============================================================================
+
+SampleBlockEncoder::SampleBlockEncoder()
+    : buffer_(nullptr),
+      capacityBits_(0),
+      bitPos_(0),
+      count_(0),
+      firstTimestamp_(0),
+      firstValue_(0),
+      prevTimestamp_(0),
+      prevDelta_(0),
+      prevValue_(0) {}
+
+void SampleBlockEncoder::begin(uint8_t* buffer, size_t capacity) {
+  buffer_ = buffer;
+  size_t bits = capacity > SAMPLE_BLOCK_HEADER_BYTES
+                    ? (capacity - SAMPLE_BLOCK_HEADER_BYTES) * 8
+                    : 0;
+  capacityBits_ = bits > maxPayloadBits ? maxPayloadBits : bits;
+  bitPos_ = 0;
+  count_ = 0;
+  firstTimestamp_ = 0;
+  firstValue_ = 0;
+  prevTimestamp_ = 0;
+  prevDelta_ = 0;
+  prevValue_ = 0;
+  if (buffer_ != nullptr && capacity >= SAMPLE_BLOCK_HEADER_BYTES) {
+    memset(buffer_, 0, capacity);
+    writeHeader();
+  }
+}
+
+bool SampleBlockEncoder::append(uint32_t timestamp, int32_t value) {
+  if (buffer_ == nullptr || count_ == 0xFFFF) return false;
+
+  if (count_ == 0) {
+    firstTimestamp_ = timestamp;
+    firstValue_ = value;
+    prevTimestamp_ = timestamp;
+    prevDelta_ = 0;
+    prevValue_ = (uint32_t)value;
+    count_ = 1;
+    writeHeader();
+    return true;
+  }
+
+  uint32_t delta = timestamp - prevTimestamp_;
+  uint32_t dod = zigZagEncode(delta - prevDelta_);
+  uint32_t dv = zigZagEncode((uint32_t)value - prevValue_);
+
+  // Reject up front so a refused sample never leaves half-written bits.
+  if (bitPos_ + timestampBits(dod) + valueBits(dv) > capacityBits_) {
+    return false;
+  }
+
+  if (dod == 0) {
+    writeBits(0, 1);
+  } else if (dod < (1u << 7)) {
+    writeBits(0x2, 2);
+    writeBits(dod, 7);
+  } else if (dod < (1u << 12)) {
+    writeBits(0x6, 3);
+    writeBits(dod, 12);
+  } else if (dod < (1u << 20)) {
+    writeBits(0xE, 4);
+    writeBits(dod, 20);
+  } else {
+    writeBits(0xF, 4);
+    writeBits(dod, 32);
+  }
+
+  if (dv == 0) {
+    writeBits(0, 1);
+  } else if (dv < (1u << 7)) {
+    writeBits(0x2, 2);
+    writeBits(dv, 7);
+  } else if (dv < (1u << 12)) {
+    writeBits(0x6, 3);
+    writeBits(dv, 12);
+  } else if (dv < (1u << 18)) {
+    writeBits(0xE, 4);
+    writeBits(dv, 18);
+  } else {
+    writeBits(0xF, 4);
+    writeBits(dv, 32);
+  }
+
+  prevTimestamp_ = timestamp;
+  prevDelta_ = delta;
+  prevValue_ = (uint32_t)value;
+  count_++;
+  writeHeader();
+  return true;
+}
+
+size_t SampleBlockEncoder::sizeBytes() const {
+  return SAMPLE_BLOCK_HEADER_BYTES + (bitPos_ + 7) / 8;
+}
+
+bool SampleBlockEncoder::full() const {
+  return bitPos_ + SAMPLE_MAX_BITS_PER_SAMPLE > capacityBits_;
+}
+
+void SampleBlockEncoder::writeBits(uint32_t bits, uint8_t width) {
+  uint8_t* payload = buffer_ + SAMPLE_BLOCK_HEADER_BYTES;
+  while (width > 0) {
+    size_t byte = bitPos_ >> 3;
+    uint8_t freeBits = 8 - (bitPos_ & 7);
+    uint8_t take = width < freeBits ? width : freeBits;
+    uint8_t chunk = (uint8_t)((bits >> (width - take)) & ((1u << take) - 1));
+    payload[byte] |= (uint8_t)(chunk << (freeBits - take));
+    bitPos_ += take;
+    width -= take;
+  }
+}
+
+void SampleBlockEncoder::writeHeader() {
+  putLe16(buffer_, SAMPLE_BLOCK_MAGIC);
+  buffer_[2] = SAMPLE_BLOCK_VERSION;
+  buffer_[3] = 0;
+  putLe16(buffer_ + 4, count_);
+  putLe16(buffer_ + 6, (uint16_t)bitPos_);
+  putLe32(buffer_ + 8, firstTimestamp_);
+  putLe32(buffer_ + 12, (uint32_t)firstValue_);
+}
+
+// ============================================================================
+// DECODER
+// ============================================================================
+
+SampleBlockDecoder::SampleBlockDecoder()
+    : payload_(nullptr),
+      payloadBits_(0),
+      bitPos_(0),
+      count_(0),
+      index_(0),
+      firstTimestamp_(0),
+      firstValue_(0),
+      prevTimestamp_(0),
+      prevDelta_(0),
+      prevValue_(0) {}
+
+bool SampleBlockDecoder::begin(const uint8_t* data, size_t length) {
+  count_ = 0;
+  index_ = 0;
+  if (data == nullptr || length < SAMPLE_BLOCK_HEADER_BYTES) return false;
+  if (getLe16(data) != SAMPLE_BLOCK_MAGIC) return false;
+  if (data[2] != SAMPLE_BLOCK_VERSION) return false;
+
+  payloadBits_ = getLe16(data + 6);
+  if (SAMPLE_BLOCK_HEADER_BYTES + (payloadBits_ + 7) / 8 > length) return false;
+
+  count_ = getLe16(data + 4);
+  firstTimestamp_ = getLe32(data + 8);
+  firstValue_ = (int32_t)getLe32(data + 12);
+  payload_ = data + SAMPLE_BLOCK_HEADER_BYTES;
+  bitPos_ = 0;
+  return true;
+}
+
+bool SampleBlockDecoder::next(uint32_t& timestamp, int32_t& value) {
+  if (index_ >= count_) return false;
+
+  if (index_ == 0) {
+    prevTimestamp_ = firstTimestamp_;
+    prevDelta_ = 0;
+    prevValue_ = (uint32_t)firstValue_;
+    index_ = 1;
+    timestamp = firstTimestamp_;
+    value = firstValue_;
+    return true;
+  }
+
+  uint32_t dod = 0;
+  if (readBits(1) != 0) {
+    if (readBits(1) == 0) {
+      dod = readBits(7);
+    } else if (readBits(1) == 0) {
+      dod = readBits(12);
+    } else if (readBits(1) == 0) {
+      dod = readBits(20);
+    } else {
+      dod = readBits(32);
+    }
+  }
+
+  uint32_t dv = 0;
+  if (readBits(1) != 0) {
+    if (readBits(1) == 0) {
+      dv = readBits(7);
+    } else if (readBits(1) == 0) {
+      dv = readBits(12);
+    } else if (readBits(1) == 0) {
+      dv = readBits(18);
+    } else {
+      dv = readBits(32);
+    }
+  }
+
+  if (bitPos_ > payloadBits_) {
+    // Truncated or corrupt payload: stop rather than return garbage.
+    index_ = count_;
+    return false;
+  }
+
+  prevDelta_ += zigZagDecode(dod);
+  prevTimestamp_ += prevDelta_;
+  prevValue_ += zigZagDecode(dv);
+  index_++;
+
+  timestamp = prevTimestamp_;
+  value = (int32_t)prevValue_;
+  return true;
+}
+
+size_t SampleBlockDecoder::sizeBytes() const {
+  return SAMPLE_BLOCK_HEADER_BYTES + (payloadBits_ + 7) / 8;
+}
+
+uint32_t SampleBlockDecoder::readBits(uint8_t width) {
+  uint32_t result = 0;
+  while (width > 0) {
+    size_t byte = bitPos_ >> 3;
+    if ((bitPos_ >> 3) >= (payloadBits_ + 7) / 8) {
+      // Reading past the payload: account for it so next() can bail out.
+      // The value is discarded; a 32-bit shift of a uint32_t is undefined.
+      bitPos_ += width;
+      return 0;
+    }
+    uint8_t avail = 8 - (bitPos_ & 7);
+    uint8_t take = width < avail ? width : avail;
+    uint8_t chunk = (uint8_t)((payload_[byte] >> (avail - take)) & ((1u << take) - 1));
+    result = (result << take) | chunk;
+    bitPos_ += take;
+    width -= take;
+  }
+  return result;
+}
+
+// ============================================================================
+// ON-DEVICE HISTORY
+// ============================================================================
+
+SampleHistory::SampleHistory() : active_(0), used_(0), total_(0) {
+  memset(sizes_, 0, sizeof(sizes_));
+  encoder_.begin(blocks_[0], SAMPLE_HISTORY_BLOCK_BYTES);
+}
+
+bool SampleHistory::append(uint32_t timestamp, int32_t value) {
+  bool sealed = false;
+  if (!encoder_.append(timestamp, value)) {
+    sizes_[active_] = encoder_.sizeBytes();
+    active_ = (active_ + 1) % SAMPLE_HISTORY_BLOCKS;
+    encoder_.begin(blocks_[active_], SAMPLE_HISTORY_BLOCK_BYTES);
+    encoder_.append(timestamp, value);
+    sealed = true;
+  }
+  if (used_ == 0 || (sealed && used_ < SAMPLE_HISTORY_BLOCKS)) used_++;
+  sizes_[active_] = encoder_.sizeBytes();
+  total_++;
+  return sealed;
+}
+
+const uint8_t* SampleHistory::block(size_t index, size_t& length) const {
+  if (index >= used_) {
+    length = 0;
+    return nullptr;
+  }
+  size_t slot = (active_ + SAMPLE_HISTORY_BLOCKS + 1 - used_ + index) %
+                SAMPLE_HISTORY_BLOCKS;
+  length = sizes_[slot];
+  return blocks_[slot];
+}
@@ -0,0 +1,79 @@
+/**
+ * @file SceneModel.cpp
+ * @brief Empty-scene baseline implementation
+ */
+
+#include "SceneModel.h"
+
+#include <math.h>
+#include <stdio.h>
+
+SceneModel::SceneModel(const SceneConfig& config) { setConfig(config); }
+
+void SceneModel::setConfig(const SceneConfig& config) {
+  config_ = config;
+  start();
+}
+
+void SceneModel::tune(const SceneConfig& config) {
+  uint16_t calibrationReadings = config_.calibrationReadings;
+  config_ = config;
+  config_.calibrationReadings = calibrationReadings;
+}
+
+void SceneModel::start() {
+  calibrated_ = 0;
+  ready_ = false;
+  samples_ = 0;
+  mean_ = 0;
+  m2_ = 0;
+  variance_ = 0;
+}
+
+float SceneModel::sigmaCm() const { return variance_ > 0 ? sqrtf(variance_) : 0; }
+
+bool SceneModel::addReading(float distanceCm, bool frozen) {
+  if (calibrating()) {
+    calibrated_++;
+    if (distanceCm > 0) {
+      // Welford: exact running mean and sum of squared deviations.
+      samples_++;
+      float delta = distanceCm - mean_;
+      mean_ += delta / samples_;
+      m2_ += delta * (distanceCm - mean_);
+    }
+    if (calibrating()) return false;
+    variance_ = samples_ > 1 ? m2_ / (samples_ - 1) : 0;
+    ready_ = samples_ * 2 >= config_.calibrationReadings && tripCm() > 0;
+    return true;
+  }
+
+  if (!ready_ || frozen || distanceCm <= 0 || config_.adaptRate <= 0) return false;
+  // Exponentially weighted form of the same update.
+  samples_++;
+  float delta = distanceCm - mean_;
+  float step = config_.adaptRate * delta;
+  mean_ += step;
+  variance_ = (1 - config_.adaptRate) * (variance_ + delta * step);
+  return false;
+}
+
+size_t SceneModel::format(char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  int n;
+  if (config_.calibrationReadings == 0) {
+    n = snprintf(out, capacity, "off (fixed thresholds)");
+  } else if (calibrating()) {
+    n = snprintf(out, capacity, "calibrating %u/%u", (unsigned)calibrated_,
+                 (unsigned)config_.calibrationReadings);
+  } else if (!ready_) {
+    n = snprintf(out, capacity, "unavailable (%lu of %u readings had an echo, mean %.2f cm)",
+                 (unsigned long)samples_, (unsigned)config_.calibrationReadings, mean_);
+  } else {
+    n = snprintf(out, capacity,
+                 "baseline=%.2f sigma=%.2f trip=%.2f clear=%.2f samples=%lu", mean_, sigmaCm(),
+                 tripCm(), clearCm(), (unsigned long)samples_);
+  }
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
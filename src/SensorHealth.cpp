@@ -0,0 +1,185 @@
+/**
+ * @file SensorHealth.cpp
+ * @brief Fault detection over the raw ping stream implementation
+ */
+
+#include "SensorHealth.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "IntruderDetector.h"
+
+namespace {
+
+/** @name Per-slot flags of the window */
+///@{
+const uint8_t SLOT_TIMEOUT = 0x01;
+const uint8_t SLOT_OUT_OF_RANGE = 0x02;
+const uint8_t SLOT_VALID = 0x04;
+///@}
+
+/** @brief Fewest valid echoes the deviation check is judged on */
+const uint32_t MIN_VALID_FOR_DEVIATION = 4;
+
+const char* const faultNames[] = {"timeouts", "out_of_range", "noisy", "stuck"};
+
+/** @brief Echo width of a distance (inverse of echoToDistanceCm()) */
+uint32_t distanceToEchoUs(float cm) { return (uint32_t)(cm * 2 / SOUND_SPEED + 0.5f); }
+
+}  // namespace
+
+SensorHealth::SensorHealth(const SensorHealthConfig& config) : listener_(nullptr) {
+  setConfig(config);
+}
+
+void SensorHealth::setConfig(const SensorHealthConfig& config) {
+  config_ = config;
+  minEchoUs_ = distanceToEchoUs(config.minCm);
+  maxEchoUs_ = distanceToEchoUs(config.maxCm);
+  reset();
+}
+
+void SensorHealth::reset() {
+  count_ = 0;
+  timeouts_ = 0;
+  outOfRange_ = 0;
+  valid_ = 0;
+  sum_ = 0;
+  sumSq_ = 0;
+  lastEchoUs_ = 0;
+  repeats_ = 0;
+  faults_ = 0;
+  faultEvents_ = 0;
+}
+
+uint8_t SensorHealth::addSample(uint32_t echoUs) {
+  if (echoUs > UINT16_MAX) echoUs = UINT16_MAX;
+
+  // Drop the ping leaving the window, then add the new one in its slot.
+  size_t slot = count_ & (SENSOR_HEALTH_WINDOW - 1);
+  if (count_ >= SENSOR_HEALTH_WINDOW) {
+    uint8_t old = flags_[slot];
+    if (old & SLOT_TIMEOUT) timeouts_--;
+    if (old & SLOT_OUT_OF_RANGE) outOfRange_--;
+    if (old & SLOT_VALID) {
+      uint64_t e = echoes_[slot];
+      valid_--;
+      sum_ -= e;
+      sumSq_ -= e * e;
+    }
+  }
+  uint8_t flags;
+  if (echoUs == 0) {
+    flags = SLOT_TIMEOUT;
+    timeouts_++;
+  } else if (echoUs < minEchoUs_ || echoUs > maxEchoUs_) {
+    flags = SLOT_OUT_OF_RANGE;
+    outOfRange_++;
+  } else {
+    flags = SLOT_VALID;
+    valid_++;
+    sum_ += echoUs;
+    sumSq_ += (uint64_t)echoUs * echoUs;
+  }
+  echoes_[slot] = (uint16_t)echoUs;
+  flags_[slot] = flags;
+  count_++;
+
+  // Timeouts are covered by the rate check, not counted as a stuck value.
+  if (echoUs != 0 && echoUs == lastEchoUs_) {
+    repeats_++;
+  } else {
+    repeats_ = echoUs != 0 ? 1 : 0;
+  }
+  lastEchoUs_ = echoUs;
+
+  uint8_t previous = faults_;
+  faults_ = evaluate();
+  if (faults_ != previous) {
+    if (previous == 0) faultEvents_++;
+    if (listener_ != nullptr) listener_->onHealthChange(faults_, previous);
+  }
+  return faults_;
+}
+
+/**
+ * @details Each check raises its fault above the limit and, once raised,
+ * keeps it until the value drops to half the limit, so a sensor hovering at
+ * the limit does not flood the alert channel.
+ */
+uint8_t SensorHealth::evaluate() const {
+  uint8_t faults = 0;
+  if (count_ >= SENSOR_HEALTH_WINDOW) {
+    float window = (float)SENSOR_HEALTH_WINDOW;
+    float timeoutLimit = config_.maxTimeoutRate * window;
+    if ((faults_ & SENSOR_FAULT_TIMEOUTS) ? timeouts_ > timeoutLimit / 2
+                                          : timeouts_ > timeoutLimit) {
+      faults |= SENSOR_FAULT_TIMEOUTS;
+    }
+    float rangeLimit = config_.maxOutOfRangeRate * window;
+    if ((faults_ & SENSOR_FAULT_OUT_OF_RANGE) ? outOfRange_ > rangeLimit / 2
+                                              : outOfRange_ > rangeLimit) {
+      faults |= SENSOR_FAULT_OUT_OF_RANGE;
+    }
+    if (valid_ >= MIN_VALID_FOR_DEVIATION) {
+      float deviation = stdDevCm();
+      if ((faults_ & SENSOR_FAULT_NOISY) ? deviation > config_.maxStdDevCm / 2
+                                         : deviation > config_.maxStdDevCm) {
+        faults |= SENSOR_FAULT_NOISY;
+      }
+    }
+  }
+  if (config_.stuckSamples > 0 && repeats_ >= config_.stuckSamples) {
+    faults |= SENSOR_FAULT_STUCK;
+  }
+  return faults;
+}
+
+float SensorHealth::timeoutRate() const {
+  uint32_t n = filled();
+  return n > 0 ? (float)timeouts_ / n : 0;
+}
+
+float SensorHealth::outOfRangeRate() const {
+  uint32_t n = filled();
+  return n > 0 ? (float)outOfRange_ / n : 0;
+}
+
+float SensorHealth::stdDevCm() const {
+  if (valid_ < 2) return 0;
+  double mean = (double)sum_ / valid_;
+  double variance = (double)sumSq_ / valid_ - mean * mean;
+  if (variance <= 0) return 0;
+  return (float)(sqrt(variance) * SOUND_SPEED / 2);
+}
+
+size_t SensorHealth::format(char* out, size_t capacity) const {
+  if (capacity == 0) return 0;
+  char names[64];
+  formatSensorFaults(faults_, names, sizeof(names));
+  int n = snprintf(out, capacity,
+                   "%s timeouts=%.2f out_of_range=%.2f stddev_cm=%.2f repeats=%lu "
+                   "fault_events=%lu",
+                   names, timeoutRate(), outOfRangeRate(), stdDevCm(), (unsigned long)repeats_,
+                   (unsigned long)faultEvents_);
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
+
+size_t formatSensorFaults(uint8_t faults, char* out, size_t capacity) {
+  if (capacity == 0) return 0;
+  size_t pos = 0;
+  out[0] = '\0';
+  if (faults == 0) {
+    int n = snprintf(out, capacity, "ok");
+    return n < 0 ? 0 : ((size_t)n < capacity ? (size_t)n : capacity - 1);
+  }
+  for (size_t i = 0; i < sizeof(faultNames) / sizeof(faultNames[0]); i++) {
+    if (!(faults & (1u << i)) || pos >= capacity - 1) continue;
+    int n = snprintf(out + pos, capacity - pos, "%s%s", pos > 0 ? "," : "", faultNames[i]);
+    if (n < 0) break;
+    pos += (size_t)n < capacity - pos ? (size_t)n : capacity - pos - 1;
+  }
+  return pos;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file SerialTasks.cpp
+ * @brief Console and telemetry output tasks
+ */
+
+#include "SerialTasks.h"
+
+void ConsoleTask::step() {
+  COOP_BEGIN();
+  for (;;) {
+    if (console_.poll()) {
+      COOP_YIELD();
+    } else {
+      COOP_SLEEP_FOR(periodUs_);
+    }
+  }
+  COOP_END();
+}
+
+TelemetryTask::TelemetryTask(TelemetryStream& stream, ConsoleIo& io, uint32_t pollUs)
+    : CoopTask(pollUs), stream_(stream), io_(io), textLength_(0) {}
+
+void TelemetryTask::step() {
+  size_t length;
+  uint32_t sequence;
+  const uint8_t* block;
+  COOP_BEGIN();
+  for (;;) {
+    COOP_WAIT_UNTIL((block = stream_.pending(length, sequence)) != nullptr);
+    // Formatting copies the block, so the stream can fill the next one while
+    // this line waits for room.
+    textLength_ = telemetryFormatBlockLine(block, length, sequence, text_);
+    stream_.releasePending();
+    COOP_AWAIT_UART_SPACE(io_, textLength_);
+    io_.write(text_, textLength_);
+  }
+  COOP_END();
+}
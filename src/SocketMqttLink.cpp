@@ -0,0 +1,71 @@
+/**
+ * @file SocketMqttLink.cpp
+ * @brief Non-blocking TCP link implementation
+ */
+
+#include "SocketMqttLink.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // lwIP raises no SIGPIPE
+#endif
+
+bool SocketMqttLink::open() {
+  close();
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port_);
+  if (inet_pton(AF_INET, address_, &address.sin_addr) != 1) return false;
+  fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_ < 0) return false;
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+  // Small packets (alarms) go out at once instead of waiting for an ACK.
+  int on = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  if (connect(fd_, (const sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+int SocketMqttLink::status() {
+  if (fd_ < 0) return -1;
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(fd_, &writable);
+  timeval none = {0, 0};
+  if (select(fd_ + 1, nullptr, &writable, nullptr, &none) <= 0) return 0;
+  int error = 0;
+  socklen_t size = sizeof(error);
+  getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &size);
+  return error == 0 ? 1 : -1;
+}
+
+int SocketMqttLink::write(const uint8_t* data, size_t length) {
+  if (fd_ < 0) return -1;
+  ssize_t n = send(fd_, data, length, MSG_NOSIGNAL);
+  if (n >= 0) return (int)n;
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+}
+
+int SocketMqttLink::read(uint8_t* out, size_t capacity) {
+  if (fd_ < 0) return -1;
+  ssize_t n = recv(fd_, out, capacity, 0);
+  if (n > 0) return (int)n;
+  if (n == 0) return -1;  // closed by the broker
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+}
+
+void SocketMqttLink::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file SummaryAggregator.cpp
+ * @brief Per-interval summary implementation
+ */
+
+#include "SummaryAggregator.h"
+
+#include <stdio.h>
+
+const float SUMMARY_BIN_EDGES_CM[SUMMARY_BINS - 1] = {10, 20, 40, 80, 160, 320};
+
+namespace {
+
+const uint16_t SUMMARY_MAGIC = 0x5349;  // "IS"
+const uint8_t SUMMARY_VERSION = 1;
+
+// ============================================================================
+// Little-endian helpers
+// ============================================================================
+
+void putU16(uint8_t* out, uint16_t v) {
+  out[0] = (uint8_t)v;
+  out[1] = (uint8_t)(v >> 8);
+}
+
+void putU32(uint8_t* out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out[i] = (uint8_t)(v >> (8 * i));
+}
+
+uint16_t getU16(const uint8_t* in) { return (uint16_t)(in[0] | (in[1] << 8)); }
+
+uint32_t getU32(const uint8_t* in) {
+  return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) |
+         ((uint32_t)in[3] << 24);
+}
+
+/** @brief Distance in 1/100 cm, clamped to the u16 range */
+uint16_t toCentiCm(float cm) {
+  if (cm <= 0) return 0;
+  float scaled = cm * 100 + 0.5f;
+  return scaled >= 65535 ? 65535 : (uint16_t)scaled;
+}
+
+void increment(uint16_t& count) {
+  if (count < UINT16_MAX) count++;
+}
+
+}  // namespace
+
+SummaryAggregator::SummaryAggregator(uint32_t intervalMs) : intervalMs_(1) {
+  setIntervalMs(intervalMs);
+  start(0);
+}
+
+void SummaryAggregator::start(uint32_t nowMs) {
+  bool active = current_.alarmActive;
+  current_ = IntervalSummary();
+  current_.startMs = nowMs;
+  current_.alarmActive = active;
+  sumCm_ = 0;
+  echoed_ = 0;
+  alarmSinceMs_ = nowMs;
+}
+
+void SummaryAggregator::addPing(uint32_t echoUs) {
+  increment(current_.pings);
+  if (echoUs == 0) increment(current_.timeouts);
+}
+
+void SummaryAggregator::addReading(float distanceCm) {
+  increment(current_.readings);
+  if (distanceCm <= 0) {
+    increment(current_.noEcho);
+    return;
+  }
+  if (echoed_ == 0 || distanceCm < current_.minCm) current_.minCm = distanceCm;
+  if (echoed_ == 0 || distanceCm > current_.maxCm) current_.maxCm = distanceCm;
+  sumCm_ += distanceCm;
+  increment(echoed_);
+  size_t bin = 0;
+  while (bin < SUMMARY_BINS - 1 && distanceCm >= SUMMARY_BIN_EDGES_CM[bin]) bin++;
+  increment(current_.bins[bin]);
+}
+
+void SummaryAggregator::setAlarm(bool active, uint32_t nowMs) {
+  if (active == current_.alarmActive) return;
+  if (active) {
+    if (current_.alarms < UINT8_MAX) current_.alarms++;
+    alarmSinceMs_ = nowMs;
+  } else {
+    current_.alarmMs += nowMs - alarmSinceMs_;
+  }
+  current_.alarmActive = active;
+}
+
+bool SummaryAggregator::poll(uint32_t nowMs) {
+  if (nowMs - current_.startMs < intervalMs_) return false;
+  close(nowMs);
+  return true;
+}
+
+void SummaryAggregator::close(uint32_t nowMs) {
+  current_.durationMs = nowMs - current_.startMs;
+  if (current_.alarmActive) current_.alarmMs += nowMs - alarmSinceMs_;
+  if (echoed_ > 0) current_.meanCm = sumCm_ / echoed_;
+  last_ = current_;
+  start(nowMs);
+}
+
+size_t formatSummary(const IntervalSummary& summary, char* out, size_t capacity) {
+  if (capacity == 0) return 0;
+  int n = snprintf(out, capacity,
+                   "t=%lu ms dur=%lu readings=%u no_echo=%u min=%.2f max=%.2f mean=%.2f "
+                   "pings=%u timeouts=%u alarms=%u alarm_ms=%lu alarm=%s bins=",
+                   (unsigned long)summary.startMs, (unsigned long)summary.durationMs,
+                   (unsigned)summary.readings, (unsigned)summary.noEcho, summary.minCm,
+                   summary.maxCm, summary.meanCm, (unsigned)summary.pings,
+                   (unsigned)summary.timeouts, (unsigned)summary.alarms,
+                   (unsigned long)summary.alarmMs, summary.alarmActive ? "on" : "off");
+  if (n < 0) return 0;
+  size_t pos = (size_t)n < capacity ? (size_t)n : capacity - 1;
+  for (size_t i = 0; i < SUMMARY_BINS && pos + 1 < capacity; i++) {
+    n = snprintf(out + pos, capacity - pos, i == 0 ? "%u" : ",%u", (unsigned)summary.bins[i]);
+    if (n < 0) break;
+    pos += (size_t)n < capacity - pos ? (size_t)n : capacity - pos - 1;
+  }
+  return pos;
+}
+
+size_t encodeSummary(const IntervalSummary& summary, uint8_t* out, size_t capacity) {
+  if (capacity < SUMMARY_BYTES) return 0;
+  putU16(out, SUMMARY_MAGIC);
+  out[2] = SUMMARY_VERSION;
+  out[3] = SUMMARY_BINS;
+  putU32(out + 4, summary.startMs);
+  putU32(out + 8, summary.durationMs);
+  putU16(out + 12, summary.readings);
+  putU16(out + 14, summary.noEcho);
+  putU16(out + 16, summary.pings);
+  putU16(out + 18, summary.timeouts);
+  putU16(out + 20, toCentiCm(summary.minCm));
+  putU16(out + 22, toCentiCm(summary.maxCm));
+  putU16(out + 24, toCentiCm(summary.meanCm));
+  putU32(out + 26, summary.alarmMs);
+  out[30] = summary.alarms;
+  out[31] = summary.alarmActive ? 1 : 0;
+  for (size_t i = 0; i < SUMMARY_BINS; i++) putU16(out + 32 + 2 * i, summary.bins[i]);
+  return SUMMARY_BYTES;
+}
+
+bool decodeSummary(const uint8_t* data, size_t length, IntervalSummary& summary) {
+  if (length < SUMMARY_BYTES || getU16(data) != SUMMARY_MAGIC || data[2] != SUMMARY_VERSION ||
+      data[3] != SUMMARY_BINS) {
+    return false;
+  }
+  summary.startMs = getU32(data + 4);
+  summary.durationMs = getU32(data + 8);
+  summary.readings = getU16(data + 12);
+  summary.noEcho = getU16(data + 14);
+  summary.pings = getU16(data + 16);
+  summary.timeouts = getU16(data + 18);
+  summary.minCm = getU16(data + 20) / 100.0f;
+  summary.maxCm = getU16(data + 22) / 100.0f;
+  summary.meanCm = getU16(data + 24) / 100.0f;
+  summary.alarmMs = getU32(data + 26);
+  summary.alarms = data[30];
+  summary.alarmActive = (data[31] & 1) != 0;
+  for (size_t i = 0; i < SUMMARY_BINS; i++) summary.bins[i] = getU16(data + 32 + 2 * i);
+  return true;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file Telemetry.cpp
+ * @brief Per-ping telemetry stream implementation
+ */
+
+#include "Telemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+TelemetryStream::TelemetryStream()
+    : pendingLength_(0),
+      active_(0),
+      hasPending_(false),
+      pendingSequence_(0),
+      nextSequence_(0),
+      overflows_(0) {
+  encoder_.begin(buffers_[0], TELEMETRY_BLOCK_BYTES);
+}
+
+void TelemetryStream::record(uint32_t timeUs, uint32_t echoUs) {
+  if (encoder_.append(timeUs, (int32_t)echoUs)) return;
+  seal();
+  encoder_.append(timeUs, (int32_t)echoUs);
+}
+
+void TelemetryStream::flush() {
+  if (encoder_.count() > 0) seal();
+}
+
+const uint8_t* TelemetryStream::pending(size_t& length, uint32_t& sequence) const {
+  if (!hasPending_) return nullptr;
+  length = pendingLength_;
+  sequence = pendingSequence_;
+  return buffers_[active_ ^ 1];
+}
+
+void TelemetryStream::releasePending() { hasPending_ = false; }
+
+void TelemetryStream::seal() {
+  if (hasPending_) {
+    // Previous block not printed yet: drop this one but keep its sequence
+    // number so the decoder sees the gap.
+    overflows_++;
+    nextSequence_++;
+    encoder_.begin(buffers_[active_], TELEMETRY_BLOCK_BYTES);
+    return;
+  }
+  pendingLength_ = encoder_.sizeBytes();
+  pendingSequence_ = nextSequence_++;
+  hasPending_ = true;
+  active_ ^= 1;
+  encoder_.begin(buffers_[active_], TELEMETRY_BLOCK_BYTES);
+}
+
+void telemetryToHex(const uint8_t* data, size_t length, char* out) {
+  static const char digits[] = "0123456789abcdef";
+  for (size_t i = 0; i < length; i++) {
+    out[2 * i] = digits[data[i] >> 4];
+    out[2 * i + 1] = digits[data[i] & 0xF];
+  }
+}
+
+size_t telemetryFormatBlockLine(const uint8_t* block, size_t length, uint32_t sequence,
+                                char* out) {
+  if (length > TELEMETRY_BLOCK_BYTES) length = TELEMETRY_BLOCK_BYTES;
+  size_t n = (size_t)snprintf(out, TELEMETRY_LINE_MAX + 1, "%s%lu ", TELEMETRY_BLOCK_PREFIX,
+                              (unsigned long)sequence);
+  telemetryToHex(block, length, out + n);
+  n += 2 * length;
+  out[n++] = '\n';
+  out[n] = '\0';
+  return n;
+}
+
+namespace {
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+}  // namespace
+
+bool telemetryFromHex(const char* hex, uint8_t* out, size_t capacity, size_t& length) {
+  size_t n = 0;
+  while (hex[0] != '\0' && hex[0] != '\r' && hex[0] != '\n') {
+    int hi = hexValue(hex[0]);
+    int lo = hexValue(hex[1]);
+    if (hi < 0 || lo < 0 || n >= capacity) return false;
+    out[n++] = (uint8_t)((hi << 4) | lo);
+    hex += 2;
+  }
+  length = n;
+  return true;
+}
+
+bool telemetryParseBlockLine(const char* line, uint8_t* block, size_t capacity,
+                             size_t& length, uint32_t& sequence) {
+  const size_t prefixLength = sizeof(TELEMETRY_BLOCK_PREFIX) - 1;
+  if (strncmp(line, TELEMETRY_BLOCK_PREFIX, prefixLength) != 0) return false;
+
+  char* end = nullptr;
+  unsigned long seq = strtoul(line + prefixLength, &end, 10);
+  if (end == line + prefixLength || *end != ' ') return false;
+
+  size_t n = 0;
+  if (!telemetryFromHex(end + 1, block, capacity, n)) return false;
+  length = n;
+  sequence = (uint32_t)seq;
+  return n > 0;
+}
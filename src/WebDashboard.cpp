@@ -0,0 +1,468 @@
+/**
+ * @file WebDashboard.cpp
+ * @brief Embedded HTTP/WebSocket dashboard implementation
+ */
+
+#include "WebDashboard.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // lwIP raises no SIGPIPE
+#endif
+
+namespace {
+
+/** @brief Plots the last 600 pings and shows the alarm state */
+const char PAGE[] =
+    "<!DOCTYPE html><html><head><meta charset=\"utf-8\"><title>Intruder detector</title>"
+    "<style>body{font-family:sans-serif;margin:1em}"
+    "canvas{width:100%;height:300px;border:1px solid #ccc}</style></head><body>"
+    "<h3>Distance (cm) <span id=\"s\">connecting</span></h3>"
+    "<canvas id=\"c\" width=\"1200\" height=\"300\"></canvas><script>"
+    "var pts=[],alarm='clear',fault=0,c=document.getElementById('c'),"
+    "g=c.getContext('2d'),s=document.getElementById('s');"
+    "function show(){s.textContent=alarm+(fault?' (sensor fault)':'')}"
+    "function draw(){g.clearRect(0,0,c.width,c.height);g.beginPath();"
+    "for(var i=0;i<pts.length;i++){var x=i*c.width/600,y=c.height*(1-pts[i]/50);"
+    "i?g.lineTo(x,y):g.moveTo(x,y)}"
+    "g.strokeStyle=alarm=='intruder'?'#c00':'#06c';g.stroke()}"
+    "function open(){var w=new WebSocket('ws://'+location.host+'/ws');"
+    "w.binaryType='arraybuffer';w.onopen=show;"
+    "w.onclose=function(){s.textContent='reconnecting';setTimeout(open,1000)};"
+    "w.onmessage=function(e){var d=new DataView(e.data);"
+    "for(var o=4;o+5<=d.byteLength;o+=5){var k=d.getUint8(o),v=d.getUint16(o+3,true);"
+    "if(k==0){if(v)pts.push(v/10)}else if(k==1)alarm='intruder';"
+    "else if(k==2)alarm='clear';else if(k==3)fault=v}"
+    "if(pts.length>600)pts.splice(0,pts.length-600);show();draw()}}"
+    "open();</script></body></html>";
+
+// ============================================================================
+// SHA-1 AND BASE64 (handshake only)
+// ============================================================================
+
+uint32_t rotl(uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+void sha1Block(uint32_t state[5], const uint8_t* block) {
+  uint32_t w[80];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+           (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+  }
+  for (int i = 16; i < 80; i++) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+  for (int i = 0; i < 80; i++) {
+    uint32_t f, k;
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5A827999;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ED9EBA1;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8F1BBCDC;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xCA62C1D6;
+    }
+    uint32_t t = rotl(a, 5) + f + e + k + w[i];
+    e = d;
+    d = c;
+    c = rotl(b, 30);
+    b = a;
+    a = t;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+}
+
+/** @brief SHA-1 of a message shorter than 119 bytes (two blocks) */
+void sha1Short(const uint8_t* data, size_t length, uint8_t digest[20]) {
+  uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  uint8_t blocks[128] = {};
+  memcpy(blocks, data, length);
+  blocks[length] = 0x80;
+  size_t total = length + 9 <= 64 ? 64 : 128;
+  uint64_t bits = (uint64_t)length * 8;
+  for (int i = 0; i < 8; i++) blocks[total - 1 - i] = (uint8_t)(bits >> (8 * i));
+  for (size_t offset = 0; offset < total; offset += 64) sha1Block(state, blocks + offset);
+  for (int i = 0; i < 20; i++) digest[i] = (uint8_t)(state[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+}  // namespace
+
+void webSocketAccept(const char* key, char* out) {
+  static const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  uint8_t message[118];
+  size_t keyLength = strnlen(key, sizeof(message) - (sizeof(GUID) - 1));
+  memcpy(message, key, keyLength);
+  memcpy(message + keyLength, GUID, sizeof(GUID) - 1);
+  uint8_t digest[21] = {};
+  sha1Short(message, keyLength + sizeof(GUID) - 1, digest);
+  // 20 bytes: six full groups and one of two bytes, padded with one '='.
+  size_t n = 0;
+  for (int i = 0; i < 21; i += 3) {
+    uint32_t group = (uint32_t)digest[i] << 16 | (uint32_t)digest[i + 1] << 8 | digest[i + 2];
+    out[n++] = BASE64[group >> 18];
+    out[n++] = BASE64[(group >> 12) & 63];
+    out[n++] = BASE64[(group >> 6) & 63];
+    out[n++] = i + 3 <= 20 ? BASE64[group & 63] : '=';
+  }
+  out[n] = '\0';
+}
+
+// ============================================================================
+// SERVER
+// ============================================================================
+
+WebDashboard::WebDashboard(uint16_t port, uint32_t flushMs, uint32_t periodUs)
+    : port_(port),
+      flushMs_(flushMs),
+      periodUs_(periodUs),
+      listenFd_(-1),
+      nextSequence_(0),
+      openLength_(0),
+      openMs_(0),
+      lastMs_(0),
+      flushNow_(false),
+      records_(0),
+      frameSends_(0),
+      bytesSent_(0),
+      skipped_(0),
+      pages_(0),
+      upgrades_(0),
+      dropped_(0) {
+  for (Client& client : clients_) {
+    client.fd = -1;
+    client.state = ClientState::Free;
+  }
+}
+
+WebDashboard::~WebDashboard() {
+  for (Client& client : clients_) {
+    if (client.state != ClientState::Free) ::close(client.fd);
+  }
+  if (listenFd_ >= 0) ::close(listenFd_);
+}
+
+bool WebDashboard::begin() {
+  listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenFd_ < 0) return false;
+  int on = 1;
+  setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port_);
+  socklen_t size = sizeof(address);
+  if (bind(listenFd_, (const sockaddr*)&address, sizeof(address)) < 0 ||
+      listen(listenFd_, DASHBOARD_MAX_CLIENTS) < 0 ||
+      getsockname(listenFd_, (sockaddr*)&address, &size) < 0) {
+    ::close(listenFd_);
+    listenFd_ = -1;
+    return false;
+  }
+  port_ = ntohs(address.sin_port);
+  fcntl(listenFd_, F_SETFL, fcntl(listenFd_, F_GETFL, 0) | O_NONBLOCK);
+  return true;
+}
+
+void WebDashboard::sample(uint32_t timeMs, float distanceCm) {
+  float tenths = distanceCm * 10 + 0.5f;
+  append(DashboardRecord::Sample, timeMs,
+         tenths <= 0 ? 0 : tenths >= 65535 ? 65535 : (uint16_t)tenths);
+}
+
+void WebDashboard::state(DashboardRecord kind, uint32_t timeMs, uint16_t value) {
+  append(kind, timeMs, value);
+  flushNow_ = true;
+}
+
+void WebDashboard::append(DashboardRecord kind, uint32_t timeMs, uint16_t value) {
+  records_++;
+  if (openLength_ > 0 && (openLength_ + DASHBOARD_RECORD_BYTES > DASHBOARD_FRAME_BYTES - 4 ||
+                          timeMs - lastMs_ > 0xffff)) {
+    seal();
+  }
+  uint8_t* payload = frames_[nextSequence_ % DASHBOARD_FRAMES].bytes + 4;
+  if (openLength_ == 0) {
+    for (int i = 0; i < 4; i++) payload[i] = (uint8_t)(timeMs >> (8 * i));
+    openLength_ = 4;
+    openMs_ = timeMs;
+    lastMs_ = timeMs;
+  }
+  uint16_t deltaMs = (uint16_t)(timeMs - lastMs_);
+  uint8_t* record = payload + openLength_;
+  record[0] = (uint8_t)kind;
+  record[1] = (uint8_t)deltaMs;
+  record[2] = (uint8_t)(deltaMs >> 8);
+  record[3] = (uint8_t)value;
+  record[4] = (uint8_t)(value >> 8);
+  openLength_ += DASHBOARD_RECORD_BYTES;
+  lastMs_ = timeMs;
+}
+
+/**
+ * @details The payload was built at offset 4; the WebSocket header (FIN,
+ * binary, unmasked as server frames are) goes right in front of it.
+ */
+void WebDashboard::seal() {
+  Frame& frame = frames_[nextSequence_ % DASHBOARD_FRAMES];
+  if (openLength_ < 126) {
+    frame.start = 2;
+    frame.bytes[2] = 0x82;
+    frame.bytes[3] = (uint8_t)openLength_;
+  } else {
+    frame.start = 0;
+    frame.bytes[0] = 0x82;
+    frame.bytes[1] = 126;
+    frame.bytes[2] = (uint8_t)(openLength_ >> 8);
+    frame.bytes[3] = (uint8_t)openLength_;
+  }
+  frame.length = (uint16_t)(4 - frame.start + openLength_);
+  nextSequence_++;
+  openLength_ = 0;
+  flushNow_ = false;
+  reuseOldest();
+}
+
+/**
+ * @details The next open frame takes the slot of the oldest sealed one, so
+ * viewers still on that frame lose it.
+ */
+void WebDashboard::reuseOldest() {
+  if (nextSequence_ < DASHBOARD_FRAMES) return;
+  uint32_t oldest = nextSequence_ - DASHBOARD_FRAMES + 1;
+  for (Client& client : clients_) {
+    if (client.state != ClientState::Streaming || client.sequence >= oldest) continue;
+    if (client.offset > 0) {
+      closeClient(client);  // half-written frame; the stream cannot resume
+      dropped_++;
+      continue;
+    }
+    skipped_ += oldest - client.sequence;
+    client.sequence = oldest;
+  }
+}
+
+void WebDashboard::poll(uint32_t nowMs) {
+  if (listenFd_ < 0) return;
+  accept();
+  if (openLength_ > 0 && (flushNow_ || nowMs - openMs_ >= flushMs_)) seal();
+  for (Client& client : clients_) {
+    if (client.state == ClientState::Request) readRequest(client);
+    if (client.state == ClientState::Streaming) readFrames(client);
+    if (client.state == ClientState::Response || client.state == ClientState::Streaming) {
+      write(client);
+    }
+  }
+}
+
+void WebDashboard::step() {
+  COOP_BEGIN();
+  for (;;) {
+    poll((uint32_t)hal().millis());
+    COOP_SLEEP_FOR(periodUs_);
+  }
+  COOP_END();
+}
+
+void WebDashboard::accept() {
+  for (;;) {
+    int fd = ::accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) return;
+    Client* free = nullptr;
+    for (Client& client : clients_) {
+      if (client.state == ClientState::Free) {
+        free = &client;
+        break;
+      }
+    }
+    if (free == nullptr) {
+      ::close(fd);
+      dropped_++;
+      continue;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    free->fd = fd;
+    free->state = ClientState::Request;
+    free->upgrade = false;
+    free->requestLength = 0;
+    free->offset = 0;
+  }
+}
+
+void WebDashboard::readRequest(Client& client) {
+  size_t room = sizeof(client.request) - 1 - client.requestLength;
+  ssize_t n = recv(client.fd, client.request + client.requestLength, room, 0);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+    closeClient(client);
+    return;
+  }
+  if (n < 0) return;
+  client.requestLength += (size_t)n;
+  client.request[client.requestLength] = '\0';
+  if (strstr(client.request, "\r\n\r\n") != nullptr) {
+    respond(client);
+  } else if (client.requestLength == sizeof(client.request) - 1) {
+    closeClient(client);  // head too long
+    dropped_++;
+  }
+}
+
+/**
+ * @details Viewers send nothing but a close frame (or, rarely, a ping);
+ * anything other than a close is read and ignored.
+ */
+void WebDashboard::readFrames(Client& client) {
+  uint8_t buffer[64];
+  ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) ||
+      (n > 0 && (buffer[0] & 0x0f) == 0x8)) {
+    closeClient(client);
+  }
+}
+
+void WebDashboard::respond(Client& client) {
+  const char* path = client.request + 4;
+  bool get = strncmp(client.request, "GET ", 4) == 0;
+  size_t pathLength = strcspn(path, " \r\n");
+  client.body = nullptr;
+  client.bodyLength = 0;
+  client.offset = 0;
+  int n;
+  if (get && pathLength == 3 && strncmp(path, "/ws", 3) == 0) {
+    // Header names are case-insensitive; the key is 24 base64 characters.
+    const char* key = nullptr;
+    for (const char* line = strstr(client.request, "\r\n"); line != nullptr;
+         line = strstr(line + 2, "\r\n")) {
+      if (strncasecmp(line + 2, "Sec-WebSocket-Key:", 18) == 0) {
+        key = line + 20;
+        break;
+      }
+    }
+    if (key == nullptr) {
+      n = snprintf(client.head, sizeof(client.head),
+                   "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    } else {
+      key += strspn(key, " \t");
+      char trimmed[64];
+      size_t keyLength = strcspn(key, " \t\r\n");
+      if (keyLength >= sizeof(trimmed)) keyLength = sizeof(trimmed) - 1;
+      memcpy(trimmed, key, keyLength);
+      trimmed[keyLength] = '\0';
+      char accept[32];
+      webSocketAccept(trimmed, accept);
+      n = snprintf(client.head, sizeof(client.head),
+                   "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                   "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n",
+                   accept);
+      client.upgrade = true;
+      upgrades_++;
+    }
+  } else if (get && pathLength == 1 && path[0] == '/') {
+    client.body = PAGE;
+    client.bodyLength = sizeof(PAGE) - 1;
+    n = snprintf(client.head, sizeof(client.head),
+                 "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: %u\r\n"
+                 "Connection: close\r\n\r\n",
+                 (unsigned)client.bodyLength);
+    pages_++;
+  } else {
+    n = snprintf(client.head, sizeof(client.head),
+                 "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+  }
+  client.headLength = n > 0 ? (size_t)n : 0;
+  client.state = ClientState::Response;
+}
+
+void WebDashboard::write(Client& client) {
+  for (;;) {
+    const uint8_t* data;
+    size_t length;
+    if (client.state == ClientState::Response) {
+      if (client.offset < client.headLength) {
+        data = (const uint8_t*)client.head + client.offset;
+        length = client.headLength - client.offset;
+      } else if (client.offset < client.headLength + client.bodyLength) {
+        data = (const uint8_t*)client.body + (client.offset - client.headLength);
+        length = client.headLength + client.bodyLength - client.offset;
+      } else if (client.upgrade) {
+        client.state = ClientState::Streaming;
+        client.sequence = nextSequence_;  // new frames only
+        client.offset = 0;
+        continue;
+      } else {
+        closeClient(client);
+        return;
+      }
+    } else {
+      if (client.sequence == nextSequence_) return;
+      const Frame& frame = frames_[client.sequence % DASHBOARD_FRAMES];
+      data = frame.bytes + frame.start + client.offset;
+      length = frame.length - client.offset;
+    }
+    ssize_t n = send(client.fd, data, length, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) closeClient(client);
+      return;
+    }
+    client.offset += (size_t)n;
+    bytesSent_ += (uint64_t)n;
+    if ((size_t)n < length) return;
+    if (client.state == ClientState::Streaming) {
+      client.sequence++;
+      client.offset = 0;
+      frameSends_++;
+    }
+  }
+}
+
+void WebDashboard::closeClient(Client& client) {
+  ::close(client.fd);
+  client.fd = -1;
+  client.state = ClientState::Free;
+}
+
+size_t WebDashboard::viewers() const {
+  size_t count = 0;
+  for (const Client& client : clients_) count += client.state == ClientState::Streaming;
+  return count;
+}
+
+uint32_t WebDashboard::lag() const {
+  uint32_t lag = 0;
+  for (const Client& client : clients_) {
+    if (client.state != ClientState::Streaming) continue;
+    uint32_t behind = nextSequence_ - client.sequence;
+    if (behind > lag) lag = behind;
+  }
+  return lag;
+}
+
+size_t WebDashboard::format(char* out, size_t capacity) const {
+  int n = snprintf(out, capacity,
+                   "port=%u viewers=%u records=%lu frames=%lu sends=%lu bytes=%llu "
+                   "skipped=%lu pages=%lu upgrades=%lu dropped=%lu",
+                   (unsigned)port_, (unsigned)viewers(), (unsigned long)records_,
+                   (unsigned long)nextSequence_, (unsigned long)frameSends_,
+                   (unsigned long long)bytesSent_, (unsigned long)skipped_,
+                   (unsigned long)pages_, (unsigned long)upgrades_, (unsigned long)dropped_);
+  return n < 0 ? 0 : (size_t)n;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file DetectionScorer.cpp
+ * @brief Detection quality scoring against labelled ground truth
+ */
+
+#include "DetectionScorer.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+namespace {
+
+struct Window {
+  uint64_t startUs;
+  uint64_t endUs;
+};
+
+}  // namespace
+
+TraceScore scoreDetections(const std::vector<AlarmInterval>& alarms,
+                           const std::vector<LabelInterval>& labels, double hours,
+                           const ScoreOptions& options) {
+  TraceScore score;
+  score.hours = hours;
+
+  // Alarms never overlap and are in time order, so both their raise and
+  // clear times are sorted: one forward pass per list is enough.
+  size_t a = 0;
+  std::vector<Window> excused;
+  for (const LabelInterval& label : labels) {
+    if (label.kind == LabelKind::Ignore) {
+      Window w = {label.startUs, label.endUs};
+      excused.push_back(w);
+      continue;
+    }
+    uint64_t windowEnd = label.endUs + options.graceUs;
+    Window w = {label.startUs, windowEnd};
+    excused.push_back(w);
+
+    while (a < alarms.size() && alarms[a].clearedUs <= label.startUs) a++;
+    EventScore event;
+    event.startUs = label.startUs;
+    event.endUs = label.endUs;
+    event.detected = a < alarms.size() && alarms[a].raisedUs <= windowEnd;
+    event.latencyUs = 0;
+    event.late = false;
+    if (event.detected && alarms[a].raisedUs > label.startUs) {
+      event.latencyUs = alarms[a].raisedUs - label.startUs;
+      event.late = event.latencyUs > options.lateUs;
+    }
+    score.events.push_back(event);
+  }
+
+  // Merge the windows that excuse an alarm, then sweep the alarms past them.
+  std::sort(excused.begin(), excused.end(),
+            [](const Window& x, const Window& y) { return x.startUs < y.startUs; });
+  std::vector<Window> merged;
+  for (const Window& w : excused) {
+    if (!merged.empty() && w.startUs <= merged.back().endUs) {
+      merged.back().endUs = std::max(merged.back().endUs, w.endUs);
+    } else {
+      merged.push_back(w);
+    }
+  }
+  size_t m = 0;
+  for (const AlarmInterval& alarm : alarms) {
+    while (m < merged.size() && merged[m].endUs < alarm.raisedUs) m++;
+    if (m == merged.size() || alarm.raisedUs < merged[m].startUs) {
+      score.falseAlarmTimes.push_back(alarm.raisedUs);
+    }
+  }
+  return score;
+}
+
+size_t TraceScore::missed() const {
+  size_t n = 0;
+  for (const EventScore& e : events) n += e.detected ? 0 : 1;
+  return n;
+}
+
+size_t TraceScore::late() const {
+  size_t n = 0;
+  for (const EventScore& e : events) n += e.late ? 1 : 0;
+  return n;
+}
+
+double TraceScore::falseAlarmsPerHour() const {
+  return hours > 0 ? falseAlarmTimes.size() / hours : 0;
+}
+
+double TraceScore::missedRate() const {
+  return events.empty() ? 0 : (double)missed() / events.size();
+}
+
+double TraceScore::meanLatencyMs() const {
+  double sum = 0;
+  size_t n = 0;
+  for (const EventScore& e : events) {
+    if (!e.detected) continue;
+    sum += e.latencyUs / 1000.0;
+    n++;
+  }
+  return n > 0 ? sum / n : -1;
+}
+
+double TraceScore::latencyPercentileMs(double p) const {
+  std::vector<uint64_t> latencies;
+  for (const EventScore& e : events) {
+    if (e.detected) latencies.push_back(e.latencyUs);
+  }
+  if (latencies.empty()) return -1;
+  std::sort(latencies.begin(), latencies.end());
+  // Nearest-rank percentile.
+  size_t rank = (size_t)(p / 100.0 * latencies.size() + 0.999999);
+  if (rank < 1) rank = 1;
+  if (rank > latencies.size()) rank = latencies.size();
+  return latencies[rank - 1] / 1000.0;
+}
+
+void TraceScore::merge(const TraceScore& other) {
+  events.insert(events.end(), other.events.begin(), other.events.end());
+  falseAlarmTimes.insert(falseAlarmTimes.end(), other.falseAlarmTimes.begin(),
+                         other.falseAlarmTimes.end());
+  hours += other.hours;
+}
+
+void TraceScore::writeJson(FILE* out, bool withEvents) const {
+  fprintf(out,
+          "{\"hours\": %.4f, \"events\": %zu, \"detected\": %zu, \"missed\": %zu, "
+          "\"late\": %zu, \"missed_rate\": %.6f, \"false_alarms\": %zu, "
+          "\"false_alarms_per_hour\": %.4f, \"latency_ms\": {\"mean\": %.1f, "
+          "\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"max\": %.1f}",
+          hours, events.size(), detected(), missed(), late(), missedRate(),
+          falseAlarmTimes.size(), falseAlarmsPerHour(), meanLatencyMs(),
+          latencyPercentileMs(50), latencyPercentileMs(90), latencyPercentileMs(99),
+          latencyPercentileMs(100));
+  if (withEvents) {
+    fprintf(out, ", \"per_event\": [");
+    for (size_t i = 0; i < events.size(); i++) {
+      const EventScore& e = events[i];
+      fprintf(out,
+              "%s{\"start_us\": %" PRIu64 ", \"end_us\": %" PRIu64
+              ", \"detected\": %s, \"late\": %s, \"latency_ms\": %.1f}",
+              i ? ", " : "", e.startUs, e.endUs, e.detected ? "true" : "false",
+              e.late ? "true" : "false", e.detected ? e.latencyUs / 1000.0 : -1.0);
+    }
+    fprintf(out, "], \"false_alarm_us\": [");
+    for (size_t i = 0; i < falseAlarmTimes.size(); i++) {
+      fprintf(out, "%s%" PRIu64, i ? ", " : "", falseAlarmTimes[i]);
+    }
+    fprintf(out, "]");
+  }
+  fprintf(out, "}");
+}
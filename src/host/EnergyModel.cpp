@@ -0,0 +1,34 @@
+/**
+ * @file EnergyModel.cpp
+ * @brief Battery drain estimate implementation
+ */
+
+#include "EnergyModel.h"
+
+#include <stdio.h>
+
+double averageCurrentMa(const EnergyConfig& config, const EnergyUsage& usage) {
+  if (usage.totalUs == 0) return 0;
+  double slept = usage.sleptUs < usage.totalUs ? (double)usage.sleptUs : (double)usage.totalUs;
+  double awake = usage.totalUs - slept;
+  // Charge in mA·µs.
+  double charge = awake * config.cpuActiveMa + slept * config.lightSleepMa;
+  if (usage.awakeMhzUs > 0) charge -= (awake * 240 - usage.awakeMhzUs) * config.cpuMaPerMhz;
+  charge += (double)usage.sleeps * config.wakeUs * (config.cpuActiveMa - config.lightSleepMa);
+  charge += (double)usage.totalUs * (config.sensorIdleMa + config.boardMa);
+  charge += (double)usage.echoWaitUs * (config.sensorRangingMa - config.sensorIdleMa);
+  charge += (double)usage.buzzerUs * config.buzzerMa;
+  return charge / usage.totalUs;
+}
+
+size_t formatEnergyConfig(const EnergyConfig& config, char* out, size_t capacity) {
+  if (capacity == 0) return 0;
+  int n = snprintf(out, capacity,
+                   "cpu %.1f mA (-%.2f mA/MHz below 240), light sleep %.2f mA, "
+                   "sensor %.1f/%.1f mA, buzzer %.1f mA, board %.1f mA, wake %lu us",
+                   config.cpuActiveMa, config.cpuMaPerMhz, config.lightSleepMa,
+                   config.sensorIdleMa, config.sensorRangingMa, config.buzzerMa, config.boardMa,
+                   (unsigned long)config.wakeUs);
+  if (n < 0) return 0;
+  return (size_t)n < capacity ? (size_t)n : capacity - 1;
+}
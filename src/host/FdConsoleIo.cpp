@@ -0,0 +1,44 @@
+/**
+ * @file FdConsoleIo.cpp
+ * @brief File-descriptor console I/O implementation
+ */
+
+#include "FdConsoleIo.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+FdConsoleIo::FdConsoleIo(int inFd, int outFd)
+    : inFd_(inFd), outFd_(outFd), length_(0), position_(0), eof_(false) {
+  savedFlags_ = fcntl(inFd_, F_GETFL);
+  if (savedFlags_ >= 0) fcntl(inFd_, F_SETFL, savedFlags_ | O_NONBLOCK);
+}
+
+FdConsoleIo::~FdConsoleIo() {
+  if (savedFlags_ >= 0) fcntl(inFd_, F_SETFL, savedFlags_);
+}
+
+int FdConsoleIo::read() {
+  if (position_ == length_) {
+    if (eof_) return -1;
+    ssize_t n = ::read(inFd_, buffer_, sizeof(buffer_));
+    if (n == 0) eof_ = true;
+    if (n <= 0) return -1;  // EOF, EAGAIN or an error: nothing to read now
+    length_ = (size_t)n;
+    position_ = 0;
+  }
+  return buffer_[position_++];
+}
+
+void FdConsoleIo::write(const char* text, size_t length) {
+  while (length > 0) {
+    ssize_t n = ::write(outFd_, text, length);
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;  // a tty shares stdin's flags
+      return;
+    }
+    text += n;
+    length -= (size_t)n;
+  }
+}
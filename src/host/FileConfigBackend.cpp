@@ -0,0 +1,30 @@
+/**
+ * @file FileConfigBackend.cpp
+ * @brief File-backed configuration storage implementation
+ */
+
+#include "FileConfigBackend.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+int FileConfigBackend::read(uint8_t* out, size_t capacity) {
+  FILE* file = fopen(path_.c_str(), "rb");
+  if (file == nullptr) return -1;
+  size_t n = fread(out, 1, capacity, file);
+  fclose(file);
+  return (int)n;
+}
+
+bool FileConfigBackend::write(const uint8_t* data, size_t length) {
+  std::string temp = path_ + ".tmp";
+  FILE* file = fopen(temp.c_str(), "wb");
+  if (file == nullptr) return false;
+  bool ok = fwrite(data, 1, length, file) == length;
+  ok = fclose(file) == 0 && ok;
+  if (ok) ok = rename(temp.c_str(), path_.c_str()) == 0;
+  if (!ok) remove(temp.c_str());
+  return ok;
+}
+
+bool FileConfigBackend::erase() { return remove(path_.c_str()) == 0 || errno == ENOENT; }
@@ -0,0 +1,75 @@
+/**
+ * @file GroundTruth.cpp
+ * @brief Label sidecar reader/writer
+ */
+
+#include "GroundTruth.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+std::string labelPathFor(const std::string& tracePath) {
+  std::string::size_type dot = tracePath.rfind('.');
+  std::string::size_type slash = tracePath.rfind('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return tracePath + ".labels";
+  }
+  return tracePath.substr(0, dot) + ".labels";
+}
+
+bool loadLabels(const std::string& path, std::vector<LabelInterval>& labels) {
+  labels.clear();
+  FILE* f = fopen(path.c_str(), "r");
+  if (f == nullptr) return false;
+
+  bool ok = true;
+  char line[256];
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    const char* p = line;
+    while (*p == ' ' || *p == '\t') p++;
+    int version;
+    if (sscanf(p, "#! ids-labels %d", &version) == 1 && version != 1) {
+      ok = false;  // Written by a newer tool; refuse rather than misread.
+      break;
+    }
+    if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+
+    LabelInterval label;
+    char kind[16] = "intruder";
+    int fields = sscanf(p, "%" SCNu64 " %" SCNu64 " %15s", &label.startUs, &label.endUs, kind);
+    if (fields < 2 || label.endUs < label.startUs) {
+      ok = false;
+      break;
+    }
+    if (strcmp(kind, "intruder") == 0) {
+      label.kind = LabelKind::Intruder;
+    } else if (strcmp(kind, "ignore") == 0) {
+      label.kind = LabelKind::Ignore;
+    } else {
+      ok = false;
+      break;
+    }
+    labels.push_back(label);
+  }
+  fclose(f);
+
+  std::sort(labels.begin(), labels.end(),
+            [](const LabelInterval& a, const LabelInterval& b) {
+              return a.startUs < b.startUs;
+            });
+  return ok;
+}
+
+bool saveLabels(const std::string& path, const std::vector<LabelInterval>& labels) {
+  FILE* f = fopen(path.c_str(), "w");
+  if (f == nullptr) return false;
+  fprintf(f, "%s\n# startUs endUs kind\n", LABEL_FORMAT_HEADER);
+  for (const LabelInterval& label : labels) {
+    fprintf(f, "%" PRIu64 " %" PRIu64 " %s\n", label.startUs, label.endUs,
+            label.kind == LabelKind::Ignore ? "ignore" : "intruder");
+  }
+  return fclose(f) == 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * @file HttpAlertTransport.cpp
+ * @brief Non-blocking HTTP POST transport implementation
+ */
+
+#include "HttpAlertTransport.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+HttpAlertTransport::HttpAlertTransport(const std::string& host, uint16_t port,
+                                       const std::string& path, uint32_t timeoutMs)
+    : host_(host),
+      port_(port),
+      path_(path),
+      timeoutMs_(timeoutMs),
+      fd_(-1),
+      step_(Step::Idle),
+      sent_(0),
+      lastStatus_(0) {}
+
+HttpAlertTransport::~HttpAlertTransport() {
+  if (fd_ >= 0) close(fd_);
+}
+
+bool HttpAlertTransport::start(const char* body, size_t length) {
+  if (step_ != Step::Idle) return false;
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port_);
+  if (inet_pton(AF_INET, host_.c_str(), &address.sin_addr) != 1) return false;
+
+  fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd_ < 0) return false;
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+  if (connect(fd_, (const sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS) {
+    finish(DeliveryStatus::Failed);
+    return false;
+  }
+
+  char header[256];
+  snprintf(header, sizeof(header),
+           "POST %s HTTP/1.1\r\nHost: %s:%u\r\nContent-Type: application/json\r\n"
+           "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+           path_.c_str(), host_.c_str(), (unsigned)port_, length);
+  request_.assign(header);
+  request_.append(body, length);
+  sent_ = 0;
+  response_.clear();
+  step_ = Step::Connecting;
+  deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs_);
+  return true;
+}
+
+DeliveryStatus HttpAlertTransport::poll() {
+  if (step_ == Step::Idle) return DeliveryStatus::Failed;
+  if (std::chrono::steady_clock::now() > deadline_) return finish(DeliveryStatus::Failed);
+
+  if (step_ == Step::Connecting) {
+    // Writable once the handshake is over; SO_ERROR tells how it ended.
+    pollfd ready = {fd_, POLLOUT, 0};
+    if (::poll(&ready, 1, 0) == 0) return DeliveryStatus::Pending;
+    int error = 0;
+    socklen_t size = sizeof(error);
+    getsockopt(fd_, SOL_SOCKET, SO_ERROR, &error, &size);
+    if (error != 0) return finish(DeliveryStatus::Failed);
+    step_ = Step::Sending;
+  }
+
+  if (step_ == Step::Sending) {
+    while (sent_ < request_.size()) {
+      ssize_t n = send(fd_, request_.data() + sent_, request_.size() - sent_, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          return DeliveryStatus::Pending;
+        }
+        return finish(DeliveryStatus::Failed);
+      }
+      sent_ += (size_t)n;
+    }
+    step_ = Step::Receiving;
+  }
+
+  // Only the status line matters: "HTTP/1.1 200 OK\r\n".
+  char buffer[256];
+  while (response_.find("\r\n") == std::string::npos) {
+    ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return DeliveryStatus::Pending;
+    // Closed or reset before a full status line: the answer was lost.
+    if (n <= 0 || response_.size() > 512) return finish(DeliveryStatus::Failed);
+    response_.append(buffer, (size_t)n);
+  }
+  int status = 0;
+  if (sscanf(response_.c_str(), "HTTP/%*d.%*d %d", &status) != 1) {
+    return finish(DeliveryStatus::Failed);
+  }
+  lastStatus_ = status;
+  return finish(status >= 200 && status < 300 ? DeliveryStatus::Delivered
+                                              : DeliveryStatus::Failed);
+}
+
+DeliveryStatus HttpAlertTransport::finish(DeliveryStatus status) {
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+  step_ = Step::Idle;
+  return status;
+}
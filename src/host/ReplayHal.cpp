@@ -0,0 +1,84 @@
+/**
+ * @file ReplayHal.cpp
+ * @brief Trace-driven Hal implementation
+ */
+
+#include "ReplayHal.h"
+
+ReplayHal::ReplayHal(const TraceRecord* records, size_t count, uint8_t echoPin,
+                     uint8_t buzzerPin)
+    : records_(records),
+      count_(count),
+      cursor_(0),
+      nowUs_(count > 0 ? records[0].timeUs : 0),
+      echoPin_(echoPin),
+      buzzerPin_(buzzerPin),
+      buzzerLevel_(LOW),
+      edgeListener_(nullptr) {}
+
+void ReplayHal::digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin != buzzerPin_ || level == buzzerLevel_) return;
+  buzzerLevel_ = level;
+  if (edgeListener_ != nullptr) edgeListener_->onBuzzerEdge(nowUs_, level);
+}
+
+unsigned long ReplayHal::pulseIn(uint8_t pin, uint8_t, unsigned long timeoutUs) {
+  if (pin != echoPin_ || cursor_ >= count_) {
+    nowUs_ += timeoutUs;
+    return 0;
+  }
+  const TraceRecord& record = records_[cursor_++];
+  if (record.timeUs > nowUs_) nowUs_ = record.timeUs;
+
+  // A recorded echo longer than the current timeout would have timed out.
+  unsigned long echo = record.echoUs;
+  if (echo == 0 || echo >= timeoutUs) {
+    nowUs_ += timeoutUs;
+    return 0;
+  }
+  nowUs_ += echo;
+  return echo;
+}
+
+// ============================================================================
+// REPLAY HELPERS
+// ============================================================================
+
+namespace {
+
+/** @brief Collects alarm intervals with their virtual timestamps */
+class AlarmCollector : public DetectorListener {
+ public:
+  AlarmCollector(ReplayHal& hal, std::vector<AlarmInterval>& alarms)
+      : hal_(hal), alarms_(alarms) {}
+
+  void onIntruder(float) override {
+    AlarmInterval alarm = {hal_.now(), UINT64_MAX};
+    alarms_.push_back(alarm);
+  }
+
+  void onClear(float) override {
+    if (!alarms_.empty()) alarms_.back().clearedUs = hal_.now();
+  }
+
+ private:
+  ReplayHal& hal_;
+  std::vector<AlarmInterval>& alarms_;
+};
+
+}  // namespace
+
+bool replayMatchesTrace(const TraceSensorConfig& sensor, const DetectorConfig& config) {
+  return config.samplesPerReading == sensor.samplesPerReading;
+}
+
+void replayAlarms(const TraceRecord* records, size_t count, const DetectorConfig& config,
+                  std::vector<AlarmInterval>& alarms) {
+  alarms.clear();
+  ReplayHal hal(records, count, config.echoPin, config.buzzerPin);
+  IntruderDetector detector(hal, config);
+  AlarmCollector collector(hal, alarms);
+  detector.setListener(&collector);
+  detector.begin();
+  while (!hal.finished()) detector.loop();
+}
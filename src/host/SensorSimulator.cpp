@@ -0,0 +1,133 @@
+/**
+ * @file SensorSimulator.cpp
+ * @brief Host-side HC-SR04 scene model implementation
+ */
+
+#include "SensorSimulator.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+/**
+ * @brief Speed of sound in air at room temperature (cm/µs)
+ * @details Must match SOUND_SPEED in the firmware.
+ */
+static const double soundSpeed = 0.034;
+
+SensorSimulator::SensorSimulator(const SimScene& scene, uint64_t seed)
+    : scene_(scene),
+      lastPingUs_(0),
+      havePing_(false),
+      state_(seed ? seed : 0x9E3779B97F4A7C15ull) {
+  // Sorting by start time plus a running maximum of end times lets
+  // trueDistanceAt() find active intrusions without scanning all of them.
+  std::sort(scene_.intrusions.begin(), scene_.intrusions.end(),
+            [](const SimIntrusion& a, const SimIntrusion& b) {
+              return a.startUs < b.startUs;
+            });
+  uint64_t latest = 0;
+  for (const SimIntrusion& intrusion : scene_.intrusions) {
+    latest = std::max(latest, intrusion.endUs);
+    latestEnd_.push_back(latest);
+  }
+}
+
+unsigned long SensorSimulator::echoAt(uint64_t timeUs) {
+  unsigned long echo = directEcho(timeUs);
+  if (scene_.ghostCm > 0 && havePing_) {
+    uint64_t ghostUs = lastPingUs_ + distanceToEchoUs(scene_.ghostCm);
+    bool strong = scene_.ghostProbability >= 1 || uniform() < scene_.ghostProbability;
+    if (ghostUs > timeUs && strong) {
+      unsigned long early = (unsigned long)(ghostUs - timeUs);
+      if (echo == 0 || early < echo) echo = early;
+    }
+  }
+  lastPingUs_ = timeUs;
+  havePing_ = true;
+  return echo;
+}
+
+unsigned long SensorSimulator::directEcho(uint64_t timeUs) {
+  if (scene_.timeoutProbability > 0 && uniform() < scene_.timeoutProbability) {
+    return 0;
+  }
+  if (scene_.glitchProbability > 0 && uniform() < scene_.glitchProbability) {
+    // Cross-talk or a passing insect: one implausibly close echo.
+    return distanceToEchoUs((float)(2.0 + 4.0 * uniform()));
+  }
+  float distance = trueDistanceAt(timeUs);
+  if (distance <= 0) return 0;
+
+  double noisy = distance + gaussian() * scene_.noiseCm;
+  if (noisy < 2.0) noisy = 2.0;  // HC-SR04 blind zone
+  unsigned long echo = distanceToEchoUs((float)noisy);
+  return echo >= scene_.echoTimeoutUs ? 0 : echo;
+}
+
+float SensorSimulator::trueDistanceAt(uint64_t timeUs) const {
+  float distance = scene_.backgroundCm;
+  const std::vector<SimIntrusion>& intrusions = scene_.intrusions;
+  size_t i = std::upper_bound(intrusions.begin(), intrusions.end(), timeUs,
+                              [](uint64_t t, const SimIntrusion& intrusion) {
+                                return t < intrusion.startUs;
+                              }) -
+             intrusions.begin();
+  // Walk back over intrusions that started earlier and may still be active.
+  while (i > 0 && latestEnd_[i - 1] > timeUs) {
+    const SimIntrusion& intrusion = intrusions[--i];
+    if (timeUs < intrusion.endUs && (distance <= 0 || intrusion.distanceCm < distance)) {
+      distance = intrusion.distanceCm;
+    }
+  }
+  return distance;
+}
+
+unsigned long SensorSimulator::distanceToEchoUs(float distanceCm) {
+  return (unsigned long)lround(distanceCm * 2.0 / soundSpeed);
+}
+
+double SensorSimulator::uniform() {
+  // xorshift64*
+  state_ ^= state_ >> 12;
+  state_ ^= state_ << 25;
+  state_ ^= state_ >> 27;
+  return (double)((state_ * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double SensorSimulator::gaussian() {
+  // Box-Muller; one value per call keeps the generator state simple.
+  double u1 = uniform();
+  double u2 = uniform();
+  if (u1 < 1e-12) u1 = 1e-12;
+  return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+/** @brief splitmix64 step, used to lay out random scenes */
+static uint64_t nextRandom(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+SimScene makeRandomScene(uint64_t durationUs, int intrusionCount, uint64_t seed) {
+  SimScene scene;
+  scene.backgroundCm = 40;
+  if (intrusionCount <= 0 || durationUs == 0) return scene;
+
+  uint64_t state = seed;
+  uint64_t slot = durationUs / (uint64_t)intrusionCount;
+  for (int i = 0; i < intrusionCount; i++) {
+    // Keep each intrusion inside its own slot so they never overlap.
+    uint64_t length = 2000000 + (nextRandom(state) % 4) * 1000000;
+    if (length > slot / 2) length = slot / 2;
+    uint64_t start = (uint64_t)i * slot + nextRandom(state) % (slot / 2 + 1);
+    SimIntrusion intrusion;
+    intrusion.startUs = start;
+    intrusion.endUs = start + length;
+    intrusion.distanceCm = 2.5f + (float)(nextRandom(state) % 30) / 10.0f;
+    scene.intrusions.push_back(intrusion);
+  }
+  return scene;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file SimHal.cpp
+ * @brief Simulator-driven Hal implementation
+ */
+
+#include "SimHal.h"
+
+SimHal::SimHal(SensorSimulator& sensor, uint8_t echoPin, uint8_t buzzerPin, uint64_t startUs)
+    : sensor_(sensor),
+      nowUs_(startUs),
+      sleptUs_(0),
+      echoWaitUs_(0),
+      awakeMhzUs_(0),
+      cpuMhz_(240),
+      clockChanges_(0),
+      pulseEndUs_(0),
+      echoPin_(echoPin),
+      buzzerPin_(buzzerPin),
+      buzzerLevel_(LOW),
+      edgeListener_(nullptr) {}
+
+void SimHal::digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin != buzzerPin_ || level == buzzerLevel_) return;
+  buzzerLevel_ = level;
+  if (edgeListener_ != nullptr) edgeListener_->onBuzzerEdge(nowUs_, level);
+}
+
+unsigned long SimHal::pulseIn(uint8_t pin, uint8_t, unsigned long timeoutUs) {
+  unsigned long echo = pin == echoPin_ ? sensor_.echoAt(nowUs_) : 0;
+  if (echo >= timeoutUs) echo = 0;
+  unsigned long waitUs = echo != 0 ? echo : timeoutUs;
+  advance(waitUs);
+  if (pin == echoPin_) echoWaitUs_ += waitUs;
+  return echo;
+}
+
+void SimHal::startPulse(uint8_t pin, uint8_t, unsigned long timeoutUs) {
+  unsigned long echo = pin == echoPin_ ? sensor_.echoAt(nowUs_) : 0;
+  if (echo >= timeoutUs) echo = 0;
+  unsigned long waitUs = echo != 0 ? echo : timeoutUs;
+  pulseUs_ = echo;
+  pulseEndUs_ = nowUs_ + waitUs;
+  if (pin == echoPin_) echoWaitUs_ += waitUs;
+}
+
+bool SimHal::pulseDone(unsigned long& widthUs) {
+  if (nowUs_ < pulseEndUs_) return false;
+  widthUs = pulseUs_;
+  return true;
+}
+
+bool SimHal::setCpuFrequencyMhz(uint32_t mhz) {
+  // The ESP32's supported clocks.
+  if (mhz != 240 && mhz != 160 && mhz != 80 && mhz != 40 && mhz != 20 && mhz != 10) {
+    return false;
+  }
+  if (mhz != cpuMhz_) clockChanges_++;
+  cpuMhz_ = mhz;
+  return true;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file ToolOptions.cpp
+ * @brief Command-line handling shared by the host tools
+ */
+
+#include "ToolOptions.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "DetectorConsole.h"
+
+namespace {
+
+/** @brief Noise-sized gap limit; the gap itself is capped at maxGapCm anyway */
+const float MAX_GAP_SIGMAS = 100;
+
+/** @brief Parses a whole decimal number in [min, max] into field */
+template <typename T>
+bool parseUnsigned(const char* value, uint32_t min, uint32_t max, T& field) {
+  char* end = nullptr;
+  unsigned long n = strtoul(value, &end, 10);
+  if (value[0] < '0' || value[0] > '9' || *end != '\0' || n < min || n > max) return false;
+  field = (T)n;
+  return true;
+}
+
+/** @brief Parses a number in [min, max] into field; false for NaN as well */
+bool parseFloat(const char* value, float min, float max, float& field) {
+  char* end = nullptr;
+  float f = strtof(value, &end);
+  if (end == value || *end != '\0' || !(f >= min && f <= max)) return false;
+  field = f;
+  return true;
+}
+
+}  // namespace
+
+void applyTraceConfig(const TraceHeader& header, DetectorConfig& config) {
+  const TraceSensorConfig& sensor = header.sensor;
+  const TraceDetectorConfig& detector = header.detector;
+  config.trigPin = sensor.trigPin;
+  config.echoPin = sensor.echoPin;
+  config.buzzerPin = sensor.buzzerPin;
+  config.samplesPerReading = sensor.samplesPerReading;
+  config.pingSpacingMs = sensor.pingSpacingMs;
+  config.echoTimeoutUs = sensor.echoTimeoutUs;
+  config.cyclePeriodMs = sensor.cyclePeriodMs;
+  if (detector.filter < FILTER_TYPE_COUNT) config.filter = (FilterType)detector.filter;
+  config.scene.calibrationReadings = detector.calibrationReadings;
+  config.scene.calibrationPeriodMs = detector.calibrationPeriodMs;
+  config.scene.tripMarginCm = detector.tripMarginCm;
+  config.scene.clearMarginCm = detector.clearMarginCm;
+  config.scene.adaptRate = detector.adaptRate;
+}
+
+int parseDetectorOption(const char* arg, const char* value, DetectorConfig& config) {
+  SceneConfig& scene = config.scene;
+  NoiseConfig& noise = config.noise;
+  PowerConfig& power = config.power;
+  const float maxCm = DETECTOR_MAX_DISTANCE_CM;
+  bool ok;
+  if (strcmp(arg, "--trip") == 0) ok = parseFloat(value, 0, maxCm, config.tripCm);
+  else if (strcmp(arg, "--clear") == 0) ok = parseFloat(value, 0, maxCm, config.clearCm);
+  else if (strcmp(arg, "--samples") == 0) {
+    ok = parseUnsigned(value, 1, DETECTOR_MAX_SAMPLES, config.samplesPerReading);
+  } else if (strcmp(arg, "--spacing") == 0) {
+    ok = parseUnsigned(value, 0, DETECTOR_MAX_SPACING_MS, config.pingSpacingMs);
+  } else if (strcmp(arg, "--jitter") == 0) {
+    ok = parseUnsigned(value, 0, DETECTOR_MAX_JITTER_MS, config.pingJitterMs);
+  } else if (strcmp(arg, "--gate") == 0) {
+    ok = parseFloat(value, 0, maxCm, config.trackGateCm);
+  } else if (strcmp(arg, "--period") == 0) {
+    ok = parseUnsigned(value, 0, DETECTOR_MAX_PERIOD_MS, config.cyclePeriodMs);
+  } else if (strcmp(arg, "--timeout") == 0) {
+    ok = parseUnsigned(value, DETECTOR_MIN_TIMEOUT_US, DETECTOR_MAX_TIMEOUT_US,
+                       config.echoTimeoutUs);
+  } else if (strcmp(arg, "--dwell") == 0) {
+    ok = parseUnsigned(value, 1, UINT8_MAX, config.tripDwell);
+  } else if (strcmp(arg, "--clear-dwell") == 0) {
+    ok = parseUnsigned(value, 1, UINT8_MAX, config.clearDwell);
+  } else if (strcmp(arg, "--calibrate") == 0) {
+    ok = parseUnsigned(value, 0, UINT16_MAX, scene.calibrationReadings);
+  } else if (strcmp(arg, "--calib-period") == 0) {
+    ok = parseUnsigned(value, 0, DETECTOR_MAX_PERIOD_MS, scene.calibrationPeriodMs);
+  } else if (strcmp(arg, "--trip-margin") == 0) {
+    ok = parseFloat(value, 0, maxCm, scene.tripMarginCm);
+  } else if (strcmp(arg, "--clear-margin") == 0) {
+    ok = parseFloat(value, 0, maxCm, scene.clearMarginCm);
+  } else if (strcmp(arg, "--adapt") == 0) {
+    ok = parseFloat(value, 0, 1, scene.adaptRate);
+  } else if (strcmp(arg, "--adaptive-gap") == 0) {
+    ok = parseFloat(value, 0, MAX_GAP_SIGMAS, noise.gapSigmas);
+    if (ok) noise.adaptive = noise.gapSigmas > 0;
+  } else if (strcmp(arg, "--sleep") == 0) {
+    ok = parseUnsigned(value, 0, 1, power.lightSleep);
+  } else if (strcmp(arg, "--idle-period") == 0) {
+    ok = parseUnsigned(value, 0, DETECTOR_MAX_PERIOD_MS, power.idlePeriodMs);
+  } else if (strcmp(arg, "--idle-mhz") == 0) {
+    uint32_t mhz = 0;
+    ok = parseUnsigned(value, 0, DETECTOR_MAX_IDLE_MHZ, mhz) && validIdleCpuMhz(mhz);
+    if (ok) power.idleCpuMhz = mhz;
+  } else if (strcmp(arg, "--filter") == 0) {
+    ok = parseFilterType(value, config.filter);
+  } else {
+    return 0;
+  }
+  return ok ? 1 : -1;
+}
@@ -0,0 +1,214 @@
+/**
+ * @file TraceFile.cpp
+ * @brief Trace file writer and mmap-based reader
+ */
+
+#include "TraceFile.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+TraceSensorConfig traceDefaultSensorConfig() {
+  TraceSensorConfig sensor;
+  sensor.trigPin = 5;
+  sensor.echoPin = 18;
+  sensor.buzzerPin = 17;
+  sensor.samplesPerReading = 5;
+  sensor.echoTimeoutUs = 30000;
+  sensor.pingSpacingMs = 10;
+  sensor.cyclePeriodMs = 500;
+  sensor.soundSpeedCmPerUs = 0.034f;
+  return sensor;
+}
+
+TraceDetectorConfig traceDefaultDetectorConfig() {
+  TraceDetectorConfig detector;
+  memset(&detector, 0, sizeof(detector));
+  detector.filter = 0;  // FilterType::Mean; calibrationReadings 0: fixed thresholds
+  detector.tripMarginCm = 10;
+  detector.clearMarginCm = 6;
+  detector.adaptRate = 0.01f;
+  return detector;
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+TraceWriter::TraceWriter() : file_(nullptr), count_(0), lastTimeUs_(0) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+TraceWriter::~TraceWriter() { close(); }
+
+bool TraceWriter::open(const char* path, const TraceSensorConfig& sensor,
+                       const TraceDetectorConfig& detector, uint32_t indexStride) {
+  close();
+  file_ = fopen(path, "wb");
+  if (file_ == nullptr) return false;
+
+  memset(&header_, 0, sizeof(header_));
+  memcpy(header_.magic, TRACE_MAGIC, sizeof(header_.magic));
+  header_.version = TRACE_VERSION;
+  header_.headerBytes = sizeof(TraceHeader);
+  header_.recordBytes = sizeof(TraceRecord);
+  header_.indexStride = indexStride > 0 ? indexStride : TRACE_DEFAULT_INDEX_STRIDE;
+  header_.sensor = sensor;
+  header_.detector = detector;
+  count_ = 0;
+  lastTimeUs_ = 0;
+  index_.clear();
+
+  // Header with recordCount 0 marks the file unfinished until close().
+  return fwrite(&header_, sizeof(header_), 1, file_) == 1;
+}
+
+bool TraceWriter::append(uint64_t timeUs, uint32_t echoUs, uint16_t flags) {
+  if (file_ == nullptr || (count_ > 0 && timeUs < lastTimeUs_)) return false;
+
+  TraceRecord record;
+  record.timeUs = timeUs;
+  record.echoUs = echoUs;
+  record.flags = (uint16_t)(flags | (echoUs == 0 ? TRACE_FLAG_TIMEOUT : 0));
+  record.reserved = 0;
+  if (count_ % header_.indexStride == 0) {
+    TraceIndexEntry entry = {timeUs, count_};
+    index_.push_back(entry);
+  }
+  if (fwrite(&record, sizeof(record), 1, file_) != 1) return false;
+  count_++;
+  lastTimeUs_ = timeUs;
+  return true;
+}
+
+bool TraceWriter::close() {
+  if (file_ == nullptr) return true;
+
+  bool ok = true;
+  header_.recordCount = count_;
+  header_.indexCount = index_.size();
+  header_.indexOffset = sizeof(TraceHeader) + count_ * sizeof(TraceRecord);
+  if (!index_.empty()) {
+    ok = fwrite(&index_[0], sizeof(TraceIndexEntry), index_.size(), file_) ==
+         index_.size();
+  }
+  ok = ok && fseek(file_, 0, SEEK_SET) == 0 &&
+       fwrite(&header_, sizeof(header_), 1, file_) == 1;
+  ok = (fclose(file_) == 0) && ok;
+  file_ = nullptr;
+  index_.clear();
+  return ok;
+}
+
+// ============================================================================
+// READER
+// ============================================================================
+
+TraceReader::TraceReader()
+    : map_(nullptr),
+      mapLength_(0),
+      records_(nullptr),
+      count_(0),
+      index_(nullptr),
+      indexCount_(0) {
+  memset(&header_, 0, sizeof(header_));
+}
+
+TraceReader::~TraceReader() { close(); }
+
+bool TraceReader::open(const char* path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < TRACE_V1_HEADER_BYTES) {
+    ::close(fd);
+    return false;
+  }
+  mapLength_ = (size_t)st.st_size;
+  map_ = mmap(nullptr, mapLength_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED) {
+    map_ = nullptr;
+    return false;
+  }
+
+  // Version 1 stops before the detector settings: copy what is there.
+  const uint8_t* base = static_cast<const uint8_t*>(map_);
+  memcpy(&header_, base, TRACE_V1_HEADER_BYTES);
+  size_t headerBytes = header_.version == 1 ? TRACE_V1_HEADER_BYTES : sizeof(TraceHeader);
+  if (memcmp(header_.magic, TRACE_MAGIC, sizeof(header_.magic)) != 0 ||
+      header_.version < 1 || header_.version > TRACE_VERSION ||
+      header_.headerBytes != headerBytes || mapLength_ < headerBytes ||
+      header_.recordBytes != sizeof(TraceRecord)) {
+    close();
+    return false;
+  }
+  if (header_.version == 1) {
+    header_.detector = traceDefaultDetectorConfig();
+  } else {
+    memcpy(&header_, base, sizeof(TraceHeader));
+  }
+
+  records_ = reinterpret_cast<const TraceRecord*>(base + headerBytes);
+  size_t available = (mapLength_ - headerBytes) / sizeof(TraceRecord);
+
+  if (header_.indexOffset == 0) {
+    // Unfinished capture: trust the file size, no index.
+    count_ = available;
+  } else {
+    uint64_t indexEnd =
+        header_.indexOffset + header_.indexCount * sizeof(TraceIndexEntry);
+    if (header_.recordCount > available || indexEnd > mapLength_) {
+      close();
+      return false;
+    }
+    count_ = (size_t)header_.recordCount;
+    index_ = reinterpret_cast<const TraceIndexEntry*>(base + header_.indexOffset);
+    indexCount_ = (size_t)header_.indexCount;
+  }
+
+  // Sequential replay is the common access pattern.
+  madvise(map_, mapLength_, MADV_SEQUENTIAL);
+  return true;
+}
+
+void TraceReader::close() {
+  if (map_ != nullptr) munmap(map_, mapLength_);
+  map_ = nullptr;
+  mapLength_ = 0;
+  memset(&header_, 0, sizeof(header_));
+  records_ = nullptr;
+  count_ = 0;
+  index_ = nullptr;
+  indexCount_ = 0;
+}
+
+size_t TraceReader::seek(uint64_t timeUs) const {
+  size_t lo = 0;
+  size_t hi = count_;
+
+  if (indexCount_ > 0) {
+    // Narrow the search to one stride using the sparse index.
+    const TraceIndexEntry* end = index_ + indexCount_;
+    // First entry at or after t bounds the answer from above, the entry
+    // before it (strictly earlier than t) bounds it from below.
+    const TraceIndexEntry* it = std::lower_bound(
+        index_, end, timeUs,
+        [](const TraceIndexEntry& e, uint64_t t) { return e.timeUs < t; });
+    if (it != index_) lo = (size_t)(it - 1)->recordIndex;
+    if (it != end) hi = (size_t)it->recordIndex + 1;
+    if (hi > count_) hi = count_;
+  }
+
+  const TraceRecord* found = std::lower_bound(
+      records_ + lo, records_ + hi, timeUs,
+      [](const TraceRecord& r, uint64_t t) { return r.timeUs < t; });
+  return (size_t)(found - records_);
+}
@@ -0,0 +1,89 @@
+/**
+ * @file WorkStealingPool.cpp
+ * @brief Work-stealing thread pool implementation
+ */
+
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(size_t threads)
+    : nextQueue_(0), pending_(0), queued_(0), steals_(0), stopping_(false) {
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  if (threads == 0) threads = 1;
+  for (size_t i = 0; i < threads; i++) queues_.emplace_back(new Queue());
+  for (size_t i = 0; i < threads; i++) workers_.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(idleMutex_);
+    stopping_ = true;
+  }
+  workAvailable_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+void WorkStealingPool::submit(std::function<void()> job) {
+  pending_.fetch_add(1);
+  {
+    // Counting under idleMutex_ means a worker about to sleep either sees
+    // the job in its predicate or is already waiting for the notify below.
+    // Counting before the push keeps queued_ from ever going negative.
+    std::lock_guard<std::mutex> lock(idleMutex_);
+    queued_.fetch_add(1);
+  }
+  Queue& queue = *queues_[nextQueue_.fetch_add(1) % queues_.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+  }
+  workAvailable_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+  std::unique_lock<std::mutex> lock(idleMutex_);
+  allDone_.wait(lock, [this] { return pending_.load() == 0; });
+}
+
+bool WorkStealingPool::takeJob(size_t self, std::function<void()>& job) {
+  {
+    Queue& own = *queues_[self];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.jobs.empty()) {
+      job = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues_.size(); i++) {
+    Queue& victim = *queues_[(self + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      queued_.fetch_sub(1);
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::run(size_t self) {
+  std::function<void()> job;
+  for (;;) {
+    if (takeJob(self, job)) {
+      job();
+      job = nullptr;
+      if (pending_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        allDone_.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idleMutex_);
+    workAvailable_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+    if (stopping_) return;
+  }
+}
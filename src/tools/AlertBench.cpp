@@ -0,0 +1,460 @@
+/**
+ * @file AlertBench.cpp
+ * @brief Alert delivery against a local HTTP stand-in for the webhook
+ *
+ * @details Starts a stand-in receiver on 127.0.0.1 (an ephemeral port, its
+ * own thread) that accepts `POST /alerts`, reads the ids out of each batch
+ * and counts unique alerts and repeats, as a real endpoint would dedupe
+ * them. It can refuse requests with 503 (an outage) or read a batch and
+ * hang up without answering (a lost acknowledgement). AlertPublisher talks
+ * to it through HttpAlertTransport, exactly as it would to the real
+ * service. Runs:
+ *
+ * - throughput: `--alerts` alerts pushed as fast as the queue takes them,
+ *   batches of 1, 4 and 8; alerts/s and requests/s on the wall clock
+ * - outage: one alarm transition per second, the receiver down for
+ *   `--outage` s; alerts dropped from the full queue, failed tries, the
+ *   longest backoff and the time to drain after the receiver is back
+ * - lost acks: `--ack-loss` % of answers lost; repeats the receiver saw
+ *   against the unique alerts it kept (nothing lost, nothing doubled)
+ * - flapping: a fault that toggles every 100 ms for 10 s during an outage;
+ *   queue use and queue saves with and without merging repeats inside the
+ *   dedup window
+ * - reboot: alerts queued during an outage, the publisher destroyed and a
+ *   new one restored from the saved queue (FileConfigBackend); once with
+ *   a new alert published after restore() and once before it
+ * - publish(): wall-clock cost of queueing one alert, the only call made
+ *   from the detector's path
+ *
+ * The outage, flapping and reboot runs use a virtual millisecond clock for
+ * the publisher's timers (it stands still while a request is in flight),
+ * so backoffs of a minute take no real time.
+ *
+ * Usage: alert_bench [--alerts n] [--outage s] [--ack-loss percent] [--seed n]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "AlertPublisher.h"
+#include "FileConfigBackend.h"
+#include "HttpAlertTransport.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Minimal HTTP receiver: one connection at a time, Connection: close
+ */
+class StandInServer {
+ public:
+  explicit StandInServer(uint64_t seed) : random_(seed | 1) {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    if (bind(listenFd_, (const sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(listenFd_, 16) < 0) {
+      perror("alert_bench: stand-in server");
+      exit(1);
+    }
+    socklen_t size = sizeof(address);
+    getsockname(listenFd_, (sockaddr*)&address, &size);
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([this] { serve(); });
+  }
+
+  ~StandInServer() {
+    stop_ = true;
+    thread_.join();
+    close(listenFd_);
+  }
+
+  uint16_t port() const { return port_; }
+
+  /** @brief Answer 503 to everything while down */
+  void setDown(bool down) { down_ = down; }
+
+  /** @brief Share of accepted batches whose answer is never sent */
+  void setAckLoss(unsigned percent) { ackLossPercent_ = percent; }
+
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ids_.clear();
+    repeats_ = 0;
+    requests_ = 0;
+    intrusions_ = 0;
+  }
+
+  size_t unique() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ids_.size();
+  }
+  uint32_t repeats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return repeats_;
+  }
+  uint32_t requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+  }
+  uint32_t highestId() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ids_.empty() ? 0 : *ids_.rbegin();
+  }
+  /** @brief Intruder alerts received, repeats included */
+  uint32_t intrusions() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return intrusions_;
+  }
+
+ private:
+  void serve() {
+    while (!stop_) {
+      pollfd ready = {listenFd_, POLLIN, 0};
+      if (poll(&ready, 1, 50) <= 0) continue;
+      int fd = accept(listenFd_, nullptr, nullptr);
+      if (fd < 0) continue;
+      handle(fd);
+      close(fd);
+    }
+  }
+
+  void handle(int fd) {
+    std::string request;
+    char buffer[1024];
+    size_t bodyStart = std::string::npos;
+    size_t contentLength = 0;
+    for (;;) {
+      ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) return;
+      request.append(buffer, (size_t)n);
+      if (bodyStart == std::string::npos) {
+        size_t end = request.find("\r\n\r\n");
+        if (end == std::string::npos) continue;
+        bodyStart = end + 4;
+        size_t field = request.find("Content-Length:");
+        if (field == std::string::npos || field > end) return;
+        contentLength = strtoul(request.c_str() + field + 15, nullptr, 10);
+      }
+      if (request.size() >= bodyStart + contentLength) break;
+    }
+
+    const char* reply = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    if (down_) {
+      reply = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n"
+              "Connection: close\r\n\r\n";
+    } else {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_++;
+      for (size_t at = request.find("\"id\":", bodyStart); at != std::string::npos;
+           at = request.find("\"id\":", at + 5)) {
+        uint32_t id = (uint32_t)strtoul(request.c_str() + at + 5, nullptr, 10);
+        if (!ids_.insert(id).second) repeats_++;
+      }
+      for (size_t at = request.find("\"intruder\"", bodyStart); at != std::string::npos;
+           at = request.find("\"intruder\"", at + 1)) {
+        intrusions_++;
+      }
+      random_ ^= random_ << 13;
+      random_ ^= random_ >> 7;
+      random_ ^= random_ << 17;
+      if (random_ % 100 < ackLossPercent_) return;  // stored, but the answer is lost
+    }
+    send(fd, reply, strlen(reply), MSG_NOSIGNAL);
+  }
+
+  int listenFd_;
+  uint16_t port_;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> down_{false};
+  std::atomic<unsigned> ackLossPercent_{0};
+  std::mutex mutex_;
+  std::set<uint32_t> ids_;
+  uint32_t repeats_ = 0;
+  uint32_t requests_ = 0;
+  uint32_t intrusions_ = 0;
+  uint64_t random_;
+};
+
+/** @brief Accepts every batch at once; isolates publish() from the network */
+class NullTransport : public AlertTransport {
+ public:
+  bool start(const char*, size_t) override { return true; }
+  DeliveryStatus poll() override { return DeliveryStatus::Delivered; }
+};
+
+/**
+ * @brief Polls on a virtual clock until the queue is empty or limitMs passed
+ * @return Virtual time at the end
+ */
+uint32_t drain(AlertPublisher& publisher, uint32_t nowMs, uint32_t limitMs) {
+  while ((publisher.queued() > 0 || publisher.inFlight()) && nowMs < limitMs) {
+    publisher.poll(nowMs);
+    if (!publisher.inFlight()) nowMs += 10;
+  }
+  return nowMs;
+}
+
+void runThroughput(StandInServer& server, unsigned alerts) {
+  printf("throughput (%u alerts, loopback HTTP)\n", alerts);
+  printf("  %-6s %10s %11s %10s\n", "batch", "alerts/s", "requests/s", "ms/request");
+  const uint8_t batches[] = {1, 4, 8};
+  for (uint8_t batch : batches) {
+    server.reset();
+    HttpAlertTransport transport("127.0.0.1", server.port(), "/alerts");
+    AlertConfig config;
+    config.batchMax = batch;
+    config.dedupWindowMs = 0;
+    AlertPublisher publisher(transport, nullptr, config);
+    Clock::time_point start = Clock::now();
+    unsigned published = 0;
+    while (publisher.delivered() < alerts) {
+      while (published < alerts && publisher.queued() < ALERT_QUEUE_SIZE) {
+        publisher.publish(published % 2 == 0 ? AlertType::Intruder : AlertType::Clear,
+                          published, 12.5f);
+        published++;
+      }
+      uint32_t nowMs = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                           Clock::now() - start)
+                           .count();
+      publisher.poll(nowMs);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("  %-6u %10.0f %11.0f %10.3f%s\n", (unsigned)batch, alerts / seconds,
+           publisher.requests() / seconds, 1000 * seconds / publisher.requests(),
+           server.unique() == alerts && publisher.dropped() == 0 ? "" : "  (alerts lost!)");
+  }
+}
+
+void runOutage(StandInServer& server, unsigned outageS) {
+  server.reset();
+  HttpAlertTransport transport("127.0.0.1", server.port(), "/alerts");
+  AlertConfig config;
+  config.dedupWindowMs = 0;  // every transition queued: the queue bound is what is measured
+  AlertPublisher publisher(transport, nullptr, config);
+  server.setDown(true);
+  uint32_t nowMs = 0;
+  uint32_t longestBackoff = 0;
+  unsigned published = 0;
+  for (uint32_t second = 0; second < outageS; second++) {
+    publisher.publish(second % 2 == 0 ? AlertType::Intruder : AlertType::Clear, nowMs, 20);
+    published++;
+    for (uint32_t end = nowMs + 1000; nowMs < end;) {
+      publisher.poll(nowMs);
+      if (publisher.backoffMs() > longestBackoff) longestBackoff = publisher.backoffMs();
+      if (!publisher.inFlight()) nowMs += 10;
+    }
+  }
+  server.setDown(false);
+  uint32_t upMs = nowMs;
+  nowMs = drain(publisher, nowMs, nowMs + 10 * 60 * 1000);
+  printf("outage: %u alerts over a %u s outage, queue of %u\n", published, outageS,
+         (unsigned)ALERT_QUEUE_SIZE);
+  printf("  dropped %lu, failed tries %lu, longest backoff %.1f s, drained %.1f s after "
+         "recovery in %lu requests, receiver has %zu (%u repeats)\n",
+         (unsigned long)publisher.dropped(), (unsigned long)publisher.failures(),
+         longestBackoff / 1000.0, (nowMs - upMs) / 1000.0,
+         (unsigned long)(publisher.requests() - publisher.failures()), server.unique(),
+         (unsigned)server.repeats());
+}
+
+void runAckLoss(StandInServer& server, unsigned alerts, unsigned percent) {
+  server.reset();
+  server.setAckLoss(percent);
+  HttpAlertTransport transport("127.0.0.1", server.port(), "/alerts");
+  AlertConfig config;
+  config.dedupWindowMs = 0;
+  AlertPublisher publisher(transport, nullptr, config);
+  uint32_t nowMs = 0;
+  uint32_t nextMs = 0;
+  unsigned published = 0;
+  while (published < alerts || publisher.queued() > 0 || publisher.inFlight()) {
+    if (published < alerts && nowMs >= nextMs) {
+      publisher.publish(published % 2 == 0 ? AlertType::Intruder : AlertType::Clear, nowMs);
+      published++;
+      nextMs += 500;
+    }
+    publisher.poll(nowMs);
+    if (!publisher.inFlight()) nowMs += 10;
+  }
+  server.setAckLoss(0);
+  printf("lost acks: %u%% of answers lost, %u alerts\n", percent, alerts);
+  printf("  %lu requests, %lu failed; receiver saw %u repeats, kept %zu unique "
+         "(%s)\n",
+         (unsigned long)publisher.requests(), (unsigned long)publisher.failures(),
+         (unsigned)server.repeats(), server.unique(),
+         server.unique() == alerts ? "none lost" : "ALERTS LOST");
+}
+
+void runFlapping(StandInServer& server) {
+  printf("flapping: fault toggling every 100 ms for 10 s while the receiver is down, "
+         "then one intrusion\n");
+  const uint32_t windows[] = {0, 10000};
+  for (uint32_t window : windows) {
+    server.reset();
+    server.setDown(true);
+    char path[] = "/tmp/alert_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    FileConfigBackend store(path);
+    HttpAlertTransport transport("127.0.0.1", server.port(), "/alerts");
+    AlertConfig config;
+    config.dedupWindowMs = window;
+    AlertPublisher publisher(transport, &store, config);
+    uint32_t nowMs = 0;
+    for (unsigned i = 0; i < 100; i++) {
+      publisher.publish(i % 2 == 0 ? AlertType::SensorFault : AlertType::SensorOk, nowMs, 0,
+                        i % 2 == 0 ? 1 : 0);
+      for (uint32_t end = nowMs + 100; nowMs < end;) {
+        publisher.poll(nowMs);
+        if (!publisher.inFlight()) nowMs += 10;
+      }
+    }
+    publisher.publish(AlertType::Intruder, nowMs, 25);
+    size_t queued = publisher.queued();
+    server.setDown(false);
+    drain(publisher, nowMs, nowMs + 120000);
+    printf("  dedup window %5lu ms: %2zu queued, %2lu merged, %2lu dropped, %3lu saves; "
+           "receiver got %3zu alerts, intrusion %s\n",
+           (unsigned long)window, queued, (unsigned long)publisher.merged(),
+           (unsigned long)publisher.dropped(), (unsigned long)publisher.saves(),
+           server.unique(), server.intrusions() > 0 ? "delivered" : "lost");
+    unlink(path);
+  }
+}
+
+void runReboot(StandInServer& server) {
+  // The firmware restores before the first cycle, but an alert raised
+  // first must still get a fresh id and be delivered once.
+  for (bool publishFirst : {false, true}) {
+    server.reset();
+    char path[] = "/tmp/alert_bench_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    FileConfigBackend store(path);
+    store.erase();
+    server.setDown(true);
+    AlertConfig config;
+    config.dedupWindowMs = 0;  // the new alert must not merge into a restored one
+    size_t queuedBefore;
+    uint32_t savesBefore;
+    {
+      HttpAlertTransport transport("127.0.0.1", server.port(), "/alerts");
+      AlertPublisher publisher(transport, &store, config);
+      uint32_t nowMs = 0;
+      for (unsigned i = 0; i < 10; i++) {
+        publisher.publish(i % 2 == 0 ? AlertType::Intruder : AlertType::Clear, nowMs, 15);
+        for (uint32_t end = nowMs + 1000; nowMs < end;) {
+          publisher.poll(nowMs);
+          if (!publisher.inFlight()) nowMs += 10;
+        }
+      }
+      queuedBefore = publisher.queued();
+      savesBefore = publisher.saves();
+      // Power lost here: no flush(), only what poll() saved after each change.
+    }
+    server.setDown(false);
+    HttpAlertTransport transport("127.0.0.1", server.port(), "/alerts");
+    AlertPublisher publisher(transport, &store, config);
+    size_t restored;
+    if (publishFirst) {
+      publisher.publish(AlertType::Intruder, 0, 30);
+      restored = publisher.restore();
+    } else {
+      restored = publisher.restore();
+      publisher.publish(AlertType::Intruder, 0, 30);
+    }
+    drain(publisher, 0, 60000);
+    printf("reboot, %s: %zu queued at power loss (ids 1-10), %zu restored "
+           "(%lu saves before), receiver has %zu (%u repeats, %s), last id %lu\n",
+           publishFirst ? "publish then restore" : "restore then publish", queuedBefore,
+           restored, (unsigned long)savesBefore, server.unique(), (unsigned)server.repeats(),
+           server.unique() == queuedBefore + 1 && publisher.queued() == 0 ? "none lost"
+                                                                          : "ALERTS LOST",
+           (unsigned long)server.highestId());
+    store.erase();
+    unlink(path);
+  }
+}
+
+void runPublishCost() {
+  const unsigned n = 1000000;
+  const uint32_t windows[] = {0, 10000};
+  for (uint32_t window : windows) {
+    NullTransport transport;
+    AlertConfig config;
+    config.dedupWindowMs = window;
+    AlertPublisher publisher(transport, nullptr, config);
+    double best = 1e9;
+    double total = 0;
+    for (int round = 0; round < 5; round++) {
+      Clock::time_point start = Clock::now();
+      // Fault bits that never repeat: a full queue scanned and the oldest dropped.
+      for (unsigned i = 0; i < n; i++) {
+        publisher.publish(AlertType::SensorFault, 0, 0, (uint8_t)(i % 251 + 1));
+      }
+      double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+      if (ns < best) best = ns;
+      total += ns;
+    }
+    printf("publish(), dedup window %5lu ms: %.1f ns/alert best, %.1f mean of 5 x %u "
+           "(queue full, no repeat found)\n",
+           (unsigned long)window, best, total / 5, n);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  unsigned alerts = 2000;
+  unsigned outageS = 60;
+  unsigned ackLoss = 20;
+  uint64_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr,
+              "usage: %s [--alerts n] [--outage s] [--ack-loss percent] [--seed n]\n",
+              argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (strcmp(arg, "--alerts") == 0) alerts = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--outage") == 0) outageS = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--ack-loss") == 0) ackLoss = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--seed") == 0) seed = strtoull(value, nullptr, 10);
+    else {
+      fprintf(stderr, "alert_bench: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  StandInServer server(seed);
+  printf("stand-in receiver on 127.0.0.1:%u\n", (unsigned)server.port());
+  runThroughput(server, alerts);
+  runOutage(server, outageS);
+  runAckLoss(server, 200, ackLoss);
+  runFlapping(server);
+  runReboot(server);
+  runPublishCost();
+  return 0;
+}
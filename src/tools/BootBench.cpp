@@ -0,0 +1,237 @@
+/**
+ * @file BootBench.cpp
+ * @brief Power-up to armed time, and the visits it lets through
+ *
+ * @details Boots the real detector `--boots` times on the virtual clock, each
+ * time against a wall at 40 cm and one visit (2-5 s, 2.5-5.5 cm) starting at
+ * a random moment in the first `--window` seconds after power-up, i.e. an
+ * intruder arriving right after a power cut. Each boot follows the firmware:
+ * configuration, pins, then the first cycle immediately. Variants:
+ * - fixed: no scene calibration (the original firmware)
+ * - calib P: 20 calibration readings at the cycle period
+ * - calib N ms: the same readings `--calib-period` ms apart (firmware default)
+ * - calib 1 ms: nearly back to back
+ *
+ * Armed is the first reading that can raise the alarm (IntruderDetector::
+ * protecting()). For each variant it prints the mean, p90 and max time to
+ * armed, the share of calibrations spoilt by the visit (fixed thresholds
+ * used instead), missed visits and their mean detection latency, then the
+ * boot timeline (BootTimeline, as printed by `boot` on the device) of the
+ * first run. Runs are seeded, so the numbers are reproducible.
+ *
+ * Finally the host cost of the boot path itself (loading a stored config
+ * record, setConfig() and begin()) is timed on the wall clock.
+ *
+ * Usage: boot_bench [detector options] [--boots n] [--window s] [--seed n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "BootTimeline.h"
+#include "ConfigStore.h"
+#include "DetectionScorer.h"
+#include "IntruderDetector.h"
+#include "SensorSimulator.h"
+#include "SimHal.h"
+#include "ToolOptions.h"
+
+namespace {
+
+/**
+ * @brief Marks the boot steps and collects alarm intervals
+ */
+class BootRecorder : public DetectorListener {
+ public:
+  BootRecorder(SimHal& hal, IntruderDetector& detector, BootTimeline& timeline,
+               std::vector<AlarmInterval>& alarms)
+      : hal_(hal), detector_(detector), timeline_(timeline), alarms_(alarms) {}
+
+  void onPing(uint32_t, uint32_t) override { timeline_.mark("first_ping", hal_.now()); }
+
+  void onReading(float) override {
+    timeline_.mark("first_reading", hal_.now());
+    if (detector_.protecting()) timeline_.mark("armed", hal_.now());
+  }
+
+  void onIntruder(float) override {
+    AlarmInterval alarm = {hal_.now(), UINT64_MAX};
+    alarms_.push_back(alarm);
+  }
+
+  void onClear(float) override {
+    if (!alarms_.empty()) alarms_.back().clearedUs = hal_.now();
+  }
+
+ private:
+  SimHal& hal_;
+  IntruderDetector& detector_;
+  BootTimeline& timeline_;
+  std::vector<AlarmInterval>& alarms_;
+};
+
+struct Variant {
+  char name[24];
+  uint16_t calibrationReadings;
+  uint32_t calibrationPeriodMs;
+};
+
+uint64_t nextRandom(uint64_t& state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+void run(const Variant& variant, DetectorConfig config, int boots, double windowS,
+         uint64_t seed) {
+  config.scene.calibrationReadings = variant.calibrationReadings;
+  config.scene.calibrationPeriodMs = variant.calibrationPeriodMs;
+  // Timeouts read as 0 cm under the mean filter, which calibration would learn.
+  if (variant.calibrationReadings > 0 && config.filter == FilterType::Mean) {
+    config.filter = FilterType::Median;
+  }
+
+  std::vector<double> armedMs;
+  int spoilt = 0;
+  TraceScore total;
+  char timelineLine[256] = "";
+  uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+  for (int boot = 0; boot < boots; boot++) {
+    SimScene scene;
+    scene.backgroundCm = 40;
+    SimIntrusion visit;
+    visit.startUs = nextRandom(state) % (uint64_t)(windowS * 1e6 + 1);
+    visit.endUs = visit.startUs + 2000000 + (nextRandom(state) % 4) * 1000000;
+    visit.distanceCm = 2.5f + (float)(nextRandom(state) % 30) / 10.0f;
+    scene.intrusions.push_back(visit);
+    uint64_t endUs = visit.endUs + 5000000;
+
+    SensorSimulator sensor(scene, seed + boot);
+    SimHal hal(sensor, config.echoPin, config.buzzerPin);
+    BootTimeline timeline;
+    timeline.mark("setup", hal.now());
+    IntruderDetector detector(hal, config);
+    timeline.mark("config", hal.now());
+    std::vector<AlarmInterval> alarms;
+    BootRecorder recorder(hal, detector, timeline, alarms);
+    detector.setListener(&recorder);
+    detector.begin();
+    timeline.mark("pins", hal.now());
+    // Score the visit, and keep going until armed (a minute at most).
+    uint64_t armedUs = 0;
+    uint64_t limitUs = endUs + 60000000;
+    while (hal.now() < endUs || (!timeline.find("armed", armedUs) && hal.now() < limitUs)) {
+      detector.loop();
+    }
+    armedMs.push_back((armedUs > 0 ? armedUs : hal.now()) / 1000.0);
+    if (variant.calibrationReadings > 0 && !detector.scene().ready()) spoilt++;
+    std::vector<LabelInterval> labels;
+    LabelInterval label = {visit.startUs, visit.endUs, LabelKind::Intruder};
+    labels.push_back(label);
+    total.merge(scoreDetections(alarms, labels, hal.now() / 3.6e9));
+    if (boot == 0) timeline.format(timelineLine, sizeof(timelineLine));
+  }
+
+  std::sort(armedMs.begin(), armedMs.end());
+  double sum = 0;
+  for (double ms : armedMs) sum += ms;
+  size_t p90 = (armedMs.size() * 9) / 10;
+  if (p90 >= armedMs.size()) p90 = armedMs.size() - 1;
+  printf("%-14s %9.1f %9.1f %9.1f %8.1f %8.1f %9.1f\n", variant.name, sum / armedMs.size(),
+         armedMs[p90], armedMs.back(), 100.0 * spoilt / boots, 100.0 * total.missedRate(),
+         total.meanLatencyMs());
+  printf("  first boot (ms): %s\n", timelineLine);
+}
+
+/**
+ * @brief Wall-clock cost of the boot path on this host
+ */
+void timeBootPath(const DetectorConfig& config) {
+  uint8_t record[CONFIG_RECORD_BYTES];
+  encodeConfigRecord(config, record, sizeof(record));
+  SimScene scene;
+  SensorSimulator sensor(scene);
+  SimHal hal(sensor, config.echoPin, config.buzzerPin);
+  IntruderDetector detector(hal, config);
+
+  const int reps = 10000;
+  double loadNs = 0;
+  double setupNs = 0;
+  for (int i = 0; i < reps; i++) {
+    auto start = std::chrono::steady_clock::now();
+    DetectorConfig loaded = config;
+    decodeConfigRecord(record, sizeof(record), loaded);
+    auto loadedAt = std::chrono::steady_clock::now();
+    detector.setConfig(loaded);
+    detector.begin();
+    auto end = std::chrono::steady_clock::now();
+    loadNs += std::chrono::duration<double, std::nano>(loadedAt - start).count();
+    setupNs += std::chrono::duration<double, std::nano>(end - loadedAt).count();
+  }
+  printf("Boot path on this host: config decode %.0f ns, setConfig + begin %.0f ns\n",
+         loadNs / reps, setupNs / reps);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  DetectorConfig config;
+  config.scene.calibrationPeriodMs = 50;
+  int boots = 200;
+  double windowS = 15;
+  uint64_t seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr,
+              "usage: %s [options] [--boots n] [--window s] [--seed n]\n" DETECTOR_OPTIONS_USAGE,
+              argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    int handled = parseDetectorOption(arg, value, config);
+    if (handled < 0) {
+      fprintf(stderr, "boot_bench: invalid value %s for %s\n", value, arg);
+      return 2;
+    }
+    if (handled > 0) continue;
+    if (strcmp(arg, "--boots") == 0) boots = atoi(value);
+    else if (strcmp(arg, "--window") == 0) windowS = atof(value);
+    else if (strcmp(arg, "--seed") == 0) seed = strtoull(value, nullptr, 10);
+    else {
+      fprintf(stderr, "boot_bench: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  if (boots <= 0) boots = 1;
+
+  Variant variants[4];
+  snprintf(variants[0].name, sizeof(variants[0].name), "fixed");
+  variants[0].calibrationReadings = 0;
+  variants[0].calibrationPeriodMs = 0;
+  snprintf(variants[1].name, sizeof(variants[1].name), "calib %lums",
+           (unsigned long)config.cyclePeriodMs);
+  variants[1].calibrationReadings = 20;
+  variants[1].calibrationPeriodMs = 0;
+  snprintf(variants[2].name, sizeof(variants[2].name), "calib %lums",
+           (unsigned long)config.scene.calibrationPeriodMs);
+  variants[2].calibrationReadings = 20;
+  variants[2].calibrationPeriodMs = config.scene.calibrationPeriodMs;
+  snprintf(variants[3].name, sizeof(variants[3].name), "calib 1ms");
+  variants[3].calibrationReadings = 20;
+  variants[3].calibrationPeriodMs = 1;  // 0 would mean the cycle period
+
+  printf("%d boots, one visit in the first %.0f s after power-up\n", boots, windowS);
+  printf("%-14s %9s %9s %9s %8s %8s %9s\n", "variant", "armed_ms", "armed_p90", "armed_max",
+         "spoilt_%", "missed_%", "lat_mean");
+  for (const Variant& variant : variants) run(variant, config, boots, windowS, seed);
+  timeBootPath(config);
+  return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file CodecBench.cpp
+ * @brief Compression ratio and speed benchmark for SampleCodec
+ *
+ * @details Encodes sample streams block by block exactly as the firmware
+ * does (SAMPLE_HISTORY_BLOCK_BYTES per block), then decodes them again and
+ * checks the round trip. Reports, per trace:
+ * - compression ratio against raw 8 byte (timestamp + value) records
+ * - encode and decode cost in ns/sample
+ *
+ * Usage: codec_bench [recorded.csv ...]
+ *
+ * Recorded traces are CSV files with one "timestampMs,distanceCm" pair per
+ * line; lines that do not parse (headers, comments) are skipped. Without
+ * arguments only the simulated traces are benchmarked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SampleCodec.h"
+#include "SensorSimulator.h"
+
+namespace {
+
+struct Trace {
+  std::string name;
+  std::vector<uint32_t> timestamps;
+  std::vector<int32_t> values;
+};
+
+/** @brief Fixed-point conversion used by the firmware history */
+int32_t toFixed(double distanceCm) {
+  return (int32_t)(distanceCm * DISTANCE_FIXED_SCALE + (distanceCm >= 0 ? 0.5 : -0.5));
+}
+
+/**
+ * @brief Simulates per-ping distances at a given ping spacing
+ * @param spacingUs Nominal spacing between pings
+ * @param jitterUs Maximum random deviation of each ping time
+ */
+Trace simulate(const char* name, double noiseCm, uint64_t spacingUs,
+               uint64_t jitterUs, size_t samples) {
+  Trace trace;
+  trace.name = name;
+  uint64_t duration = spacingUs * samples;
+  SimScene scene = makeRandomScene(duration, (int)(duration / 60000000) + 1, 7);
+  scene.noiseCm = (float)noiseCm;
+  scene.timeoutProbability = 0.01f;
+  SensorSimulator sim(scene, 42);
+
+  uint64_t t = 0;
+  uint64_t jitterState = 12345;
+  for (size_t i = 0; i < samples; i++) {
+    unsigned long echo = sim.echoAt(t);
+    trace.timestamps.push_back((uint32_t)(t / 1000));
+    trace.values.push_back(toFixed(echo * 0.034 / 2));
+    jitterState = jitterState * 6364136223846793005ull + 1442695040888963407ull;
+    uint64_t jitter = jitterUs ? (jitterState >> 33) % (2 * jitterUs + 1) : 0;
+    t += spacingUs + jitter - jitterUs;
+  }
+  return trace;
+}
+
+bool loadCsv(const char* path, Trace& trace) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) return false;
+  trace.name = path;
+  char line[256];
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    unsigned long ts;
+    double cm;
+    if (sscanf(line, "%lu,%lf", &ts, &cm) == 2) {
+      trace.timestamps.push_back((uint32_t)ts);
+      trace.values.push_back(toFixed(cm));
+    }
+  }
+  fclose(f);
+  return !trace.values.empty();
+}
+
+double nsSince(std::chrono::steady_clock::time_point start, size_t samples) {
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / (double)samples;
+}
+
+void run(const Trace& trace) {
+  const size_t n = trace.values.size();
+  std::vector<uint8_t> storage;
+  std::vector<size_t> blockSizes;
+
+  // Encode repeatedly so short traces still give stable timings.
+  const int rounds = n < 100000 ? 20 : 3;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    storage.assign(n * 16 + SAMPLE_HISTORY_BLOCK_BYTES, 0);
+    blockSizes.clear();
+    size_t offset = 0;
+    SampleBlockEncoder encoder;
+    encoder.begin(&storage[0], SAMPLE_HISTORY_BLOCK_BYTES);
+    for (size_t i = 0; i < n; i++) {
+      if (!encoder.append(trace.timestamps[i], trace.values[i])) {
+        blockSizes.push_back(encoder.sizeBytes());
+        offset += SAMPLE_HISTORY_BLOCK_BYTES;
+        encoder.begin(&storage[offset], SAMPLE_HISTORY_BLOCK_BYTES);
+        encoder.append(trace.timestamps[i], trace.values[i]);
+      }
+    }
+    blockSizes.push_back(encoder.sizeBytes());
+  }
+  double encodeNs = nsSince(start, n * rounds);
+
+  size_t compressed = 0;
+  for (size_t size : blockSizes) compressed += size;
+
+  size_t decoded = 0;
+  bool exact = true;
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; round++) {
+    decoded = 0;
+    for (size_t b = 0; b < blockSizes.size(); b++) {
+      SampleBlockDecoder decoder;
+      if (!decoder.begin(&storage[b * SAMPLE_HISTORY_BLOCK_BYTES], blockSizes[b])) {
+        exact = false;
+        break;
+      }
+      uint32_t ts;
+      int32_t value;
+      while (decoder.next(ts, value)) {
+        if (round == 0 && (decoded >= n || ts != trace.timestamps[decoded] ||
+                           value != trace.values[decoded])) {
+          exact = false;
+        }
+        decoded++;
+      }
+    }
+  }
+  double decodeNs = nsSince(start, n * rounds);
+  exact = exact && decoded == n;
+
+  size_t raw = n * (sizeof(uint32_t) + sizeof(int32_t));
+  printf("%-28s %9zu %10zu %9zu %7.2fx %6.2f %9.1f %9.1f  %s\n", trace.name.c_str(), n,
+         raw, compressed, (double)raw / (double)compressed,
+         compressed * 8.0 / (double)n, encodeNs, decodeNs, exact ? "ok" : "MISMATCH");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Trace> traces;
+  traces.push_back(simulate("sim 2Hz cycle, 0.3cm noise", 0.3, 550000, 0, 200000));
+  traces.push_back(simulate("sim 100Hz ping, 0.3cm noise", 0.3, 10000, 0, 1000000));
+  traces.push_back(simulate("sim 100Hz ping, jittered", 0.3, 10000, 800, 1000000));
+  traces.push_back(simulate("sim 100Hz ping, 2cm noise", 2.0, 10000, 0, 1000000));
+  traces.push_back(simulate("sim 1kHz ping, 0.1cm noise", 0.1, 1000, 0, 1000000));
+
+  for (int i = 1; i < argc; i++) {
+    Trace trace;
+    if (!loadCsv(argv[i], trace)) {
+      fprintf(stderr, "codec_bench: cannot read samples from %s\n", argv[i]);
+      return 1;
+    }
+    traces.push_back(trace);
+  }
+
+  printf("%-28s %9s %10s %9s %8s %6s %9s %9s\n", "trace", "samples", "raw B",
+         "packed B", "ratio", "bits", "enc ns", "dec ns");
+  for (const Trace& trace : traces) run(trace);
+  return 0;
+}
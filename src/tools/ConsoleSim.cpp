@@ -0,0 +1,247 @@
+/**
+ * @file ConsoleSim.cpp
+ * @brief The Serial command console on a simulated detector
+ *
+ * @details Runs the real detector on simulated visits (makeRandomScene()) in
+ * virtual time and polls a CommandConsole on stdin/stdout once per cycle,
+ * the way the firmware polls Serial, so the commands can be tried without a
+ * board:
+ *
+ *   printf 'get trip\nset trip 7\narm off\nrun 60\nstatus\nquit\n' | console_sim
+ *
+ * Besides help/get/set it offers `arm [on|off]`, `trace [on|off]` (one line
+ * per ping), `status`, `run <seconds>` (advance the simulation before the
+ * next command) and `quit`. Alarms and clears are printed with their
+ * virtual time. At the end it prints how many polls and lines ran and the
+ * longest poll in host wall-clock time, i.e. what the console adds to a
+ * cycle. The simulation ends on `quit`, at end of input or after `--hours`.
+ *
+ * With `--config file` the file stands in for the firmware's NVS record: it
+ * is loaded over the command-line configuration at start, and `save` and
+ * `defaults` write or delete it.
+ *
+ * Usage: console_sim [detector options] [--hours h] [--seed n] [--config file]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include "ConfigStore.h"
+#include "DetectorConsole.h"
+#include "FdConsoleIo.h"
+#include "FileConfigBackend.h"
+#include "IntruderDetector.h"
+#include "SensorSimulator.h"
+#include "SimHal.h"
+#include "ToolOptions.h"
+
+namespace {
+
+struct Session {
+  SimHal* hal;
+  IntruderDetector* detector;
+  ConfigStore* store;
+  DetectorConfig defaults;  ///< Command-line configuration
+  DetectorConfig tuning;
+  bool trace = false;
+  bool quit = false;
+  uint64_t resumeUs = 0;  ///< Commands wait until the virtual clock gets here
+};
+
+double seconds(uint64_t us) { return us / 1e6; }
+
+/**
+ * @brief Prints alarms, clears and (with `trace on`) pings to the console
+ */
+class ConsoleReporter : public DetectorListener {
+ public:
+  ConsoleReporter(CommandConsole& console, Session& session)
+      : console_(console), session_(session) {}
+
+  void onPing(uint32_t timeUs, uint32_t echoUs) override {
+    if (session_.trace) {
+      console_.printf("ping t=%lu echo_us=%lu\n", (unsigned long)timeUs, (unsigned long)echoUs);
+    }
+  }
+
+  void onIntruder(float distanceCm) override {
+    console_.printf("[%.1f s] Intruder detected at %.1f cm\n", seconds(session_.hal->now()),
+                    distanceCm);
+  }
+
+  void onClear(float distanceCm) override {
+    console_.printf("[%.1f s] Area clear at %.1f cm\n", seconds(session_.hal->now()),
+                    distanceCm);
+  }
+
+ private:
+  CommandConsole& console_;
+  Session& session_;
+};
+
+bool parseOnOff(const char* args, bool& value) {
+  if (args[0] == '\0') return true;
+  if (strcmp(args, "on") == 0) {
+    value = true;
+  } else if (strcmp(args, "off") == 0) {
+    value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void cmdArm(CommandConsole& out, const char* args, void* context) {
+  Session& session = *(Session*)context;
+  bool armed = session.detector->armed();
+  if (!parseOnOff(args, armed)) {
+    out.println("Usage: arm [on|off]");
+    return;
+  }
+  if (armed != session.detector->armed()) session.detector->setArmed(armed);
+  out.printf("Alarm %s\n", armed ? "armed" : "disarmed");
+}
+
+void cmdTrace(CommandConsole& out, const char* args, void* context) {
+  Session& session = *(Session*)context;
+  if (!parseOnOff(args, session.trace)) {
+    out.println("Usage: trace [on|off]");
+    return;
+  }
+  out.printf("Trace %s\n", session.trace ? "on" : "off");
+}
+
+void cmdStatus(CommandConsole& out, const char*, void* context) {
+  Session& session = *(Session*)context;
+  IntruderDetector& detector = *session.detector;
+  float tripCm, clearCm;
+  detector.thresholds(tripCm, clearCm);
+  out.printf("t=%.1f s distance=%.1f cm alarm=%s armed=%s trip=%.2f clear=%.2f\n",
+             seconds(session.hal->now()), detector.distanceCm(),
+             detector.intruder() ? "on" : "off", detector.armed() ? "on" : "off", tripCm,
+             clearCm);
+}
+
+void cmdRun(CommandConsole& out, const char* args, void* context) {
+  Session& session = *(Session*)context;
+  char* end = nullptr;
+  double runSeconds = strtod(args, &end);
+  if (args[0] == '\0' || *end != '\0' || runSeconds < 0) {
+    out.println("Usage: run <seconds>");
+    return;
+  }
+  session.resumeUs = session.hal->now() + (uint64_t)(runSeconds * 1e6);
+}
+
+void cmdQuit(CommandConsole&, const char*, void* context) { ((Session*)context)->quit = true; }
+
+bool onParameterSet(const char*, void* context) {
+  Session& session = *(Session*)context;
+  if (!validDetectorTuning(session.tuning)) return false;
+  session.detector->tune(session.tuning);
+  return true;
+}
+
+void cmdSave(CommandConsole& out, const char*, void* context) {
+  Session& session = *(Session*)context;
+  out.println(session.store->save(session.tuning) ? "Config saved" : "Config save failed");
+}
+
+void cmdDefaults(CommandConsole& out, const char*, void* context) {
+  Session& session = *(Session*)context;
+  bool erased = session.store->erase();
+  session.tuning = session.defaults;
+  onParameterSet(nullptr, &session);
+  out.println(erased ? "Defaults restored" : "Defaults applied, stored config not erased");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  DetectorConfig config;
+  double hours = 1;
+  uint64_t seed = 1;
+  const char* configPath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr,
+              "usage: %s [options] [--hours h] [--seed n] [--config file]\n" DETECTOR_OPTIONS_USAGE,
+              argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    int handled = parseDetectorOption(arg, value, config);
+    if (handled < 0) {
+      fprintf(stderr, "console_sim: invalid value %s for %s\n", value, arg);
+      return 2;
+    }
+    if (handled > 0) continue;
+    if (strcmp(arg, "--hours") == 0) hours = atof(value);
+    else if (strcmp(arg, "--seed") == 0) seed = strtoull(value, nullptr, 10);
+    else if (strcmp(arg, "--config") == 0) configPath = value;
+    else {
+      fprintf(stderr, "console_sim: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  FileConfigBackend backend(configPath != nullptr ? configPath : "");
+  ConfigStore store(backend);
+  DetectorConfig defaults = config;
+  ConfigLoad configLoad = ConfigLoad::Missing;
+  if (configPath != nullptr) configLoad = store.load(config);
+
+  uint64_t endUs = (uint64_t)(hours * 3.6e9);
+  SimScene scene = makeRandomScene(endUs, (int)(hours * 120), seed);
+  SensorSimulator sensor(scene, seed);
+  SimHal hal(sensor, config.echoPin, config.buzzerPin);
+  IntruderDetector detector(hal, config);
+
+  Session session;
+  session.hal = &hal;
+  session.detector = &detector;
+  session.store = &store;
+  session.defaults = defaults;
+  session.tuning = config;
+  FdConsoleIo io(STDIN_FILENO, STDOUT_FILENO);
+  CommandConsole console(io);
+  console.addCommand("arm", "arm [on|off]", cmdArm, &session);
+  console.addCommand("trace", "trace [on|off]", cmdTrace, &session);
+  console.addCommand("status", "status", cmdStatus, &session);
+  console.addCommand("run", "run <seconds>", cmdRun, &session);
+  console.addCommand("quit", "quit", cmdQuit, &session);
+  if (configPath != nullptr) {
+    console.addCommand("save", "save", cmdSave, &session);
+    console.addCommand("defaults", "defaults", cmdDefaults, &session);
+    console.printf("Config %s: %s\n", configPath, configLoadName(configLoad));
+  }
+  addDetectorParameters(console, session.tuning);
+  console.setParameterListener(onParameterSet, &session);
+
+  ConsoleReporter reporter(console, session);
+  detector.setListener(&reporter);
+  detector.begin();
+
+  uint32_t polls = 0;
+  uint32_t lines = 0;
+  double maxPollUs = 0;
+  while (!session.quit && hal.now() < endUs) {
+    detector.loop();
+    if (hal.now() < session.resumeUs) continue;
+    if (io.eof()) break;
+    auto start = std::chrono::steady_clock::now();
+    if (console.poll()) lines++;
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    polls++;
+    if (elapsed.count() > maxPollUs) maxPollUs = elapsed.count();
+  }
+  console.printf("%.1f s simulated, %lu polls, %lu lines, max poll %.1f us\n", seconds(hal.now()),
+                 (unsigned long)polls, (unsigned long)lines, maxPollUs);
+  return 0;
+}
@@ -0,0 +1,336 @@
+/**
+ * @file CoopSim.cpp
+ * @brief Blocking loop() against cooperative tasks on one simulated board
+ *
+ * @details Runs the same detector, console and `@B` telemetry twice on a
+ * SimHal with simulated intrusions and console commands arriving at random
+ * times:
+ * - blocking: what the firmware's loop() does, detector.loop() followed by
+ *   the telemetry output and one console poll
+ * - cooperative: DetectorTask, a console task (polled every 5 ms) and a
+ *   telemetry task that writes a whole `@B` line once the UART has room
+ *   for it (COOP_AWAIT_UART_SPACE), all on one CoopScheduler
+ *
+ * The simulated UART sends at 115200 baud from the firmware's
+ * SERIAL_TX_BUFFER_BYTES buffer and, like Serial.write(), blocks when the
+ * buffer is full. Printed per mode: readings
+ * per second, detection latency and misses, command response time, time
+ * spent blocked in UART writes and scheduler steps per second.
+ *
+ * Usage: coop_sim [detector options] [--events n] [--commands-per-min n]
+ *                 [--seed n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "CommandConsole.h"
+#include "CoopScheduler.h"
+#include "DetectorConsole.h"
+#include "DetectorTask.h"
+#include "IntruderDetector.h"
+#include "LatencyProbe.h"
+#include "LogHistogram.h"
+#include "SensorSimulator.h"
+#include "SerialTasks.h"
+#include "SimHal.h"
+#include "Telemetry.h"
+#include "ToolOptions.h"
+
+namespace {
+
+/** @brief 10 bits per byte at 115200 baud */
+const double UART_US_PER_BYTE = 1e6 / 11520;
+
+/** @brief UART TX buffer, as the firmware sets it up */
+const size_t UART_BUFFER_BYTES = SERIAL_TX_BUFFER_BYTES;
+
+uint64_t splitmix(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Serial port on the virtual clock: timed input lines, paced output
+ * @details The first write after a command line was read counts as its
+ * response. A write that does not fit the buffer waits (advancing the clock)
+ * until it does.
+ */
+class SimUart : public ConsoleIo {
+ public:
+  struct Line {
+    uint64_t arrivalUs;
+    const char* text;
+  };
+
+  SimUart(SimHal& hal, const std::vector<Line>& lines)
+      : hal_(hal),
+        lines_(lines),
+        readLine_(0),
+        readPos_(0),
+        answered_(0),
+        queued_(0),
+        drainedUs_(0),
+        blockedUs_(0) {}
+
+  int read() override {
+    if (readLine_ >= lines_.size() || lines_[readLine_].arrivalUs > hal_.now()) return -1;
+    const char* text = lines_[readLine_].text;
+    char c = text[readPos_++];
+    if (text[readPos_] == '\0') {
+      readLine_++;
+      readPos_ = 0;
+    }
+    return c;
+  }
+
+  void write(const char*, size_t length) override {
+    if (answered_ < readLine_) {
+      responseUs_.record((uint32_t)(hal_.now() - lines_[answered_].arrivalUs));
+      answered_++;
+    }
+    drain();
+    queued_ += length;
+    if (queued_ > UART_BUFFER_BYTES) {
+      uint64_t waitUs = (uint64_t)((queued_ - UART_BUFFER_BYTES) * UART_US_PER_BYTE) + 1;
+      hal_.delayMicroseconds((uint32_t)waitUs);
+      blockedUs_ += waitUs;
+      drain();
+    }
+  }
+
+  size_t writeSpace() override {
+    drain();
+    return queued_ < UART_BUFFER_BYTES ? UART_BUFFER_BYTES - queued_ : 0;
+  }
+
+  const LogHistogram& responseUs() const { return responseUs_; }
+  uint64_t blockedUs() const { return blockedUs_; }
+
+ private:
+  /** @brief Removes what the UART sent since the last call */
+  void drain() {
+    uint64_t nowUs = hal_.now();
+    size_t sent = (size_t)((nowUs - drainedUs_) / UART_US_PER_BYTE);
+    if (sent >= queued_) {
+      queued_ = 0;
+      drainedUs_ = nowUs;
+      return;
+    }
+    queued_ -= sent;
+    drainedUs_ += (uint64_t)(sent * UART_US_PER_BYTE);
+  }
+
+  SimHal& hal_;
+  const std::vector<Line>& lines_;
+  size_t readLine_;
+  size_t readPos_;
+  size_t answered_;
+  size_t queued_;
+  uint64_t drainedUs_;
+  uint64_t blockedUs_;
+  LogHistogram responseUs_;
+};
+
+/**
+ * @brief Feeds intrusion starts and buzzer edges to the probe in time order
+ */
+class ProbeFeeder : public BuzzerEdgeListener {
+ public:
+  ProbeFeeder(LatencyProbe& probe, const std::vector<SimIntrusion>& intrusions)
+      : probe_(probe), intrusions_(intrusions), next_(0) {}
+
+  void feed(uint64_t timeUs) {
+    while (next_ < intrusions_.size() && intrusions_[next_].startUs <= timeUs) {
+      probe_.markEvent(intrusions_[next_++].startUs);
+    }
+  }
+
+  void onBuzzerEdge(uint64_t timeUs, uint8_t level) override {
+    feed(timeUs);
+    if (level == HIGH) {
+      probe_.markAlarm(timeUs);
+    } else {
+      probe_.markClear(timeUs);
+    }
+  }
+
+ private:
+  LatencyProbe& probe_;
+  const std::vector<SimIntrusion>& intrusions_;
+  size_t next_;
+};
+
+/** @brief Records every ping into the telemetry stream, as the firmware does */
+class TelemetryRecorder : public DetectorListener {
+ public:
+  explicit TelemetryRecorder(TelemetryStream& stream) : stream_(stream) {}
+  void onPing(uint32_t timeUs, uint32_t echoUs) override { stream_.record(timeUs, echoUs); }
+
+ private:
+  TelemetryStream& stream_;
+};
+
+/** @brief The firmware's emitTelemetry(): the whole line at once */
+void emitBlocking(TelemetryStream& stream, ConsoleIo& io) {
+  size_t length;
+  uint32_t sequence;
+  const uint8_t* block = stream.pending(length, sequence);
+  if (block == nullptr) return;
+  char line[TELEMETRY_LINE_MAX + 1];
+  io.write(line, telemetryFormatBlockLine(block, length, sequence, line));
+  stream.releasePending();
+}
+
+struct Scenario {
+  DetectorConfig config;
+  SimScene scene;
+  std::vector<SimUart::Line> commands;
+  uint64_t endUs;
+  uint64_t seed;
+};
+
+struct ModeResult {
+  uint32_t readings = 0;
+  uint32_t steps = 0;
+  uint64_t blockedUs = 0;
+  LatencyProbe probe;
+  LogHistogram responseUs;
+};
+
+/**
+ * @brief Runs one mode over the scenario
+ * @param cooperative false for the firmware's blocking loop()
+ */
+void runMode(const Scenario& scenario, bool cooperative, ModeResult& result) {
+  SensorSimulator sensor(scenario.scene, scenario.seed);
+  SimHal hal(sensor, scenario.config.echoPin, scenario.config.buzzerPin);
+  ProbeFeeder feeder(result.probe, scenario.scene.intrusions);
+  hal.setEdgeListener(&feeder);
+  TelemetryStream telemetry;
+  TelemetryRecorder recorder(telemetry);
+  IntruderDetector detector(hal, scenario.config);
+  detector.setListener(&recorder);
+  SimUart uart(hal, scenario.commands);
+  CommandConsole console(uart);
+  DetectorConfig tuning = scenario.config;
+  addDetectorParameters(console, tuning);
+
+  detector.begin();
+  if (!cooperative) {
+    while (hal.now() < scenario.endUs) {
+      feeder.feed(hal.now());
+      result.probe.poll(hal.now());
+      detector.loop();
+      result.readings++;
+      emitBlocking(telemetry, uart);
+      console.poll();
+    }
+  } else {
+    CoopScheduler scheduler(hal);
+    DetectorTask detectorTask(detector);
+    ConsoleTask consoleTask(console);
+    TelemetryTask telemetryTask(telemetry, uart);
+    scheduler.add(detectorTask);
+    scheduler.add(consoleTask);
+    scheduler.add(telemetryTask);
+    while (hal.now() < scenario.endUs) {
+      feeder.feed(hal.now());
+      result.probe.poll(hal.now());
+      uint64_t nextUs = scheduler.run();
+      if (nextUs > hal.now()) hal.delayMicroseconds((uint32_t)(nextUs - hal.now()));
+    }
+    result.readings = detectorTask.readings();
+    result.steps = scheduler.steps();
+  }
+  feeder.feed(scenario.endUs);
+  result.probe.poll(scenario.endUs + LATENCY_MISS_TIMEOUT_US + 1);
+  result.blockedUs = uart.blockedUs();
+  result.responseUs = uart.responseUs();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Scenario scenario;
+  unsigned events = 200;
+  double commandsPerMin = 30;
+  scenario.seed = 1;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr,
+              "usage: %s [options] [--events n] [--commands-per-min n] [--seed n]\n"
+              DETECTOR_OPTIONS_USAGE,
+              argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    int handled = parseDetectorOption(arg, value, scenario.config);
+    if (handled < 0) {
+      fprintf(stderr, "coop_sim: invalid value %s for %s\n", value, arg);
+      return 2;
+    }
+    if (handled > 0) continue;
+    if (strcmp(arg, "--events") == 0) events = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--commands-per-min") == 0) commandsPerMin = atof(value);
+    else if (strcmp(arg, "--seed") == 0) scenario.seed = strtoull(value, nullptr, 10);
+    else {
+      fprintf(stderr, "coop_sim: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  // Intrusions as in latency_sim: 2-8 s apart, 3 s long, inside the trip distance.
+  SimScene& scene = scenario.scene;
+  scene.backgroundCm = 40;
+  scene.noiseCm = 0.3f;
+  scene.timeoutProbability = 0.005f;
+  uint64_t state = scenario.seed;
+  uint64_t t = 5000000;
+  for (unsigned i = 0; i < events; i++) {
+    t += 2000000 + splitmix(state) % 6000000;
+    SimIntrusion intrusion;
+    intrusion.startUs = t;
+    intrusion.endUs = t + 3000000;
+    intrusion.distanceCm =
+        scenario.config.tripCm * (0.4f + 0.4f * (splitmix(state) % 1000) / 1000.0f);
+    scene.intrusions.push_back(intrusion);
+    t = intrusion.endUs;
+  }
+  scenario.endUs = t + 10000000;
+  if (commandsPerMin > 0) {
+    uint64_t meanGapUs = (uint64_t)(60e6 / commandsPerMin);
+    for (uint64_t at = 1000000 + splitmix(state) % meanGapUs; at < scenario.endUs;
+         at += meanGapUs / 2 + splitmix(state) % meanGapUs) {
+      scenario.commands.push_back({at, "get trip\n"});
+    }
+  }
+
+  printf("%u intrusions, %zu commands over %.0f s; %u pings/reading, spacing %lu ms, "
+         "period %lu ms\n",
+         events, scenario.commands.size(), scenario.endUs / 1e6,
+         (unsigned)scenario.config.samplesPerReading,
+         (unsigned long)scenario.config.pingSpacingMs,
+         (unsigned long)scenario.config.cyclePeriodMs);
+  printf("%-12s %10s %9s %9s %7s %9s %9s %11s %9s\n", "mode", "readings/s", "det_ms",
+         "det_p99", "missed", "cmd_ms", "cmd_max", "blocked_ms/s", "steps/s");
+  const char* names[] = {"blocking", "cooperative"};
+  for (int mode = 0; mode < 2; mode++) {
+    ModeResult result;
+    runMode(scenario, mode == 1, result);
+    double seconds = scenario.endUs / 1e6;
+    const LogHistogram& detect = result.probe.histogram();
+    printf("%-12s %10.2f %9.1f %9.1f %7u %9.1f %9.1f %11.2f %9.0f\n", names[mode],
+           result.readings / seconds, detect.mean() / 1000, detect.percentile(99) / 1000.0,
+           (unsigned)result.probe.missed(), result.responseUs.mean() / 1000,
+           result.responseUs.max() / 1000.0, result.blockedUs / 1000.0 / seconds,
+           result.steps / seconds);
+  }
+  return 0;
+}
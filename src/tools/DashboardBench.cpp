@@ -0,0 +1,401 @@
+/**
+ * @file DashboardBench.cpp
+ * @brief WebDashboard streaming to several viewers on loopback
+ *
+ * @details Starts the firmware's WebDashboard on an ephemeral port and
+ * polls it from the main thread, as loop() or its task would. A second
+ * thread plays the browsers: it fetches the page, opens the WebSocket
+ * connections (checking the handshake), and parses every frame, checking
+ * that each viewer sees the sample sequence without gaps. Runs:
+ *
+ * - encoding: ns per sample to append and seal frames, with no viewers;
+ *   the cost that per-viewer encoding would multiply by the viewer count
+ * - sustained: for 1 to DASHBOARD_MAX_CLIENTS viewers, samples are
+ *   recorded as fast as the slowest viewer drains the frame ring, for
+ *   `--seconds` s; samples/s each viewer received, frames and MB/s written,
+ *   server CPU ns per sample
+ * - slow viewer: `--rate` samples/s to 4 viewers, one of which never
+ *   reads; what the others received and what happened to the stalled one
+ *
+ * Usage: dashboard_bench [--seconds s] [--rate samples_per_s]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "WebDashboard.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t nowMs() { return (uint32_t)(nowNs() / 1000000); }
+
+uint64_t threadCpuNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/** @brief Sample values cycle through 1..SAMPLE_CYCLE tenths of a cm */
+const uint16_t SAMPLE_CYCLE = 6000;
+
+uint16_t sampleValue(uint64_t index) { return (uint16_t)(index % SAMPLE_CYCLE + 1); }
+
+// Key and answer from the example in RFC 6455, section 1.3.
+const char TEST_KEY[] = "dGhlIHNhbXBsZSBub25jZQ==";
+const char TEST_ACCEPT[] = "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=";
+
+/** @param receiveBuffer SO_RCVBUF, 0 for the default */
+int connectTo(uint16_t port, int receiveBuffer = 0) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (receiveBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  }
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+    perror("dashboard_bench: connect");
+    exit(1);
+  }
+  return fd;
+}
+
+/** @brief Sends a request and reads until the end of the response head */
+std::string exchange(int fd, const std::string& request, std::string& rest) {
+  send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+  std::string response;
+  size_t end;
+  while ((end = response.find("\r\n\r\n")) == std::string::npos) {
+    char buffer[4096];
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0) return response;
+    response.append(buffer, (size_t)n);
+  }
+  rest = response.substr(end + 4);
+  return response.substr(0, end + 4);
+}
+
+/** @brief One browser tab: a WebSocket and what arrived on it */
+struct Viewer {
+  int fd = -1;
+  bool reads = true;  ///< false: never reads (a stalled tab)
+  bool closed = false;
+  std::string buffer;
+  uint64_t samples = 0;
+  uint64_t frames = 0;
+  uint64_t gaps = 0;
+  uint16_t last = 0;
+};
+
+/** @brief Parses whole frames out of viewer.buffer */
+void parseFrames(Viewer& viewer) {
+  size_t used = 0;
+  for (;;) {
+    const uint8_t* in = (const uint8_t*)viewer.buffer.data() + used;
+    size_t available = viewer.buffer.size() - used;
+    if (available < 2) break;
+    size_t header = 2;
+    size_t length = in[1] & 0x7f;
+    if (length == 126) {
+      if (available < 4) break;
+      header = 4;
+      length = (size_t)in[2] << 8 | in[3];
+    }
+    if (available < header + length) break;
+    const uint8_t* payload = in + header;
+    for (size_t offset = 4; offset + 5 <= length; offset += 5) {
+      if (payload[offset] != 0) continue;
+      uint16_t value = (uint16_t)(payload[offset + 3] | payload[offset + 4] << 8);
+      if (viewer.last != 0 && value != viewer.last % SAMPLE_CYCLE + 1) viewer.gaps++;
+      viewer.last = value;
+      viewer.samples++;
+    }
+    viewer.frames++;
+    used += header + length;
+  }
+  viewer.buffer.erase(0, used);
+}
+
+/**
+ * @brief The browsers: connects, then reads every viewer until stopped
+ */
+class Browsers {
+ public:
+  Browsers(uint16_t port, size_t count, bool stalledLast)
+      : port_(port), viewers_(count) {
+    if (stalledLast) viewers_.back().reads = false;
+    thread_ = std::thread([this] { run(); });
+  }
+
+  ~Browsers() {
+    stop();
+    for (Viewer& viewer : viewers_) {
+      if (viewer.fd >= 0) close(viewer.fd);
+    }
+  }
+
+  bool ready() const { return ready_; }
+  bool pageOk() const { return pageOk_; }
+  bool handshakeOk() const { return handshakeOk_; }
+
+  /** @brief Results; call after stop() */
+  const std::vector<Viewer>& viewers() const { return viewers_; }
+
+  void stop() {
+    stop_ = true;
+    if (thread_.joinable()) thread_.join();
+  }
+
+ private:
+  void run() {
+    std::string rest;
+    int page = connectTo(port_);
+    std::string head = exchange(page, "GET / HTTP/1.1\r\nHost: bench\r\n\r\n", rest);
+    while (rest.find("</html>") == std::string::npos) {
+      char buffer[4096];
+      ssize_t n = recv(page, buffer, sizeof(buffer), 0);
+      if (n <= 0) break;
+      rest.append(buffer, (size_t)n);
+    }
+    pageOk_ = head.compare(0, 12, "HTTP/1.1 200") == 0 &&
+              rest.find("<canvas") != std::string::npos;
+    close(page);
+
+    bool handshakes = true;
+    for (Viewer& viewer : viewers_) {
+      // A stalled tab on WiFi: its small window fills up quickly.
+      viewer.fd = connectTo(port_, viewer.reads ? 0 : 4096);
+      std::string response = exchange(viewer.fd,
+                                       std::string("GET /ws HTTP/1.1\r\nHost: bench\r\n"
+                                                   "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                                                   "sec-websocket-key: ") +
+                                           TEST_KEY + "\r\nSec-WebSocket-Version: 13\r\n\r\n",
+                                       viewer.buffer);
+      handshakes = handshakes && response.compare(0, 12, "HTTP/1.1 101") == 0 &&
+                   response.find(TEST_ACCEPT) != std::string::npos;
+    }
+    handshakeOk_ = handshakes;
+    ready_ = true;
+
+    std::vector<pollfd> fds;
+    std::vector<Viewer*> reading;
+    for (Viewer& viewer : viewers_) {
+      if (!viewer.reads) continue;
+      fds.push_back({viewer.fd, POLLIN, 0});
+      reading.push_back(&viewer);
+    }
+    while (!stop_) {
+      if (fds.empty() || poll(fds.data(), fds.size(), 10) <= 0) {
+        if (fds.empty()) usleep(1000);
+        continue;
+      }
+      for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i].revents == 0) continue;
+        Viewer& viewer = *reading[i];
+        char buffer[65536];
+        ssize_t n = recv(viewer.fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+          viewer.closed = true;
+          fds[i].events = 0;
+          continue;
+        }
+        viewer.buffer.append(buffer, (size_t)n);
+        parseFrames(viewer);
+      }
+    }
+    // A stalled tab finally reads what reached it, to see where it stopped.
+    for (Viewer& viewer : viewers_) {
+      if (viewer.reads) continue;
+      for (;;) {
+        char buffer[65536];
+        ssize_t n = recv(viewer.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n <= 0) {
+          viewer.closed = n == 0;
+          break;
+        }
+        viewer.buffer.append(buffer, (size_t)n);
+        parseFrames(viewer);
+      }
+    }
+  }
+
+  uint16_t port_;
+  std::vector<Viewer> viewers_;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> ready_{false};
+  std::atomic<bool> pageOk_{false};
+  std::atomic<bool> handshakeOk_{false};
+};
+
+/** @brief Polls until the browsers are connected and streaming */
+void connect(WebDashboard& dashboard, Browsers& browsers, size_t viewers) {
+  uint32_t start = nowMs();
+  while (!browsers.ready() || dashboard.viewers() < viewers) {
+    dashboard.poll(nowMs());
+    if (nowMs() - start > 5000) {
+      fprintf(stderr, "dashboard_bench: viewers did not connect\n");
+      exit(1);
+    }
+  }
+  if (!browsers.pageOk() || !browsers.handshakeOk()) {
+    fprintf(stderr, "dashboard_bench: page %s, handshake %s\n",
+            browsers.pageOk() ? "ok" : "FAILED", browsers.handshakeOk() ? "ok" : "FAILED");
+    exit(1);
+  }
+}
+
+/** @brief Polls until every frame is written, then gives the browsers time to read */
+void drain(WebDashboard& dashboard) {
+  dashboard.poll(nowMs() + DASHBOARD_FLUSH_MS);
+  uint32_t start = nowMs();
+  while (dashboard.lag() > 0 && nowMs() - start < 2000) dashboard.poll(nowMs());
+  start = nowMs();
+  while (nowMs() - start < 100) dashboard.poll(nowMs());
+}
+
+void runEncoding() {
+  WebDashboard dashboard(0);
+  const uint64_t samples = 10000000;
+  uint64_t start = nowNs();
+  for (uint64_t i = 0; i < samples; i++) {
+    dashboard.sample((uint32_t)(i / 64), sampleValue(i) / 10.0f);
+  }
+  double ns = (double)(nowNs() - start) / samples;
+  printf("encoding: %.1f ns per sample, %lu frames of up to %u samples (%u bytes)\n", ns,
+         (unsigned long)dashboard.frames(), (unsigned)DASHBOARD_FRAME_RECORDS,
+         (unsigned)DASHBOARD_FRAME_BYTES);
+}
+
+void runSustained(unsigned seconds) {
+  printf("sustained: samples recorded as fast as the slowest viewer keeps up, %u s\n", seconds);
+  printf("  %7s %14s %10s %9s %8s %6s %8s\n", "viewers", "samples/s each", "frames/s",
+         "MB/s out", "cpu ns", "gaps", "skipped");
+  for (size_t count = 1; count <= DASHBOARD_MAX_CLIENTS; count *= 2) {
+    WebDashboard dashboard(0);
+    if (!dashboard.begin()) {
+      perror("dashboard_bench: listen");
+      exit(1);
+    }
+    Browsers browsers(dashboard.port(), count, false);
+    connect(dashboard, browsers, count);
+    uint64_t produced = 0;
+    uint64_t startNs = nowNs();
+    uint64_t startCpu = threadCpuNs();
+    uint64_t endNs = startNs + (uint64_t)seconds * 1000000000ull;
+    while (nowNs() < endNs) {
+      uint32_t now = nowMs();
+      // Keep two frames of the ring free so nobody has to skip.
+      if (dashboard.lag() + 2 < DASHBOARD_FRAMES) {
+        for (int i = 0; i < DASHBOARD_FRAME_RECORDS; i++) {
+          dashboard.sample(now, sampleValue(produced++) / 10.0f);
+        }
+      }
+      dashboard.poll(now);
+    }
+    drain(dashboard);
+    double cpuNs = (double)(threadCpuNs() - startCpu);
+    double elapsed = (nowNs() - startNs) / 1e9;
+    browsers.stop();
+    uint64_t least = UINT64_MAX;
+    uint64_t gaps = 0;
+    for (const Viewer& viewer : browsers.viewers()) {
+      if (viewer.samples < least) least = viewer.samples;
+      gaps += viewer.gaps;
+    }
+    printf("  %7zu %14.0f %10.0f %9.1f %8.1f %6llu %8lu%s\n", count, least / elapsed,
+           dashboard.frames() / elapsed, dashboard.bytesSent() / elapsed / 1e6,
+           cpuNs / produced, (unsigned long long)gaps, (unsigned long)dashboard.skipped(),
+           least == produced ? "" : "  (samples missing)");
+  }
+}
+
+void runSlowViewer(unsigned seconds, unsigned rate) {
+  const size_t count = 4;
+  WebDashboard dashboard(0);
+  if (!dashboard.begin()) {
+    perror("dashboard_bench: listen");
+    exit(1);
+  }
+  Browsers browsers(dashboard.port(), count, true);
+  connect(dashboard, browsers, count);
+  uint64_t produced = 0;
+  uint64_t startNs = nowNs();
+  uint64_t endNs = startNs + (uint64_t)seconds * 1000000000ull;
+  while (nowNs() < endNs) {
+    uint64_t due = (nowNs() - startNs) * rate / 1000000000ull;
+    // After a late wake-up, catch up a frame at a time, writing in between.
+    do {
+      for (int i = 0; i < DASHBOARD_FRAME_RECORDS && produced < due; i++) {
+        dashboard.sample(nowMs(), sampleValue(produced++) / 10.0f);
+      }
+      dashboard.poll(nowMs());
+    } while (produced < due);
+  }
+  drain(dashboard);
+  browsers.stop();
+  printf("slow viewer: %u samples/s for %u s to %zu viewers, the last never reads\n", rate,
+         seconds, count);
+  for (size_t i = 0; i < count; i++) {
+    const Viewer& viewer = browsers.viewers()[i];
+    printf("  viewer %zu: %llu of %llu samples, %llu gaps%s\n", i + 1,
+           (unsigned long long)viewer.samples, (unsigned long long)produced,
+           (unsigned long long)viewer.gaps,
+           viewer.reads ? "" : viewer.closed ? " (stalled, closed by the server)" : " (stalled)");
+  }
+  printf("  server: %lu frames skipped, %lu connections dropped, %u viewers left\n",
+         (unsigned long)dashboard.skipped(), (unsigned long)dashboard.dropped(),
+         (unsigned)dashboard.viewers());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  unsigned seconds = 2;
+  unsigned rate = 500000;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "usage: %s [--seconds s] [--rate samples_per_s]\n", argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (strcmp(arg, "--seconds") == 0) seconds = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--rate") == 0) rate = (unsigned)strtoul(value, nullptr, 10);
+    else {
+      fprintf(stderr, "dashboard_bench: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  char accept[32];
+  webSocketAccept(TEST_KEY, accept);
+  printf("handshake: Sec-WebSocket-Accept %s (%s)\n", accept,
+         strcmp(accept, TEST_ACCEPT) == 0 ? "matches RFC 6455" : "WRONG");
+  runEncoding();
+  runSustained(seconds);
+  runSlowViewer(seconds, rate);
+  return 0;
+}
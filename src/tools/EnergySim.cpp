@@ -0,0 +1,175 @@
+/**
+ * @file EnergySim.cpp
+ * @brief Battery life against detection latency for each scheduling policy
+ *
+ * @details Runs the real detector on simulated visits (makeRandomScene())
+ * once per scheduling policy and feeds where the time went (awake, light
+ * sleep, sensor ranging, buzzer) to the EnergyModel. With P the configured
+ * cycle period (`--period`, 500 ms by default) the policies are:
+ * - awake: delay() for P, the original firmware
+ * - sleep: light sleep for P; same cadence, same latency
+ * - sleep P/2, sleep 2P: faster or slower sampling
+ * - sleep P idle 2P, sleep P idle 4P: longer waits while quiet, P again as
+ *   soon as a reading comes near the trip distance or the alarm is on
+ * - awake 80 MHz, sleep 80 MHz: CPU clock lowered to 80 MHz while quiet
+ *   (`--idle-mhz` picks another idle clock)
+ *
+ * For each it prints missed visits, mean and p90 detection latency, the
+ * share of time awake, the mean CPU clock while awake (mhz), the mean current,
+ * mAh per day and days on `--battery` mAh.
+ *
+ * Usage: energy_sim [detector options] [--hours h] [--battery mAh]
+ *                   [--cpu-ma mA] [--sleep-ma mA] [--board-ma mA] [--seed n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "DetectionScorer.h"
+#include "EnergyModel.h"
+#include "IntruderDetector.h"
+#include "SensorSimulator.h"
+#include "SimHal.h"
+#include "ToolOptions.h"
+
+namespace {
+
+/**
+ * @brief Collects alarm intervals on the virtual clock
+ */
+class AlarmRecorder : public DetectorListener {
+ public:
+  AlarmRecorder(SimHal& hal, std::vector<AlarmInterval>& alarms) : hal_(hal), alarms_(alarms) {}
+
+  void onIntruder(float) override {
+    AlarmInterval alarm = {hal_.now(), UINT64_MAX};
+    alarms_.push_back(alarm);
+  }
+
+  void onClear(float) override {
+    if (!alarms_.empty()) alarms_.back().clearedUs = hal_.now();
+  }
+
+ private:
+  SimHal& hal_;
+  std::vector<AlarmInterval>& alarms_;
+};
+
+struct Policy {
+  const char* name;
+  bool lightSleep;
+  uint32_t periodMs;
+  uint32_t idlePeriodMs;
+  uint32_t idleCpuMhz;
+};
+
+void run(const Policy& policy, const SimScene& scene, DetectorConfig config,
+         const EnergyConfig& energy, uint64_t endUs, double batteryMah, uint64_t seed) {
+  config.cyclePeriodMs = policy.periodMs;
+  config.power.lightSleep = policy.lightSleep;
+  config.power.idlePeriodMs = policy.idlePeriodMs;
+  config.power.idleCpuMhz = policy.idleCpuMhz;
+
+  SensorSimulator sensor(scene, seed);
+  SimHal hal(sensor, config.echoPin, config.buzzerPin);
+  IntruderDetector detector(hal, config);
+  std::vector<AlarmInterval> alarms;
+  AlarmRecorder recorder(hal, alarms);
+  detector.setListener(&recorder);
+  detector.begin();
+  while (hal.now() < endUs) detector.loop();
+
+  std::vector<LabelInterval> labels;
+  for (const SimIntrusion& intrusion : scene.intrusions) {
+    LabelInterval label = {intrusion.startUs, intrusion.endUs, LabelKind::Intruder};
+    labels.push_back(label);
+  }
+  TraceScore score = scoreDetections(alarms, labels, hal.now() / 3.6e9);
+
+  EnergyUsage usage;
+  usage.totalUs = hal.now();
+  usage.sleptUs = hal.sleptUs();
+  usage.sleeps = detector.power().sleeps();
+  usage.awakeMhzUs = hal.awakeMhzUs();
+  usage.echoWaitUs = hal.echoWaitUs();
+  for (const AlarmInterval& alarm : alarms) {
+    uint64_t clearedUs = alarm.clearedUs < hal.now() ? alarm.clearedUs : hal.now();
+    usage.buzzerUs += clearedUs - alarm.raisedUs;
+  }
+  double currentMa = averageCurrentMa(energy, usage);
+  uint64_t awakeUs = usage.totalUs - usage.sleptUs;
+  uint32_t idleMhz = policy.idleCpuMhz != 0 ? policy.idleCpuMhz : config.power.fullCpuMhz;
+  printf("%-7s %7lu %7lu %8lu %6zu %9.1f %9.1f %8.2f %7.0f %8.2f %9.1f %7.1f\n", policy.name,
+         (unsigned long)policy.periodMs, (unsigned long)policy.idlePeriodMs,
+         (unsigned long)idleMhz, score.missed(),
+         score.meanLatencyMs(), score.latencyPercentileMs(90), 100.0 * awakeUs / usage.totalUs,
+         (double)usage.awakeMhzUs / awakeUs, currentMa, currentMa * 24,
+         batteryMah / (currentMa * 24));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  DetectorConfig config;
+  EnergyConfig energy;
+  double hours = 12;
+  double batteryMah = 2000;
+  uint64_t seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr,
+              "usage: %s [options] [--hours h] [--battery mAh] [--cpu-ma mA] [--sleep-ma mA]"
+              " [--board-ma mA] [--seed n]\n" DETECTOR_OPTIONS_USAGE,
+              argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    int handled = parseDetectorOption(arg, value, config);
+    if (handled < 0) {
+      fprintf(stderr, "energy_sim: invalid value %s for %s\n", value, arg);
+      return 2;
+    }
+    if (handled > 0) continue;
+    if (strcmp(arg, "--hours") == 0) hours = atof(value);
+    else if (strcmp(arg, "--battery") == 0) batteryMah = atof(value);
+    else if (strcmp(arg, "--cpu-ma") == 0) energy.cpuActiveMa = (float)atof(value);
+    else if (strcmp(arg, "--sleep-ma") == 0) energy.lightSleepMa = (float)atof(value);
+    else if (strcmp(arg, "--board-ma") == 0) energy.boardMa = (float)atof(value);
+    else if (strcmp(arg, "--seed") == 0) seed = strtoull(value, nullptr, 10);
+    else {
+      fprintf(stderr, "energy_sim: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  uint64_t endUs = (uint64_t)(hours * 3.6e9);
+  SimScene scene = makeRandomScene(endUs, (int)(hours * 120), seed);
+  uint32_t p = config.cyclePeriodMs;
+  uint32_t idleMhz = config.power.idleCpuMhz != 0 ? config.power.idleCpuMhz : 80;
+  const Policy policies[] = {
+      {"awake", false, p, 0, 0},
+      {"awake", false, p, 0, idleMhz},
+      {"sleep", true, p, 0, 0},
+      {"sleep", true, p, 0, idleMhz},
+      {"sleep", true, p / 2, 0, 0},
+      {"sleep", true, p * 2, 0, 0},
+      {"sleep", true, p, p * 2, 0},
+      {"sleep", true, p, p * 4, 0},
+  };
+
+  char line[256];
+  formatEnergyConfig(energy, line, sizeof(line));
+  printf("%zu visits in %.1f h, battery %.0f mAh\n%s\n", scene.intrusions.size(), hours,
+         batteryMah, line);
+  printf("%-7s %7s %7s %8s %6s %9s %9s %8s %7s %8s %9s %7s\n", "policy", "period", "idle",
+         "idle_mhz", "missed", "lat_mean", "lat_p90", "awake_%", "mhz", "mA", "mAh/day", "days");
+  for (const Policy& policy : policies) {
+    run(policy, scene, config, energy, endUs, batteryMah, seed);
+  }
+  return 0;
+}
@@ -0,0 +1,529 @@
+/**
+ * @file MicroBench.cpp
+ * @brief Micro-benchmarks for the detection hot path
+ *
+ * @details Times the pieces of getDistanceCm()/loop() and the code around
+ * them on the PC, so a change to any of them shows up as a number before it
+ * reaches a device:
+ *
+ * - filter/...    IntruderDetector::filterReading() per filter type and size
+ * - echo_to_cm    echo width -> distance conversion
+ * - update/...    hysteresis state machine, steady and alternating
+ * - loop/replay   a whole detector cycle against a ReplayHal
+ * - telemetry/... TelemetryStream::record() and hex encoding of a block
+ * - ring/...      RingBuffer push/pop
+ * - config/decode the boot-time check and unpacking of a stored config record
+ * - bus/...       EventBus dispatch per event: one subscriber, eight, a
+ *                 subscriber that publishes a follow-up event, and a whole
+ *                 detector cycle published through DetectorEventSource
+ * - coop/...      CoopScheduler: one task step (yield and resume), a run()
+ *                 with eight sleeping tasks, and a detector cycle run as
+ *                 DetectorTask instead of loop()
+ *
+ * Each benchmark is run in batches until a batch takes long enough to time,
+ * then repeated; the median batch gives ns/op. Heap allocations made while
+ * the benchmark runs are counted by replacing operator new in this program
+ * (the hot path should never allocate).
+ *
+ * Absolute numbers are for the host CPU only; compare runs on one machine.
+ *
+ * Usage: micro_bench [--filter substring] [--min-ms ms] [--reps n] [--json path]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "ConfigStore.h"
+#include "CoopScheduler.h"
+#include "DetectorEvents.h"
+#include "DetectorTask.h"
+#include "EventBus.h"
+#include "IntruderDetector.h"
+#include "ReplayHal.h"
+#include "RingBuffer.h"
+#include "SensorSimulator.h"
+#include "Telemetry.h"
+#include "TraceFile.h"
+
+// ============================================================================
+// ALLOCATION COUNTING
+// ============================================================================
+
+namespace {
+std::atomic<uint64_t> allocCount(0);
+std::atomic<uint64_t> allocBytes(0);
+}  // namespace
+
+void* operator new(size_t size) {
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  allocBytes.fetch_add(size, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+// Kept out of line: once inlined, GCC pairs the free() with the standard
+// operator new and warns about a mismatch.
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+// ============================================================================
+// HARNESS
+// ============================================================================
+
+/** @brief Keeps the compiler from discarding a computed value */
+template <typename T>
+inline void keep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief A benchmark body
+ * @details Called with a batch size; must perform that many operations.
+ */
+typedef std::function<void(size_t)> BenchBody;
+
+struct Benchmark {
+  std::string name;
+  BenchBody body;
+};
+
+struct Result {
+  std::string name;
+  uint64_t ops;          ///< Operations timed over all repetitions
+  double nsPerOp;        ///< Median over repetitions
+  double nsMin;          ///< Fastest repetition
+  double allocsPerOp;
+  double bytesPerOp;
+};
+
+double timeBatch(const BenchBody& body, size_t batch) {
+  auto start = std::chrono::steady_clock::now();
+  body(batch);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+Result run(const Benchmark& bench, double minMs, int reps) {
+  // Warm up, then grow the batch until one batch takes minMs / reps.
+  double targetNs = minMs * 1e6 / reps;
+  size_t batch = 1;
+  double ns = timeBatch(bench.body, batch);
+  while (ns < targetNs && batch < ((size_t)1 << 40)) {
+    double grow = ns > 0 ? targetNs / ns * 1.2 : 10;
+    batch = (size_t)(batch * std::min(std::max(grow, 2.0), 100.0));
+    ns = timeBatch(bench.body, batch);
+  }
+
+  std::vector<double> perOp;
+  uint64_t allocs = allocCount.load();
+  uint64_t bytes = allocBytes.load();
+  for (int r = 0; r < reps; r++) perOp.push_back(timeBatch(bench.body, batch) / batch);
+  allocs = allocCount.load() - allocs;
+  bytes = allocBytes.load() - bytes;
+
+  std::sort(perOp.begin(), perOp.end());
+  Result result;
+  result.name = bench.name;
+  result.ops = (uint64_t)batch * reps;
+  result.nsPerOp = perOp[perOp.size() / 2];
+  result.nsMin = perOp[0];
+  result.allocsPerOp = (double)allocs / result.ops;
+  result.bytesPerOp = (double)bytes / result.ops;
+  return result;
+}
+
+void writeJson(FILE* out, const std::vector<Result>& results) {
+  fprintf(out, "{\"context\": {\"compiler\": \"%s\", \"optimized\": %s},\n \"benchmarks\": [",
+          __VERSION__,
+#ifdef __OPTIMIZE__
+          "true"
+#else
+          "false"
+#endif
+  );
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& r = results[i];
+    fprintf(out,
+            "%s\n  {\"name\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.3f, \"ns_min\": %.3f, "
+            "\"ops_per_sec\": %.0f, \"allocs_per_op\": %.4f, \"bytes_per_op\": %.2f}",
+            i ? "," : "", r.name.c_str(), (unsigned long long)r.ops, r.nsPerOp, r.nsMin,
+            r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0, r.allocsPerOp, r.bytesPerOp);
+  }
+  fprintf(out, "\n ]}\n");
+}
+
+// ============================================================================
+// INPUTS
+// ============================================================================
+
+/** @brief Hal with no hardware behind it, for code that only writes pins */
+class NullHal : public Hal {
+ public:
+  void pinMode(uint8_t, uint8_t) override {}
+  void digitalWrite(uint8_t, uint8_t) override {}
+  unsigned long pulseIn(uint8_t, uint8_t, unsigned long) override { return 0; }
+  void delayMicroseconds(uint32_t) override {}
+  void delay(uint32_t) override {}
+  unsigned long millis() override { return 0; }
+  unsigned long micros() override { return 0; }
+  uint64_t micros64() override { return 0; }
+};
+
+/** @brief Simulated pings laid out as getDistanceCm() would take them */
+std::vector<TraceRecord> simulatePings(size_t count) {
+  TraceSensorConfig sensor = traceDefaultSensorConfig();
+  SimScene scene = makeRandomScene(count * 100000ull, (int)(count / 2000) + 1, 3);
+  scene.timeoutProbability = 0.01f;
+  scene.glitchProbability = 0.002f;
+  SensorSimulator sim(scene, 11);
+
+  std::vector<TraceRecord> records;
+  uint64_t t = 0;
+  while (records.size() < count) {
+    for (int i = 0; i < sensor.samplesPerReading && records.size() < count; i++) {
+      TraceRecord record;
+      record.timeUs = t;
+      record.echoUs = (uint32_t)sim.echoAt(t);
+      record.flags = record.echoUs ? 0 : TRACE_FLAG_TIMEOUT;
+      record.reserved = 0;
+      records.push_back(record);
+      t += 12 + (record.echoUs ? record.echoUs : sensor.echoTimeoutUs) +
+           sensor.pingSpacingMs * 1000ull;
+    }
+    t += sensor.cyclePeriodMs * 1000ull;
+  }
+  return records;
+}
+
+/** @brief Trivial bus subscriber: counts events into *context */
+void countEvents(const Event&, void* context) { (*(uint32_t*)context)++; }
+
+/** @brief Counts its steps and yields; the smallest possible task */
+class YieldTask : public CoopTask {
+ public:
+  uint32_t count = 0;
+
+  void step() override {
+    COOP_BEGIN();
+    for (;;) {
+      count++;
+      COOP_YIELD();
+    }
+    COOP_END();
+  }
+};
+
+/** @brief Sleeps for a day at a time */
+class SleepTask : public CoopTask {
+ public:
+  void step() override {
+    COOP_BEGIN();
+    for (;;) COOP_SLEEP_FOR(86400000000ull);
+    COOP_END();
+  }
+};
+
+/** @brief Input sets of DETECTOR_MAX_SAMPLES echo widths each */
+const size_t INPUT_SETS = 1024;
+
+// ============================================================================
+// BENCHMARKS
+// ============================================================================
+
+std::vector<Benchmark> makeBenchmarks(const std::vector<TraceRecord>& pings) {
+  std::vector<Benchmark> benches;
+
+  // Echo sets for the filters, with the simulator's timeouts and glitches.
+  std::vector<unsigned long> echoes(INPUT_SETS * DETECTOR_MAX_SAMPLES);
+  for (size_t i = 0; i < echoes.size(); i++) echoes[i] = pings[i % pings.size()].echoUs;
+
+  struct FilterCase {
+    FilterType filter;
+    uint8_t samples;
+  };
+  const FilterCase filterCases[] = {
+      {FilterType::Mean, 5},   {FilterType::ValidMean, 5}, {FilterType::Median, 5},
+      {FilterType::Mean, 16},  {FilterType::Median, 16},
+  };
+  for (const FilterCase& fc : filterCases) {
+    std::string name = std::string("filter/") + filterTypeName(fc.filter) + "/" +
+                       std::to_string(fc.samples);
+    benches.push_back({name, [echoes, fc](size_t n) {
+                         static NullHal hal;
+                         DetectorConfig config;
+                         config.filter = fc.filter;
+                         IntruderDetector detector(hal, config);
+                         for (size_t i = 0; i < n; i++) {
+                           const unsigned long* set =
+                               &echoes[(i % INPUT_SETS) * DETECTOR_MAX_SAMPLES];
+                           keep(detector.filterReading(set, fc.samples));
+                         }
+                       }});
+  }
+
+  benches.push_back({"echo_to_cm", [echoes](size_t n) {
+                       for (size_t i = 0; i < n; i++) {
+                         keep(echoToDistanceCm(echoes[i % echoes.size()]));
+                       }
+                     }});
+
+  // Far readings only: the state machine never changes state.
+  benches.push_back({"update/steady", [](size_t n) {
+                       static NullHal hal;
+                       IntruderDetector detector(hal);
+                       for (size_t i = 0; i < n; i++) {
+                         keep(detector.update(30.0f + (float)(i & 7)));
+                       }
+                     }});
+  // Near/far alternating: every reading is a transition (pin write + listener).
+  benches.push_back({"update/toggle", [](size_t n) {
+                       static NullHal hal;
+                       IntruderDetector detector(hal);
+                       for (size_t i = 0; i < n; i++) {
+                         keep(detector.update((i & 1) ? 30.0f : 3.0f));
+                       }
+                     }});
+
+  benches.push_back({"loop/replay", [&pings](size_t n) {
+                       DetectorConfig config;
+                       size_t done = 0;
+                       while (done < n) {
+                         ReplayHal hal(pings.data(), pings.size(), config.echoPin,
+                                       config.buzzerPin);
+                         IntruderDetector detector(hal, config);
+                         detector.begin();
+                         while (done < n &&
+                                hal.consumed() + config.samplesPerReading <= pings.size()) {
+                           detector.loop();
+                           done++;
+                         }
+                       }
+                       keep(done);
+                     }});
+
+  benches.push_back({"telemetry/record", [&pings](size_t n) {
+                       static TelemetryStream stream;
+                       for (size_t i = 0; i < n; i++) {
+                         const TraceRecord& r = pings[i % pings.size()];
+                         stream.record((uint32_t)r.timeUs, r.echoUs);
+                         size_t length;
+                         uint32_t sequence;
+                         if (stream.pending(length, sequence) != nullptr) {
+                           stream.releasePending();
+                         }
+                       }
+                     }});
+
+  benches.push_back({"telemetry/hex_block", [](size_t n) {
+                       uint8_t block[TELEMETRY_BLOCK_BYTES];
+                       char hex[2 * TELEMETRY_BLOCK_BYTES];
+                       for (size_t i = 0; i < sizeof(block); i++) block[i] = (uint8_t)(i * 37);
+                       for (size_t i = 0; i < n; i++) {
+                         block[0] = (uint8_t)i;
+                         telemetryToHex(block, sizeof(block), hex);
+                         keep(hex[0]);
+                       }
+                     }});
+
+  benches.push_back({"ring/push_pop", [](size_t n) {
+                       static RingBuffer<uint32_t, 256> ring;
+                       uint32_t value = 0;
+                       for (size_t i = 0; i < n; i++) {
+                         ring.push((uint32_t)i);
+                         ring.pop(value);
+                       }
+                       keep(value);
+                     }});
+  // 64 pushes then 64 pops; one op is one push + one pop.
+  benches.push_back({"ring/burst64", [](size_t n) {
+                       static RingBuffer<uint32_t, 256> ring;
+                       uint32_t value = 0;
+                       for (size_t i = 0; i < n; i += 64) {
+                         for (uint32_t k = 0; k < 64; k++) ring.push(k);
+                         for (uint32_t k = 0; k < 64; k++) ring.pop(value);
+                       }
+                       keep(value);
+                     }});
+
+  benches.push_back({"config/decode", [](size_t n) {
+                       uint8_t record[CONFIG_RECORD_BYTES];
+                       encodeConfigRecord(DetectorConfig(), record, sizeof(record));
+                       DetectorConfig config;
+                       for (size_t i = 0; i < n; i++) {
+                         decodeConfigRecord(record, sizeof(record), config);
+                         keep(config.samplesPerReading);
+                       }
+                     }});
+
+  // One op is one published event.
+  benches.push_back({"bus/publish_1", [](size_t n) {
+                       EventBus bus;
+                       uint32_t sum = 0;
+                       bus.subscribe(eventBit(EventType::SampleReady), countEvents, &sum);
+                       for (size_t i = 0; i < n; i++) bus.publishSample(i, (uint32_t)i, 1200);
+                       keep(sum);
+                     }});
+  benches.push_back({"bus/fanout_8", [](size_t n) {
+                       EventBus bus;
+                       uint32_t sum = 0;
+                       for (int k = 0; k < 8; k++) {
+                         bus.subscribe(eventBit(EventType::SampleReady), countEvents, &sum);
+                       }
+                       for (size_t i = 0; i < n; i++) bus.publishSample(i, (uint32_t)i, 1200);
+                       keep(sum);
+                     }});
+  // Each sample raises a fault event from inside its handler (queued, not nested).
+  benches.push_back({"bus/reentrant", [](size_t n) {
+                       static EventBus bus;
+                       static uint32_t faults = 0;
+                       static bool subscribed = false;
+                       if (!subscribed) {
+                         bus.subscribe(eventBit(EventType::SampleReady),
+                                       [](const Event& event, void*) {
+                                         bus.publishFault(event.timeUs, 1, 0);
+                                       });
+                         bus.subscribe(eventBit(EventType::SensorFault),
+                                       [](const Event& event, void*) {
+                                         faults += event.fault.faults;
+                                       });
+                         subscribed = true;
+                       }
+                       for (size_t i = 0; i < n; i++) bus.publishSample(i, (uint32_t)i, 1200);
+                       keep(faults);
+                     }});
+  // As loop/replay, with every ping and reading published to 8 subscribers.
+  benches.push_back({"bus/loop_replay_8", [&pings](size_t n) {
+                       DetectorConfig config;
+                       EventBus bus;
+                       uint32_t sum = 0;
+                       for (int k = 0; k < 8; k++) bus.subscribe(EVENT_MASK_ALL, countEvents, &sum);
+                       size_t done = 0;
+                       while (done < n) {
+                         ReplayHal hal(pings.data(), pings.size(), config.echoPin,
+                                       config.buzzerPin);
+                         DetectorEventSource source(bus, hal);
+                         IntruderDetector detector(hal, config);
+                         detector.setListener(&source);
+                         detector.begin();
+                         while (done < n &&
+                                hal.consumed() + config.samplesPerReading <= pings.size()) {
+                           detector.loop();
+                           done++;
+                         }
+                       }
+                       keep(sum);
+                     }});
+
+  // One op is one task step: four yielding tasks, all due every run().
+  benches.push_back({"coop/yield_4", [](size_t n) {
+                       static NullHal hal;
+                       CoopScheduler scheduler(hal);
+                       YieldTask tasks[4];
+                       for (YieldTask& task : tasks) scheduler.add(task);
+                       for (size_t i = 0; i < n; i += 4) scheduler.run();
+                       keep(tasks[0].count);
+                     }});
+  // One op is one run() that finds nothing due.
+  benches.push_back({"coop/idle_8", [](size_t n) {
+                       static NullHal hal;
+                       CoopScheduler scheduler(hal);
+                       SleepTask tasks[8];
+                       for (SleepTask& task : tasks) scheduler.add(task);
+                       scheduler.run();
+                       uint64_t next = 0;
+                       for (size_t i = 0; i < n; i++) next = scheduler.run();
+                       keep(next);
+                     }});
+  // As loop/replay, one op per reading, with the waits done by the scheduler.
+  benches.push_back({"coop/detector_replay", [&pings](size_t n) {
+                       DetectorConfig config;
+                       size_t done = 0;
+                       while (done < n) {
+                         ReplayHal hal(pings.data(), pings.size(), config.echoPin,
+                                       config.buzzerPin);
+                         IntruderDetector detector(hal, config);
+                         DetectorTask task(detector);
+                         CoopScheduler scheduler(hal);
+                         scheduler.add(task);
+                         detector.begin();
+                         while (done < n &&
+                                hal.consumed() + config.samplesPerReading <= pings.size()) {
+                           uint32_t readings = task.readings();
+                           while (task.readings() == readings) {
+                             uint64_t next = scheduler.run();
+                             if (next > hal.micros64()) {
+                               hal.delayMicroseconds((uint32_t)(next - hal.micros64()));
+                             }
+                           }
+                           done++;
+                         }
+                       }
+                       keep(done);
+                     }});
+  return benches;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* filter = nullptr;
+  const char* jsonPath = nullptr;
+  double minMs = 200;
+  int reps = 5;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) {
+      fprintf(stderr, "usage: %s [--filter substring] [--min-ms ms] [--reps n] [--json path]\n",
+              argv[0]);
+      return 2;
+    }
+    const char* arg = argv[i];
+    const char* value = argv[++i];
+    if (strcmp(arg, "--filter") == 0) filter = value;
+    else if (strcmp(arg, "--json") == 0) jsonPath = value;
+    else if (strcmp(arg, "--min-ms") == 0) minMs = atof(value);
+    else if (strcmp(arg, "--reps") == 0) reps = atoi(value);
+    else {
+      fprintf(stderr, "micro_bench: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  if (reps < 1) reps = 1;
+
+  std::vector<TraceRecord> pings = simulatePings(200000);
+  std::vector<Benchmark> benches = makeBenchmarks(pings);
+
+  std::vector<Result> results;
+  printf("%-22s %12s %10s %10s %14s %10s %10s\n", "benchmark", "ops", "ns/op", "ns min",
+         "ops/s", "allocs/op", "B/op");
+  for (const Benchmark& bench : benches) {
+    if (filter != nullptr && bench.name.find(filter) == std::string::npos) continue;
+    Result r = run(bench, minMs, reps);
+    printf("%-22s %12llu %10.2f %10.2f %14.0f %10.4f %10.2f\n", r.name.c_str(),
+           (unsigned long long)r.ops, r.nsPerOp, r.nsMin, r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0,
+           r.allocsPerOp, r.bytesPerOp);
+    results.push_back(r);
+  }
+
+  if (jsonPath != nullptr) {
+    FILE* out = fopen(jsonPath, "w");
+    if (out == nullptr) {
+      fprintf(stderr, "micro_bench: cannot write %s\n", jsonPath);
+      return 1;
+    }
+    writeJson(out, results);
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,601 @@
+/**
+ * @file MqttBench.cpp
+ * @brief MQTT publishing: payload batching, throughput, alarm latency
+ *
+ * @details Uses the firmware's MqttClient over SocketMqttLink against a
+ * broker on loopback: `--broker 127.0.0.1:1883` for a real one (e.g.
+ * mosquitto), otherwise a stand-in started in its own thread that speaks
+ * enough MQTT 3.1.1 (CONNECT, PUBLISH QoS 0/1 with PUBACK, SUBSCRIBE with
+ * `#` filters, PINGREQ) to route messages. A second client subscribes to
+ * the test topics and timestamps what arrives. Runs:
+ *
+ * - batching: the detector on simulated pings for `--seconds` virtual
+ *   seconds; messages and bytes on the wire (MQTT headers included) for one
+ *   JSON message per reading, one binary message per ping, and the
+ *   telemetry blocks MqttTask publishes
+ * - throughput: `--messages` sample-block-sized messages at QoS 0 and at
+ *   QoS 1, published as fast as the queue takes them; messages/s and KB/s
+ *   at the subscriber
+ * - alarm latency: QoS 1 alarms, publish() to the subscriber's handler,
+ *   with no other traffic, with a sample block every 1 ms and with the
+ *   queue kept full of sample blocks
+ * - broker restart (stand-in only): every connection is dropped 7 times
+ *   during a run of QoS 1 alarms, 3 of them between an alarm and its
+ *   PUBACK; alarms lost and repeated at the broker
+ * - publish(): publish() plus poll() per message over a null link
+ *
+ * Usage: mqtt_bench [--broker ip:port] [--messages n] [--seconds s]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "IntruderDetector.h"
+#include "LogHistogram.h"
+#include "MqttClient.h"
+#include "MqttTask.h"
+#include "SensorSimulator.h"
+#include "SimHal.h"
+#include "SocketMqttLink.h"
+#include "Telemetry.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t nowMs() { return (uint32_t)(nowNs() / 1000000); }
+
+/**
+ * @brief Just enough of an MQTT broker for the benchmark, on 127.0.0.1
+ */
+class StandInBroker {
+ public:
+  StandInBroker() {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listenFd_, (const sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(listenFd_, 8) < 0) {
+      perror("mqtt_bench: stand-in broker");
+      exit(1);
+    }
+    socklen_t size = sizeof(address);
+    getsockname(listenFd_, (sockaddr*)&address, &size);
+    port_ = ntohs(address.sin_port);
+    thread_ = std::thread([this] { serve(); });
+  }
+
+  ~StandInBroker() {
+    stop_ = true;
+    thread_.join();
+    for (Client& client : clients_) close(client.fd);
+    close(listenFd_);
+  }
+
+  uint16_t port() const { return port_; }
+
+  /** @brief Closes every client connection, as a broker restart would */
+  void dropAll() { drop_ = true; }
+
+  /** @brief Distinct and repeated sequence numbers published on bench/alarm */
+  void alarms(size_t& unique, uint32_t& repeats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    unique = alarmSequences_.size();
+    repeats = alarmRepeats_;
+  }
+
+  /** @brief Drops every connection right after the next alarm, before its PUBACK */
+  void restartAfterNextAlarm() { restart_ = true; }
+
+  void resetAlarms() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    alarmSequences_.clear();
+    alarmRepeats_ = 0;
+  }
+
+ private:
+  struct Client {
+    int fd;
+    std::string rx;
+    std::vector<std::string> filters;
+  };
+
+  static bool matches(const std::string& filter, const std::string& topic) {
+    if (!filter.empty() && filter.back() == '#') {
+      return topic.compare(0, filter.size() - 1, filter, 0, filter.size() - 1) == 0;
+    }
+    return filter == topic;
+  }
+
+  static void sendAll(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+      ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+      if (n <= 0) return;
+      data += n;
+      length -= (size_t)n;
+    }
+  }
+
+  void serve() {
+    while (!stop_) {
+      if (drop_.exchange(false)) {
+        for (Client& client : clients_) close(client.fd);
+        clients_.clear();
+      }
+      std::vector<pollfd> fds(1 + clients_.size());
+      fds[0] = {listenFd_, POLLIN, 0};
+      for (size_t i = 0; i < clients_.size(); i++) fds[i + 1] = {clients_[i].fd, POLLIN, 0};
+      if (poll(fds.data(), fds.size(), 20) <= 0) continue;
+      if (fds[0].revents & POLLIN) {
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd >= 0) clients_.push_back(Client{fd, std::string(), {}});
+      }
+      for (size_t i = fds.size() - 1; i >= 1; i--) {
+        if (fds[i].revents == 0) continue;
+        char buffer[4096];
+        ssize_t n = recv(clients_[i - 1].fd, buffer, sizeof(buffer), 0);
+        if (n <= 0 || !handle(clients_[i - 1], buffer, (size_t)n)) {
+          close(clients_[i - 1].fd);
+          clients_.erase(clients_.begin() + (long)(i - 1));
+        }
+      }
+    }
+  }
+
+  /** @return false to close the connection */
+  bool handle(Client& client, const char* data, size_t length) {
+    client.rx.append(data, length);
+    for (;;) {
+      const uint8_t* in = (const uint8_t*)client.rx.data();
+      size_t available = client.rx.size();
+      if (available < 2) return true;
+      size_t remaining;
+      int fieldBytes = mqttGetLength(in + 1, available - 1, remaining);
+      if (fieldBytes < 0) return false;
+      if (fieldBytes == 0 || available < 1 + fieldBytes + remaining) return true;
+      const uint8_t* body = in + 1 + fieldBytes;
+      switch (in[0] >> 4) {
+        case 1: {  // CONNECT
+          const uint8_t connack[] = {0x20, 2, 0, 0};
+          sendAll(client.fd, connack, sizeof(connack));
+          break;
+        }
+        case 3: {  // PUBLISH
+          uint8_t qos = (in[0] >> 1) & 3;
+          size_t topicLength = (size_t)(body[0] << 8 | body[1]);
+          std::string topic((const char*)body + 2, topicLength);
+          size_t skip = 2 + topicLength + (qos > 0 ? 2 : 0);
+          if (topic == "bench/alarm" && remaining >= skip + 4) {
+            uint32_t sequence;
+            memcpy(&sequence, body + skip, 4);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!alarmSequences_.insert(sequence).second) alarmRepeats_++;
+            if (restart_.exchange(false)) {
+              drop_ = true;
+              return false;
+            }
+          }
+          if (qos > 0) {
+            const uint8_t puback[] = {0x40, 2, body[2 + topicLength], body[3 + topicLength]};
+            sendAll(client.fd, puback, sizeof(puback));
+          }
+          std::vector<uint8_t> out(remaining + 8);
+          size_t n = mqttEncodePublish(out.data(), out.size(), topic.c_str(), body + skip,
+                                       remaining - skip, 0, 0);
+          for (Client& other : clients_) {
+            for (const std::string& filter : other.filters) {
+              if (!matches(filter, topic)) continue;
+              sendAll(other.fd, out.data(), n);
+              break;
+            }
+          }
+          break;
+        }
+        case 8: {  // SUBSCRIBE: one filter per packet is all the client sends
+          size_t filterLength = (size_t)(body[2] << 8 | body[3]);
+          client.filters.push_back(std::string((const char*)body + 4, filterLength));
+          const uint8_t suback[] = {0x90, 3, body[0], body[1], 0};
+          sendAll(client.fd, suback, sizeof(suback));
+          break;
+        }
+        case 12: {  // PINGREQ
+          const uint8_t pingresp[] = {0xD0, 0};
+          sendAll(client.fd, pingresp, sizeof(pingresp));
+          break;
+        }
+        case 14:  // DISCONNECT
+          return false;
+        default:
+          break;
+      }
+      client.rx.erase(0, 1 + fieldBytes + remaining);
+    }
+  }
+
+  int listenFd_;
+  uint16_t port_;
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> drop_{false};
+  std::atomic<bool> restart_{false};
+  std::vector<Client> clients_;  ///< Broker thread only
+  std::mutex mutex_;
+  std::set<uint32_t> alarmSequences_;
+  uint32_t alarmRepeats_ = 0;
+};
+
+/** @brief What the subscriber saw; payloads start with sequence and send time */
+struct Received {
+  uint32_t messages = 0;
+  uint64_t bytes = 0;
+  LogHistogram alarmUs;  ///< publish() to handler, bench/alarm only
+};
+
+void onMessage(const char* topic, const uint8_t* payload, size_t length, void* context) {
+  Received& received = *(Received*)context;
+  received.messages++;
+  received.bytes += length;
+  if (strcmp(topic, "bench/alarm") != 0 || length < 12) return;
+  uint64_t sentNs;
+  memcpy(&sentNs, payload + 4, 8);
+  received.alarmUs.record((uint32_t)((nowNs() - sentNs) / 1000));
+}
+
+/** @brief Writes the sequence number and the send time into a test payload */
+void stamp(uint8_t* payload, uint32_t sequence) {
+  uint64_t sentNs = nowNs();
+  memcpy(payload, &sequence, 4);
+  memcpy(payload + 4, &sentNs, 8);
+}
+
+/** @brief Polls both clients until done() returns true or timeoutMs passes */
+template <typename Done>
+bool pumpUntil(MqttClient& a, MqttClient& b, uint32_t timeoutMs, Done done) {
+  uint32_t start = nowMs();
+  while (!done()) {
+    if (nowMs() - start > timeoutMs) return false;
+    a.poll(nowMs());
+    b.poll(nowMs());
+  }
+  return true;
+}
+
+struct Endpoint {
+  const char* address;
+  uint16_t port;
+};
+
+/**
+ * @brief A publisher and a subscriber on `bench/#`, both connected
+ */
+struct ClientPair {
+  explicit ClientPair(const Endpoint& broker)
+      : pubLink(broker.address, broker.port),
+        subLink(broker.address, broker.port),
+        publisher(pubLink, options("bench-pub")),
+        subscriber(subLink, options("bench-sub")) {
+    blocksTopic = publisher.addTopic("bench/samples", 0);
+    reliableTopic = publisher.addTopic("bench/samples1", 1);
+    alarmTopic = publisher.addTopic("bench/alarm", 1);
+    subscriber.subscribe("bench/#", onMessage, &received);
+    if (!pumpUntil(publisher, subscriber, 3000,
+                   [&] { return publisher.connected() && subscriber.connected(); })) {
+      fprintf(stderr, "mqtt_bench: cannot connect to %s:%u\n", broker.address,
+              (unsigned)broker.port);
+      exit(1);
+    }
+    // Give the SUBSCRIBE time to reach the broker before anything is published.
+    pumpUntil(publisher, subscriber, 50, [] { return false; });
+  }
+
+  static MqttOptions options(const char* clientId) {
+    MqttOptions options;
+    options.clientId = clientId;
+    options.reconnectMs = 100;
+    options.ackTimeoutMs = 1000;
+    return options;
+  }
+
+  SocketMqttLink pubLink;
+  SocketMqttLink subLink;
+  MqttClient publisher;
+  MqttClient subscriber;
+  Received received;
+  int blocksTopic;
+  int reliableTopic;
+  int alarmTopic;
+};
+
+/** @brief Counts the pings and readings of a simulated run */
+class BatchRecorder : public DetectorListener {
+ public:
+  explicit BatchRecorder(TelemetryStream& stream) : stream_(stream) {}
+  void onPing(uint32_t timeUs, uint32_t echoUs) override {
+    stream_.record(timeUs, echoUs);
+    pings++;
+  }
+  void onReading(float distanceCm) override {
+    char json[48];
+    readingBytes += (uint64_t)snprintf(json, sizeof(json), "{\"t_ms\":%lu,\"cm\":%.2f}",
+                                       (unsigned long)(readings * 500), (double)distanceCm);
+    readings++;
+  }
+
+  uint64_t pings = 0;
+  uint64_t readings = 0;
+  uint64_t readingBytes = 0;  ///< JSON payloads, one per reading
+
+ private:
+  TelemetryStream& stream_;
+};
+
+/** @brief Size of one QoS 0 PUBLISH with a payload of length bytes */
+size_t wireBytes(const char* topic, size_t length) {
+  static uint8_t packet[1024];
+  static const uint8_t payload[1024] = {};
+  return mqttEncodePublish(packet, sizeof(packet), topic, payload, length, 0, 0);
+}
+
+void runBatching(unsigned seconds) {
+  SimScene scene;
+  scene.backgroundCm = 40;
+  scene.timeoutProbability = 0.005f;
+  uint64_t endUs = (uint64_t)seconds * 1000000;
+  for (uint64_t t = 20000000; t + 5000000 < endUs; t += 30000000) {
+    SimIntrusion intrusion;
+    intrusion.startUs = t;
+    intrusion.endUs = t + 3000000;
+    intrusion.distanceCm = 4;
+    scene.intrusions.push_back(intrusion);
+  }
+  DetectorConfig config;
+  SensorSimulator sensor(scene, 1);
+  SimHal hal(sensor, config.echoPin, config.buzzerPin);
+  TelemetryStream stream;
+  BatchRecorder recorder(stream);
+  IntruderDetector detector(hal, config);
+  detector.setListener(&recorder);
+  detector.begin();
+  uint64_t blocks = 0;
+  uint64_t blockBytes = 0;
+  while (hal.now() < endUs) {
+    detector.loop();
+    size_t length;
+    uint32_t sequence;
+    if (stream.pending(length, sequence) != nullptr) {
+      blocks++;
+      blockBytes += wireBytes("intruder/samples", MQTT_SAMPLES_HEADER + length);
+      stream.releasePending();
+    }
+  }
+  double minutes = seconds / 60.0;
+  double pings = (double)recorder.pings;
+  uint64_t readingBytes =
+      recorder.readings * wireBytes("intruder/reading", 0) + recorder.readingBytes;
+  uint64_t pingBytes = recorder.pings * wireBytes("intruder/ping", 8);
+  printf("batching: %u s simulated, %llu pings, %llu readings; bytes include MQTT headers\n",
+         seconds, (unsigned long long)recorder.pings, (unsigned long long)recorder.readings);
+  printf("  %-26s %10s %10s %8s\n", "payload", "msgs/min", "bytes/min", "B/ping");
+  printf("  %-26s %10.1f %10.0f %8.2f\n", "JSON per reading", recorder.readings / minutes,
+         readingBytes / minutes, readingBytes / pings);
+  printf("  %-26s %10.1f %10.0f %8.2f\n", "binary per ping (8 B)", recorder.pings / minutes,
+         pingBytes / minutes, pingBytes / pings);
+  printf("  %-26s %10.1f %10.0f %8.2f\n", "sample blocks (MqttTask)", blocks / minutes,
+         blockBytes / minutes, blockBytes / pings);
+}
+
+void runThroughput(const Endpoint& broker, unsigned messages) {
+  const size_t size = MQTT_SAMPLES_HEADER + TELEMETRY_BLOCK_BYTES;
+  printf("throughput: %u messages of %zu bytes, publisher to subscriber\n", messages, size);
+  printf("  %-4s %10s %9s %9s %8s\n", "qos", "msgs/s", "KB/s", "received", "dropped");
+  for (int qos = 0; qos < 2; qos++) {
+    ClientPair pair(broker);
+    int topic = qos == 0 ? pair.blocksTopic : pair.reliableTopic;
+    uint8_t payload[size] = {};
+    uint32_t published = 0;
+    uint64_t start = nowNs();
+    // QoS 0 messages the broker could not forward are never received; stop
+    // once the publisher is drained and the subscriber has gone quiet.
+    uint32_t lastCount = 0;
+    uint32_t quietSince = nowMs();
+    bool done = pumpUntil(pair.publisher, pair.subscriber, 30000, [&] {
+      while (published < messages && pair.publisher.queued() < MQTT_QUEUE_SLOTS) {
+        stamp(payload, published++);
+        pair.publisher.publish(topic, payload, size);
+      }
+      if (pair.received.messages != lastCount) {
+        lastCount = pair.received.messages;
+        quietSince = nowMs();
+      }
+      return pair.received.messages >= messages ||
+             (published == messages && pair.publisher.queued() == 0 &&
+              nowMs() - quietSince > 200);
+    });
+    double seconds = (nowNs() - start) / 1e9;
+    printf("  %-4d %10.0f %9.0f %9u %8u%s\n", qos, pair.received.messages / seconds,
+           pair.received.bytes / 1024.0 / seconds, (unsigned)pair.received.messages,
+           (unsigned)pair.publisher.dropped(), done ? "" : "  (timed out)");
+  }
+}
+
+/**
+ * @param blockGapMs Sample blocks on the QoS 0 topic every this many ms; 0
+ *        for none, -1 to keep the publisher's queue full
+ */
+void runLatency(const Endpoint& broker, const char* name, int blockGapMs) {
+  const uint32_t alarms = 500;
+  ClientPair pair(broker);
+  uint8_t block[MQTT_SAMPLES_HEADER + TELEMETRY_BLOCK_BYTES] = {};
+  uint8_t alarm[16] = {};
+  uint32_t sent = 0;
+  uint32_t alarmMs = nowMs();
+  uint32_t blockMs = nowMs();
+  pumpUntil(pair.publisher, pair.subscriber, 30000, [&] {
+    if (blockGapMs < 0) {
+      while (pair.publisher.queued() < MQTT_QUEUE_SLOTS) {
+        pair.publisher.publish(pair.blocksTopic, block, sizeof(block));
+      }
+    } else if (blockGapMs > 0 && nowMs() - blockMs >= (uint32_t)blockGapMs) {
+      pair.publisher.publish(pair.blocksTopic, block, sizeof(block));
+      blockMs = nowMs();
+    }
+    if (sent < alarms && nowMs() - alarmMs >= 2) {
+      stamp(alarm, sent++);
+      pair.publisher.publish(pair.alarmTopic, alarm, sizeof(alarm));
+      alarmMs = nowMs();
+    }
+    return sent == alarms && pair.received.alarmUs.count() == alarms;
+  });
+  const LogHistogram& latency = pair.received.alarmUs;
+  printf("  %-24s %8u %7.0f %7u %7u %7u\n", name, (unsigned)latency.count(), latency.mean(),
+         (unsigned)latency.percentile(50), (unsigned)latency.percentile(99),
+         (unsigned)latency.max());
+}
+
+void runRestart(StandInBroker& broker) {
+  const uint32_t alarms = 200;
+  Endpoint endpoint = {"127.0.0.1", broker.port()};
+  ClientPair pair(endpoint);
+  broker.resetAlarms();
+  uint8_t alarm[16] = {};
+  uint32_t sent = 0;
+  uint32_t lastMs = nowMs();
+  pumpUntil(pair.publisher, pair.subscriber, 30000, [&] {
+    if (sent < alarms && nowMs() - lastMs >= 20) {
+      stamp(alarm, sent++);
+      pair.publisher.publish(pair.alarmTopic, alarm, sizeof(alarm));
+      lastMs = nowMs();
+      if (sent % 50 == 25) broker.dropAll();
+      if (sent % 50 == 0 && sent < alarms) broker.restartAfterNextAlarm();
+    }
+    return sent == alarms && pair.publisher.queued() == 0;
+  });
+  size_t unique;
+  uint32_t repeats;
+  broker.alarms(unique, repeats);
+  printf("broker restart: %u QoS 1 alarms 20 ms apart; connections dropped 7 times, "
+         "3 of them before a PUBACK\n",
+         (unsigned)alarms);
+  printf("  at broker: %zu unique, %u lost, %u repeated; publisher: %u resent, %u dropped, "
+         "%u connects\n",
+         unique, (unsigned)(alarms - unique), (unsigned)repeats, (unsigned)pair.publisher.resent(),
+         (unsigned)pair.publisher.dropped(), (unsigned)pair.publisher.connects());
+}
+
+/** @brief Takes every write and answers the CONNECT; nothing goes anywhere */
+class NullLink : public MqttLink {
+ public:
+  bool open() override {
+    connack_ = true;
+    return true;
+  }
+  int status() override { return 1; }
+  int write(const uint8_t*, size_t length) override { return (int)length; }
+  int read(uint8_t* out, size_t capacity) override {
+    if (!connack_ || capacity < 4) return 0;
+    connack_ = false;
+    const uint8_t connack[] = {0x20, 2, 0, 0};
+    memcpy(out, connack, sizeof(connack));
+    return 4;
+  }
+  void close() override {}
+
+ private:
+  bool connack_ = false;
+};
+
+void runPublishCost() {
+  NullLink link;
+  MqttClient client(link);
+  int topic = client.addTopic("intruder/samples", 0);
+  while (!client.connected()) client.poll(nowMs());
+  uint8_t payload[MQTT_SAMPLES_HEADER + TELEMETRY_BLOCK_BYTES] = {};
+  const uint32_t rounds = 1000000;
+  uint64_t start = nowNs();
+  for (uint32_t i = 0; i < rounds; i++) {
+    client.publish(topic, payload, sizeof(payload));
+    client.poll(nowMs());
+  }
+  double ns = (double)(nowNs() - start) / rounds;
+  printf("publish() + poll(): %.0f ns per %zu-byte QoS 0 message (null link, %u sent)\n", ns,
+         sizeof(payload), (unsigned)client.sent());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* brokerArg = nullptr;
+  unsigned messages = 20000;
+  unsigned seconds = 600;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "usage: %s [--broker ip:port] [--messages n] [--seconds s]\n", argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (strcmp(arg, "--broker") == 0) brokerArg = value;
+    else if (strcmp(arg, "--messages") == 0) messages = (unsigned)strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--seconds") == 0) seconds = (unsigned)strtoul(value, nullptr, 10);
+    else {
+      fprintf(stderr, "mqtt_bench: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  runBatching(seconds);
+
+  StandInBroker* standIn = nullptr;
+  std::string address = "127.0.0.1";
+  Endpoint broker;
+  if (brokerArg != nullptr) {
+    const char* colon = strrchr(brokerArg, ':');
+    if (colon == nullptr) {
+      fprintf(stderr, "mqtt_bench: --broker wants ip:port\n");
+      return 2;
+    }
+    address.assign(brokerArg, (size_t)(colon - brokerArg));
+    broker = {address.c_str(), (uint16_t)atoi(colon + 1)};
+    printf("broker: %s\n", brokerArg);
+  } else {
+    standIn = new StandInBroker();
+    broker = {address.c_str(), standIn->port()};
+    printf("broker: stand-in on 127.0.0.1:%u (--broker ip:port for a real one)\n",
+           (unsigned)standIn->port());
+  }
+
+  runThroughput(broker, messages);
+  printf("alarm latency: 500 QoS 1 alarms 2 ms apart, publish() to subscriber, us\n");
+  printf("  %-24s %8s %7s %7s %7s %7s\n", "other traffic", "received", "mean", "p50", "p99",
+         "max");
+  runLatency(broker, "none", 0);
+  runLatency(broker, "a block every 1 ms", 1);
+  runLatency(broker, "queue kept full", -1);
+  if (standIn != nullptr) runRestart(*standIn);
+  runPublishCost();
+  delete standIn;
+  return 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file NoiseEval.cpp
+ * @brief Fixed versus noise-adaptive hysteresis on simulated noise profiles
+ *
+ * @details For each noise profile (quiet to very noisy, plus one with
+ * spurious short echoes) the same simulated session is run twice through the
+ * real detector on a SimHal: once with the configured fixed trip/clear band
+ * and once with the gap sized by NoiseEstimator (`--adaptive-gap`). Each
+ * visitor stops between half the trip distance and the trip distance, then
+ * backs away slowly (WALK_AWAY_CM_PER_S) through the hysteresis band, where
+ * a narrow band chatters in a noisy installation and a wide one holds the
+ * alarm needlessly long in a quiet one. Per run it prints:
+ *
+ * - missed visits and false alarms per hour (DetectionScorer; a visit lasts
+ *   until the visitor is back beyond the trip distance)
+ * - chatter: extra alarms raised during a visit after the first one
+ * - mean trip latency, and mean release latency from leaving the trip
+ *   distance to the alarm clearing
+ * - the thresholds in use at the end of the session
+ *
+ * Usage: noise_eval [detector options] [--hours h] [--seed n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "DetectionScorer.h"
+#include "IntruderDetector.h"
+#include "SensorSimulator.h"
+#include "SimHal.h"
+#include "ToolOptions.h"
+
+namespace {
+
+struct NoiseProfile {
+  const char* name;
+  float noiseCm;
+  float glitchProbability;
+};
+
+const NoiseProfile profiles[] = {
+    {"quiet", 0.05f, 0},
+    {"typical", 0.3f, 0},
+    {"noisy", 1.0f, 0},
+    {"very_noisy", 2.0f, 0},
+    {"glitchy", 0.3f, 0.02f},
+};
+
+/** @brief Speed at which visitors back away */
+const float WALK_AWAY_CM_PER_S = 4;
+
+/** @brief Time resolution of the walk-away ramp */
+const uint64_t RAMP_STEP_US = 100000;
+
+/** @brief Distance at which a visitor has left the scene */
+const float WALK_AWAY_END_CM = 20;
+
+struct Visit {
+  uint64_t startUs;
+  uint64_t leaveUs;  ///< Back beyond the trip distance
+};
+
+uint64_t splitmix(uint64_t& state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/**
+ * @brief Collects alarm intervals on the virtual clock
+ */
+class AlarmRecorder : public DetectorListener {
+ public:
+  AlarmRecorder(SimHal& hal, std::vector<AlarmInterval>& alarms) : hal_(hal), alarms_(alarms) {}
+
+  void onIntruder(float) override {
+    AlarmInterval alarm = {hal_.now(), UINT64_MAX};
+    alarms_.push_back(alarm);
+  }
+
+  void onClear(float) override {
+    if (!alarms_.empty()) alarms_.back().clearedUs = hal_.now();
+  }
+
+ private:
+  SimHal& hal_;
+  std::vector<AlarmInterval>& alarms_;
+};
+
+struct RunResult {
+  TraceScore score;
+  size_t chatter = 0;
+  double releaseMs = 0;
+  float tripCm = 0;
+  float clearCm = 0;
+};
+
+RunResult run(const SimScene& scene, const std::vector<Visit>& visits,
+              const DetectorConfig& config, uint64_t endUs, uint64_t seed) {
+  SensorSimulator sensor(scene, seed);
+  SimHal hal(sensor, config.echoPin, config.buzzerPin);
+  IntruderDetector detector(hal, config);
+  std::vector<AlarmInterval> alarms;
+  AlarmRecorder recorder(hal, alarms);
+  detector.setListener(&recorder);
+  detector.begin();
+  while (hal.now() < endUs) detector.loop();
+
+  std::vector<LabelInterval> labels;
+  for (const Visit& visit : visits) {
+    LabelInterval label = {visit.startUs, visit.leaveUs, LabelKind::Intruder};
+    labels.push_back(label);
+  }
+  RunResult result;
+  ScoreOptions options;
+  result.score = scoreDetections(alarms, labels, endUs / 3.6e9, options);
+
+  // Alarms and visits are both in time order.
+  size_t a = 0;
+  size_t released = 0;
+  for (const Visit& visit : visits) {
+    uint64_t windowEnd = visit.leaveUs + options.graceUs;
+    while (a < alarms.size() && alarms[a].clearedUs <= visit.startUs) a++;
+    size_t raised = 0;
+    uint64_t clearedUs = UINT64_MAX;
+    for (; a < alarms.size() && alarms[a].raisedUs <= windowEnd; a++) {
+      raised++;
+      clearedUs = alarms[a].clearedUs;
+    }
+    if (raised > 1) result.chatter += raised - 1;
+    if (raised > 0 && clearedUs != UINT64_MAX && clearedUs > visit.leaveUs) {
+      result.releaseMs += (clearedUs - visit.leaveUs) / 1000.0;
+      released++;
+    }
+  }
+  if (released > 0) result.releaseMs /= released;
+  detector.thresholds(result.tripCm, result.clearCm);
+  return result;
+}
+
+void printRow(const char* profile, const char* mode, const RunResult& r) {
+  printf("%-10s %-8s %6zu %6zu %8.2f %7zu %9.1f %10.1f %6.2f %6.2f\n", profile, mode,
+         r.score.events.size(), r.score.missed(), r.score.falseAlarmsPerHour(), r.chatter,
+         r.score.meanLatencyMs(), r.releaseMs, r.tripCm, r.clearCm);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  DetectorConfig config;
+  config.filter = FilterType::Median;
+  double hours = 2;
+  uint64_t seed = 1;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "usage: %s [options] [--hours h] [--seed n]\n" DETECTOR_OPTIONS_USAGE,
+              argv[0]);
+      return 2;
+    }
+    const char* value = argv[++i];
+    int handled = parseDetectorOption(arg, value, config);
+    if (handled < 0) {
+      fprintf(stderr, "noise_eval: invalid value %s for %s\n", value, arg);
+      return 2;
+    }
+    if (handled > 0) continue;
+    if (strcmp(arg, "--hours") == 0) hours = atof(value);
+    else if (strcmp(arg, "--seed") == 0) seed = strtoull(value, nullptr, 10);
+    else {
+      fprintf(stderr, "noise_eval: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  DetectorConfig fixed = config;
+  fixed.noise.adaptive = false;
+  DetectorConfig adaptive = config;
+  adaptive.noise.adaptive = true;
+
+  printf("trip %.2f cm, clear %.2f cm, %u pings/reading (%s), period %lu ms, "
+         "adaptive gap %.1f sigma in [%.1f, %.1f] cm, %.1f h per run\n",
+         config.tripCm, config.clearCm, (unsigned)config.samplesPerReading,
+         filterTypeName(config.filter), (unsigned long)config.cyclePeriodMs,
+         adaptive.noise.gapSigmas, adaptive.noise.minGapCm, adaptive.noise.maxGapCm, hours);
+  printf("%-10s %-8s %6s %6s %8s %7s %9s %10s %6s %6s\n", "profile", "gap", "events", "missed",
+         "false/h", "chatter", "trip_ms", "release_ms", "trip", "clear");
+
+  uint64_t endUs = (uint64_t)(hours * 3.6e9);
+  for (const NoiseProfile& profile : profiles) {
+    // Visits 5-20 s apart, held 2-8 s, then a walk away laid out as short
+    // consecutive intrusions (the simulator shows the closest active one).
+    SimScene scene;
+    std::vector<Visit> visits;
+    scene.backgroundCm = 40;
+    scene.noiseCm = profile.noiseCm;
+    scene.glitchProbability = profile.glitchProbability;
+    scene.timeoutProbability = 0.005f;
+    uint64_t state = seed;
+    uint64_t t = 10000000;
+    while (true) {
+      t += 5000000 + splitmix(state) % 15000000;
+      if (t + 20000000 > endUs) break;
+      Visit visit = {t, 0};
+      SimIntrusion hold;
+      hold.startUs = t;
+      hold.endUs = t + 2000000 + splitmix(state) % 6000000;
+      hold.distanceCm = config.tripCm * (0.5f + 0.45f * (splitmix(state) % 1000) / 1000.0f);
+      scene.intrusions.push_back(hold);
+      t = hold.endUs;
+      for (float d = hold.distanceCm; d < WALK_AWAY_END_CM;
+           d += WALK_AWAY_CM_PER_S * RAMP_STEP_US / 1e6f) {
+        SimIntrusion step = {t, t + RAMP_STEP_US, d};
+        scene.intrusions.push_back(step);
+        if (visit.leaveUs == 0 && d >= config.tripCm) visit.leaveUs = t;
+        t += RAMP_STEP_US;
+      }
+      visits.push_back(visit);
+    }
+    printRow(profile.name, "fixed", run(scene, visits, fixed, endUs, seed));
+    printRow(profile.name, "adaptive", run(scene, visits, adaptive, endUs, seed));
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+/**
+ * @file Replay.cpp
+ * @brief Faster-than-real-time replay of recorded traces through the detector
+ *
+ * @details Drives IntruderDetector::loop() — the same code the firmware runs —
+ * with a ReplayHal over a memory-mapped trace. Every alarm transition and
+ * buzzer edge is printed as CSV with its virtual timestamp:
+ *
+ *   timeUs,event,distanceCm
+ *
+ * where event is `intruder`, `clear`, `buzzer_on` or `buzzer_off`
+ * (distanceCm is empty for buzzer edges). `--health` runs SensorHealth on the
+ * pings and adds `sensor_fault:<faults>` / `sensor_ok` events. A summary with the replay speed is
+ * printed to stderr. `--profile` adds the host-side LoopProfiler table (same
+ * phases and format as the firmware's `prof` command) and the DeadlineMonitor
+ * counters on the virtual clock (as `deadline` on the device) to stderr.
+ * `--summary ms` runs the firmware's SummaryAggregator over the replay,
+ * prints each interval to stderr and compares the Serial bytes of the
+ * summaries (`@S` lines) with those of printing every reading.
+ *
+ * Usage: replay <trace> [detector options] [--from us] [--to us] [--quiet]
+ *               [--profile] [--health] [--summary ms]
+ * (detector options: see DETECTOR_OPTIONS_USAGE in ToolOptions.h)
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "DeadlineMonitor.h"
+#include "IntruderDetector.h"
+#include "LoopProfiler.h"
+#include "ReplayHal.h"
+#include "SensorHealth.h"
+#include "SummaryAggregator.h"
+#include "ToolOptions.h"
+#include "TraceFile.h"
+
+namespace {
+
+/**
+ * @brief Writes transitions and buzzer edges as CSV
+ */
+class EventPrinter : public DetectorListener,
+                     public BuzzerEdgeListener,
+                     public SensorHealthListener {
+ public:
+  EventPrinter(ReplayHal& hal, bool quiet, SensorHealth* health, SummaryAggregator* summaries)
+      : hal_(hal),
+        quiet_(quiet),
+        health_(health),
+        summaries_(summaries),
+        events_(0),
+        readings_(0),
+        readingBytes_(0) {}
+
+  void onPing(uint32_t, uint32_t echoUs) override {
+    if (health_ != nullptr) health_->addSample(echoUs);
+    if (summaries_ != nullptr) summaries_->addPing(echoUs);
+  }
+
+  void onReading(float cm) override {
+    readings_++;
+    if (summaries_ == nullptr) return;
+    summaries_->addReading(cm);
+    // What the firmware prints per reading with `readings on`.
+    char line[96];
+    readingBytes_ += snprintf(line, sizeof(line),
+                              "Distance (cm): %.2f\r\nDistance (inch): %.2f\r\n", cm,
+                              cm * 0.393701f);
+  }
+
+  void onHealthChange(uint8_t faults, uint8_t) override {
+    events_++;
+    if (quiet_) return;
+    if (faults == 0) {
+      printf("%" PRIu64 ",sensor_ok,\n", hal_.now());
+    } else {
+      char names[64];
+      formatSensorFaults(faults, names, sizeof(names));
+      printf("%" PRIu64 ",sensor_fault:%s,\n", hal_.now(), names);
+    }
+  }
+
+  void onIntruder(float cm) override {
+    if (summaries_ != nullptr) summaries_->setAlarm(true, (uint32_t)(hal_.now() / 1000));
+    print("intruder", cm);
+  }
+  void onClear(float cm) override {
+    if (summaries_ != nullptr) summaries_->setAlarm(false, (uint32_t)(hal_.now() / 1000));
+    print("clear", cm);
+  }
+
+  void onBuzzerEdge(uint64_t timeUs, uint8_t level) override {
+    events_++;
+    if (!quiet_) {
+      printf("%" PRIu64 ",%s,\n", timeUs, level == HIGH ? "buzzer_on" : "buzzer_off");
+    }
+  }
+
+  unsigned long events() const { return events_; }
+  unsigned long readings() const { return readings_; }
+  uint64_t readingBytes() const { return readingBytes_; }
+
+ private:
+  void print(const char* event, float cm) {
+    events_++;
+    if (!quiet_) printf("%" PRIu64 ",%s,%.2f\n", hal_.now(), event, cm);
+  }
+
+  ReplayHal& hal_;
+  bool quiet_;
+  SensorHealth* health_;
+  SummaryAggregator* summaries_;
+  unsigned long events_;
+  unsigned long readings_;
+  uint64_t readingBytes_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s <trace> [options] [--from us] [--to us] [--quiet] [--profile] [--health]\n"
+            "          [--summary ms]\n"
+            DETECTOR_OPTIONS_USAGE,
+            argv[0]);
+    return 2;
+  }
+
+  TraceReader trace;
+  if (!trace.open(argv[1])) {
+    fprintf(stderr, "replay: %s is not a readable trace\n", argv[1]);
+    return 1;
+  }
+
+  // Start from the configuration the trace was recorded with.
+  DetectorConfig config;
+  applyTraceConfig(trace.header(), config);
+
+  uint64_t fromUs = 0;
+  uint64_t toUs = UINT64_MAX;
+  bool quiet = false;
+  bool profile = false;
+  bool health = false;
+  uint32_t summaryMs = 0;
+  for (int i = 2; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : "0";
+    if (strcmp(arg, "--quiet") == 0) {
+      quiet = true;
+      continue;
+    }
+    if (strcmp(arg, "--profile") == 0) {
+      profile = true;
+      continue;
+    }
+    if (strcmp(arg, "--health") == 0) {
+      health = true;
+      continue;
+    }
+    i++;
+    int handled = parseDetectorOption(arg, value, config);
+    if (handled < 0) {
+      fprintf(stderr, "replay: invalid value %s for %s\n", value, arg);
+      return 2;
+    }
+    if (handled > 0) continue;
+    if (strcmp(arg, "--from") == 0) {
+      fromUs = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--to") == 0) {
+      toUs = strtoull(value, nullptr, 10);
+    } else if (strcmp(arg, "--summary") == 0) {
+      summaryMs = (uint32_t)strtoul(value, nullptr, 10);
+    } else {
+      fprintf(stderr, "replay: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+
+  if (!replayMatchesTrace(trace.sensor(), config)) {
+    fprintf(stderr, "replay: trace was recorded with %u pings per reading\n",
+            (unsigned)trace.sensor().samplesPerReading);
+    return 2;
+  }
+
+  size_t first = trace.seek(fromUs);
+  size_t last = toUs == UINT64_MAX ? trace.size() : trace.seek(toUs);
+  if (last < first) last = first;
+
+  ReplayHal hal(trace.records() + first, last - first, config.echoPin, config.buzzerPin);
+  IntruderDetector detector(hal, config);
+  SensorHealth sensorHealth;
+  SummaryAggregator summaries(summaryMs);
+  EventPrinter printer(hal, quiet, health ? &sensorHealth : nullptr,
+                       summaryMs > 0 ? &summaries : nullptr);
+  sensorHealth.setListener(&printer);
+  detector.setListener(&printer);
+  hal.setEdgeListener(&printer);
+  LoopProfiler profiler;
+  if (profile) detector.setProfiler(&profiler);
+  DeadlineConfig deadlineConfig;
+  deadlineConfig.budgetUs = detector.cycleBudgetUs();
+  DeadlineMonitor deadline(deadlineConfig);
+
+  if (!quiet) printf("timeUs,event,distanceCm\n");
+  auto start = std::chrono::steady_clock::now();
+  detector.begin();
+  summaries.start((uint32_t)(hal.now() / 1000));
+  uint64_t summaryCount = 0;
+  while (!hal.finished()) {
+    ProfileScope cycle(profile ? &profiler : nullptr, LoopPhase::Loop);
+    if (profile) deadline.cycleStart(hal.now());
+    detector.loop();
+    if (summaryMs > 0 && summaries.poll((uint32_t)(hal.now() / 1000))) {
+      summaryCount++;
+      if (!quiet) {
+        char line[256];
+        formatSummary(summaries.summary(), line, sizeof(line));
+        fprintf(stderr, "summary: %s\n", line);
+      }
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start).count();
+
+  size_t samples = hal.consumed();
+  double virtualSeconds =
+      samples > 0 ? (double)(trace[last - 1].timeUs - trace[first].timeUs) / 1e6 : 0;
+  fprintf(stderr,
+          "replayed %zu pings / %lu readings (%.1f s of capture) in %.3f s: "
+          "%.2f M pings/s, %.0fx real time, %lu events\n",
+          samples, printer.readings(), virtualSeconds, seconds,
+          seconds > 0 ? samples / seconds / 1e6 : 0.0,
+          seconds > 0 ? virtualSeconds / seconds : 0.0, printer.events());
+  if (summaryMs > 0 && virtualSeconds > 0) {
+    // `@S ` + hex + CRLF per interval.
+    uint64_t summaryBytes = summaryCount * (strlen(SUMMARY_PREFIX) + 2 * SUMMARY_BYTES + 2);
+    fprintf(stderr,
+            "serial output: %.1f B/s printing every reading, %.2f B/s as %lu ms summaries "
+            "(%.0fx less)\n",
+            printer.readingBytes() / virtualSeconds, summaryBytes / virtualSeconds,
+            (unsigned long)summaryMs,
+            summaryBytes > 0 ? (double)printer.readingBytes() / summaryBytes : 0.0);
+  }
+  if (health) {
+    char line[256];
+    sensorHealth.format(line, sizeof(line));
+    fprintf(stderr, "sensor health: %s\n", line);
+  }
+  if (profile) {
+    char line[1024];
+    fprintf(stderr, "%s\n", histogramSummaryHeader());
+    for (size_t i = 0; i < (size_t)LoopPhase::Count; i++) {
+      profiler.formatPhase((LoopPhase)i, line, sizeof(line));
+      fprintf(stderr, "%s\n", line);
+    }
+    for (size_t i = 0; i < (size_t)LoopPhase::Count; i++) {
+      profiler.formatHistogram((LoopPhase)i, line, sizeof(line));
+      fprintf(stderr, "%s\n", line);
+    }
+    deadline.formatCounters(line, sizeof(line));
+    fprintf(stderr, "virtual cycle periods: %s\n", line);
+  }
+  return 0;
+}
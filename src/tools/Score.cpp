@@ -0,0 +1,164 @@
+/**
+ * @file Score.cpp
+ * @brief Detection-quality harness: replays labelled traces and scores them
+ *
+ * @details Runs the detector over each trace (with optional overrides),
+ * scores the alarms against the trace's `.labels` sidecar with
+ * DetectionScorer and writes one JSON document:
+ *
+ *   {"traces": [{"trace": "a.trace", "config": {...}, "score": {...}}, ...],
+ *    "options": {"grace_ms": ..., "late_ms": ...},
+ *    "total": {...}}
+ *
+ * Two runs (e.g. before and after a change to getDistanceCm()) can then be
+ * compared field by field.
+ *
+ * Usage: score [detector options] [--grace ms] [--late ms] [--events]
+ *              [--out file.json] <trace> [trace ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DetectionScorer.h"
+#include "GroundTruth.h"
+#include "ReplayHal.h"
+#include "ToolOptions.h"
+#include "TraceFile.h"
+
+namespace {
+
+void writeConfigJson(FILE* out, const DetectorConfig& c) {
+  fprintf(out,
+          "{\"trip_cm\": %.2f, \"clear_cm\": %.2f, \"samples\": %u, \"filter\": \"%s\", "
+          "\"dwell\": %u, \"clear_dwell\": %u, \"spacing_ms\": %u, \"period_ms\": %u, "
+          "\"timeout_us\": %u}",
+          c.tripCm, c.clearCm, (unsigned)c.samplesPerReading, filterTypeName(c.filter),
+          (unsigned)c.tripDwell, (unsigned)c.clearDwell, (unsigned)c.pingSpacingMs,
+          (unsigned)c.cyclePeriodMs, (unsigned)c.echoTimeoutUs);
+}
+
+/** @brief Writes a string as a JSON string literal */
+void writeJsonString(FILE* out, const std::string& text) {
+  fputc('"', out);
+  for (char c : text) {
+    if (c == '"' || c == '\\') fputc('\\', out);
+    fputc(c, out);
+  }
+  fputc('"', out);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> paths;
+  std::vector<char*> overrides;
+  ScoreOptions options;
+  bool withEvents = false;
+  const char* outPath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (arg[0] != '-') {
+      paths.push_back(arg);
+      continue;
+    }
+    if (strcmp(arg, "--events") == 0) {
+      withEvents = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "score: %s needs a value\n", arg);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (strcmp(arg, "--grace") == 0) {
+      options.graceUs = strtoull(value, nullptr, 10) * 1000;
+    } else if (strcmp(arg, "--late") == 0) {
+      options.lateUs = strtoull(value, nullptr, 10) * 1000;
+    } else if (strcmp(arg, "--out") == 0) {
+      outPath = value;
+    } else {
+      // Detector overrides are applied per trace, after its own config.
+      DetectorConfig probe;
+      if (parseDetectorOption(arg, value, probe) <= 0) {
+        fprintf(stderr, "score: bad option %s %s\n", arg, value);
+        return 2;
+      }
+      overrides.push_back(argv[i - 1]);
+      overrides.push_back(argv[i]);
+    }
+  }
+  if (paths.empty()) {
+    fprintf(stderr,
+            "usage: %s [options] [--grace ms] [--late ms] [--events] [--out file.json]"
+            " <trace> [trace ...]\n" DETECTOR_OPTIONS_USAGE,
+            argv[0]);
+    return 2;
+  }
+
+  // Load everything first so a bad input never leaves half a document.
+  std::vector<std::unique_ptr<TraceReader>> traces;
+  std::vector<std::vector<LabelInterval>> labels(paths.size());
+  std::vector<DetectorConfig> configs(paths.size());
+  for (size_t p = 0; p < paths.size(); p++) {
+    traces.emplace_back(new TraceReader());
+    if (!traces[p]->open(paths[p].c_str())) {
+      fprintf(stderr, "score: %s is not a readable trace\n", paths[p].c_str());
+      return 1;
+    }
+    if (!loadLabels(labelPathFor(paths[p]), labels[p])) {
+      fprintf(stderr, "score: cannot read labels %s\n", labelPathFor(paths[p]).c_str());
+      return 1;
+    }
+    applyTraceConfig(traces[p]->header(), configs[p]);
+    for (size_t o = 0; o < overrides.size(); o += 2) {
+      parseDetectorOption(overrides[o], overrides[o + 1], configs[p]);
+    }
+    if (!replayMatchesTrace(traces[p]->sensor(), configs[p])) {
+      fprintf(stderr, "score: %s was recorded with %u pings per reading\n", paths[p].c_str(),
+              (unsigned)traces[p]->sensor().samplesPerReading);
+      return 2;
+    }
+  }
+
+  FILE* out = outPath != nullptr ? fopen(outPath, "w") : stdout;
+  if (out == nullptr) {
+    fprintf(stderr, "score: cannot write %s\n", outPath);
+    return 1;
+  }
+
+  TraceScore total;
+  fprintf(out, "{\"traces\": [");
+  for (size_t p = 0; p < paths.size(); p++) {
+    const TraceReader& trace = *traces[p];
+    const DetectorConfig& config = configs[p];
+
+    std::vector<AlarmInterval> alarms;
+    replayAlarms(trace.records(), trace.size(), config, alarms);
+    double hours =
+        trace.size() > 1 ? (trace[trace.size() - 1].timeUs - trace[0].timeUs) / 3.6e9 : 0;
+    TraceScore score = scoreDetections(alarms, labels[p], hours, options);
+    total.merge(score);
+
+    fprintf(out, "%s\n  {\"trace\": ", p ? "," : "");
+    writeJsonString(out, paths[p]);
+    fprintf(out, ", \"config\": ");
+    writeConfigJson(out, config);
+    fprintf(out, ", \"score\": ");
+    score.writeJson(out, withEvents);
+    fprintf(out, "}");
+  }
+  fprintf(out, "\n ],\n \"options\": {\"grace_ms\": %llu, \"late_ms\": %llu},\n \"total\": ",
+          (unsigned long long)(options.graceUs / 1000),
+          (unsigned long long)(options.lateUs / 1000));
+  total.writeJson(out, false);
+  fprintf(out, "\n}\n");
+  if (out != stdout) fclose(out);
+  return 0;
+}
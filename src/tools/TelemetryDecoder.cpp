@@ -0,0 +1,253 @@
+/**
+ * @file TelemetryDecoder.cpp
+ * @brief Converts a captured serial log into an indexed trace file
+ *
+ * @details Reads the firmware's serial output (e.g. saved from
+ * `pio device monitor`), picks out the `@C` configuration line and the `@B`
+ * telemetry blocks, decodes every ping and writes it to a trace file.
+ * Everything else in the log is ignored, except `@M` metrics snapshots
+ * (the `metrics bin` command) and `@S` interval summaries, which are
+ * decoded and printed to stdout.
+ *
+ * - 32-bit micros() timestamps are unwrapped into a 64-bit timeline.
+ * - A jump in block sequence numbers marks the next record with
+ *   TRACE_FLAG_GAP.
+ * - A device restart (a new `@C` line, a sequence number going back, or a
+ *   timestamp going back further than a wrap could explain) starts a new
+ *   segment: the timeline continues 1 µs after the last record, the first
+ *   record is flagged TRACE_FLAG_GAP, and no blocks count as lost.
+ *
+ * Usage: telemetry_decoder <capture.log | -> <out.trace> [index-stride]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "IntruderDetector.h"
+#include "Metrics.h"
+#include "SampleCodec.h"
+#include "SummaryAggregator.h"
+#include "Telemetry.h"
+#include "TraceFile.h"
+
+namespace {
+
+/** @brief Longest plausible step between two pings; a larger backward step is a restart */
+const uint64_t MAX_PING_STEP_US = 120000000;
+
+/**
+ * @brief Applies the key=value pairs of an `@C` line to the trace config
+ * @details Keys an older firmware does not print keep their defaults.
+ */
+void parseConfigLine(const char* line, TraceSensorConfig& sensor, TraceDetectorConfig& detector) {
+  char key[32];
+  char value[32];
+  const char* p = line + strlen(TELEMETRY_CONFIG_PREFIX);
+  int consumed = 0;
+  while (sscanf(p, " %31[^=]=%31s%n", key, value, &consumed) == 2) {
+    p += consumed;
+    unsigned long n = strtoul(value, nullptr, 10);
+    if (strcmp(key, "trig") == 0) sensor.trigPin = (uint8_t)n;
+    else if (strcmp(key, "echo") == 0) sensor.echoPin = (uint8_t)n;
+    else if (strcmp(key, "buzzer") == 0) sensor.buzzerPin = (uint8_t)n;
+    else if (strcmp(key, "samples") == 0) sensor.samplesPerReading = (uint8_t)n;
+    else if (strcmp(key, "timeout") == 0) sensor.echoTimeoutUs = (uint32_t)n;
+    else if (strcmp(key, "spacing") == 0) sensor.pingSpacingMs = (uint32_t)n;
+    else if (strcmp(key, "period") == 0) sensor.cyclePeriodMs = (uint32_t)n;
+    else if (strcmp(key, "sound") == 0) sensor.soundSpeedCmPerUs = (float)atof(value);
+    else if (strcmp(key, "calib") == 0) detector.calibrationReadings = (uint16_t)n;
+    else if (strcmp(key, "calib_period") == 0) detector.calibrationPeriodMs = (uint32_t)n;
+    else if (strcmp(key, "trip_margin") == 0) detector.tripMarginCm = (float)atof(value);
+    else if (strcmp(key, "clear_margin") == 0) detector.clearMarginCm = (float)atof(value);
+    else if (strcmp(key, "adapt") == 0) detector.adaptRate = (float)atof(value);
+    else if (strcmp(key, "filter") == 0) {
+      FilterType filter;
+      if (parseFilterType(value, filter)) detector.filter = (uint8_t)filter;
+    }
+  }
+}
+
+/**
+ * @brief Prints the metrics of an `@M` snapshot, one per line
+ */
+class MetricsPrinter : public MetricsSnapshotVisitor {
+ public:
+  void onValue(const char* name, MetricKind kind, double value) override {
+    if (kind == MetricKind::Gauge) {
+      printf("  %-22s %-9s %.3f\n", name, metricKindName(kind), value);
+    } else {
+      printf("  %-22s %-9s %.0f\n", name, metricKindName(kind), value);
+    }
+  }
+
+  void onHistogram(const char* name, uint32_t count, uint32_t min, uint32_t max, uint32_t p50,
+                   uint32_t p90, uint32_t p99, uint64_t sum) override {
+    printf("  %-22s %-9s count=%lu min=%lu mean=%.1f p50=%lu p90=%lu p99=%lu max=%lu\n", name,
+           metricKindName(MetricKind::Histogram), (unsigned long)count, (unsigned long)min,
+           count ? (double)sum / count : 0.0, (unsigned long)p50, (unsigned long)p90,
+           (unsigned long)p99, (unsigned long)max);
+  }
+};
+
+/** @brief Decodes and prints one `@M` line; false if it is malformed */
+bool printMetricsLine(const char* line) {
+  static uint8_t snapshot[METRICS_SNAPSHOT_MAX_BYTES];
+  size_t length = 0;
+  if (!telemetryFromHex(line + strlen(METRICS_SNAPSHOT_PREFIX), snapshot, sizeof(snapshot),
+                        length)) {
+    return false;
+  }
+  uint32_t uptimeMs = 0;
+  MetricsPrinter printer;
+  printf("metrics snapshot:\n");
+  if (!decodeMetricsSnapshot(snapshot, length, uptimeMs, printer)) return false;
+  printf("  (uptime %lu ms)\n", (unsigned long)uptimeMs);
+  return true;
+}
+
+/** @brief Decodes and prints one `@S` line; false if it is malformed */
+bool printSummaryLine(const char* line) {
+  uint8_t encoded[SUMMARY_BYTES];
+  size_t length = 0;
+  IntervalSummary summary;
+  if (!telemetryFromHex(line + strlen(SUMMARY_PREFIX), encoded, sizeof(encoded), length) ||
+      !decodeSummary(encoded, length, summary)) {
+    return false;
+  }
+  char text[256];
+  formatSummary(summary, text, sizeof(text));
+  printf("summary: %s\n", text);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <capture.log | -> <out.trace> [index-stride]\n", argv[0]);
+    return 2;
+  }
+
+  FILE* in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "r");
+  if (in == nullptr) {
+    fprintf(stderr, "telemetry_decoder: cannot open %s\n", argv[1]);
+    return 1;
+  }
+  uint32_t stride = argc > 3 ? (uint32_t)strtoul(argv[3], nullptr, 10)
+                             : TRACE_DEFAULT_INDEX_STRIDE;
+
+  // The writer is only opened at the first block, so an `@C` line printed
+  // at boot can still fill in the sensor and detector config of the header.
+  TraceSensorConfig sensor = traceDefaultSensorConfig();
+  TraceDetectorConfig detector = traceDefaultDetectorConfig();
+  TraceWriter writer;
+  bool opened = false;
+
+  char line[2 * METRICS_SNAPSHOT_MAX_BYTES + 64];
+  uint8_t block[TELEMETRY_BLOCK_BYTES];
+  uint64_t epoch = 0;
+  uint64_t base = 0;  // added to the unwrapped stamps of the current segment
+  uint64_t lastTime = 0;
+  uint32_t lastStamp = 0;
+  bool haveStamp = false;
+  bool restarted = false;
+  unsigned long restarts = 0;
+  bool haveSequence = false;
+  uint32_t expectedSequence = 0;
+  unsigned long blocks = 0;
+  unsigned long lostBlocks = 0;
+  unsigned long badLines = 0;
+
+  while (fgets(line, sizeof(line), in) != nullptr) {
+    if (strncmp(line, TELEMETRY_CONFIG_PREFIX, strlen(TELEMETRY_CONFIG_PREFIX)) == 0) {
+      // Printed once per boot, so a second one means the device restarted.
+      if (opened) restarted = true;
+      else parseConfigLine(line, sensor, detector);
+      continue;
+    }
+    if (strncmp(line, METRICS_SNAPSHOT_PREFIX, strlen(METRICS_SNAPSHOT_PREFIX)) == 0) {
+      if (!printMetricsLine(line)) badLines++;
+      continue;
+    }
+    if (strncmp(line, SUMMARY_PREFIX, strlen(SUMMARY_PREFIX)) == 0) {
+      if (!printSummaryLine(line)) badLines++;
+      continue;
+    }
+
+    size_t length = 0;
+    uint32_t sequence = 0;
+    if (!telemetryParseBlockLine(line, block, sizeof(block), length, sequence)) {
+      if (strncmp(line, TELEMETRY_BLOCK_PREFIX, strlen(TELEMETRY_BLOCK_PREFIX)) == 0) {
+        badLines++;
+      }
+      continue;
+    }
+
+    SampleBlockDecoder decoder;
+    if (!decoder.begin(block, length)) {
+      badLines++;
+      continue;
+    }
+    if (!opened) {
+      if (!writer.open(argv[2], sensor, detector, stride)) {
+        fprintf(stderr, "telemetry_decoder: cannot create %s\n", argv[2]);
+        return 1;
+      }
+      opened = true;
+    }
+
+    uint16_t flags = 0;
+    if (haveSequence && sequence < expectedSequence) restarted = true;
+    if (restarted) {
+      flags = TRACE_FLAG_GAP;
+    } else if (haveSequence && sequence != expectedSequence) {
+      lostBlocks += sequence - expectedSequence;
+      flags = TRACE_FLAG_GAP;
+    }
+    haveSequence = true;
+    expectedSequence = sequence + 1;
+    blocks++;
+
+    uint32_t stamp;
+    int32_t echo;
+    while (decoder.next(stamp, echo)) {
+      if (haveStamp && !restarted && stamp < lastStamp) {
+        if ((uint32_t)(stamp - lastStamp) <= MAX_PING_STEP_US) {
+          epoch += 1ull << 32;
+        } else {
+          restarted = true;  // micros() restarted mid-capture without a `@C` line
+          flags = TRACE_FLAG_GAP;
+        }
+      }
+      if (restarted && haveStamp) {
+        epoch = 0;
+        base = lastTime + 1 - stamp;
+        restarts++;
+      }
+      restarted = false;
+      haveStamp = true;
+      lastStamp = stamp;
+      lastTime = base + (epoch | stamp);
+      if (!writer.append(lastTime, (uint32_t)echo, flags)) {
+        fprintf(stderr, "telemetry_decoder: write failed\n");
+        return 1;
+      }
+      flags = 0;
+    }
+  }
+  if (in != stdin) fclose(in);
+
+  if (!opened) {
+    fprintf(stderr, "telemetry_decoder: no telemetry blocks found\n");
+    return 1;
+  }
+  unsigned long long records = writer.recordCount();
+  if (!writer.close()) {
+    fprintf(stderr, "telemetry_decoder: failed to finalise %s\n", argv[2]);
+    return 1;
+  }
+  printf("%llu records from %lu blocks (%lu lost, %lu malformed lines, %lu restarts)\n",
+         records, blocks, lostBlocks, badLines, restarts);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file TraceTool.cpp
+ * @brief Inspects, searches and synthesises trace files
+ *
+ * @details Commands:
+ * - `info <trace>`                     header, sensor config and time span
+ * - `dump <trace> <fromUs> [count]`    records starting at a timestamp
+ * - `simulate <out> <seconds> [seed] [noiseCm]`
+ *                                      writes a trace from SensorSimulator,
+ *                                      pinging with the stock firmware timing,
+ *                                      plus its label sidecar
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "GroundTruth.h"
+#include "IntruderDetector.h"
+#include "SensorSimulator.h"
+#include "TraceFile.h"
+
+namespace {
+
+int usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s info <trace>\n"
+          "       %s dump <trace> <fromUs> [count]\n"
+          "       %s simulate <out.trace> <seconds> [seed] [noiseCm]\n",
+          argv0, argv0, argv0);
+  return 2;
+}
+
+int info(const char* path) {
+  TraceReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "trace_tool: %s is not a readable trace\n", path);
+    return 1;
+  }
+  const TraceHeader& h = reader.header();
+  const TraceSensorConfig& s = reader.sensor();
+  printf("version        %u\n", (unsigned)h.version);
+  printf("records        %zu%s\n", reader.size(),
+         h.indexOffset == 0 ? " (unfinished, no index)" : "");
+  printf("index          %" PRIu64 " entries, stride %u\n", h.indexCount,
+         (unsigned)h.indexStride);
+  printf("pins           trig=%u echo=%u buzzer=%u\n", s.trigPin, s.echoPin,
+         s.buzzerPin);
+  printf("sampling       %u pings/reading, %u ms spacing, %u ms period, %u us timeout\n",
+         s.samplesPerReading, (unsigned)s.pingSpacingMs, (unsigned)s.cyclePeriodMs,
+         (unsigned)s.echoTimeoutUs);
+  const TraceDetectorConfig& d = reader.detector();
+  printf("detector       filter=%s calibration=%u readings (%u ms period), margins "
+         "%.1f/%.1f cm, adapt %.4f\n",
+         d.filter < FILTER_TYPE_COUNT ? filterTypeName((FilterType)d.filter) : "?",
+         (unsigned)d.calibrationReadings, (unsigned)d.calibrationPeriodMs,
+         (double)d.tripMarginCm, (double)d.clearMarginCm, (double)d.adaptRate);
+  if (reader.size() > 0) {
+    uint64_t first = reader[0].timeUs;
+    uint64_t last = reader[reader.size() - 1].timeUs;
+    printf("span           %" PRIu64 " .. %" PRIu64 " us (%.1f s)\n", first, last,
+           (double)(last - first) / 1e6);
+  }
+  return 0;
+}
+
+int dump(const char* path, uint64_t fromUs, size_t count) {
+  TraceReader reader;
+  if (!reader.open(path)) {
+    fprintf(stderr, "trace_tool: %s is not a readable trace\n", path);
+    return 1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  size_t i = reader.seek(fromUs);
+  double seekUs = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start).count();
+  printf("# seek to %" PRIu64 " us -> record %zu in %.2f us\n", fromUs, i, seekUs);
+  for (size_t n = 0; n < count && i < reader.size(); n++, i++) {
+    const TraceRecord& r = reader[i];
+    printf("%" PRIu64 ",%u,%u\n", r.timeUs, (unsigned)r.echoUs, (unsigned)r.flags);
+  }
+  return 0;
+}
+
+int simulate(const char* path, double seconds, uint64_t seed, float noiseCm) {
+  TraceSensorConfig sensor = traceDefaultSensorConfig();
+  uint64_t duration = (uint64_t)(seconds * 1e6);
+  SimScene scene = makeRandomScene(duration, (int)(seconds / 60) + 1, seed);
+  scene.noiseCm = noiseCm;
+  scene.timeoutProbability = 0.005f;
+  scene.glitchProbability = 0.002f;
+  SensorSimulator sim(scene, seed);
+
+  TraceWriter writer;
+  if (!writer.open(path, sensor)) {
+    fprintf(stderr, "trace_tool: cannot create %s\n", path);
+    return 1;
+  }
+  // Mirrors getDistanceCm()/loop(): a burst of pings, then the cycle delay.
+  uint64_t t = 0;
+  while (t < duration) {
+    for (int i = 0; i < sensor.samplesPerReading; i++) {
+      unsigned long echo = sim.echoAt(t);
+      writer.append(t, (uint32_t)echo);
+      t += 12 + (echo ? echo : sensor.echoTimeoutUs) + sensor.pingSpacingMs * 1000ull;
+    }
+    t += sensor.cyclePeriodMs * 1000ull;
+  }
+  unsigned long long records = writer.recordCount();
+  if (!writer.close()) {
+    fprintf(stderr, "trace_tool: failed to write %s\n", path);
+    return 1;
+  }
+
+  std::vector<LabelInterval> labels;
+  for (const SimIntrusion& intrusion : scene.intrusions) {
+    LabelInterval label = {intrusion.startUs, intrusion.endUs};
+    labels.push_back(label);
+  }
+  if (!saveLabels(labelPathFor(path), labels)) {
+    fprintf(stderr, "trace_tool: failed to write labels for %s\n", path);
+    return 1;
+  }
+  printf("%llu records, %zu labelled intrusions\n", records, scene.intrusions.size());
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc >= 3 && strcmp(argv[1], "info") == 0) return info(argv[2]);
+  if (argc >= 4 && strcmp(argv[1], "dump") == 0) {
+    return dump(argv[2], strtoull(argv[3], nullptr, 10),
+                argc > 4 ? strtoul(argv[4], nullptr, 10) : 10);
+  }
+  if (argc >= 4 && strcmp(argv[1], "simulate") == 0) {
+    return simulate(argv[2], atof(argv[3]), argc > 4 ? strtoull(argv[4], nullptr, 10) : 1,
+                    argc > 5 ? (float)atof(argv[5]) : 0.3f);
+  }
+  return usage(argv[0]);
+}
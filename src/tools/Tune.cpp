@@ -0,0 +1,337 @@
+/**
+ * @file Tune.cpp
+ * @brief Parallel threshold/hysteresis sweep over a corpus of labelled traces
+ *
+ * @details Every combination of trip distance, hysteresis gap (clear = trip
+ * + gap), pings per reading, filter type and dwell counts is replayed over
+ * every trace with the real detector code. One job per (configuration,
+ * trace) pair runs on a WorkStealingPool using every core. Each
+ * configuration is scored against the traces' label sidecars with
+ * DetectionScorer (missed rate, false alarms per hour, mean latency; see
+ * docs/label_format.md).
+ *
+ * The Pareto front over (missed rate, false alarms/h, mean latency) is
+ * printed; `--csv` writes every configuration. Thresholds are fixed: a
+ * trace's recorded scene calibration is not used (see Score for that).
+ *
+ * Usage: tune [options] <trace> [trace ...]
+ *   --trip lo:hi:step      trip distances in cm        (default 3:8:0.5)
+ *   --gap a,b,...          clear - trip in cm          (default 0.5,1,2,3,4)
+ *   --samples n            pings per reading; must be what the traces were
+ *                          recorded with (default: that value)
+ *   --filter a,b,...       mean, validmean, median     (default all)
+ *   --dwell a,b,...        readings needed to alarm    (default 1,2)
+ *   --clear-dwell a,b,...  readings needed to clear    (default 1,2)
+ *   --grace ms             detection tolerance after a label ends (2000)
+ *   --threads n            worker threads (default: all cores)
+ *   --csv path             write all results as CSV
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DetectionScorer.h"
+#include "GroundTruth.h"
+#include "IntruderDetector.h"
+#include "ReplayHal.h"
+#include "ToolOptions.h"
+#include "TraceFile.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+struct Corpus {
+  std::string path;
+  std::unique_ptr<TraceReader> reader;
+  std::vector<LabelInterval> labels;
+  double hours;
+};
+
+/**
+ * @brief Counts kept per (configuration, trace) pair
+ *
+ * @details A full TraceScore keeps every event; with thousands of
+ * configurations only the sums needed for the corpus totals are stored.
+ */
+struct Score {
+  size_t labels = 0;
+  size_t missed = 0;
+  size_t falseAlarms = 0;
+  double latencySumMs = 0;
+  double hours = 0;
+};
+
+struct Result {
+  DetectorConfig config;
+  double missedRate;
+  double falseAlarmsPerHour;
+  double meanLatencyMs;
+  bool pareto;
+};
+
+std::vector<float> parseList(const char* text) {
+  std::vector<float> values;
+  float lo, hi, step;
+  if (sscanf(text, "%f:%f:%f", &lo, &hi, &step) == 3 && step > 0) {
+    for (float v = lo; v <= hi + step / 1000; v += step) values.push_back(v);
+    return values;
+  }
+  for (const char* p = text; *p != '\0';) {
+    values.push_back((float)atof(p));
+    const char* comma = strchr(p, ',');
+    if (comma == nullptr) break;
+    p = comma + 1;
+  }
+  return values;
+}
+
+/** @brief a dominates b if it is no worse everywhere and better somewhere */
+bool dominates(const Result& a, const Result& b) {
+  bool noWorse = a.missedRate <= b.missedRate &&
+                 a.falseAlarmsPerHour <= b.falseAlarmsPerHour &&
+                 a.meanLatencyMs <= b.meanLatencyMs;
+  bool better = a.missedRate < b.missedRate ||
+                a.falseAlarmsPerHour < b.falseAlarmsPerHour ||
+                a.meanLatencyMs < b.meanLatencyMs;
+  return noWorse && better;
+}
+
+void printConfig(FILE* out, const DetectorConfig& c, const char* sep) {
+  fprintf(out, "%.2f%s%.2f%s%u%s%s%s%u%s%u", c.tripCm, sep, c.clearCm, sep,
+          (unsigned)c.samplesPerReading, sep, filterTypeName(c.filter), sep,
+          (unsigned)c.tripDwell, sep, (unsigned)c.clearDwell);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<float> trips = parseList("3:8:0.5");
+  std::vector<float> gaps = parseList("0.5,1,2,3,4");
+  std::vector<float> samples;
+  std::vector<float> dwells = parseList("1,2");
+  std::vector<float> clearDwells = parseList("1,2");
+  std::vector<FilterType> filters = {FilterType::Mean, FilterType::ValidMean,
+                                     FilterType::Median};
+  ScoreOptions scoreOptions;
+  size_t threads = 0;
+  const char* csvPath = nullptr;
+  std::vector<Corpus> corpus;
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    if (arg[0] != '-') {
+      Corpus entry;
+      entry.path = arg;
+      entry.reader.reset(new TraceReader());
+      if (!entry.reader->open(arg)) {
+        fprintf(stderr, "tune: %s is not a readable trace\n", arg);
+        return 1;
+      }
+      if (!loadLabels(labelPathFor(arg), entry.labels)) {
+        fprintf(stderr, "tune: cannot read labels %s\n", labelPathFor(arg).c_str());
+        return 1;
+      }
+      const TraceReader& r = *entry.reader;
+      entry.hours = r.size() > 1 ? (r[r.size() - 1].timeUs - r[0].timeUs) / 3.6e9 : 0;
+      corpus.push_back(std::move(entry));
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "tune: %s needs a value\n", arg);
+      return 2;
+    }
+    const char* value = argv[++i];
+    if (strcmp(arg, "--trip") == 0) trips = parseList(value);
+    else if (strcmp(arg, "--gap") == 0) gaps = parseList(value);
+    else if (strcmp(arg, "--samples") == 0) samples = parseList(value);
+    else if (strcmp(arg, "--dwell") == 0) dwells = parseList(value);
+    else if (strcmp(arg, "--clear-dwell") == 0) clearDwells = parseList(value);
+    else if (strcmp(arg, "--grace") == 0) {
+      scoreOptions.graceUs = strtoull(value, nullptr, 10) * 1000;
+    }
+    else if (strcmp(arg, "--threads") == 0) threads = strtoul(value, nullptr, 10);
+    else if (strcmp(arg, "--csv") == 0) csvPath = value;
+    else if (strcmp(arg, "--filter") == 0) {
+      filters.clear();
+      std::string list = value;
+      size_t start = 0;
+      while (start <= list.size()) {
+        size_t comma = list.find(',', start);
+        std::string name = list.substr(start, comma == std::string::npos ? std::string::npos
+                                                                          : comma - start);
+        FilterType filter;
+        if (!parseFilterType(name.c_str(), filter)) {
+          fprintf(stderr, "tune: unknown filter %s\n", name.c_str());
+          return 2;
+        }
+        filters.push_back(filter);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+      }
+    } else {
+      fprintf(stderr, "tune: unknown option %s\n", arg);
+      return 2;
+    }
+  }
+  if (corpus.empty()) {
+    fprintf(stderr, "usage: %s [options] <trace> [trace ...]  (see source for options)\n",
+            argv[0]);
+    return 2;
+  }
+
+  // Replay keeps the recorded ping times, so every trace must share one
+  // pings-per-reading value and the sweep cannot vary it (see ReplayHal.h).
+  const TraceSensorConfig& sensor = corpus[0].reader->sensor();
+  for (const Corpus& entry : corpus) {
+    if (entry.reader->sensor().samplesPerReading != sensor.samplesPerReading) {
+      fprintf(stderr, "tune: %s was recorded with %u pings per reading, %s with %u\n",
+              entry.path.c_str(), (unsigned)entry.reader->sensor().samplesPerReading,
+              corpus[0].path.c_str(), (unsigned)sensor.samplesPerReading);
+      return 2;
+    }
+  }
+  if (samples.empty()) samples.push_back(sensor.samplesPerReading);
+  for (float n : samples) {
+    if ((uint8_t)n != sensor.samplesPerReading) {
+      fprintf(stderr, "tune: traces were recorded with %u pings per reading; cannot replay %g\n",
+              (unsigned)sensor.samplesPerReading, n);
+      return 2;
+    }
+  }
+
+  // Build the grid, starting from the traces' recorded timing. The sweep is
+  // over fixed thresholds, which scene calibration would replace, so a
+  // recorded calibration is turned off (the recorded filter is swept anyway).
+  std::vector<DetectorConfig> grid;
+  for (float trip : trips)
+    for (float gap : gaps)
+      for (float n : samples)
+        for (FilterType filter : filters)
+          for (float dwell : dwells)
+            for (float clearDwell : clearDwells) {
+              DetectorConfig c;
+              applyTraceConfig(corpus[0].reader->header(), c);
+              c.scene.calibrationReadings = 0;
+              c.tripCm = trip;
+              c.clearCm = trip + gap;
+              c.samplesPerReading = (uint8_t)n;
+              c.filter = filter;
+              c.tripDwell = (uint8_t)dwell;
+              c.clearDwell = (uint8_t)clearDwell;
+              grid.push_back(c);
+            }
+
+  std::vector<Score> scores(grid.size() * corpus.size());
+  auto start = std::chrono::steady_clock::now();
+  size_t stealCount = 0;
+  size_t workerCount = 0;
+  {
+    WorkStealingPool pool(threads);
+    workerCount = pool.threadCount();
+    for (size_t g = 0; g < grid.size(); g++) {
+      for (size_t t = 0; t < corpus.size(); t++) {
+        pool.submit([&, g, t] {
+          std::vector<AlarmInterval> alarms;
+          const TraceReader& reader = *corpus[t].reader;
+          replayAlarms(reader.records(), reader.size(), grid[g], alarms);
+          TraceScore full =
+              scoreDetections(alarms, corpus[t].labels, corpus[t].hours, scoreOptions);
+          Score& s = scores[g * corpus.size() + t];
+          s.labels = full.events.size();
+          s.missed = full.missed();
+          s.falseAlarms = full.falseAlarmTimes.size();
+          s.hours = full.hours;
+          for (const EventScore& e : full.events) {
+            if (e.detected) s.latencySumMs += e.latencyUs / 1000.0;
+          }
+        });
+      }
+    }
+    pool.wait();
+    stealCount = pool.steals();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start).count();
+
+  std::vector<Result> results;
+  for (size_t g = 0; g < grid.size(); g++) {
+    Score total;
+    for (size_t t = 0; t < corpus.size(); t++) {
+      const Score& s = scores[g * corpus.size() + t];
+      total.labels += s.labels;
+      total.missed += s.missed;
+      total.falseAlarms += s.falseAlarms;
+      total.latencySumMs += s.latencySumMs;
+      total.hours += s.hours;
+    }
+    Result r;
+    r.config = grid[g];
+    r.missedRate = total.labels ? (double)total.missed / total.labels : 0;
+    r.falseAlarmsPerHour = total.hours > 0 ? total.falseAlarms / total.hours : 0;
+    size_t detected = total.labels - total.missed;
+    // Detecting nothing is not "zero latency".
+    r.meanLatencyMs = detected ? total.latencySumMs / detected : 1e12;
+    r.pareto = false;
+    results.push_back(r);
+  }
+  for (Result& r : results) {
+    r.pareto = true;
+    for (const Result& other : results) {
+      if (dominates(other, r)) {
+        r.pareto = false;
+        break;
+      }
+    }
+  }
+
+  if (csvPath != nullptr) {
+    FILE* csv = fopen(csvPath, "w");
+    if (csv == nullptr) {
+      fprintf(stderr, "tune: cannot write %s\n", csvPath);
+      return 1;
+    }
+    fprintf(csv, "trip,clear,samples,filter,dwell,clear_dwell,missed_rate,"
+                 "false_alarms_per_hour,mean_latency_ms,pareto\n");
+    for (const Result& r : results) {
+      printConfig(csv, r.config, ",");
+      fprintf(csv, ",%.4f,%.3f,%.1f,%d\n", r.missedRate, r.falseAlarmsPerHour,
+              r.meanLatencyMs, r.pareto ? 1 : 0);
+    }
+    fclose(csv);
+  }
+
+  std::vector<Result> front;
+  for (const Result& r : results) {
+    if (r.pareto) front.push_back(r);
+  }
+  std::sort(front.begin(), front.end(), [](const Result& a, const Result& b) {
+    if (a.missedRate != b.missedRate) return a.missedRate < b.missedRate;
+    if (a.falseAlarmsPerHour != b.falseAlarmsPerHour) {
+      return a.falseAlarmsPerHour < b.falseAlarmsPerHour;
+    }
+    return a.meanLatencyMs < b.meanLatencyMs;
+  });
+
+  printf("%zu configurations x %zu traces in %.2f s on %zu threads (%zu steals)\n",
+         grid.size(), corpus.size(), seconds, workerCount, stealCount);
+  printf("Pareto front (%zu):\n", front.size());
+  printf("%6s %6s %7s %-9s %5s %5s  %8s %10s %11s\n", "trip", "clear", "samples",
+         "filter", "dwell", "cdwel", "missed%", "false/h", "latency ms");
+  for (const Result& r : front) {
+    const DetectorConfig& c = r.config;
+    char latency[32] = "-";
+    if (r.meanLatencyMs < 1e12) snprintf(latency, sizeof(latency), "%.1f", r.meanLatencyMs);
+    printf("%6.2f %6.2f %7u %-9s %5u %5u  %8.2f %10.3f %11s\n", c.tripCm, c.clearCm,
+           (unsigned)c.samplesPerReading, filterTypeName(c.filter), (unsigned)c.tripDwell,
+           (unsigned)c.clearDwell, r.missedRate * 100, r.falseAlarmsPerHour, latency);
+  }
+  return 0;
+}